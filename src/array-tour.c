@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "array-tour.h"
+
+static bool alloc_arrays(ArrayTour *at, int32_t n) {
+    at->pred = veci32_create(n);
+    at->pos = veci32_create(n);
+    at->order = veci32_create(n);
+    return at->pred && at->pos && at->order;
+}
+
+void array_tour_clear(ArrayTour *at) {
+    const int32_t n = at->tour.num_customers + 1;
+    tour_clear(&at->tour);
+    at->len = 0;
+    at->cost = 0.0;
+    at->profit = 0.0;
+    at->demand = 0.0;
+    veci32_set(at->pred, n, INT32_DEAD_VAL);
+    veci32_set(at->pos, n, -1);
+}
+
+ArrayTour array_tour_create(const Instance *instance) {
+    ArrayTour at = {0};
+    at.instance = instance;
+    at.tour = tour_create(instance);
+    if (!alloc_arrays(&at, instance->num_customers + 1)) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        array_tour_destroy(&at);
+        return at;
+    }
+    array_tour_clear(&at);
+    return at;
+}
+
+void array_tour_destroy(ArrayTour *at) {
+    tour_destroy(&at->tour);
+    free(at->pred);
+    free(at->pos);
+    free(at->order);
+    memset(at, 0, sizeof(*at));
+}
+
+ArrayTour array_tour_adopt(const Instance *instance, Tour *tour) {
+    ArrayTour at = {0};
+    const int32_t n = tour->num_customers + 1;
+    assert(tour->num_comps <= 1);
+    assert(instance->num_customers == tour->num_customers);
+
+    // NOTE(dparo): Allocate before taking ownership, such that the caller
+    //     still owns `tour` on failure
+    if (!alloc_arrays(&at, n)) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        array_tour_destroy(&at);
+        return at;
+    }
+    at.instance = instance;
+    at.tour = tour_move(tour);
+
+    veci32_set(at.pred, n, INT32_DEAD_VAL);
+    veci32_set(at.pos, n, -1);
+
+    int32_t first = -1;
+    for (int32_t i = 0; i < n; i++) {
+        if (at.tour.comp[i] == 0) {
+            first = i;
+            break;
+        }
+    }
+
+    if (first >= 0) {
+        int32_t curr = first;
+        do {
+            const int32_t next = at.tour.succ[curr];
+            assert(next >= 0 && next < n);
+            at.pos[curr] = at.len;
+            at.order[at.len++] = curr;
+            at.pred[next] = curr;
+            at.cost += array_tour_dist(&at, curr, next);
+            at.profit += instance->profits[curr];
+            at.demand += instance->demands[curr];
+            curr = next;
+        } while (curr != first);
+    }
+
+    at.tour.num_comps = at.len > 0 ? 1 : 0;
+    array_tour_validate(&at);
+    return at;
+}
+
+Tour array_tour_release(ArrayTour *at) {
+    Tour result = tour_move(&at->tour);
+    array_tour_destroy(at);
+    return result;
+}
+
+static inline void link_nodes(ArrayTour *at, int32_t u, int32_t v) {
+    at->tour.succ[u] = v;
+    at->pred[v] = u;
+}
+
+/// Recomputes `succ` and `pred` for the `count` edges leaving the positions
+/// `p, ..., p + count - 1` (cyclically).
+static void relink_positions(ArrayTour *at, int32_t p, int32_t count) {
+    const int32_t len = at->len;
+    for (int32_t t = 0; t < count; t++) {
+        const int32_t q = (p + t) % len;
+        link_nodes(at, at->order[q], at->order[(q + 1) % len]);
+    }
+}
+
+/// Reverses the `count` positions starting from `p` (cyclically)
+static void reverse_positions(ArrayTour *at, int32_t p, int32_t count) {
+    const int32_t len = at->len;
+    if (count <= 1) {
+        return;
+    }
+
+    for (int32_t t = 0; t < count / 2; t++) {
+        const int32_t i = (p + t) % len;
+        const int32_t j = (p + count - 1 - t) % len;
+        const int32_t u = at->order[i];
+        const int32_t v = at->order[j];
+        at->order[i] = v;
+        at->order[j] = u;
+        at->pos[v] = i;
+        at->pos[u] = j;
+    }
+
+    // Relink the reversed positions together with their two neighbours
+    if (count >= len) {
+        relink_positions(at, 0, len);
+    } else {
+        relink_positions(at, (p - 1 + len) % len, count + 1);
+    }
+}
+
+/// Number of positions going forward from `a` to `b` (both included)
+static inline int32_t forward_count(const ArrayTour *at, int32_t a,
+                                    int32_t b) {
+    return (at->pos[b] - at->pos[a] + at->len) % at->len + 1;
+}
+
+void array_tour_insert(ArrayTour *at, int32_t h, int32_t a) {
+    assert(!array_tour_contains(at, h));
+
+    at->cost += array_tour_insert_delta(at, h, a);
+    at->profit += at->instance->profits[h];
+    at->demand += at->instance->demands[h];
+
+    if (at->len == 0) {
+        at->order[0] = h;
+        at->pos[h] = 0;
+        at->len = 1;
+        at->tour.comp[h] = 0;
+        at->tour.num_comps = 1;
+        link_nodes(at, h, h);
+        return;
+    }
+
+    assert(array_tour_contains(at, a));
+    const int32_t p = at->pos[a] + 1;
+    const int32_t b = at->tour.succ[a];
+
+    memmove(&at->order[p + 1], &at->order[p],
+            (at->len - p) * sizeof(*at->order));
+    at->order[p] = h;
+    at->len++;
+    for (int32_t q = p; q < at->len; q++) {
+        at->pos[at->order[q]] = q;
+    }
+
+    at->tour.comp[h] = 0;
+    link_nodes(at, a, h);
+    link_nodes(at, h, b);
+
+#ifndef NDEBUG
+    array_tour_validate(at);
+#endif
+}
+
+void array_tour_remove(ArrayTour *at, int32_t h) {
+    assert(array_tour_contains(at, h));
+    at->cost += array_tour_remove_delta(at, h);
+    at->profit -= at->instance->profits[h];
+    at->demand -= at->instance->demands[h];
+    const int32_t p = at->pos[h];
+    const int32_t a = at->pred[h];
+    const int32_t b = at->tour.succ[h];
+
+    memmove(&at->order[p], &at->order[p + 1],
+            (at->len - p - 1) * sizeof(*at->order));
+    at->len--;
+    for (int32_t q = p; q < at->len; q++) {
+        at->pos[at->order[q]] = q;
+    }
+
+    at->pos[h] = -1;
+    at->pred[h] = INT32_DEAD_VAL;
+    at->tour.succ[h] = INT32_DEAD_VAL;
+    at->tour.comp[h] = INT32_DEAD_VAL;
+
+    if (at->len == 0) {
+        at->tour.num_comps = 0;
+    } else {
+        link_nodes(at, a, b);
+    }
+
+#ifndef NDEBUG
+    array_tour_validate(at);
+#endif
+}
+
+void array_tour_2opt_move(ArrayTour *at, int32_t a, int32_t b) {
+    assert(array_tour_contains(at, a) && array_tour_contains(at, b));
+    assert(a != b);
+
+    const int32_t succ_a = at->tour.succ[a];
+    const int32_t succ_b = at->tour.succ[b];
+    at->cost += array_tour_2opt_delta(at, a, b);
+
+    // NOTE(dparo):
+    //     Reversing the path `succ(a) -> b` or the path `succ(b) -> a` yields
+    //     the same route (with opposite orientations)
+    const int32_t count = forward_count(at, succ_a, b);
+    if (count <= at->len - count) {
+        reverse_positions(at, at->pos[succ_a], count);
+    } else {
+        reverse_positions(at, at->pos[succ_b], at->len - count);
+    }
+
+#ifndef NDEBUG
+    array_tour_validate(at);
+#endif
+}
+
+double array_tour_or_move_delta(const ArrayTour *at, int32_t s, int32_t e,
+                                int32_t c, bool reversed) {
+    const int32_t p = array_tour_pred(at, s);
+    const int32_t q = array_tour_succ(at, e);
+    const int32_t succ_c = array_tour_succ(at, c);
+
+    if (p == c) {
+        // The segment stays in place, possibly reversed
+        if (!reversed) {
+            return 0.0;
+        }
+        return array_tour_dist(at, c, e) + array_tour_dist(at, s, q) -
+               array_tour_dist(at, c, s) - array_tour_dist(at, e, q);
+    }
+
+    double removed = array_tour_dist(at, p, s) + array_tour_dist(at, e, q) +
+                     array_tour_dist(at, c, succ_c);
+    double added = array_tour_dist(at, p, q);
+    if (reversed) {
+        added += array_tour_dist(at, c, e) + array_tour_dist(at, s, succ_c);
+    } else {
+        added += array_tour_dist(at, c, s) + array_tour_dist(at, e, succ_c);
+    }
+    return added - removed;
+}
+
+void array_tour_or_move(ArrayTour *at, int32_t s, int32_t e, int32_t c,
+                        bool reversed) {
+    assert(array_tour_contains(at, s) && array_tour_contains(at, e));
+    assert(array_tour_contains(at, c));
+    assert(!array_tour_between(at, s, c, e));
+
+    at->cost += array_tour_or_move_delta(at, s, e, c, reversed);
+
+    const int32_t seg_count = forward_count(at, s, e);
+    const int32_t succ_c = at->tour.succ[c];
+    if (succ_c == s) {
+        // Already in place
+        if (reversed) {
+            reverse_positions(at, at->pos[s], seg_count);
+        }
+#ifndef NDEBUG
+        array_tour_validate(at);
+#endif
+        return;
+    }
+
+    // NOTE(dparo):
+    //     The move is a rotation of two adjacent blocks of positions, which
+    //     is carried out with three reversals. Either the block
+    //     `succ(c) -> pred(s)` precedes the segment, or the block
+    //     `succ(e) -> c` follows it: rotate the shorter of the two.
+    //     Skipping the reversal of the segment itself leaves it reversed.
+    const int32_t before_count = forward_count(at, succ_c, at->pred[s]);
+    const int32_t after_count = forward_count(at, at->tour.succ[e], c);
+
+    if (before_count <= after_count) {
+        const int32_t p = at->pos[succ_c];
+        const int32_t seg_p = at->pos[s];
+        reverse_positions(at, p, before_count);
+        if (!reversed) {
+            reverse_positions(at, seg_p, seg_count);
+        }
+        reverse_positions(at, p, before_count + seg_count);
+    } else {
+        const int32_t p = at->pos[s];
+        const int32_t block_p = at->pos[at->tour.succ[e]];
+        if (!reversed) {
+            reverse_positions(at, p, seg_count);
+        }
+        reverse_positions(at, block_p, after_count);
+        reverse_positions(at, p, seg_count + after_count);
+    }
+
+#ifndef NDEBUG
+    array_tour_validate(at);
+#endif
+}
+
+void array_tour_validate(const ArrayTour *at) {
+#ifndef NDEBUG
+    const int32_t n = at->tour.num_customers + 1;
+    assert(at->len >= 0 && at->len <= n);
+    assert(at->tour.num_comps == (at->len > 0 ? 1 : 0));
+
+    int32_t num_visited = 0;
+    for (int32_t i = 0; i < n; i++) {
+        if (at->pos[i] >= 0) {
+            ++num_visited;
+            assert(at->pos[i] < at->len);
+            assert(at->order[at->pos[i]] == i);
+            assert(at->tour.comp[i] == 0);
+            const int32_t next = at->tour.succ[i];
+            assert(next == at->order[(at->pos[i] + 1) % at->len]);
+            assert(at->pred[next] == i);
+        } else {
+            assert(at->tour.comp[i] < 0);
+        }
+    }
+    assert(num_visited == at->len);
+
+    // Full recompute of the incrementally maintained metrics
+    double cost = 0.0, profit = 0.0, demand = 0.0;
+    for (int32_t p = 0; p < at->len; p++) {
+        const int32_t i = at->order[p];
+        cost += array_tour_dist(at, i, at->tour.succ[i]);
+        profit += at->instance->profits[i];
+        demand += at->instance->demands[i];
+    }
+    assert(feq(cost, at->cost, 1e-5));
+    assert(feq(profit, at->profit, 1e-5));
+    assert(feq(demand, at->demand, 1e-5));
+#else
+    UNUSED_PARAM(at);
+#endif
+}
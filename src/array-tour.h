@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+#include "core-utils.h"
+
+/// Single route representation for local search. On top of the `succ` and
+/// `comp` arrays of a `Tour` it maintains:
+///   - `pred`: the predecessor of each visited node
+///   - `order`: the visited nodes in route order, `order[0 .. len)`
+///   - `pos`: the index of each node in `order`, or -1 if not visited
+///
+/// This allows O(1) `pred` and orientation (`array_tour_between`) queries.
+/// All the arrays are kept consistent by the move primitives below, which
+/// also update the route `cost`, `profit` and `demand` in O(1). Debug builds
+/// check these metrics against a full recompute after each move.
+/// Unvisited nodes have `comp` and `succ` set to `INT32_DEAD_VAL`, as done by
+/// `tour_clear`.
+typedef struct ArrayTour {
+    /// Always consistent: can be passed as is to any function expecting a
+    /// `Tour`
+    Tour tour;
+    const Instance *instance;
+    int32_t len;
+
+    /// Sum of the distances of the route edges
+    double cost;
+    /// Sum of the profits of the visited nodes
+    double profit;
+    /// Sum of the demands of the visited nodes
+    double demand;
+
+    int32_t *pred;
+    int32_t *pos;
+    int32_t *order;
+} ArrayTour;
+
+ArrayTour array_tour_create(const Instance *instance);
+void array_tour_destroy(ArrayTour *at);
+void array_tour_clear(ArrayTour *at);
+
+/// Takes ownership of the arrays of `tour` (which is left zeroed) and builds
+/// the additional ones in O(n). `tour` must have at most one component:
+/// the route is walked starting from the depot, if visited. On allocation
+/// failure a zeroed struct is returned and `tour` is left untouched.
+ArrayTour array_tour_adopt(const Instance *instance, Tour *tour);
+/// Gives back the underlying `Tour`, releasing the additional arrays.
+Tour array_tour_release(ArrayTour *at);
+
+static inline bool array_tour_contains(const ArrayTour *at, int32_t i) {
+    return at->pos[i] >= 0;
+}
+
+static inline int32_t array_tour_succ(const ArrayTour *at, int32_t i) {
+    assert(array_tour_contains(at, i));
+    return at->tour.succ[i];
+}
+
+static inline int32_t array_tour_pred(const ArrayTour *at, int32_t i) {
+    assert(array_tour_contains(at, i));
+    return at->pred[i];
+}
+
+/// Returns true if, going forward from `a`, `b` is met before (or when)
+/// reaching `c`. All the nodes must be visited.
+static inline bool array_tour_between(const ArrayTour *at, int32_t a,
+                                      int32_t b, int32_t c) {
+    const int32_t pa = at->pos[a];
+    const int32_t pb = at->pos[b];
+    const int32_t pc = at->pos[c];
+    assert(pa >= 0 && pb >= 0 && pc >= 0);
+    if (pa <= pc) {
+        return pa <= pb && pb <= pc;
+    } else {
+        return pb >= pa || pb <= pc;
+    }
+}
+
+/// Distance between two nodes of the route. Unlike `cptp_dist`, it also
+/// accepts `i == j`, which occurs for the single node route.
+static inline double array_tour_dist(const ArrayTour *at, int32_t i,
+                                     int32_t j) {
+    return i == j ? 0.0 : cptp_dist(at->instance, i, j);
+}
+
+/// Objective value of the route, as computed by `tour_eval` when the
+/// capacity is not exceeded
+static inline double array_tour_objective(const ArrayTour *at) {
+    return at->cost - at->profit;
+}
+
+/// Change in `cost` caused by `array_tour_insert(at, h, a)`
+static inline double array_tour_insert_delta(const ArrayTour *at, int32_t h,
+                                             int32_t a) {
+    if (at->len == 0) {
+        return 0.0;
+    }
+    const int32_t b = array_tour_succ(at, a);
+    return array_tour_dist(at, a, h) + array_tour_dist(at, h, b) -
+           array_tour_dist(at, a, b);
+}
+
+/// Change in `cost` caused by `array_tour_remove(at, h)`
+static inline double array_tour_remove_delta(const ArrayTour *at, int32_t h) {
+    const int32_t a = array_tour_pred(at, h);
+    const int32_t b = array_tour_succ(at, h);
+    return array_tour_dist(at, a, b) - array_tour_dist(at, a, h) -
+           array_tour_dist(at, h, b);
+}
+
+/// Change in `cost` caused by `array_tour_2opt_move(at, a, b)`
+static inline double array_tour_2opt_delta(const ArrayTour *at, int32_t a,
+                                           int32_t b) {
+    const int32_t succ_a = array_tour_succ(at, a);
+    const int32_t succ_b = array_tour_succ(at, b);
+    return array_tour_dist(at, a, b) +
+           array_tour_dist(at, succ_a, succ_b) -
+           array_tour_dist(at, a, succ_a) -
+           array_tour_dist(at, b, succ_b);
+}
+
+/// Change in `cost` caused by `array_tour_or_move(at, s, e, c, reversed)`
+double array_tour_or_move_delta(const ArrayTour *at, int32_t s, int32_t e,
+                                int32_t c, bool reversed);
+
+/// Inserts the unvisited node `h` right after `a`. If the tour is empty `a`
+/// is ignored and `h` becomes the only visited node.
+/// Takes O(len - pos(a)).
+void array_tour_insert(ArrayTour *at, int32_t h, int32_t a);
+
+/// Removes the visited node `h`, linking its predecessor and successor.
+/// Takes O(len - pos(h)).
+void array_tour_remove(ArrayTour *at, int32_t h);
+
+/// Replaces the edges `(a, succ(a))` and `(b, succ(b))` with `(a, b)` and
+/// `(succ(a), succ(b))`. Only the shorter of the two paths that need to be
+/// reversed is actually reversed: the orientation of the whole route may
+/// therefore change. Takes O(min(k, len - k)).
+void array_tour_2opt_move(ArrayTour *at, int32_t a, int32_t b);
+
+/// Moves the path going forward from `s` to `e` right after `c`, which must
+/// not be part of the path. If `reversed` the path is inserted as
+/// `c -> e -> ... -> s`. Takes O(min(dist(succ(c), e), dist(s, c))).
+void array_tour_or_move(ArrayTour *at, int32_t s, int32_t e, int32_t c,
+                        bool reversed);
+
+/// Asserts the consistency of all the arrays and metrics (debug builds only)
+void array_tour_validate(const ArrayTour *at);
+
+#if __cplusplus
+}
+#endif
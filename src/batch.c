@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "batch.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "misc.h"
+#include "os.h"
+#include "parser.h"
+
+#include <log.h>
+
+typedef struct {
+    const CptpJob *jobs;
+    int32_t num_jobs;
+    CancellationToken *cancel;
+    /// Cores granted to each job whose solver accepts `NUM_THREADS`
+    int32_t threads_per_job;
+    CptpJobResult *results;
+    CptpJobDoneCallback on_done;
+    void *user_data;
+    atomic_int next_job;
+    pthread_mutex_t on_done_mutex;
+} BatchCtx;
+
+static void notify_job_done(BatchCtx *ctx, const CptpJob *job,
+                            const CptpJobResult *result,
+                            const Instance *instance, Solution *solution) {
+    if (ctx->on_done) {
+        pthread_mutex_lock(&ctx->on_done_mutex);
+        ctx->on_done(job, result, instance, solution, ctx->user_data);
+        pthread_mutex_unlock(&ctx->on_done_mutex);
+    }
+}
+
+static CptpJobResult run_job(BatchCtx *ctx, const CptpJob *job) {
+    static const SolverParams EMPTY_PARAMS = {0};
+
+    CptpJobResult result = {0};
+    Instance instance = parse(job->instance_filepath);
+
+    if (!is_valid_instance(&instance)) {
+        log_fatal("%s :: %s: Failed to parse file", __func__,
+                  job->instance_filepath);
+        result.status = SOLVE_STATUS_ERR;
+        notify_job_done(ctx, job, &result, NULL, NULL);
+        instance_destroy(&instance);
+        return result;
+    }
+
+    // NOTE(dparo):
+    //     The workers solve concurrently: unless the job sets its own
+    //     `NUM_THREADS`, each job gets its share of the cores instead of
+    //     autodetecting all of them.
+    SolverParams params = job->params ? *job->params : EMPTY_PARAMS;
+    char num_threads[16];
+    solver_params_default_num_threads(&params, job->solver_name,
+                                      ctx->threads_per_job, num_threads,
+                                      sizeof(num_threads));
+
+    result.parsed = true;
+    Solution solution = solution_create(&instance);
+    solution_reserve_columns(&solution, job->num_columns);
+
+    result.timing.started = time(NULL);
+    int64_t begin_solve_time = os_get_usecs();
+    result.status =
+        cptp_solve(&instance, job->solver_name, &params, &solution,
+                   job->timelimit, job->randomseed, ctx->cancel);
+    result.timing.ended = time(NULL);
+    result.timing.took_usecs = os_get_usecs() - begin_solve_time;
+
+    bool success =
+        result.status != 0 && !BOOL(result.status & SOLVE_STATUS_ERR);
+
+    if (success && job->json_report_path) {
+        SolveReport report = {
+            .solver_name = job->solver_name,
+            .timelimit = job->timelimit,
+            .randomseed = job->randomseed,
+            .defines = job->defines,
+            .num_defines = job->num_defines,
+            .instance_filepath = job->instance_filepath,
+            .instance = &instance,
+            .solution = &solution,
+            .status = result.status,
+            .timing = result.timing,
+        };
+        write_json_report(job->json_report_path, &report);
+    }
+
+    notify_job_done(ctx, job, &result, &instance, &solution);
+
+    solution_destroy(&solution);
+    instance_destroy(&instance);
+    return result;
+}
+
+static void *worker_main(void *arg) {
+    BatchCtx *ctx = arg;
+    int32_t job_idx;
+
+    // NOTE(dparo):
+    //     Jobs are handed out in order to whichever worker is free first,
+    //     such that a long solve does not hold back the remaining jobs.
+    while ((job_idx = atomic_fetch_add(&ctx->next_job, 1)) < ctx->num_jobs) {
+        if (ctx->cancel && cancellation_requested(ctx->cancel)) {
+            break;
+        }
+        CptpJobResult result = run_job(ctx, &ctx->jobs[job_idx]);
+        if (ctx->results) {
+            ctx->results[job_idx] = result;
+        }
+    }
+
+    return NULL;
+}
+
+bool cptp_solve_many(const CptpJob *jobs, int32_t num_jobs,
+                     int32_t num_workers, CancellationToken *cancel,
+                     CptpJobResult *results, CptpJobDoneCallback on_done,
+                     void *user_data) {
+    if (num_jobs <= 0) {
+        return true;
+    }
+
+    if (results) {
+        memset(results, 0, num_jobs * sizeof(*results));
+    }
+
+    if (num_workers <= 0) {
+        num_workers = os_get_num_cpus();
+    }
+    num_workers = MIN(num_workers, num_jobs);
+
+    BatchCtx ctx = {.jobs = jobs,
+                    .num_jobs = num_jobs,
+                    .cancel = cancel,
+                    .threads_per_job =
+                        MAX(1, os_get_num_cpus() / num_workers),
+                    .results = results,
+                    .on_done = on_done,
+                    .user_data = user_data};
+    atomic_init(&ctx.next_job, 0);
+
+    if (pthread_mutex_init(&ctx.on_done_mutex, NULL) != 0) {
+        log_fatal("%s :: Failed to initialize mutex", __func__);
+        return false;
+    }
+
+    pthread_t *workers = malloc(num_workers * sizeof(*workers));
+    int32_t num_started = 0;
+
+    if (!workers) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        goto terminate;
+    }
+
+    for (int32_t i = 0; i < num_workers; i++) {
+        if (pthread_create(&workers[i], NULL, worker_main, &ctx) != 0) {
+            log_warn("%s :: Failed to start worker %d", __func__, i);
+            break;
+        }
+        ++num_started;
+    }
+
+    if (num_started == 0) {
+        log_fatal("%s :: Failed to start any worker", __func__);
+    }
+
+terminate:
+    for (int32_t i = 0; i < num_started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    free(workers);
+    pthread_mutex_destroy(&ctx.on_done_mutex);
+    return num_started > 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+#include "report.h"
+
+/// A single (instance, solver, seed) solve to be run by `cptp_solve_many`
+typedef struct CptpJob {
+    const char *instance_filepath;
+    const char *solver_name;
+    const SolverParams *params;
+    /// Parameter definitions (`KEY=VALUE`) listed in the JSON report
+    const char **defines;
+    int32_t num_defines;
+    double timelimit;
+    int32_t randomseed;
+    /// Maximum number of columns collected by the solution, 0 to only
+    /// retain the best tour (see `solution_reserve_columns`)
+    int32_t num_columns;
+    /// Where to write the JSON report of the job, can be NULL
+    const char *json_report_path;
+} CptpJob;
+
+typedef struct CptpJobResult {
+    /// False if the instance could not be parsed: the job was not solved
+    bool parsed;
+    SolveStatus status;
+    SolveTiming timing;
+} CptpJobResult;
+
+/// Invoked once per job as soon as it terminates. Invocations are serialized,
+/// but may happen from any of the worker threads and in any order. `instance`
+/// and `solution` are NULL when the instance could not be parsed.
+typedef void (*CptpJobDoneCallback)(const CptpJob *job,
+                                    const CptpJobResult *result,
+                                    const Instance *instance,
+                                    Solution *solution, void *user_data);
+
+/// Solves all the `jobs` with a pool of `num_workers` threads (a value <= 0
+/// uses one worker per online CPU). Each worker parses, solves and reports
+/// a job at a time, therefore at most `num_workers` instances are kept in
+/// memory. The jobs whose solver accepts a `NUM_THREADS` parameter, and
+/// which do not set it, get `max(1, num_cpus / num_workers)` threads each.
+/// `results` (optional) is filled with one entry per job, and the
+/// JSON report of the successful jobs is written to their
+/// `json_report_path`. Requesting `cancel` (can be NULL) aborts the running
+/// solves: the jobs which were not started yet are skipped, their result is
+/// left zeroed and `on_done` is not invoked for them. Returns false if the
+/// worker pool could not be started, true otherwise, even if some of the
+/// jobs failed.
+bool cptp_solve_many(const CptpJob *jobs, int32_t num_jobs,
+                     int32_t num_workers, CancellationToken *cancel,
+                     CptpJobResult *results, CptpJobDoneCallback on_done,
+                     void *user_data);
+
+#if __cplusplus
+}
+#endif
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "candidates.h"
+#include "core-utils.h"
+#include "dist-kernel.h"
+#include "spatial-index.h"
+
+typedef struct {
+    double dist;
+    int32_t idx;
+} PoolEntry;
+
+static inline bool pool_entry_less(const PoolEntry *a, const PoolEntry *b) {
+    return a->dist < b->dist || (a->dist == b->dist && a->idx < b->idx);
+}
+
+static int cmp_pool_entry(const void *a, const void *b) {
+    const PoolEntry *pa = a;
+    const PoolEntry *pb = b;
+    if (pool_entry_less(pa, pb)) {
+        return -1;
+    } else if (pool_entry_less(pb, pa)) {
+        return 1;
+    }
+    return 0;
+}
+
+static inline void swap_pool_entry(PoolEntry *a, PoolEntry *b) {
+    PoolEntry tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/// Partially orders `entries` such that the first `m` entries are the `m`
+/// smallest ones (in no particular order).
+static void select_smallest(PoolEntry *entries, int32_t len, int32_t m) {
+    int32_t lo = 0;
+    int32_t hi = len - 1;
+    while (lo < hi) {
+        PoolEntry pivot = entries[lo + (hi - lo) / 2];
+        int32_t i = lo;
+        int32_t j = hi;
+        while (i <= j) {
+            while (pool_entry_less(&entries[i], &pivot)) {
+                ++i;
+            }
+            while (pool_entry_less(&pivot, &entries[j])) {
+                --j;
+            }
+            if (i <= j) {
+                swap_pool_entry(&entries[i], &entries[j]);
+                ++i;
+                --j;
+            }
+        }
+
+        if (m - 1 <= j) {
+            hi = j;
+        } else if (m - 1 >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+}
+
+static inline bool rc_less(double key_a, int32_t a, double key_b, int32_t b) {
+    return key_a < key_b || (key_a == key_b && a < b);
+}
+
+/// Inserts `j` in the sorted list `ids` (of maximum size `k`) if its
+/// reduced cost `key` ranks among the `k` best ones seen so far.
+static inline void push_candidate(int32_t *ids, double *keys, int32_t *len,
+                                  int32_t k, int32_t j, double key) {
+    if (*len == k && !rc_less(key, j, keys[k - 1], ids[k - 1])) {
+        return;
+    }
+
+    int32_t pos = *len < k ? (*len)++ : k - 1;
+    while (pos > 0 && rc_less(key, j, keys[pos - 1], ids[pos - 1])) {
+        keys[pos] = keys[pos - 1];
+        ids[pos] = ids[pos - 1];
+        --pos;
+    }
+    keys[pos] = key;
+    ids[pos] = j;
+}
+
+static void update_node(CandidateLists *cl, const Instance *instance,
+                        int32_t i, double max_profit, double *keys,
+                        double *row) {
+    const int32_t n = cl->num_nodes;
+    const int32_t k = cl->k;
+    const int32_t *pool = &cl->pool[(size_t)i * (size_t)cl->pool_len];
+    const double *pool_dist =
+        &cl->pool_dist[(size_t)i * (size_t)cl->pool_len];
+    const double pi = instance->profits[i];
+    int32_t *ids = &cl->lists[(size_t)i * (size_t)k];
+
+    int32_t len = 0;
+    bool exhausted = true;
+
+    for (int32_t t = 0; t < cl->pool_len; t++) {
+        const double dist = pool_dist[t];
+        // NOTE(dparo):
+        //     The pool is sorted by increasing distance, therefore any node
+        //     following `t` has a reduced cost of at least
+        //     `dist - (pi + max_profit) / 2`. As soon as this bound is worse
+        //     than the k-th best candidate, the remaining nodes can be
+        //     skipped altogether.
+        if (len == k && dist - (pi + max_profit) / 2.0 > keys[k - 1]) {
+            exhausted = false;
+            break;
+        }
+        const int32_t j = pool[t];
+        push_candidate(ids, keys, &len, k, j,
+                       dist - (pi + instance->profits[j]) / 2.0);
+    }
+
+    if (exhausted && cl->pool_len < n - 1) {
+        // NOTE(dparo):
+        //     The profits are spread enough that some node outside of the
+        //     pool may still rank among the best `k`. Fallback to a full
+        //     scan of the row.
+        dist_block(instance, i, i + 1, 0, n, row, n);
+        len = 0;
+        for (int32_t j = 0; j < n; j++) {
+            if (j != i) {
+                push_candidate(ids, keys, &len, k, j,
+                               row[j] - (pi + instance->profits[j]) / 2.0);
+            }
+        }
+    }
+
+    assert(len == k);
+}
+
+bool candidate_lists_update(CandidateLists *cl, const Instance *instance) {
+    assert(cl->lists);
+    assert(cl->num_nodes == instance->num_customers + 1);
+
+    const int32_t n = cl->num_nodes;
+    double max_profit = -INFINITY;
+    for (int32_t i = 0; i < n; i++) {
+        max_profit = MAX(max_profit, instance->profits[i]);
+    }
+
+    bool result = true;
+    double *keys = malloc((size_t)cl->k * sizeof(*keys));
+    double *row = malloc((size_t)n * sizeof(*row));
+
+    if (!keys || !row) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        update_node(cl, instance, i, max_profit, keys, row);
+    }
+
+terminate:
+    free(row);
+    free(keys);
+    return result;
+}
+
+CandidateLists candidate_lists_create(const Instance *instance, int32_t k) {
+    const int32_t n = instance->num_customers + 1;
+    CandidateLists cl = {0};
+    PoolEntry *entries = NULL;
+    double *row = NULL;
+    SpatialIndex index = {0};
+    int32_t *nn = NULL;
+
+    k = MIN(k, n - 1);
+    if (k <= 0) {
+        log_warn("%s :: Cannot build candidate lists with k = %d (%d nodes)",
+                 __func__, k, n);
+        goto fail;
+    }
+
+    cl.num_nodes = n;
+    cl.k = k;
+    cl.pool_len = MIN(n - 1, k * CANDIDATE_LISTS_POOL_FACTOR);
+    cl.lists = malloc((size_t)n * (size_t)k * sizeof(*cl.lists));
+    cl.pool = malloc((size_t)n * (size_t)cl.pool_len * sizeof(*cl.pool));
+    cl.pool_dist =
+        malloc((size_t)n * (size_t)cl.pool_len * sizeof(*cl.pool_dist));
+    entries = malloc((size_t)n * sizeof(*entries));
+    row = malloc((size_t)n * sizeof(*row));
+
+    if (!cl.lists || !cl.pool || !cl.pool_dist || !entries || !row) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        goto fail;
+    }
+
+    // NOTE(dparo):
+    //     Every `DistanceRounding` is monotone, therefore the `pool_len`
+    //     nearest nodes in euclidean terms are also a valid pool for the
+    //     rounded distances. For geometric instances the pool can thus be
+    //     collected from the spatial index, without computing every row.
+    bool use_spatial_index = !instance->edge_weight && instance->positions;
+    if (use_spatial_index) {
+        index = spatial_index_create(instance->positions, n);
+        nn = malloc(cl.pool_len * sizeof(*nn));
+        if (!index.points || !nn) {
+            log_fatal("%s :: Failed memory allocation", __func__);
+            goto fail;
+        }
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        if (use_spatial_index) {
+            int32_t len = spatial_index_knn(&index, instance->positions[i],
+                                            cl.pool_len, i, nn, NULL);
+            if (len < 0) {
+                goto fail;
+            }
+            assert(len == cl.pool_len);
+            for (int32_t t = 0; t < len; t++) {
+                entries[t] = (PoolEntry){cptp_dist(instance, i, nn[t]), nn[t]};
+            }
+        } else {
+            dist_block(instance, i, i + 1, 0, n, row, n);
+
+            int32_t len = 0;
+            for (int32_t j = 0; j < n; j++) {
+                if (j != i) {
+                    entries[len++] = (PoolEntry){row[j], j};
+                }
+            }
+            select_smallest(entries, len, cl.pool_len);
+        }
+
+        qsort(entries, cl.pool_len, sizeof(*entries), cmp_pool_entry);
+
+        int32_t *pool = &cl.pool[(size_t)i * (size_t)cl.pool_len];
+        double *pool_dist = &cl.pool_dist[(size_t)i * (size_t)cl.pool_len];
+        for (int32_t t = 0; t < cl.pool_len; t++) {
+            pool[t] = entries[t].idx;
+            pool_dist[t] = entries[t].dist;
+        }
+    }
+
+    free(nn);
+    spatial_index_destroy(&index);
+    free(row);
+    free(entries);
+    if (!candidate_lists_update(&cl, instance)) {
+        candidate_lists_destroy(&cl);
+    }
+    return cl;
+
+fail:
+    free(nn);
+    spatial_index_destroy(&index);
+    free(row);
+    free(entries);
+    candidate_lists_destroy(&cl);
+    return cl;
+}
+
+void candidate_lists_destroy(CandidateLists *cl) {
+    free(cl->lists);
+    free(cl->pool);
+    free(cl->pool_dist);
+    memset(cl, 0, sizeof(*cl));
+}
+
+bool candidate_lists_contains_edge(const CandidateLists *cl, int32_t i,
+                                   int32_t j) {
+    const int32_t *li = candidate_list(cl, i);
+    const int32_t *lj = candidate_list(cl, j);
+    for (int32_t t = 0; t < cl->k; t++) {
+        if (li[t] == j || lj[t] == i) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+/// For each node `i`, the `k` nodes `j != i` having the smallest reduced cost
+/// `cptp_reduced_cost(instance, i, j)`, sorted by increasing reduced cost
+/// (ties are broken by the smaller node index).
+///
+/// The lists are derived from a per-node pool of the nearest nodes sorted by
+/// distance, which depends only on the geometry of the instance. When only
+/// the `profits` change (eg between pricing iterations) the lists can be
+/// rebuilt with `candidate_lists_update` without sorting any distance row.
+typedef struct CandidateLists {
+    int32_t num_nodes;
+    int32_t k;
+    /// `num_nodes * k` node indices
+    int32_t *lists;
+
+    int32_t pool_len;
+    /// `num_nodes * pool_len` node indices sorted by increasing distance
+    int32_t *pool;
+    /// Distances associated to each entry of `pool`
+    double *pool_dist;
+} CandidateLists;
+
+/// Builds the candidate lists of size `k` (clamped to `n - 1`).
+/// Returns a zeroed struct on failure.
+CandidateLists candidate_lists_create(const Instance *instance, int32_t k);
+void candidate_lists_destroy(CandidateLists *cl);
+
+/// Recomputes the lists for the current `instance->profits`. The instance
+/// geometry must be the same the lists were created with. Returns false on
+/// allocation failure, leaving the previous lists in place.
+bool candidate_lists_update(CandidateLists *cl, const Instance *instance);
+
+static inline const int32_t *candidate_list(const CandidateLists *cl,
+                                            int32_t i) {
+    assert(i >= 0 && i < cl->num_nodes);
+    return &cl->lists[(size_t)i * (size_t)cl->k];
+}
+
+/// Returns true if `j` appears in the candidate list of `i` or viceversa.
+bool candidate_lists_contains_edge(const CandidateLists *cl, int32_t i,
+                                   int32_t j);
+
+#if __cplusplus
+}
+#endif
@@ -31,6 +31,24 @@ extern "C" {
 // RCSP_PRECISION from BapCod
 #define COST_TOLERANCE ((double)1e-6)
 
+// Instances with more nodes than this do not get a precomputed distance
+// cache: 4096 nodes already amount to ~32MB with 32 bit storage (~64MB when
+// the distances must be kept as doubles)
+#define DIST_CACHE_MAX_NUM_NODES (4096)
+
+// Each node keeps a pool of its `k * CANDIDATE_LISTS_POOL_FACTOR` nearest
+// nodes, from which the reduced cost candidate lists are rebuilt whenever the
+// profits change
+#define CANDIDATE_LISTS_POOL_FACTOR (4)
+
+// Maximum number of (a, b) node pairs examined by the customer elimination
+// preprocessing when searching for a profitable insertion of each customer:
+// `CUSTOMER_ELIMINATION_SCAN_FACTOR * n^2`, capped to
+// `CUSTOMER_ELIMINATION_SCAN_BUDGET`. Once exhausted, the remaining customers
+// are conservatively kept.
+#define CUSTOMER_ELIMINATION_SCAN_FACTOR (32)
+#define CUSTOMER_ELIMINATION_SCAN_BUDGET ((int64_t)1 << 24)
+
 #if __cplusplus
 }
 #endif
@@ -33,12 +33,17 @@ bool solver_params_contains(SolverTypedParams *params, char *key);
 bool solver_params_get_bool(SolverTypedParams *params, char *key);
 int32_t solver_params_get_int32(SolverTypedParams *params, char *key);
 double solver_params_get_double(SolverTypedParams *params, char *key);
+const char *solver_params_get_str(SolverTypedParams *params, char *key);
 
-static inline int64_t hm_nentries(int32_t n) { return ((n * n) - n) / 2; }
+static inline int64_t hm_nentries(int32_t n) {
+    return ((int64_t)n * n - n) / 2;
+}
 
 // Number of entries in a full matrix of size `N x N`
 // Eg N**2 - num_entries(diagonal)
-static inline int64_t fm_nentries(int32_t n) { return (n * n) - n; }
+static inline int64_t fm_nentries(int32_t n) {
+    return (int64_t)n * n - n;
+}
 
 static inline int64_t sxpos(int32_t n, int32_t i, int32_t j) {
     assert(i != j);
@@ -46,7 +51,7 @@ static inline int64_t sxpos(int32_t n, int32_t i, int32_t j) {
     int32_t l = MIN(i, j);
     int32_t u = MAX(i, j);
 
-    int64_t result = l * n + u - ((l + 1) * (l + 2)) / 2;
+    int64_t result = (int64_t)l * n + u - ((int64_t)(l + 1) * (l + 2)) / 2;
     return result;
 }
 
@@ -57,12 +62,59 @@ static inline int64_t asxpos(int32_t n, int32_t i, int32_t j) {
         return hm_nentries(n) + sxpos(n, j, i);
 }
 
+static inline size_t dist_storage_elem_size(DistStorage storage) {
+    switch (storage) {
+    case CPTP_DIST_STORAGE_F64:
+        return sizeof(double);
+    case CPTP_DIST_STORAGE_F32:
+        return sizeof(float);
+    case CPTP_DIST_STORAGE_I32:
+        return sizeof(int32_t);
+    default:
+        assert(!"Invalid code path!");
+        return 0;
+    }
+}
+
+static inline double dist_storage_load(DistStorage storage, double scale,
+                                       const void *data, int64_t idx) {
+    switch (storage) {
+    case CPTP_DIST_STORAGE_F64:
+        return ((const double *)data)[idx];
+    case CPTP_DIST_STORAGE_F32:
+        return (double)((const float *)data)[idx];
+    case CPTP_DIST_STORAGE_I32: {
+        // NOTE(dparo):
+        //     Divide instead of multiplying by the reciprocal: the division
+        //     is correctly rounded and recovers the original value exactly.
+        double v = (double)((const int32_t *)data)[idx];
+        return scale == 1.0 ? v : v / scale;
+    }
+    default:
+        assert(!"Invalid code path!");
+        return INFINITY;
+    }
+}
+
+static inline double cptp_edge_weight(const Instance *instance, int64_t idx) {
+    return dist_storage_load(instance->edge_weight_storage,
+                             instance->edge_weight_scale, instance->edge_weight,
+                             idx);
+}
+
 static inline double cptp_dist(const Instance *instance, int32_t i, int32_t j) {
     assert(i >= 0 && i < instance->num_customers + 1);
     assert(j >= 0 && j < instance->num_customers + 1);
 
-    if (instance->edge_weight) {
-        return instance->edge_weight[sxpos(instance->num_customers + 1, i, j)];
+    if (instance->dist_cache) {
+        return i == j ? 0.0
+                      : dist_storage_load(
+                            instance->dist_cache_storage,
+                            instance->dist_cache_scale, instance->dist_cache,
+                            sxpos(instance->num_customers + 1, i, j));
+    } else if (instance->edge_weight) {
+        return cptp_edge_weight(instance,
+                                sxpos(instance->num_customers + 1, i, j));
     } else {
         double distance =
             vec2d_dist(&instance->positions[i], &instance->positions[j]);
@@ -23,12 +23,14 @@
 #include "core.h"
 #include <stdlib.h>
 #include <string.h>
-#include <signal.h>
+#include <stdatomic.h>
 
 #include "solvers.h"
 #include "core-utils.h"
 #include "parsing-utils.h"
 #include "validation.h"
+#include "dist-kernel.h"
+#include "preprocess.h"
 
 void instance_set_name(Instance *instance, const char *name) {
     if (instance->name) {
@@ -37,6 +39,106 @@ void instance_set_name(Instance *instance, const char *name) {
     instance->name = strdup(name);
 }
 
+struct InstanceArena {
+    atomic_int refcount;
+    size_t size;
+};
+
+#define ARENA_HEADER_SIZE                                                      \
+    POW2_ALIGN(size_t, sizeof(InstanceArena), CACHE_LINE_SIZE)
+
+/// Size reserved in an arena for an array of `size` bytes, such that the
+/// following array starts on a new cache line
+static inline size_t arena_slot_size(size_t size) {
+    return POW2_ALIGN(size_t, size, CACHE_LINE_SIZE);
+}
+
+static InstanceArena *arena_create(size_t size) {
+    InstanceArena *arena =
+        aligned_malloc(CACHE_LINE_SIZE, ARENA_HEADER_SIZE + MAX(1, size));
+    if (arena) {
+        atomic_init(&arena->refcount, 1);
+        arena->size = size;
+        memset((uint8_t *)arena + ARENA_HEADER_SIZE, 0, size);
+    }
+    return arena;
+}
+
+static inline uint8_t *arena_data(InstanceArena *arena) {
+    return (uint8_t *)arena + ARENA_HEADER_SIZE;
+}
+
+static InstanceArena *arena_retain(InstanceArena *arena) {
+    if (arena) {
+        atomic_fetch_add(&arena->refcount, 1);
+    }
+    return arena;
+}
+
+static void arena_release(InstanceArena *arena) {
+    if (arena && atomic_fetch_sub(&arena->refcount, 1) == 1) {
+        aligned_free(arena);
+    }
+}
+
+/// Allocates a new geometry arena holding `n` positions and, if
+/// `with_edge_weight`, a triangle of distances stored as `storage`.
+/// The instance previous geometry arena (if any) is released, the caller is
+/// responsible for copying over the old contents beforehand.
+static bool alloc_geometry(Instance *instance, int32_t n,
+                           bool with_edge_weight, DistStorage storage) {
+    const size_t positions_size =
+        arena_slot_size(n * sizeof(*instance->positions));
+    const size_t edge_weight_size =
+        with_edge_weight ? hm_nentries(n) * dist_storage_elem_size(storage)
+                         : 0;
+
+    InstanceArena *arena = arena_create(positions_size + edge_weight_size);
+    if (!arena) {
+        return false;
+    }
+
+    arena_release(instance->geometry_arena);
+    instance->geometry_arena = arena;
+    instance->positions = (Vec2d *)arena_data(arena);
+    instance->edge_weight =
+        with_edge_weight ? (double *)(arena_data(arena) + positions_size)
+                         : NULL;
+    instance->edge_weight_storage = storage;
+    instance->edge_weight_scale = 1.0;
+    return true;
+}
+
+static bool alloc_nodes(Instance *instance, int32_t n) {
+    const size_t demands_size =
+        arena_slot_size(n * sizeof(*instance->demands));
+    const size_t profits_size = n * sizeof(*instance->profits);
+
+    InstanceArena *arena = arena_create(demands_size + profits_size);
+    if (!arena) {
+        return false;
+    }
+
+    arena_release(instance->nodes_arena);
+    instance->nodes_arena = arena;
+    instance->demands = (double *)arena_data(arena);
+    instance->profits = (double *)(arena_data(arena) + demands_size);
+    return true;
+}
+
+bool instance_alloc(Instance *instance, bool with_edge_weight) {
+    return instance_alloc_with_storage(instance, with_edge_weight,
+                                       CPTP_DIST_STORAGE_F64);
+}
+
+bool instance_alloc_with_storage(Instance *instance, bool with_edge_weight,
+                                 DistStorage storage) {
+    const int32_t n = instance->num_customers + 1;
+    instance_drop_dist_cache(instance);
+    return alloc_geometry(instance, n, with_edge_weight, storage) &&
+           alloc_nodes(instance, n);
+}
+
 void instance_destroy(Instance *instance) {
     if (instance->name) {
         free(instance->name);
@@ -46,14 +148,205 @@ void instance_destroy(Instance *instance) {
         free(instance->comment);
     }
 
-    free(instance->positions);
-    free(instance->demands);
-    free(instance->profits);
-    free(instance->edge_weight);
+    arena_release(instance->geometry_arena);
+    arena_release(instance->nodes_arena);
+    arena_release(instance->dist_cache_arena);
 
     memset(instance, 0, sizeof(*instance));
 }
 
+// Fixed point scales tried when compacting a triangle of distances
+static const double FIXED_POINT_SCALES[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+static bool fits_fixed_point(const double *values, int64_t len,
+                             double scale) {
+    for (int64_t k = 0; k < len; k++) {
+        double q = round(values[k] * scale);
+        // NOTE(dparo): The representation must round trip exactly, see
+        // `dist_storage_load`
+        if (!(fabs(q) <= (double)INT32_MAX) || q / scale != values[k]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool fits_f32(const double *values, int64_t len, double tolerance) {
+    for (int64_t k = 0; k < len; k++) {
+        if (!(fabs((double)(float)values[k] - values[k]) <= tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Picks the most compact storage able to represent all the `values` of a
+/// triangle of size `n`. The fixed point representation is exact. The
+/// float representation is accepted only if the error accumulated over the
+/// (at most `n`) edges of a tour stays well below `COST_TOLERANCE`.
+static DistStorage pick_dist_storage(const double *values, int32_t n,
+                                     double *scale) {
+    const int64_t len = hm_nentries(n);
+
+    for (int32_t k = 0; k < ARRAY_LEN_i32(FIXED_POINT_SCALES); k++) {
+        if (fits_fixed_point(values, len, FIXED_POINT_SCALES[k])) {
+            *scale = FIXED_POINT_SCALES[k];
+            return CPTP_DIST_STORAGE_I32;
+        }
+    }
+
+    *scale = 1.0;
+    if (fits_f32(values, len, 0.1 * COST_TOLERANCE / MAX(1, n))) {
+        return CPTP_DIST_STORAGE_F32;
+    }
+
+    return CPTP_DIST_STORAGE_F64;
+}
+
+static void convert_dist_triangle(const double *values, int64_t len,
+                                  DistStorage storage, double scale,
+                                  void *out) {
+    switch (storage) {
+    case CPTP_DIST_STORAGE_F64:
+        memcpy(out, values, len * sizeof(*values));
+        break;
+    case CPTP_DIST_STORAGE_F32:
+        for (int64_t k = 0; k < len; k++) {
+            ((float *)out)[k] = (float)values[k];
+        }
+        break;
+    case CPTP_DIST_STORAGE_I32:
+        for (int64_t k = 0; k < len; k++) {
+            ((int32_t *)out)[k] = (int32_t)round(values[k] * scale);
+        }
+        break;
+    default:
+        assert(!"Invalid code path!");
+        break;
+    }
+}
+
+bool instance_compact_edge_weight(Instance *instance) {
+    const int32_t n = instance->num_customers + 1;
+
+    if (!instance->edge_weight ||
+        instance->edge_weight_storage != CPTP_DIST_STORAGE_F64) {
+        return false;
+    }
+
+    double scale = 1.0;
+    DistStorage storage = pick_dist_storage(instance->edge_weight, n, &scale);
+    if (storage == CPTP_DIST_STORAGE_F64) {
+        return false;
+    }
+
+    // NOTE(dparo):
+    //     The compact triangle goes into a new (smaller) geometry arena. The
+    //     old arena is kept alive until its contents are copied over.
+    Instance compact = {0};
+    if (!alloc_geometry(&compact, n, true, storage)) {
+        return false;
+    }
+
+    memcpy(compact.positions, instance->positions,
+           n * sizeof(*instance->positions));
+    convert_dist_triangle(instance->edge_weight, hm_nentries(n), storage,
+                          scale, compact.edge_weight);
+
+    arena_release(instance->geometry_arena);
+    instance->geometry_arena = compact.geometry_arena;
+    instance->positions = compact.positions;
+    instance->edge_weight = compact.edge_weight;
+    instance->edge_weight_storage = storage;
+    instance->edge_weight_scale = scale;
+
+    log_trace("%s :: Compacted edge weights to %s storage (scale = %g)",
+              __func__, storage == CPTP_DIST_STORAGE_I32 ? "int32" : "float",
+              scale);
+    return true;
+}
+
+static double positions_max_dist(const Vec2d *positions, int32_t n) {
+    Vec2d lo = positions[0];
+    Vec2d hi = positions[0];
+    for (int32_t i = 1; i < n; i++) {
+        lo.x = MIN(lo.x, positions[i].x);
+        lo.y = MIN(lo.y, positions[i].y);
+        hi.x = MAX(hi.x, positions[i].x);
+        hi.y = MAX(hi.y, positions[i].y);
+    }
+    return vec2d_dist(&lo, &hi);
+}
+
+bool instance_build_dist_cache(Instance *instance) {
+    instance_drop_dist_cache(instance);
+
+    const int32_t n = instance->num_customers + 1;
+
+    // NOTE(dparo):
+    //     Instances with an explicit `edge_weight` section already
+    //     resolve `cptp_dist` with a single load, nothing to cache.
+    if (instance->edge_weight || !instance->positions || n < 2 ||
+        n > DIST_CACHE_MAX_NUM_NODES) {
+        return false;
+    }
+
+    // NOTE(dparo):
+    //     Every rounding strategy, except CPTP_DIST_NO_ROUND, produces
+    //     integral distances. Those are stored as int32 whenever the
+    //     bounding box diagonal guarantees that they fit, halving the size
+    //     of the cache.
+    DistStorage storage = CPTP_DIST_STORAGE_F64;
+    if (instance->rounding_strat != CPTP_DIST_NO_ROUND &&
+        ceil(positions_max_dist(instance->positions, n)) < (double)INT32_MAX) {
+        storage = CPTP_DIST_STORAGE_I32;
+    }
+
+    InstanceArena *arena =
+        arena_create(hm_nentries(n) * dist_storage_elem_size(storage));
+    double *row = malloc(n * sizeof(*row));
+    if (!arena || !row) {
+        log_warn("%s :: Failed to allocate distance cache for %d nodes",
+                 __func__, n);
+        arena_release(arena);
+        free(row);
+        return false;
+    }
+    void *cache = arena_data(arena);
+
+    // NOTE(dparo):
+    //     Row `i` of the triangle holds the distances to the nodes
+    //     `[i + 1, n)`, stored contiguously starting at `sxpos(n, i, i + 1)`
+    DistRowKernel kernel = dist_row_kernel(instance->rounding_strat);
+    for (int32_t i = 0; i < n - 1; i++) {
+        int64_t base = sxpos(n, i, i + 1);
+        if (storage == CPTP_DIST_STORAGE_F64) {
+            kernel(instance->positions, i, i + 1, n, (double *)cache + base);
+        } else {
+            kernel(instance->positions, i, i + 1, n, row);
+            convert_dist_triangle(row, n - (i + 1), storage, 1.0,
+                                  (int32_t *)cache + base);
+        }
+    }
+    free(row);
+
+    instance->dist_cache_arena = arena;
+    instance->dist_cache = cache;
+    instance->dist_cache_storage = storage;
+    instance->dist_cache_scale = 1.0;
+    log_trace("%s :: Built %s distance cache for %d nodes", __func__,
+              storage == CPTP_DIST_STORAGE_I32 ? "int32" : "double", n);
+    return true;
+}
+
+void instance_drop_dist_cache(Instance *instance) {
+    arena_release(instance->dist_cache_arena);
+    instance->dist_cache_arena = NULL;
+    instance->dist_cache = NULL;
+    instance->dist_cache_storage = CPTP_DIST_STORAGE_F64;
+    instance->dist_cache_scale = 0.0;
+}
+
 bool tour_is_valid(Tour *tour) {
     return tour->comp && tour->succ && tour->num_customers > 0;
 }
@@ -100,13 +393,146 @@ void solution_clear(Solution *solution) {
     solution->dual_bound = INFINITY;
     solution->primal_bound = 0;
     tour_clear(&solution->tour);
+    solution->columns.num_columns = 0;
+}
+
+static void column_pool_destroy(ColumnPool *pool) {
+    for (int32_t k = 0; k < pool->capacity; k++) {
+        tour_destroy(&pool->tours[k]);
+    }
+    free(pool->tours);
+    free(pool->reduced_costs);
+    free(pool->hashes);
+    memset(pool, 0, sizeof(*pool));
 }
 
 void solution_destroy(Solution *solution) {
     tour_destroy(&solution->tour);
+    column_pool_destroy(&solution->columns);
     memset(solution, 0, sizeof(*solution));
 }
 
+bool solution_reserve_columns(Solution *solution, int32_t k) {
+    ColumnPool *pool = &solution->columns;
+    const int32_t n = solution->tour.num_customers + 1;
+    column_pool_destroy(pool);
+
+    if (k <= 0) {
+        return true;
+    }
+
+    pool->tours = calloc(k, sizeof(*pool->tours));
+    pool->reduced_costs = malloc(k * sizeof(*pool->reduced_costs));
+    pool->hashes = malloc(k * sizeof(*pool->hashes));
+    if (!pool->tours || !pool->reduced_costs || !pool->hashes) {
+        goto fail;
+    }
+
+    pool->capacity = k;
+    for (int32_t i = 0; i < k; i++) {
+        Tour *t = &pool->tours[i];
+        t->num_customers = n - 1;
+        t->succ = veci32_create(n);
+        t->comp = veci32_create(n);
+        if (!tour_is_valid(t)) {
+            goto fail;
+        }
+        tour_clear(t);
+    }
+    return true;
+
+fail:
+    log_fatal("%s :: Failed memory allocation", __func__);
+    column_pool_destroy(pool);
+    return false;
+}
+
+static uint64_t tour_nodes_hash(const Tour *tour) {
+    // NOTE(dparo): FNV-1a over the (sorted) visited nodes
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int32_t i = 0; i < tour->num_customers + 1; i++) {
+        if (tour->comp[i] == 0) {
+            hash ^= (uint64_t)i;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+static bool tour_same_nodes(const Tour *a, const Tour *b) {
+    for (int32_t i = 0; i < a->num_customers + 1; i++) {
+        if ((a->comp[i] == 0) != (b->comp[i] == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool solution_add_column_with_cost(Solution *solution, const Tour *tour,
+                                   double reduced_cost) {
+    ColumnPool *pool = &solution->columns;
+
+    if (pool->capacity <= 0 || tour->num_comps != 1 || tour->comp[0] != 0 ||
+        !isfinite(reduced_cost) || !is_valid_reduced_cost(reduced_cost)) {
+        return false;
+    }
+
+    assert(tour->num_customers == pool->tours[0].num_customers);
+    uint64_t hash = tour_nodes_hash(tour);
+
+    // Slot freed for the new column, which is then moved up to keep the
+    // pool sorted
+    int32_t pos = -1;
+    for (int32_t k = 0; k < pool->num_columns; k++) {
+        if (pool->hashes[k] == hash &&
+            tour_same_nodes(&pool->tours[k], tour)) {
+            if (reduced_cost >= pool->reduced_costs[k]) {
+                return false;
+            }
+            pos = k;
+            break;
+        }
+    }
+
+    if (pos < 0) {
+        if (pool->num_columns < pool->capacity) {
+            pos = pool->num_columns++;
+        } else if (reduced_cost < pool->reduced_costs[pool->capacity - 1]) {
+            // Evict the worst column
+            pos = pool->capacity - 1;
+        } else {
+            return false;
+        }
+    }
+
+    Tour slot = pool->tours[pos];
+    while (pos > 0 && pool->reduced_costs[pos - 1] > reduced_cost) {
+        pool->tours[pos] = pool->tours[pos - 1];
+        pool->reduced_costs[pos] = pool->reduced_costs[pos - 1];
+        pool->hashes[pos] = pool->hashes[pos - 1];
+        --pos;
+    }
+
+    const int32_t n = tour->num_customers + 1;
+    memcpy(slot.succ, tour->succ, n * sizeof(*slot.succ));
+    memcpy(slot.comp, tour->comp, n * sizeof(*slot.comp));
+    slot.num_comps = tour->num_comps;
+
+    pool->tours[pos] = slot;
+    pool->reduced_costs[pos] = reduced_cost;
+    pool->hashes[pos] = hash;
+    return true;
+}
+
+bool solution_add_column(Solution *solution, const Instance *instance,
+                         const Tour *tour) {
+    if (solution->columns.capacity <= 0) {
+        return false;
+    }
+    return solution_add_column_with_cost(solution, tour,
+                                         tour_eval(instance, (Tour *)tour));
+}
+
 Tour tour_copy(Tour const *other) {
     Tour result = {0};
     result.num_customers = other->num_customers;
@@ -124,6 +550,21 @@ Tour tour_move(Tour *other) {
     return result;
 }
 
+int32_t tour_comp_to_bitset(const Tour *tour, int32_t comp, Bitset *out) {
+    const int32_t n = tour->num_customers + 1;
+    assert(out->nbits >= n);
+    bitset_clear(out);
+
+    int32_t size = 0;
+    for (int32_t i = 0; i < n; i++) {
+        if (tour->comp[i] == comp) {
+            bitset_set(out, i);
+            ++size;
+        }
+    }
+    return size;
+}
+
 typedef Solver (*SolverCreateFn)(const Instance *instance,
                                  SolverTypedParams *tparams, double timelimit,
                                  int32_t randomseed);
@@ -133,6 +574,7 @@ static const struct SolverLookup {
     SolverCreateFn create_fn;
 } SOLVERS_REGISTRY[] = {
     {&STUB_SOLVER_DESCRIPTOR, &stub_solver_create},
+    {&PORTFOLIO_SOLVER_DESCRIPTOR, &portfolio_solver_create},
 #if COMPILED_WITH_CPLEX
     {&MIP_SOLVER_DESCRIPTOR, &mip_solver_create},
 #endif
@@ -407,35 +849,42 @@ static void postprocess_solver_solution(const Instance *instance,
 
     if (status == SOLVE_STATUS_NULL || BOOL(status & SOLVE_STATUS_ERR)) {
         solution_clear(solution);
+    } else if (primal_avail) {
+        // NOTE(dparo):
+        //     The best tour is always part of the columns, whichever the
+        //     solver which produced it
+        solution_add_column(solution, instance, &solution->tour);
     }
 }
 
-typedef void (*sighandler_t)(int);
-static THREAD_LOCAL volatile Solver *sighandler_ctx_solver_ptr;
+static SolveStatus run_solver(Solver *solver, const Instance *instance,
+                              Solution *solution, CancellationToken *cancel) {
+    CancellationToken never_cancelled = {0};
+    solver->cancel = cancel ? cancel : &never_cancelled;
 
-/// \brief Consumes the signal and does not propagate it further
-static void cptp_sighandler(int signum) {
-    switch (signum) {
-    case SIGINT:
-        log_warn("Received SIGINT");
-        break;
-    case SIGTERM:
-        log_warn("Received SIGTERM");
-        break;
-    default:
-        break;
-    }
-    if (signum == SIGTERM || signum == SIGINT) {
-        if (sighandler_ctx_solver_ptr) {
-            sighandler_ctx_solver_ptr->sigterm_occured = true;
-            sighandler_ctx_solver_ptr->sigterm_occured_int = 1;
-        }
+    int64_t begin_time = os_get_usecs();
+    SolveStatus status = solver->solve(solver, instance, solution, begin_time);
+
+    if (cancellation_requested(solver->cancel)) {
+        status |= SOLVE_STATUS_ABORTION_SIGTERM;
     }
+
+    solver->cancel = NULL;
+    return status;
+}
+
+/// The `CUSTOMER_ELIMINATION` param is optional: solvers not listing it in
+/// their descriptor never run the elimination
+static bool customer_elimination_enabled(SolverTypedParams *tparams) {
+    SolverTypedParamsEntry *entry =
+        shgetp_null(tparams->entries, "CUSTOMER_ELIMINATION");
+    return entry && entry->value.count > 0 && entry->value.bval;
 }
 
 SolveStatus cptp_solve(const Instance *instance, const char *solver_name,
                        const SolverParams *params, Solution *solution,
-                       double timelimit, int32_t randomseed) {
+                       double timelimit, int32_t randomseed,
+                       CancellationToken *cancel) {
     SolveStatus status = SOLVE_STATUS_NULL;
     const SolverLookup *lookup = lookup_solver(solver_name);
 
@@ -452,7 +901,6 @@ SolveStatus cptp_solve(const Instance *instance, const char *solver_name,
     }
 
     printf("%s :: Setting seed = %d\n", __func__, randomseed);
-    srand(randomseed);
 
     printf("%s :: Setting timelimit = %f\n", __func__, timelimit);
 
@@ -469,32 +917,44 @@ SolveStatus cptp_solve(const Instance *instance, const char *solver_name,
         goto fail;
     }
 
-    Solver solver =
-        lookup->create_fn(instance, &tparams, timelimit, randomseed);
-
-    {
-        solver.sigterm_occured = false;
-        solver.sigterm_occured_int = 0;
-
-        // Setup signals
-        sighandler_ctx_solver_ptr = &solver;
-        sighandler_t prev_sigterm_handler = signal(SIGTERM, cptp_sighandler);
-        sighandler_t prev_sigint_handler = signal(SIGINT, cptp_sighandler);
-        {
-            int64_t begin_time = os_get_usecs();
-            status = solver.solve(&solver, instance, solution, begin_time);
+    // NOTE(dparo):
+    //     When enabled, run the solver on the sub-instance made of the
+    //     customers that may still belong to an optimal tour. The solution
+    //     is mapped back to the original instance once solved.
+    const Instance *solve_instance = instance;
+    Solution *solve_solution = solution;
+    ReducedInstance reduced = {0};
+    Solution reduced_solution = {0};
+
+    if (customer_elimination_enabled(&tparams)) {
+        Bitset eliminated = bitset_create(instance->num_customers + 1);
+        int32_t num_eliminated =
+            eliminated.words ? eliminate_customers(instance, &eliminated) : 0;
+
+        if (num_eliminated > 0 &&
+            reduced_instance_create(&reduced, instance, &eliminated)) {
+            reduced_solution = solution_create(&reduced.instance);
+            solution_reserve_columns(&reduced_solution,
+                                     solution->columns.capacity);
+            solve_instance = &reduced.instance;
+            solve_solution = &reduced_solution;
+            log_info("%s :: Eliminated %d customers out of %d", __func__,
+                     num_eliminated, instance->num_customers);
         }
-        // Resets the signals
-        signal(SIGTERM, prev_sigterm_handler);
-        signal(SIGINT, prev_sigint_handler);
-        sighandler_ctx_solver_ptr = NULL;
+        bitset_destroy(&eliminated);
     }
 
-    if (solver.sigterm_occured) {
-        status |= SOLVE_STATUS_ABORTION_SIGTERM;
+    Solver solver =
+        lookup->create_fn(solve_instance, &tparams, timelimit, randomseed);
+    status = run_solver(&solver, solve_instance, solve_solution, cancel);
+    solver.destroy(&solver);
+
+    if (solve_instance != instance) {
+        reduced_instance_map_solution(&reduced, &reduced_solution, solution);
+        solution_destroy(&reduced_solution);
+        reduced_instance_destroy(&reduced);
     }
 
-    solver.destroy(&solver);
     log_solve_status(status, solver_name);
     postprocess_solver_solution(instance, status, solution);
     solver_typed_params_destroy(&tparams);
@@ -505,6 +965,175 @@ fail:
     return status;
 }
 
+const SolverDescriptor *cptp_find_solver_descriptor(const char *solver_name) {
+    const SolverLookup *lookup = lookup_solver(solver_name);
+    return lookup ? lookup->descriptor : NULL;
+}
+
+bool solver_params_default_num_threads(SolverParams *params,
+                                       const char *solver_name,
+                                       int32_t num_threads, char *buf,
+                                       size_t bufsize) {
+    const SolverDescriptor *desc = cptp_find_solver_descriptor(solver_name);
+    bool accepted = false;
+    for (int32_t i = 0; desc && desc->params[i].name; i++) {
+        if (0 == strcmp(desc->params[i].name, "NUM_THREADS")) {
+            accepted = true;
+            break;
+        }
+    }
+
+    if (!accepted || params->num_params >= MAX_NUM_SOLVER_PARAMS) {
+        return false;
+    }
+
+    for (int32_t i = 0; i < params->num_params; i++) {
+        if (0 == strcmp(params->params[i].name, "NUM_THREADS")) {
+            return false;
+        }
+    }
+
+    snprintf(buf, bufsize, "%d", num_threads);
+    params->params[params->num_params].name = "NUM_THREADS";
+    params->params[params->num_params].value = buf;
+    params->num_params++;
+    return true;
+}
+
+Solver cptp_solver_create(const char *solver_name, const Instance *instance,
+                          const SolverParams *params,
+                          SolverTypedParams *tparams, double timelimit,
+                          int32_t randomseed) {
+    Solver solver = {0};
+    const SolverLookup *lookup = lookup_solver(solver_name);
+
+    if (lookup == NULL) {
+        log_fatal("%s :: `%s` is not a know solver", __func__, solver_name);
+        return solver;
+    }
+
+    if (!verify_solver_params(lookup->descriptor, params) ||
+        !resolve_params(params, lookup->descriptor, tparams)) {
+        log_fatal("%s :: Failed to resolve the parameters of `%s`", __func__,
+                  solver_name);
+        return solver;
+    }
+
+    solver = lookup->create_fn(instance, tparams, timelimit, randomseed);
+    if (!solver.solve) {
+        log_fatal("%s :: Failed to create solver `%s`", __func__,
+                  solver_name);
+    }
+    return solver;
+}
+
+bool cptp_session_create(CptpSession *session, const Instance *instance,
+                         const char *solver_name, const SolverParams *params,
+                         double timelimit, int32_t randomseed) {
+    memset(session, 0, sizeof(*session));
+
+    const SolverLookup *lookup = lookup_solver(solver_name);
+    if (lookup == NULL) {
+        log_fatal("%s :: `%s` is not a know solver", __func__, solver_name);
+        goto fail;
+    }
+
+    if (randomseed == 0) {
+        randomseed = (int32_t)(time(NULL) % INT32_MAX);
+    }
+
+    if (!verify_solver_params(lookup->descriptor, params) ||
+        !resolve_params(params, lookup->descriptor, &session->tparams)) {
+        log_fatal("%s :: Failed to resolve parameters", __func__);
+        goto fail;
+    }
+
+    session->instance = instance_view(instance);
+    if (!session->instance.profits) {
+        log_fatal("%s :: Failed to create the instance view", __func__);
+        goto fail;
+    }
+
+    session->lookup = lookup;
+    session->timelimit = timelimit;
+    session->randomseed = randomseed;
+    session->solver = lookup->create_fn(&session->instance, &session->tparams,
+                                        timelimit, randomseed);
+    if (!session->solver.solve) {
+        log_fatal("%s :: Failed to create solver `%s`", __func__,
+                  solver_name);
+        goto fail;
+    }
+
+    return true;
+
+fail:
+    cptp_session_destroy(session);
+    return false;
+}
+
+void cptp_session_destroy(CptpSession *session) {
+    if (session->solver.destroy) {
+        session->solver.destroy(&session->solver);
+    }
+    solver_typed_params_destroy(&session->tparams);
+    instance_destroy(&session->instance);
+    memset(session, 0, sizeof(*session));
+}
+
+bool cptp_session_update_profits(CptpSession *session, const double *profits) {
+    Instance *instance = &session->instance;
+    memcpy(instance->profits, profits,
+           (instance->num_customers + 1) * sizeof(*instance->profits));
+
+    if (!session->stale && session->solver.update_profits) {
+        if (session->solver.update_profits(&session->solver, instance)) {
+            return true;
+        }
+        log_warn("%s :: Failed to update the profits in place, the solver "
+                 "will be re-created",
+                 __func__);
+    }
+
+    session->stale = true;
+    return true;
+}
+
+SolveStatus cptp_session_solve(CptpSession *session, Solution *solution,
+                               CancellationToken *cancel) {
+    const Instance *instance = &session->instance;
+
+    if (session->stale) {
+        if (session->solver.destroy) {
+            session->solver.destroy(&session->solver);
+        }
+        session->solver =
+            session->lookup->create_fn(instance, &session->tparams,
+                                       session->timelimit, session->randomseed);
+        session->stale = false;
+    }
+
+    if (!session->solver.solve) {
+        log_fatal("%s :: Failed to create the solver", __func__);
+        // NOTE(dparo): Retry on the next solve
+        session->stale = true;
+        solution_clear(solution);
+        return SOLVE_STATUS_ERR;
+    }
+
+    // NOTE(dparo):
+    //     The columns of the previous solve were priced under the old
+    //     profits, and must not leak into the columns of this one
+    solution->columns.num_columns = 0;
+
+    SolveStatus status =
+        run_solver(&session->solver, instance, solution, cancel);
+
+    log_solve_status(status, session->lookup->descriptor->name);
+    postprocess_solver_solution(instance, status, solution);
+    return status;
+}
+
 static inline TypedParam *solver_params_get_key(SolverTypedParams *params,
                                                 char *key) {
     SolverTypedParamsEntry *entry = shgetp_null(params->entries, key);
@@ -563,28 +1192,53 @@ double solver_params_get_double(SolverTypedParams *params, char *key) {
     return p->dval;
 }
 
+const char *solver_params_get_str(SolverTypedParams *params, char *key) {
+    TypedParam *p = solver_params_get_val(params, key, TYPED_PARAM_STR);
+    return p->sval;
+}
+
+static void copy_instance_header(Instance *result, const Instance *instance) {
+    result->num_customers = instance->num_customers;
+    result->num_vehicles = instance->num_vehicles;
+    result->vehicle_cap = instance->vehicle_cap;
+    result->rounding_strat = instance->rounding_strat;
+    result->name = instance->name ? strdup(instance->name) : NULL;
+    result->comment = instance->comment ? strdup(instance->comment) : NULL;
+}
+
+static void share_dist_cache(Instance *result, const Instance *instance) {
+    if (instance->dist_cache_arena) {
+        result->dist_cache_arena = arena_retain(instance->dist_cache_arena);
+        result->dist_cache = instance->dist_cache;
+        result->dist_cache_storage = instance->dist_cache_storage;
+        result->dist_cache_scale = instance->dist_cache_scale;
+    }
+}
+
 Instance instance_copy(const Instance *instance, bool allocate,
                        bool deep_copy) {
     Instance result = {0};
     int32_t n = instance->num_customers + 1;
 
-    result.num_customers = instance->num_customers;
-    result.num_vehicles = instance->num_vehicles;
-    result.vehicle_cap = instance->vehicle_cap;
-
-    if (allocate) {
-        if (instance->edge_weight) {
-            result.edge_weight =
-                malloc(sizeof(*instance->edge_weight) * hm_nentries(n));
-        }
+    if (!allocate) {
+        result.num_customers = instance->num_customers;
+        result.num_vehicles = instance->num_vehicles;
+        result.vehicle_cap = instance->vehicle_cap;
+        result.rounding_strat = instance->rounding_strat;
+        return result;
+    }
 
-        result.profits = malloc(n * sizeof(*result.profits));
-        result.demands = malloc(n * sizeof(*result.demands));
-        result.positions = malloc(n * sizeof(*result.positions));
+    copy_instance_header(&result, instance);
 
-        result.name = strdup(instance->name);
-        result.comment = strdup(instance->comment);
+    const bool with_edge_weight = instance->edge_weight != NULL;
+    if (!alloc_geometry(&result, n, with_edge_weight,
+                        instance->edge_weight_storage) ||
+        !alloc_nodes(&result, n)) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        instance_destroy(&result);
+        return result;
     }
+    result.edge_weight_scale = instance->edge_weight_scale;
 
     if (deep_copy) {
         memcpy(result.profits, instance->profits, n * sizeof(*result.profits));
@@ -592,11 +1246,44 @@ Instance instance_copy(const Instance *instance, bool allocate,
         memcpy(result.positions, instance->positions,
                n * sizeof(*result.positions));
 
-        if (instance->edge_weight) {
+        if (with_edge_weight) {
             memcpy(result.edge_weight, instance->edge_weight,
-                   hm_nentries(n) * sizeof(*result.edge_weight));
+                   hm_nentries(n) *
+                       dist_storage_elem_size(instance->edge_weight_storage));
         }
+
+        // NOTE(dparo):
+        //     The distance cache is only carried over when the copy is a
+        //     full deep copy. An allocated but not yet filled copy must not
+        //     answer `cptp_dist` from stale data. Since the cache is
+        //     immutable it can be shared instead of copied.
+        share_dist_cache(&result, instance);
+    }
+
+    return result;
+}
+
+Instance instance_view(const Instance *instance) {
+    Instance result = {0};
+    int32_t n = instance->num_customers + 1;
+
+    copy_instance_header(&result, instance);
+
+    if (!alloc_nodes(&result, n)) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        instance_destroy(&result);
+        return result;
     }
 
+    memcpy(result.profits, instance->profits, n * sizeof(*result.profits));
+    memcpy(result.demands, instance->demands, n * sizeof(*result.demands));
+
+    result.geometry_arena = arena_retain(instance->geometry_arena);
+    result.positions = instance->positions;
+    result.edge_weight = instance->edge_weight;
+    result.edge_weight_storage = instance->edge_weight_storage;
+    result.edge_weight_scale = instance->edge_weight_scale;
+
+    share_dist_cache(&result, instance);
     return result;
 }
@@ -39,8 +39,22 @@ typedef enum DistanceRounding {
     CPTP_DIST_FLOOR = 3,
 } DistanceRounding;
 
+/// Element type used to store a triangle of distances (`edge_weight`,
+/// `dist_cache`). Use `dist_storage_load` to read an element back as double.
+typedef enum DistStorage {
+    CPTP_DIST_STORAGE_F64 = 0, /// default
+    CPTP_DIST_STORAGE_F32 = 1,
+    /// Fixed point: the stored value is `round(value * scale)` and `scale` is
+    /// a power of 10, such that the value is recovered exactly.
+    CPTP_DIST_STORAGE_I32 = 2,
+} DistStorage;
+
 #define DEPOT_NODE_ID 0
 
+/// Reference counted, cache line aligned block of memory holding some of the
+/// arrays of an `Instance`. See `instance_view`.
+typedef struct InstanceArena InstanceArena;
+
 typedef struct Instance {
     char *name;
     char *comment;
@@ -53,7 +67,46 @@ typedef struct Instance {
     Vec2d *positions;
     double *demands;
     double *profits;
-    double *edge_weight;
+
+    // NOTE(dparo):
+    //     The triangles below may be stored in a compact 32 bit form, as
+    //     described by their `*_storage` and `*_scale` fields. The `double`
+    //     pointer can be used to test for presence, but elements must be
+    //     read with `dist_storage_load` (or simply through `cptp_dist`).
+    DistStorage edge_weight_storage;
+    double edge_weight_scale;
+    union {
+        double *edge_weight;
+        float *edge_weight_f32;
+        int32_t *edge_weight_i32;
+    };
+
+    // NOTE(dparo):
+    //     Optional precomputed distances for instances without an explicit
+    //     `edge_weight` section. Same triangular `sxpos` layout as
+    //     `edge_weight`, 64-byte aligned, and already rounded according to
+    //     `rounding_strat`. Must be rebuilt if `positions` or
+    //     `rounding_strat` change after it was built.
+    DistStorage dist_cache_storage;
+    double dist_cache_scale;
+    union {
+        double *dist_cache;
+        float *dist_cache_f32;
+        int32_t *dist_cache_i32;
+    };
+
+    // NOTE(dparo):
+    //     The arrays above are not allocated individually, but carved out of
+    //     reference counted arenas, each array starting on its own cache
+    //     line:
+    //       - `geometry_arena`: `positions` and `edge_weight`. Immutable once
+    //         the instance is built, it may be shared among instances.
+    //       - `nodes_arena`: `demands` and `profits`. Always owned by this
+    //         instance, which is free to modify them.
+    //       - `dist_cache_arena`: `dist_cache`, shared like the geometry.
+    InstanceArena *geometry_arena;
+    InstanceArena *nodes_arena;
+    InstanceArena *dist_cache_arena;
 } Instance;
 
 typedef struct Tour {
@@ -63,10 +116,26 @@ typedef struct Tour {
     int32_t *comp;
 } Tour;
 
+/// Up to `capacity` distinct tours with negative reduced cost (columns),
+/// sorted by increasing reduced cost. Tours visiting the same set of nodes
+/// are the same column: only the best of them is kept.
+typedef struct ColumnPool {
+    int32_t capacity;
+    int32_t num_columns;
+    Tour *tours;
+    double *reduced_costs;
+    /// Hash of the set of nodes visited by each tour
+    uint64_t *hashes;
+} ColumnPool;
+
 typedef struct Solution {
     double primal_bound;
     double dual_bound;
     Tour tour;
+    /// Optional, disabled (zero capacity) unless `solution_reserve_columns`
+    /// is called. When enabled, the solvers fill it with the best columns
+    /// they come across, `tour` included.
+    ColumnPool columns;
 } Solution;
 
 typedef struct SolverData SolverData;
@@ -107,23 +176,94 @@ typedef enum SolveStatus {
     SOLVE_STATUS_CLOSED_PROBLEM = (1 << 1),
     SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL = (1 << 2),
     SOLVE_STATUS_ABORTION_RES_EXHAUSTED = (1 << 3),
+    // Aborted through the cancellation token (eg on SIGTERM/SIGINT)
     SOLVE_STATUS_ABORTION_SIGTERM = (1 << 4),
 } SolveStatus;
 
+/// Cooperative cancellation of one or more solves. The solvers poll the
+/// token and abort as soon as possible once it is requested. Requesting a
+/// cancellation is async-signal-safe, and a token may be shared among solves
+/// running concurrently.
+typedef struct CancellationToken {
+    // NOTE(dparo):
+    //     Plain `volatile int` since CPLEX polls it directly (see
+    //     `CPXXsetterminate`).
+    volatile int requested;
+} CancellationToken;
+
+static inline void cancellation_token_request(CancellationToken *token) {
+    token->requested = 1;
+}
+
+static inline bool cancellation_requested(const CancellationToken *token) {
+    return token->requested != 0;
+}
+
 typedef struct Solver {
     SolverData *data;
-    volatile bool sigterm_occured;
-    volatile int sigterm_occured_int;
+    /// Never NULL while solving
+    CancellationToken *cancel;
+    /// Per solve random state, seeded by the `create_fn` of the solver from
+    /// the random seed of the solve
+    Rng rng;
 
     // TODO: set_params
     bool (*set_params)(struct Solver *self, const SolverParams *params);
+    /// Optional: adapts the solver to the new profits of `instance` (the
+    /// same instance the solver was created for), such that it can be
+    /// solved again without being re-created
+    bool (*update_profits)(struct Solver *self, const Instance *instance);
     SolveStatus (*solve)(struct Solver *self, const Instance *instance,
                          Solution *solution, int64_t begin_time);
     void (*destroy)(struct Solver *self);
+
+    /// Optional, set by the caller before solving: invoked with each
+    /// feasible tour found during the solve (not necessarily improving), and
+    /// its cost. May be invoked concurrently from multiple threads.
+    void (*on_incumbent)(void *user_data, const Instance *instance,
+                         Tour *tour, double cost);
+    void *on_incumbent_user_data;
+
+    /// Optional, set by the caller before solving: returns the cost of the
+    /// best tour found so far by the solves racing alongside this one (eg
+    /// the other members of a portfolio), +INFINITY if none. The solver may
+    /// prune the part of its search which cannot improve on it. May be
+    /// invoked concurrently from multiple threads.
+    double (*shared_incumbent_cost)(void *user_data);
+    void *shared_incumbent_user_data;
 } Solver;
 
+struct SolverLookup;
+
+/// A solver kept alive across the solves of instances differing only in the
+/// profits, eg the successive pricing problems of a column generation.
+/// Solvers implementing `update_profits` apply the new profits in place,
+/// the others are re-created on the next solve.
+typedef struct CptpSession {
+    /// View of the instance given at creation, owning its own profits
+    Instance instance;
+    Solver solver;
+    SolverTypedParams tparams;
+    const struct SolverLookup *lookup;
+    double timelimit;
+    int32_t randomseed;
+    /// The solver must be re-created before the next solve
+    bool stale;
+} CptpSession;
+
 void instance_set_name(Instance *instance, const char *name);
 void instance_destroy(Instance *instance);
+/// Allocates zeroed `positions`, `demands` and `profits` arrays (and a F64
+/// `edge_weight` triangle if requested) for `num_customers + 1` nodes,
+/// replacing any previous one.
+bool instance_alloc(Instance *instance, bool with_edge_weight);
+/// Same as `instance_alloc`, with the `edge_weight` triangle (if requested)
+/// stored as `storage`. `edge_weight_scale` is reset to 1.
+bool instance_alloc_with_storage(Instance *instance, bool with_edge_weight,
+                                 DistStorage storage);
+bool instance_build_dist_cache(Instance *instance);
+void instance_drop_dist_cache(Instance *instance);
+bool instance_compact_edge_weight(Instance *instance);
 
 Tour tour_create(const Instance *instance);
 void tour_destroy(Tour *tour);
@@ -131,20 +271,80 @@ void tour_clear(Tour *tour);
 bool tour_is_valid(Tour *tour);
 Tour tour_copy(Tour const *other);
 Tour tour_move(Tour *other);
+/// Fills `out` (created with at least `num_customers + 1` bits) with the
+/// nodes labelled as component `comp`. Returns the size of the component.
+int32_t tour_comp_to_bitset(const Tour *tour, int32_t comp, Bitset *out);
 
 Solution solution_create(const Instance *instance);
 void solution_destroy(Solution *solution);
 void solution_clear(Solution *solution);
+/// Enables collecting up to `k` columns (see `ColumnPool`), dropping the
+/// current ones. `k = 0` disables the collection.
+bool solution_reserve_columns(Solution *solution, int32_t k);
+/// Offers `tour` to the column pool. The tour is copied if it is a single
+/// cycle through the depot, its reduced cost is negative, and it is better
+/// than the worst column in a full pool (or the column visiting the same
+/// nodes). Returns true if it was added.
+bool solution_add_column(Solution *solution, const Instance *instance,
+                         const Tour *tour);
+/// Same as `solution_add_column`, for a tour whose reduced cost is known
+bool solution_add_column_with_cost(Solution *solution, const Tour *tour,
+                                   double reduced_cost);
 
 void solver_typed_params_destroy(SolverTypedParams *params);
 bool resolve_params(const SolverParams *params, const SolverDescriptor *desc,
                     SolverTypedParams *out);
 
 Instance instance_copy(const Instance *instance, bool allocate, bool deep_copy);
+/// Derives a new instance sharing the (immutable) geometry, edge weights and
+/// distance cache of `instance`, in O(n). The view owns a copy of `demands`
+/// and `profits`, which can be freely modified (eg new duals), as can the
+/// scalar fields such as `vehicle_cap`. The view must be released with
+/// `instance_destroy`, and remains valid even after `instance` is destroyed.
+Instance instance_view(const Instance *instance);
 
+/// Solves the pricing problem of `instance`. The solve aborts, reporting
+/// `SOLVE_STATUS_ABORTION_SIGTERM`, once `cancel` (can be NULL) is
+/// requested. Multiple solves can run concurrently from different threads.
 SolveStatus cptp_solve(const Instance *instance, const char *solver_name,
                        const SolverParams *params, Solution *solution,
-                       double timelimit, int32_t randomseed);
+                       double timelimit, int32_t randomseed,
+                       CancellationToken *cancel);
+
+/// Returns the descriptor of the registered solver `solver_name`, or NULL
+const SolverDescriptor *cptp_find_solver_descriptor(const char *solver_name);
+
+/// Appends `NUM_THREADS=num_threads` to `params` if `solver_name` accepts a
+/// `NUM_THREADS` parameter and `params` does not set it already. The value
+/// is formatted into `buf`, which must outlive `params`. Lets the callers
+/// running several solves concurrently split the cores among them. Returns
+/// true if the parameter was appended.
+bool solver_params_default_num_threads(SolverParams *params,
+                                       const char *solver_name,
+                                       int32_t num_threads, char *buf,
+                                       size_t bufsize);
+
+/// Creates the solver `solver_name`, resolving `params` into `tparams`,
+/// which must outlive the solver (and be released with
+/// `solver_typed_params_destroy`). Returns a zeroed solver (NULL `solve`) on
+/// failure.
+Solver cptp_solver_create(const char *solver_name, const Instance *instance,
+                          const SolverParams *params,
+                          SolverTypedParams *tparams, double timelimit,
+                          int32_t randomseed);
+
+/// Unlike `cptp_solve`, the customers are not eliminated in a session,
+/// since the elimination depends on the profits.
+bool cptp_session_create(CptpSession *session, const Instance *instance,
+                         const char *solver_name, const SolverParams *params,
+                         double timelimit, int32_t randomseed);
+void cptp_session_destroy(CptpSession *session);
+/// Replaces the profits of all the `num_customers + 1` nodes
+bool cptp_session_update_profits(CptpSession *session, const double *profits);
+/// `solution` must be created from `session->instance`. The columns of the
+/// previous solve are discarded.
+SolveStatus cptp_session_solve(CptpSession *session, Solution *solution,
+                               CancellationToken *cancel);
 
 void cptp_print_list_of_solvers_and_params(void);
 
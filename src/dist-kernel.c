@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "dist-kernel.h"
+#include "core-utils.h"
+
+#include <math.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DIST_KERNEL_HAS_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define DIST_KERNEL_HAS_X86_SIMD 0
+#endif
+
+// NOTE(dparo):
+//     This translation unit is compiled with `-ffp-contract=off` (see
+//     src/CMakeLists.txt). Fusing `dx * dx + dy * dy` into an FMA would
+//     produce results that differ in the last bit from the scalar
+//     `vec2d_dist`, breaking the equivalence with `cptp_dist`.
+//
+//     Rounding follows the C `round()` semantics (half away from zero).
+//     Distances are non-negative, therefore `round(d)` is computed as
+//     `t = trunc(d); t + (d - t >= 0.5)`, which is exact since `d - t` is
+//     exactly representable.
+
+static inline double apply_rounding(double d, DistanceRounding rounding) {
+    switch (rounding) {
+    case CPTP_DIST_ROUND:
+        return round(d);
+    case CPTP_DIST_NO_ROUND:
+        return d;
+    case CPTP_DIST_CEIL:
+        return ceil(d);
+    case CPTP_DIST_FLOOR:
+        return floor(d);
+    default:
+        assert(!"Invalid code path!");
+        return INFINITY;
+    }
+}
+
+static inline void dist_row_scalar(const Vec2d *positions, int32_t i,
+                                   int32_t jbegin, int32_t jend, double *out,
+                                   DistanceRounding rounding) {
+    const Vec2d *pi = &positions[i];
+    for (int32_t j = jbegin; j < jend; j++) {
+        out[j - jbegin] = apply_rounding(vec2d_dist(pi, &positions[j]), rounding);
+    }
+}
+
+#if DIST_KERNEL_HAS_X86_SIMD
+
+#define ATTRIB_TARGET_AVX2 __attribute__((target("avx2")))
+#define ATTRIB_TARGET_AVX512 __attribute__((target("avx512f")))
+
+ATTRIB_TARGET_AVX2 static inline __m256d
+apply_rounding_avx2(__m256d d, DistanceRounding rounding) {
+    switch (rounding) {
+    case CPTP_DIST_ROUND: {
+        __m256d t = _mm256_round_pd(d, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __m256d ge_half = _mm256_cmp_pd(_mm256_sub_pd(d, t),
+                                        _mm256_set1_pd(0.5), _CMP_GE_OQ);
+        return _mm256_add_pd(t, _mm256_and_pd(ge_half, _mm256_set1_pd(1.0)));
+    }
+    case CPTP_DIST_NO_ROUND:
+        return d;
+    case CPTP_DIST_CEIL:
+        return _mm256_round_pd(d, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+    case CPTP_DIST_FLOOR:
+        return _mm256_round_pd(d, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    default:
+        assert(!"Invalid code path!");
+        return _mm256_set1_pd(INFINITY);
+    }
+}
+
+ATTRIB_TARGET_AVX2 static inline void
+dist_row_avx2(const Vec2d *positions, int32_t i, int32_t jbegin, int32_t jend,
+              double *out, DistanceRounding rounding) {
+    const __m256d xi = _mm256_set1_pd(positions[i].x);
+    const __m256d yi = _mm256_set1_pd(positions[i].y);
+
+    int32_t j = jbegin;
+    for (; j + 4 <= jend; j += 4) {
+        // a = [x0 y0 x1 y1], b = [x2 y2 x3 y3]
+        __m256d a = _mm256_loadu_pd(&positions[j].x);
+        __m256d b = _mm256_loadu_pd(&positions[j + 2].x);
+
+        // Deinterleave. Lanes are in the [0 2 1 3] order
+        __m256d xs = _mm256_unpacklo_pd(a, b);
+        __m256d ys = _mm256_unpackhi_pd(a, b);
+
+        __m256d dx = _mm256_sub_pd(xs, xi);
+        __m256d dy = _mm256_sub_pd(ys, yi);
+        __m256d sq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        __m256d d = _mm256_sqrt_pd(sq);
+
+        d = apply_rounding_avx2(d, rounding);
+
+        // Restore the [0 1 2 3] order
+        d = _mm256_permute4x64_pd(d, 0xD8);
+        _mm256_storeu_pd(&out[j - jbegin], d);
+    }
+
+    for (; j < jend; j++) {
+        out[j - jbegin] =
+            apply_rounding(vec2d_dist(&positions[i], &positions[j]), rounding);
+    }
+}
+
+ATTRIB_TARGET_AVX512 static inline __m512d
+apply_rounding_avx512(__m512d d, DistanceRounding rounding) {
+    switch (rounding) {
+    case CPTP_DIST_ROUND: {
+        __m512d t =
+            _mm512_roundscale_pd(d, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __mmask8 ge_half = _mm512_cmp_pd_mask(_mm512_sub_pd(d, t),
+                                              _mm512_set1_pd(0.5), _CMP_GE_OQ);
+        return _mm512_mask_add_pd(t, ge_half, t, _mm512_set1_pd(1.0));
+    }
+    case CPTP_DIST_NO_ROUND:
+        return d;
+    case CPTP_DIST_CEIL:
+        return _mm512_roundscale_pd(d, _MM_FROUND_TO_POS_INF |
+                                           _MM_FROUND_NO_EXC);
+    case CPTP_DIST_FLOOR:
+        return _mm512_roundscale_pd(d, _MM_FROUND_TO_NEG_INF |
+                                           _MM_FROUND_NO_EXC);
+    default:
+        assert(!"Invalid code path!");
+        return _mm512_set1_pd(INFINITY);
+    }
+}
+
+ATTRIB_TARGET_AVX512 static inline void
+dist_row_avx512(const Vec2d *positions, int32_t i, int32_t jbegin,
+                int32_t jend, double *out, DistanceRounding rounding) {
+    const __m512d xi = _mm512_set1_pd(positions[i].x);
+    const __m512d yi = _mm512_set1_pd(positions[i].y);
+    const __m512i xidx = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i yidx = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+
+    int32_t j = jbegin;
+    for (; j + 8 <= jend; j += 8) {
+        __m512d a = _mm512_loadu_pd(&positions[j].x);
+        __m512d b = _mm512_loadu_pd(&positions[j + 4].x);
+
+        __m512d xs = _mm512_permutex2var_pd(a, xidx, b);
+        __m512d ys = _mm512_permutex2var_pd(a, yidx, b);
+
+        __m512d dx = _mm512_sub_pd(xs, xi);
+        __m512d dy = _mm512_sub_pd(ys, yi);
+        __m512d sq = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+        __m512d d = _mm512_sqrt_pd(sq);
+
+        _mm512_storeu_pd(&out[j - jbegin], apply_rounding_avx512(d, rounding));
+    }
+
+    for (; j < jend; j++) {
+        out[j - jbegin] =
+            apply_rounding(vec2d_dist(&positions[i], &positions[j]), rounding);
+    }
+}
+
+#endif
+
+//
+// Instantiate one kernel for each (isa, rounding) pair, such that the
+// rounding switch is resolved at compile time inside the hot loops
+//
+
+#define DEFINE_DIST_ROW_KERNEL(ATTRIB, NAME, IMPL, ROUNDING)                  \
+    ATTRIB static void NAME(const Vec2d *positions, int32_t i,               \
+                            int32_t jbegin, int32_t jend, double *out) {     \
+        IMPL(positions, i, jbegin, jend, out, ROUNDING);                     \
+    }
+
+#define DEFINE_DIST_ROW_KERNELS(ATTRIB, ISA, IMPL)                            \
+    DEFINE_DIST_ROW_KERNEL(ATTRIB, dist_row_##ISA##_round, IMPL,              \
+                           CPTP_DIST_ROUND)                                   \
+    DEFINE_DIST_ROW_KERNEL(ATTRIB, dist_row_##ISA##_no_round, IMPL,           \
+                           CPTP_DIST_NO_ROUND)                                \
+    DEFINE_DIST_ROW_KERNEL(ATTRIB, dist_row_##ISA##_ceil, IMPL,               \
+                           CPTP_DIST_CEIL)                                    \
+    DEFINE_DIST_ROW_KERNEL(ATTRIB, dist_row_##ISA##_floor, IMPL,              \
+                           CPTP_DIST_FLOOR)                                   \
+    static const DistRowKernel DIST_ROW_KERNELS_##ISA[] = {                  \
+        [CPTP_DIST_ROUND] = dist_row_##ISA##_round,                           \
+        [CPTP_DIST_NO_ROUND] = dist_row_##ISA##_no_round,                     \
+        [CPTP_DIST_CEIL] = dist_row_##ISA##_ceil,                             \
+        [CPTP_DIST_FLOOR] = dist_row_##ISA##_floor,                           \
+    };
+
+DEFINE_DIST_ROW_KERNELS(, scalar, dist_row_scalar)
+
+#if DIST_KERNEL_HAS_X86_SIMD
+DEFINE_DIST_ROW_KERNELS(ATTRIB_TARGET_AVX2, avx2, dist_row_avx2)
+DEFINE_DIST_ROW_KERNELS(ATTRIB_TARGET_AVX512, avx512, dist_row_avx512)
+#endif
+
+static bool isa_supported(DistKernelIsa isa) {
+    switch (isa) {
+    case DIST_KERNEL_ISA_SCALAR:
+        return true;
+#if DIST_KERNEL_HAS_X86_SIMD
+    case DIST_KERNEL_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case DIST_KERNEL_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+DistKernelIsa dist_kernel_best_isa(void) {
+    // NOTE(dparo):
+    //     Racing threads can only ever store the same value, therefore a
+    //     relaxed atomic is enough to cache the detection.
+    static _Atomic int32_t cached_isa = -1;
+
+    int32_t result = atomic_load_explicit(&cached_isa, memory_order_relaxed);
+    if (result < 0) {
+        DistKernelIsa isa = DIST_KERNEL_ISA_SCALAR;
+        if (isa_supported(DIST_KERNEL_ISA_AVX512)) {
+            isa = DIST_KERNEL_ISA_AVX512;
+        } else if (isa_supported(DIST_KERNEL_ISA_AVX2)) {
+            isa = DIST_KERNEL_ISA_AVX2;
+        }
+        log_trace("%s :: Selected `%s` distance kernels", __func__,
+                  dist_kernel_isa_name(isa));
+        atomic_store_explicit(&cached_isa, isa, memory_order_relaxed);
+        result = isa;
+    }
+    return (DistKernelIsa)result;
+}
+
+const char *dist_kernel_isa_name(DistKernelIsa isa) {
+    switch (isa) {
+    case DIST_KERNEL_ISA_SCALAR:
+        return "scalar";
+    case DIST_KERNEL_ISA_AVX2:
+        return "avx2";
+    case DIST_KERNEL_ISA_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+DistRowKernel dist_row_kernel_for_isa(DistKernelIsa isa,
+                                      DistanceRounding rounding) {
+    if (rounding < CPTP_DIST_ROUND || rounding > CPTP_DIST_FLOOR) {
+        assert(!"Invalid rounding strategy");
+        return NULL;
+    }
+
+    if (!isa_supported(isa)) {
+        return NULL;
+    }
+
+    switch (isa) {
+    case DIST_KERNEL_ISA_SCALAR:
+        return DIST_ROW_KERNELS_scalar[rounding];
+#if DIST_KERNEL_HAS_X86_SIMD
+    case DIST_KERNEL_ISA_AVX2:
+        return DIST_ROW_KERNELS_avx2[rounding];
+    case DIST_KERNEL_ISA_AVX512:
+        return DIST_ROW_KERNELS_avx512[rounding];
+#endif
+    default:
+        return NULL;
+    }
+}
+
+void dist_block(const Instance *instance, int32_t ibegin, int32_t iend,
+                int32_t jbegin, int32_t jend, double *out, int64_t ld) {
+    assert(ld >= jend - jbegin);
+
+    if (instance->edge_weight || !instance->positions) {
+        for (int32_t i = ibegin; i < iend; i++) {
+            double *row = out + (i - ibegin) * ld;
+            for (int32_t j = jbegin; j < jend; j++) {
+                row[j - jbegin] = i == j ? 0.0 : cptp_dist(instance, i, j);
+            }
+        }
+    } else {
+        DistRowKernel kernel = dist_row_kernel(instance->rounding_strat);
+        for (int32_t i = ibegin; i < iend; i++) {
+            kernel(instance->positions, i, jbegin, jend,
+                   out + (i - ibegin) * ld);
+        }
+    }
+}
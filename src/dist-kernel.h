@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+typedef enum DistKernelIsa {
+    DIST_KERNEL_ISA_SCALAR = 0,
+    DIST_KERNEL_ISA_AVX2 = 1,
+    DIST_KERNEL_ISA_AVX512 = 2,
+} DistKernelIsa;
+
+/// Computes `out[j - jbegin] = dist(positions[i], positions[j])` for every
+/// `j` in `[jbegin, jend)`, rounded according to the `DistanceRounding` the
+/// kernel was resolved for. The results are bit-by-bit identical to the
+/// ones computed by `cptp_dist` on an instance without `edge_weight`.
+typedef void (*DistRowKernel)(const Vec2d *positions, int32_t i,
+                              int32_t jbegin, int32_t jend, double *out);
+
+/// Returns the best instruction set supported by the running CPU. The
+/// detection is performed once and then cached.
+DistKernelIsa dist_kernel_best_isa(void);
+const char *dist_kernel_isa_name(DistKernelIsa isa);
+
+/// Resolves the kernel for the given rounding strategy and instruction set.
+/// Returns NULL if the instruction set is not supported by the running CPU
+/// or was not compiled in.
+DistRowKernel dist_row_kernel_for_isa(DistKernelIsa isa,
+                                      DistanceRounding rounding);
+
+/// Resolves the fastest kernel available for the given rounding strategy.
+/// Callers are expected to resolve the kernel once per instance and then
+/// invoke it in their loops.
+static inline DistRowKernel dist_row_kernel(DistanceRounding rounding) {
+    return dist_row_kernel_for_isa(dist_kernel_best_isa(), rounding);
+}
+
+/// Computes a block of distances: row `r` of `out` (with stride `ld`) holds
+/// the distances from node `ibegin + r` to the nodes `[jbegin, jend)`.
+void dist_block(const Instance *instance, int32_t ibegin, int32_t iend,
+                int32_t jbegin, int32_t jend, double *out, int64_t ld);
+
+#if __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "edge-graph.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "core-utils.h"
+
+typedef struct {
+    double m1, m2;
+    int32_t arg_m1;
+} NodeRcBound;
+
+/// The two smallest reduced costs among the edges incident to each node.
+static void compute_node_bounds(const Instance *instance, NodeRcBound *b) {
+    const int32_t n = instance->num_customers + 1;
+
+    for (int32_t i = 0; i < n; i++) {
+        b[i].m1 = INFINITY;
+        b[i].m2 = INFINITY;
+        b[i].arg_m1 = -1;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            double rc = cptp_reduced_cost(instance, i, j);
+            int32_t ends[2] = {i, j};
+            int32_t others[2] = {j, i};
+            for (int32_t e = 0; e < 2; e++) {
+                NodeRcBound *nb = &b[ends[e]];
+                if (rc < nb->m1) {
+                    nb->m2 = nb->m1;
+                    nb->m1 = rc;
+                    nb->arg_m1 = others[e];
+                } else if (rc < nb->m2) {
+                    nb->m2 = rc;
+                }
+            }
+        }
+    }
+}
+
+static inline double node_contribution(const NodeRcBound *b, int32_t i) {
+    double c = 0.5 * (b[i].m1 + b[i].m2);
+    // NOTE(dparo): The depot is always visited, customers only if convenient
+    return i == DEPOT_NODE_ID ? c : MIN(0.0, c);
+}
+
+static inline bool exceeds_cutoff(double value, double cutoff) {
+    return value - cutoff > COST_TOLERANCE * (1.0 + fabs(cutoff));
+}
+
+/// Marks in `keep` (one bit per `sxpos` entry) the surviving edges.
+static int64_t mark_surviving_edges(const Instance *instance,
+                                    const EdgeEliminationParams *params,
+                                    const NodeRcBound *b, double base,
+                                    Bitset *keep) {
+    const int32_t n = instance->num_customers + 1;
+    const double Q = instance->vehicle_cap;
+    int64_t num_edges = 0;
+
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            if (instance->demands[i] + instance->demands[j] > Q) {
+                continue;
+            }
+
+            if (params && b) {
+                // Lower bound of a tour using (i, j): both endpoints are
+                // visited, and pay half of (i, j) plus half of their best
+                // other incident edge
+                double rc = cptp_reduced_cost(instance, i, j);
+                double oi = b[i].arg_m1 == j ? b[i].m2 : b[i].m1;
+                double oj = b[j].arg_m1 == i ? b[j].m2 : b[j].m1;
+                double lb = base - node_contribution(b, i) -
+                            node_contribution(b, j) + 0.5 * (rc + oi) +
+                            0.5 * (rc + oj);
+                if (exceeds_cutoff(lb, params->cutoff)) {
+                    continue;
+                }
+            }
+
+            if (params && params->lp_reduced_costs) {
+                double lp_rc = params->lp_reduced_costs[sxpos(n, i, j)];
+                if (exceeds_cutoff(params->lp_obj + lp_rc, params->cutoff)) {
+                    continue;
+                }
+            }
+
+            bitset_set(keep, sxpos(n, i, j));
+            ++num_edges;
+        }
+    }
+
+    return num_edges;
+}
+
+EdgeGraph edge_graph_create(const Instance *instance,
+                            const EdgeEliminationParams *params) {
+    EdgeGraph graph = {0};
+    const int32_t n = instance->num_customers + 1;
+    NodeRcBound *b = NULL;
+    Bitset keep = bitset_create(hm_nentries(n));
+    int64_t *fill = NULL;
+
+    if (!keep.words) {
+        goto fail;
+    }
+
+    double base = 0.0;
+    if (params && params->cutoff < INFINITY && n >= 3) {
+        b = malloc(n * sizeof(*b));
+        if (!b) {
+            goto fail;
+        }
+        compute_node_bounds(instance, b);
+        for (int32_t i = 0; i < n; i++) {
+            base += node_contribution(b, i);
+        }
+    }
+
+    graph.num_nodes = n;
+    graph.num_edges = mark_surviving_edges(instance, params, b, base, &keep);
+    graph.offsets = calloc(n + 1, sizeof(*graph.offsets));
+    graph.adj = malloc(MAX(1, 2 * graph.num_edges) * sizeof(*graph.adj));
+    fill = malloc(n * sizeof(*fill));
+
+    if (!graph.offsets || !graph.adj || !fill) {
+        goto fail;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            if (bitset_test(&keep, sxpos(n, i, j))) {
+                ++graph.offsets[i + 1];
+                ++graph.offsets[j + 1];
+            }
+        }
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        graph.offsets[i + 1] += graph.offsets[i];
+        fill[i] = graph.offsets[i];
+    }
+
+    // NOTE(dparo): Visiting the pairs by increasing (i, j) appends the
+    //     neighbors of each row already sorted
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            if (bitset_test(&keep, sxpos(n, i, j))) {
+                graph.adj[fill[i]++] = j;
+                graph.adj[fill[j]++] = i;
+            }
+        }
+    }
+
+    assert(graph.offsets[n] == 2 * graph.num_edges);
+
+    log_info("%s :: Kept %lld out of %lld edges", __func__,
+             (long long)graph.num_edges, (long long)hm_nentries(n));
+
+    free(fill);
+    free(b);
+    bitset_destroy(&keep);
+    return graph;
+
+fail:
+    log_fatal("%s :: Failed memory allocation", __func__);
+    free(fill);
+    free(b);
+    bitset_destroy(&keep);
+    edge_graph_destroy(&graph);
+    return graph;
+}
+
+void edge_graph_destroy(EdgeGraph *graph) {
+    free(graph->offsets);
+    free(graph->adj);
+    memset(graph, 0, sizeof(*graph));
+}
+
+bool edge_graph_contains(const EdgeGraph *graph, int32_t i, int32_t j) {
+    const int32_t *nbrs = edge_graph_neighbors(graph, i);
+    int32_t lo = 0, hi = edge_graph_degree(graph, i);
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (nbrs[mid] < j) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < edge_graph_degree(graph, i) && nbrs[lo] == j;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+/// Undirected graph over the nodes of an instance, stored in CSR form: the
+/// neighbors of node `i` are `adj[offsets[i]] ... adj[offsets[i + 1] - 1]`,
+/// sorted by increasing index. Every edge appears in the rows of both of its
+/// endpoints.
+typedef struct EdgeGraph {
+    int32_t num_nodes;
+    int64_t num_edges;
+    int64_t *offsets;
+    int32_t *adj;
+} EdgeGraph;
+
+typedef struct EdgeEliminationParams {
+    /// Edges which cannot be part of any tour of cost lower than `cutoff`
+    /// (eg the cost of a known primal tour) are removed. INFINITY disables
+    /// the reduced cost test.
+    double cutoff;
+    /// Optional LP reduced costs of the edges (in `sxpos` order), together
+    /// with the objective value of the LP they were taken from.
+    const double *lp_reduced_costs;
+    double lp_obj;
+} EdgeEliminationParams;
+
+/// Builds the graph of the edges of `instance` which may appear in an
+/// improving tour. An edge `(i, j)` is removed if:
+///   - `demands[i] + demands[j] > vehicle_cap`, or
+///   - a lower bound on the cost of the tours using it exceeds
+///     `params->cutoff`. The bound is the degree 2 relaxation in reduced
+///     cost terms: each visited node pays half of its two incident edges.
+///   - `lp_obj` plus the LP reduced cost of the edge exceeds the cutoff.
+/// `params` may be NULL, in which case only the demand test is applied.
+/// Returns a zeroed graph on failure.
+EdgeGraph edge_graph_create(const Instance *instance,
+                            const EdgeEliminationParams *params);
+void edge_graph_destroy(EdgeGraph *graph);
+bool edge_graph_contains(const EdgeGraph *graph, int32_t i, int32_t j);
+
+static inline int32_t edge_graph_degree(const EdgeGraph *graph, int32_t i) {
+    assert(i >= 0 && i < graph->num_nodes);
+    return (int32_t)(graph->offsets[i + 1] - graph->offsets[i]);
+}
+
+static inline const int32_t *edge_graph_neighbors(const EdgeGraph *graph,
+                                                  int32_t i) {
+    assert(i >= 0 && i < graph->num_nodes);
+    return &graph->adj[graph->offsets[i]];
+}
+
+#if __cplusplus
+}
+#endif
@@ -22,6 +22,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
 
 #include "misc.h"
 #include "core-utils.h"
@@ -31,11 +34,16 @@
 #include "types.h"
 #include "version.h"
 #include "render.h"
+#include "report.h"
+#include "batch.h"
+#include "serve.h"
+#include "parsing-utils.h"
 
 #include <argtable3.h>
 #include <cJSON.h>
 #include <log.h>
 #include <sha256.h>
+#include <stb_ds.h>
 
 #define DEFAULT_TIME_LIMIT ((double)600.0) // 10 minutes
 
@@ -74,6 +82,26 @@ make_solver_params_from_cmdline(const char **defines, int32_t num_defines) {
     return result;
 }
 
+/// Shared by all the solves of the process, requested on SIGTERM/SIGINT
+static CancellationToken G_cancel;
+
+/// \brief Consumes the signal and does not propagate it further
+static void cptp_sighandler(int signum) {
+    switch (signum) {
+    case SIGINT:
+        log_warn("Received SIGINT");
+        break;
+    case SIGTERM:
+        log_warn("Received SIGTERM");
+        break;
+    default:
+        break;
+    }
+    if (signum == SIGTERM || signum == SIGINT) {
+        cancellation_token_request(&G_cancel);
+    }
+}
+
 typedef struct {
     int32_t loglvl;
     bool treat_sigterm_as_failure;
@@ -85,24 +113,24 @@ typedef struct {
     int32_t num_defines;
     const char *vis_path;
     const char *json_report_path;
+    const char *batch_path;
+    int32_t num_workers;
+    int32_t num_columns;
+    bool serve;
+    const char *socket_path;
+    const char *shm_name;
 } AppCtx;
 
-typedef struct {
-    time_t started;
-    time_t ended;
-    int64_t took_usecs;
-} Timing;
-
-static void writeout_results(FILE *fh, AppCtx *ctx, bool success,
-                             Instance *instance, Solution *solution,
-                             SolveStatus status, Timing timing) {
+static void writeout_results(FILE *fh, const CptpJob *job, bool success,
+                             const Instance *instance, Solution *solution,
+                             SolveStatus status, SolveTiming timing) {
     bool primal_sol_avail = BOOL(status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL);
     bool valid = status != 0 && !BOOL(status & SOLVE_STATUS_ERR);
 
-    fprintf(fh, "%-16s %s\n", "SOLVER:", ctx->solver);
-    fprintf(fh, "%-16s %f\n", "TIMELIM:", ctx->timelimit);
-    fprintf(fh, "%-16s %d\n", "SEED:", ctx->randomseed);
-    fprintf(fh, "%-16s %s\n", "INPUT:", ctx->instance_filepath);
+    fprintf(fh, "%-16s %s\n", "SOLVER:", job->solver_name);
+    fprintf(fh, "%-16s %f\n", "TIMELIM:", job->timelimit);
+    fprintf(fh, "%-16s %d\n", "SEED:", job->randomseed);
+    fprintf(fh, "%-16s %s\n", "INPUT:", job->instance_filepath);
     fprintf(fh, "%-16s %.17g\n", "VEHICLE_CAP:", instance->vehicle_cap);
 
     fprintf(fh, "%-16s 0x%x\n", "STATUS:", status);
@@ -128,6 +156,10 @@ static void writeout_results(FILE *fh, AppCtx *ctx, bool success,
                demand / instance->vehicle_cap * 100.0);
     }
 
+    if (solution->columns.capacity > 0) {
+        printf("%-16s %d\n", "COLUMNS:", solution->columns.num_columns);
+    }
+
     printf("%-16s %s", "STARTED:", ctime(&timing.started));
     printf("%-16s %s", "ENDED:", ctime(&timing.ended));
     printf("%-16s ", "TOOK:");
@@ -139,236 +171,345 @@ static void writeout_results(FILE *fh, AppCtx *ctx, bool success,
     printf("%-16s %s\n", "SUCCESS", success ? "TRUE" : "FALSE");
 }
 
-static void writeout_json_report(AppCtx *ctx, Instance *instance,
-                                 Solution *solution, SolveStatus status,
-                                 Timing timing) {
-    if (!ctx->json_report_path) {
-        return;
+static bool is_job_successfull(const AppCtx *ctx, SolveStatus status) {
+    bool success = status != 0 && !BOOL(status & SOLVE_STATUS_ERR);
+    if (ctx->treat_sigterm_as_failure &&
+        BOOL(status & SOLVE_STATUS_ABORTION_SIGTERM)) {
+        success = false;
     }
+    return success;
+}
 
-    cJSON *root = NULL;
-    FILE *fh = fopen(ctx->json_report_path, "w");
-    if (!fh) {
-        log_fatal("%s: failed to open file for writing JSON report",
-                  ctx->json_report_path);
-        goto cleanup;
+static Instance parse_instance_arg(const char *filepath) {
+    // NOTE(dparo): `-` reads the instance from stdin, eg through a pipe
+    if (0 == strcmp(filepath, "-")) {
+        return parse_fd(STDIN_FILENO, "stdin");
     }
+    return parse(filepath);
+}
 
-    root = cJSON_CreateObject();
-    if (!root) {
-        log_fatal("%s :: Failed to create JSON root object", __func__);
-        goto cleanup;
-    }
+static int main2(AppCtx *ctx) {
+    Instance instance = parse_instance_arg(ctx->instance_filepath);
+    if (is_valid_instance(&instance)) {
+        SolverParams params =
+            make_solver_params_from_cmdline(ctx->defines, ctx->num_defines);
+        Solution solution = solution_create(&instance);
+        solution_reserve_columns(&solution, ctx->num_columns);
+
+        CptpJob job = {.instance_filepath = ctx->instance_filepath,
+                       .solver_name = ctx->solver ? ctx->solver : "mip",
+                       .params = &params,
+                       .defines = ctx->defines,
+                       .num_defines = ctx->num_defines,
+                       .timelimit = ctx->timelimit,
+                       .randomseed = ctx->randomseed,
+                       .num_columns = ctx->num_columns,
+                       .json_report_path = ctx->json_report_path};
 
-    bool primal_sol_avail = BOOL(status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL);
-    bool valid = status != 0 && !BOOL(status & SOLVE_STATUS_ERR);
-    bool sigterm_abortion = BOOL(status & SOLVE_STATUS_ABORTION_SIGTERM);
-    bool res_exhaustion_abortion =
-        BOOL(status & SOLVE_STATUS_ABORTION_RES_EXHAUSTED);
-    bool closed_problem = BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM);
-
-    bool s = true;
-    s &= cJSON_AddItemToObject(root, "solverName",
-                               cJSON_CreateString(ctx->solver));
-    s &= cJSON_AddItemToObject(root, "timeLimit",
-                               cJSON_CreateNumber(ctx->timelimit));
-    s &= cJSON_AddItemToObject(root, "randomSeed",
-                               cJSON_CreateNumber(ctx->randomseed));
-    s &= cJSON_AddItemToObject(
-        root, "cmdLineDefines",
-        cJSON_CreateStringArray(ctx->defines, ctx->num_defines));
-    s &= cJSON_AddItemToObject(root, "inputFile",
-                               cJSON_CreateString(ctx->instance_filepath));
-
-    cJSON *instance_info_obj = cJSON_CreateObject();
-    s &= cJSON_AddItemToObject(root, "instanceInfo", instance_info_obj);
-    {
-        s &= cJSON_AddItemToObject(
-            instance_info_obj, "name",
-            cJSON_CreateString(instance->name ? instance->name : ""));
-        s &= cJSON_AddItemToObject(
-            instance_info_obj, "comment",
-            cJSON_CreateString(instance->comment ? instance->comment : ""));
-        s &= cJSON_AddItemToObject(instance_info_obj, "vehicleCap",
-                                   cJSON_CreateNumber(instance->vehicle_cap));
-        s &= cJSON_AddItemToObject(instance_info_obj, "numCustomers",
-                                   cJSON_CreateNumber(instance->num_customers));
-        s &= cJSON_AddItemToObject(instance_info_obj, "numVehicles",
-                                   cJSON_CreateNumber(instance->num_vehicles));
-    }
-
-    cJSON *status_obj = cJSON_CreateObject();
-    s &= cJSON_AddItemToObject(root, "solveStatus", status_obj);
-    {
-        s &= cJSON_AddItemToObject(status_obj, "code",
-                                   cJSON_CreateNumber(status));
+        bool success = true;
 
-        s &= cJSON_AddItemToObject(
-            status_obj, "erroredOut",
-            cJSON_CreateBool(BOOL(status & SOLVE_STATUS_ERR)));
+        // Solve, timing and printing of final solution
+        {
+            SolveTiming timing;
+            timing.started = time(NULL);
 
-        s &= cJSON_AddItemToObject(status_obj, "containsPrimalSolution",
-                                   cJSON_CreateBool(primal_sol_avail));
+            int64_t begin_solve_time = os_get_usecs();
+            SolveStatus status =
+                cptp_solve(&instance, job.solver_name, &params, &solution,
+                           job.timelimit, job.randomseed, &G_cancel);
 
-        s &= cJSON_AddItemToObject(status_obj, "closedProblem",
-                                   cJSON_CreateBool(closed_problem));
+            timing.ended = time(NULL);
+            timing.took_usecs = os_get_usecs() - begin_solve_time;
 
-        s &= cJSON_AddItemToObject(status_obj, "resExhaustionAbortion",
-                                   cJSON_CreateBool(res_exhaustion_abortion));
+            success = is_job_successfull(ctx, status);
 
-        s &= cJSON_AddItemToObject(status_obj, "sigTermAbortion",
-                                   cJSON_CreateBool(sigterm_abortion));
-    }
+            printf("\n\n###\n###\n###\n\n");
+            writeout_results(stdout, &job, success, &instance, &solution,
+                             status, timing);
 
-    cJSON *timing_obj = cJSON_CreateObject();
-    s &= cJSON_AddItemToObject(root, "timingInfo", timing_obj);
-    {
-        enum {
-            TIMEREPR_LEN = 4096,
-        };
+            if (success) {
+                if (job.json_report_path) {
+                    SolveReport report = {
+                        .solver_name = job.solver_name,
+                        .timelimit = job.timelimit,
+                        .randomseed = job.randomseed,
+                        .defines = job.defines,
+                        .num_defines = job.num_defines,
+                        .instance_filepath = job.instance_filepath,
+                        .instance = &instance,
+                        .solution = &solution,
+                        .status = status,
+                        .timing = timing,
+                    };
+                    write_json_report(job.json_report_path, &report);
+                }
 
-        char timerepr_str[TIMEREPR_LEN];
-        TimeRepr timerepr = timerepr_from_usecs(timing.took_usecs);
-        timerepr_to_string(&timerepr, timerepr_str, ARRAY_LEN(timerepr_str));
+                if (ctx->vis_path) {
+                    render_tour_image(ctx->vis_path, &instance, &solution.tour,
+                                      NULL);
+                }
+            }
+        }
 
-        s &= cJSON_AddItemToObject(
-            timing_obj, "took",
-            cJSON_CreateNumber((double)timing.took_usecs * USECS_TO_SECS));
-        s &= cJSON_AddItemToObject(timing_obj, "tookRepr",
-                                   cJSON_CreateString(timerepr_str));
+        instance_destroy(&instance);
+        solution_destroy(&solution);
 
-        char *time = ctime(&timing.started);
-        // Remove newline introduced from ctime
-        time[strlen(time) - 1] = 0;
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } else {
+        fprintf(stderr, "%s: Failed to parse file\n", ctx->instance_filepath);
+        return EXIT_FAILURE;
+    }
+}
 
-        s &= cJSON_AddItemToObject(timing_obj, "started",
-                                   cJSON_CreateString(time));
+typedef struct {
+    const AppCtx *ctx;
+    int32_t num_done;
+    int32_t num_jobs;
+    int32_t num_failed;
+} BatchProgress;
+
+static void on_batch_job_done(const CptpJob *job, const CptpJobResult *result,
+                              const Instance *instance, Solution *solution,
+                              void *user_data) {
+    BatchProgress *progress = user_data;
+    bool success = result->parsed &&
+                   is_job_successfull(progress->ctx, result->status);
+
+    ++progress->num_done;
+    if (!success) {
+        ++progress->num_failed;
+    }
 
-        time = ctime(&timing.ended);
-        // Remove newline introduced from ctime
-        time[strlen(time) - 1] = 0;
-        s &= cJSON_AddItemToObject(timing_obj, "ended",
-                                   cJSON_CreateString(time));
+    printf("\n\n### [%d/%d]\n###\n###\n\n", progress->num_done,
+           progress->num_jobs);
+    if (instance) {
+        writeout_results(stdout, job, success, instance, solution,
+                         result->status, result->timing);
+    } else {
+        printf("%-16s %s\n", "INPUT:", job->instance_filepath);
+        printf("%-16s Failed to parse file\n", "ERR:");
     }
+    fflush(stdout);
+}
 
-    cJSON *bounds_obj = cJSON_CreateObject();
-    s &= cJSON_AddItemToObject(root, "bounds", bounds_obj);
-    {
+static int cmp_strings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool is_instance_file(const char *filepath) {
+    const char *ext = os_get_fext(filepath);
+    return ext &&
+           (0 == strcmp(ext, "vrp") || 0 == strcmp(ext, "simplified-vrp"));
+}
 
-        s &= cJSON_AddItemToObject(bounds_obj, "dual",
-                                   cJSON_CreateNumber(solution->dual_bound));
+static bool append_batch_job(CptpJob **jobs, const AppCtx *ctx,
+                             const char *filepath, const char *solver,
+                             int32_t randomseed) {
+    CptpJob job = {.instance_filepath = strdup(filepath),
+                   .solver_name = strdup(solver),
+                   .defines = ctx->defines,
+                   .num_defines = ctx->num_defines,
+                   .timelimit = ctx->timelimit,
+                   .randomseed = randomseed,
+                   .num_columns = ctx->num_columns};
+
+    if (!job.instance_filepath || !job.solver_name) {
+        free((char *)job.instance_filepath);
+        free((char *)job.solver_name);
+        return false;
+    }
 
-        s &= cJSON_AddItemToObject(bounds_obj, "primal",
-                                   cJSON_CreateNumber(solution->primal_bound));
+    arrpush(*jobs, job);
+    return true;
+}
 
-        s &= cJSON_AddItemToObject(
-            bounds_obj, "gap", cJSON_CreateNumber(solution_relgap(solution)));
+/// Lists the instance files (sorted by name) contained in the directory
+/// `dirpath`. One job per instance is generated, using the solver and seed
+/// given from the command line.
+static bool collect_batch_jobs_from_dir(CptpJob **jobs, const AppCtx *ctx,
+                                        const char *dirpath) {
+    bool result = false;
+    char **filepaths = NULL;
+    DIR *dir = opendir(dirpath);
+
+    if (!dir) {
+        fprintf(stderr, "%s: Failed to open directory\n", dirpath);
+        goto terminate;
     }
 
-    if (primal_sol_avail) {
-        cJSON *tour_info_obj = cJSON_CreateObject();
-        s &= cJSON_AddItemToObject(root, "tourInfo", tour_info_obj);
-        {
-            double cost = tour_eval(instance, &solution->tour);
-            double profit = tour_profit(instance, &solution->tour);
-            double demand = tour_demand(instance, &solution->tour);
-
-            s &= cJSON_AddItemToObject(tour_info_obj, "cost",
-                                       cJSON_CreateNumber(cost));
-            s &= cJSON_AddItemToObject(tour_info_obj, "profit",
-                                       cJSON_CreateNumber(profit));
-            s &= cJSON_AddItemToObject(tour_info_obj, "demand",
-                                       cJSON_CreateNumber(demand));
-
-            cJSON *route_array = cJSON_CreateArray();
-            int32_t curr_vertex = 0;
-            int32_t next_vertex = curr_vertex;
-            do {
-                next_vertex = *tsucc(&solution->tour, curr_vertex);
-                cJSON_AddItemToArray(route_array,
-                                     cJSON_CreateNumber(curr_vertex));
-
-                curr_vertex = next_vertex;
-            } while (curr_vertex != 0);
-            s &= cJSON_AddItemToObject(tour_info_obj, "route", route_array);
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (!is_instance_file(entry->d_name)) {
+            continue;
         }
-    }
 
-    cJSON *constants_obj = cJSON_CreateObject();
-    s &= cJSON_AddItemToObject(root, "constants", constants_obj);
-    {
-        s &= cJSON_AddItemToObject(constants_obj, "COST_TOLERANCE",
-                                   cJSON_CreateNumber(COST_TOLERANCE));
+        char filepath[OS_MAX_PATH];
+        snprintf(filepath, ARRAY_LEN(filepath), "%s/%s", dirpath,
+                 entry->d_name);
+        if (os_fexists(filepath)) {
+            arrpush(filepaths, strdup(filepath));
+        }
     }
 
-    if (!s) {
-        log_fatal("%s :: Failed to add all the necessary JSON elements to the "
-                  "parent JSON root object",
-                  __func__);
-        goto cleanup;
+    if (arrlen(filepaths) > 0) {
+        qsort(filepaths, arrlen(filepaths), sizeof(*filepaths), cmp_strings);
     }
 
-    char *content = cJSON_Print(root);
-    fprintf(fh, "%s", content);
-    free(content);
+    result = true;
+    for (int32_t i = 0; result && i < arrlen(filepaths); i++) {
+        result &= filepaths[i] && append_batch_job(jobs, ctx, filepaths[i],
+                                                   ctx->solver,
+                                                   ctx->randomseed);
+    }
 
-cleanup:
-    if (root)
-        cJSON_Delete(root);
-    if (fh)
-        fclose(fh);
+terminate:
+    for (int32_t i = 0; i < arrlen(filepaths); i++) {
+        free(filepaths[i]);
+    }
+    arrfree(filepaths);
+    if (dir) {
+        closedir(dir);
+    }
+    return result;
 }
 
-static int main2(AppCtx *ctx) {
-    Instance instance = parse(ctx->instance_filepath);
-    if (is_valid_instance(&instance)) {
-        SolverParams params =
-            make_solver_params_from_cmdline(ctx->defines, ctx->num_defines);
-        Solution solution = solution_create(&instance);
+/// Reads a list of jobs, one per line, in the form
+///     <INSTANCE_FILEPATH> [SOLVER [SEED]]
+/// where the omitted fields default to the ones given from the command line.
+/// Empty lines and lines starting with `#` are skipped.
+static bool collect_batch_jobs_from_list(CptpJob **jobs, const AppCtx *ctx,
+                                         const char *listpath) {
+    bool result = true;
+    FILE *fh = fopen(listpath, "r");
+    if (!fh) {
+        fprintf(stderr, "%s: Failed to open file\n", listpath);
+        return false;
+    }
 
-        bool success = true;
+    char line[OS_MAX_PATH + 256];
+    int32_t lineno = 0;
 
-        // Solve, timing and printing of final solution
-        {
-            Timing timing;
-            timing.started = time(NULL);
+    while (result && fgets(line, ARRAY_LEN(line), fh)) {
+        ++lineno;
+        char *saveptr = NULL;
+        char *filepath = strtok_r(line, " \t\r\n", &saveptr);
+        if (!filepath || filepath[0] == '#') {
+            continue;
+        }
 
-            int64_t begin_solve_time = os_get_usecs();
-            SolveStatus status =
-                cptp_solve(&instance, ctx->solver ? ctx->solver : "mip",
-                           &params, &solution, ctx->timelimit, ctx->randomseed);
+        char *solver = strtok_r(NULL, " \t\r\n", &saveptr);
+        char *seed = strtok_r(NULL, " \t\r\n", &saveptr);
+        int32_t randomseed = ctx->randomseed;
 
-            timing.ended = time(NULL);
-            timing.took_usecs = os_get_usecs() - begin_solve_time;
+        if (seed && !str_to_int32(seed, &randomseed)) {
+            fprintf(stderr, "%s:%d: Invalid seed `%s`\n", listpath, lineno,
+                    seed);
+            result = false;
+            break;
+        }
 
-            success = status != 0 && !BOOL(status & SOLVE_STATUS_ERR);
-            if (ctx->treat_sigterm_as_failure &&
-                BOOL(status & SOLVE_STATUS_ABORTION_SIGTERM)) {
-                success = false;
-            }
+        result = append_batch_job(jobs, ctx, filepath,
+                                  solver ? solver : ctx->solver, randomseed);
+    }
 
-            printf("\n\n###\n###\n###\n\n");
-            writeout_results(stdout, ctx, success, &instance, &solution, status,
-                             timing);
+    fclose(fh);
+    return result;
+}
 
-            if (success) {
-                writeout_json_report(ctx, &instance, &solution, status, timing);
+static void destroy_batch_jobs(CptpJob *jobs) {
+    for (int32_t i = 0; i < arrlen(jobs); i++) {
+        free((char *)jobs[i].instance_filepath);
+        free((char *)jobs[i].solver_name);
+        free((char *)jobs[i].json_report_path);
+    }
+    arrfree(jobs);
+}
 
-                if (ctx->vis_path) {
-                    render_tour_image(ctx->vis_path, &instance, &solution.tour,
-                                      NULL);
-                }
-            }
+/// Assigns to each job the JSON report path
+///     <REPORT_DIR>/<INSTANCE_NAME>-<SOLVER>-<SEED>.json
+static bool assign_batch_report_paths(CptpJob *jobs, const char *report_dir) {
+    if (!os_mkdir((char *)report_dir, true)) {
+        fprintf(stderr, "%s: Failed to create report directory\n",
+                report_dir);
+        return false;
+    }
+
+    for (int32_t i = 0; i < arrlen(jobs); i++) {
+        Path p;
+        char *basename = os_basename(jobs[i].instance_filepath, &p);
+        char *ext = strchr(basename, '.');
+        if (ext) {
+            *ext = 0;
         }
 
-        instance_destroy(&instance);
-        solution_destroy(&solution);
+        char filepath[OS_MAX_PATH];
+        snprintf(filepath, ARRAY_LEN(filepath), "%s/%s-%s-%d.json", report_dir,
+                 basename, jobs[i].solver_name, jobs[i].randomseed);
+        jobs[i].json_report_path = strdup(filepath);
+        if (!jobs[i].json_report_path) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        return success ? EXIT_SUCCESS : EXIT_FAILURE;
-    } else {
-        fprintf(stderr, "%s: Failed to parse file\n", ctx->instance_filepath);
-        return EXIT_FAILURE;
+static int batch_main(AppCtx *ctx) {
+    int exitcode = EXIT_FAILURE;
+    CptpJob *jobs = NULL;
+
+    SolverParams params =
+        make_solver_params_from_cmdline(ctx->defines, ctx->num_defines);
+
+    bool collected = os_direxists((char *)ctx->batch_path)
+                         ? collect_batch_jobs_from_dir(&jobs, ctx,
+                                                       ctx->batch_path)
+                         : collect_batch_jobs_from_list(&jobs, ctx,
+                                                        ctx->batch_path);
+    if (!collected) {
+        goto terminate;
     }
+
+    if (arrlen(jobs) == 0) {
+        fprintf(stderr, "%s: No instances to solve\n", ctx->batch_path);
+        goto terminate;
+    }
+
+    for (int32_t i = 0; i < arrlen(jobs); i++) {
+        jobs[i].params = &params;
+    }
+
+    if (ctx->json_report_path &&
+        !assign_batch_report_paths(jobs, ctx->json_report_path)) {
+        goto terminate;
+    }
+
+    BatchProgress progress = {.ctx = ctx, .num_jobs = arrlen(jobs)};
+    if (!cptp_solve_many(jobs, arrlen(jobs), ctx->num_workers, &G_cancel,
+                         NULL, on_batch_job_done, &progress)) {
+        goto terminate;
+    }
+
+    printf("\n%-16s %d/%d\n", "BATCH FAILED:", progress.num_failed,
+           progress.num_jobs);
+    exitcode = progress.num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+terminate:
+    destroy_batch_jobs(jobs);
+    return exitcode;
+}
+
+static int serve_main2(AppCtx *ctx) {
+    SolverParams params =
+        make_solver_params_from_cmdline(ctx->defines, ctx->num_defines);
+    ServeConfig config = {.solver_name = ctx->solver ? ctx->solver : "mip",
+                          .params = &params,
+                          .timelimit = ctx->timelimit,
+                          .randomseed = ctx->randomseed,
+                          .num_columns = MAX(1, ctx->num_columns),
+                          .socket_path = ctx->socket_path,
+                          .shm_name = ctx->shm_name,
+                          .instance_filepath = ctx->instance_filepath};
+    return serve_main(&config, &G_cancel);
 }
 
 enum {
@@ -415,7 +556,40 @@ int main(int argc, char **argv) {
     struct arg_lit *version =
         arg_lit0(NULL, "version", "print version information and exit");
     struct arg_file *instance =
-        arg_file1("i", "instance", NULL, "input instance file");
+        arg_file0("i", "instance", NULL,
+                  "input instance file (`-` reads it from stdin)");
+    struct arg_file *batch = arg_file0(
+        NULL, "batch", "<DIR|LIST>",
+        "solve all the instances contained in a directory, or listed in a "
+        "file (one `INSTANCE [SOLVER [SEED]]` per line), instead of a single "
+        "instance. The JSON reports are written to the directory given by "
+        "`-w`");
+    struct arg_int *num_workers =
+        arg_int0("j", "jobs", NULL,
+                 "number of instances solved in parallel in batch mode "
+                 "(default 1, 0 to use all the available CPUs). The CPUs are "
+                 "split evenly among the parallel solves: each one gets "
+                 "max(1, CPUs / JOBS) threads, unless NUM_THREADS is "
+                 "defined");
+    struct arg_int *num_columns =
+        arg_int0("k", "columns", NULL,
+                 "collect up to K distinct tours of negative reduced cost "
+                 "(columns), listed in the JSON report and in the replies "
+                 "of the serve mode (default 0, only the best tour)");
+
+    struct arg_lit *serve = arg_lit0(
+        NULL, "serve",
+        "stay resident and answer pricing requests, one JSON object per "
+        "line, read from stdin (or the socket given by `--socket`). The "
+        "replies are written as JSON lines to stdout");
+    struct arg_file *socket_path =
+        arg_file0(NULL, "socket", "PATH",
+                  "serve the requests on a Unix domain socket instead of "
+                  "stdin/stdout");
+    struct arg_str *shm_name = arg_str0(
+        NULL, "shm", "NAME",
+        "serve the requests of the shared memory channel NAME, created by a "
+        "master process on the same host, for the instance given by `-i`");
 
     struct arg_file *vis_path =
         arg_file0(NULL, "visualize", NULL, "tour visualization output file");
@@ -433,6 +607,12 @@ int main(int argc, char **argv) {
                         randomseed,
                         defines,
                         instance,
+                        batch,
+                        num_workers,
+                        num_columns,
+                        serve,
+                        socket_path,
+                        shm_name,
                         vis_path,
                         json_report_path,
                         solver,
@@ -459,6 +639,10 @@ int main(int argc, char **argv) {
     vis_path->filename[0] = NULL;
     // No JSON report output file by default
     json_report_path->filename[0] = NULL;
+    // Solve one instance at a time in batch mode by default
+    num_workers->ival[0] = 1;
+    // Do not collect columns by default
+    num_columns->ival[0] = 0;
     // Contain only fatal&warning log messages by default
     loglvl->ival[0] = 0;
 
@@ -482,6 +666,42 @@ int main(int argc, char **argv) {
             exitcode = 1;
             goto exit;
         }
+
+        // NOTE(dparo): The shared memory serve mode also takes an instance
+        int32_t num_modes = batch->count + serve->count +
+                            (shm_name->count > 0 ? 0 : instance->count);
+        if (version->count == 0 && num_modes != 1) {
+            printf("%s: exactly one of `--instance`, `--batch` and `--serve` "
+                   "must be given\n",
+                   progname);
+            print_use_help_for_more_information(progname);
+            exitcode = 1;
+            goto exit;
+        }
+
+        if ((batch->count > 0 || serve->count > 0) && vis_path->count > 0) {
+            printf("%s: `--visualize` is not supported in batch and serve "
+                   "mode\n",
+                   progname);
+            exitcode = 1;
+            goto exit;
+        }
+
+        if (socket_path->count > 0 && serve->count == 0) {
+            printf("%s: `--socket` requires `--serve`\n", progname);
+            exitcode = 1;
+            goto exit;
+        }
+
+        if (shm_name->count > 0 &&
+            (serve->count == 0 || instance->count == 0 ||
+             socket_path->count > 0)) {
+            printf("%s: `--shm` requires `--serve` and `--instance`, and "
+                   "cannot be used with `--socket`\n",
+                   progname);
+            exitcode = 1;
+            goto exit;
+        }
     }
 
     /* special case: '--version' takes precedence error reporting */
@@ -524,13 +744,42 @@ int main(int argc, char **argv) {
                   .defines = defines->sval,
                   .num_defines = defines->count,
                   .vis_path = vis_path->filename[0],
-                  .json_report_path = json_report_path->filename[0]};
+                  .json_report_path = json_report_path->filename[0],
+                  .batch_path = batch->count > 0 ? batch->filename[0] : NULL,
+                  .num_workers = num_workers->ival[0],
+                  .num_columns = MAX(0, num_columns->ival[0]),
+                  .serve = serve->count > 0,
+                  .socket_path = socket_path->count > 0
+                                     ? socket_path->filename[0]
+                                     : NULL,
+                  .shm_name = shm_name->count > 0 ? shm_name->sval[0] : NULL};
 
     if (ctx.randomseed == 0) {
         ctx.randomseed = (int32_t)(time(NULL) % INT32_MAX);
     }
 
-    exitcode = main2(&ctx);
+    {
+        // NOTE(dparo):
+        //     No SA_RESTART: the blocking reads of the serve mode must be
+        //     interrupted to notice the cancellation.
+        struct sigaction action = {.sa_handler = cptp_sighandler};
+        sigemptyset(&action.sa_mask);
+        struct sigaction prev_sigterm_action, prev_sigint_action;
+        sigaction(SIGTERM, &action, &prev_sigterm_action);
+        sigaction(SIGINT, &action, &prev_sigint_action);
+
+        if (ctx.serve) {
+            exitcode = serve_main2(&ctx);
+        } else if (ctx.batch_path) {
+            exitcode = batch_main(&ctx);
+        } else {
+            exitcode = main2(&ctx);
+        }
+
+        // Resets the signals
+        sigaction(SIGTERM, &prev_sigterm_action, NULL);
+        sigaction(SIGINT, &prev_sigint_action, NULL);
+    }
 
 exit:
     arg_freetable(argtable, ARRAY_LEN(argtable));
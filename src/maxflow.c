@@ -64,6 +64,21 @@ void max_flow_result_copy(MaxFlowResult *dest, const MaxFlowResult *src) {
     memcpy(dest->colors, src->colors, dest->nnodes * sizeof(*dest->colors));
 }
 
+int32_t max_flow_result_to_bitset(const MaxFlowResult *result, int32_t color,
+                                  Bitset *out) {
+    assert(out->nbits >= result->nnodes);
+    bitset_clear(out);
+
+    int32_t size = 0;
+    for (int32_t i = 0; i < result->nnodes; i++) {
+        if (result->colors[i] == color) {
+            bitset_set(out, i);
+            ++size;
+        }
+    }
+    return size;
+}
+
 void max_flow_destroy(MaxFlow *mf) {
 
     switch (mf->kind) {
@@ -101,8 +116,11 @@ void max_flow_create(MaxFlow *mf, int32_t nnodes, MaxFlowAlgoKind kind) {
 
     mf->kind = kind;
     mf->nnodes = nnodes;
+    mf->rng = rng_create((uint64_t)nnodes);
 }
 
+void max_flow_seed(MaxFlow *mf, uint64_t seed) { mf->rng = rng_create(seed); }
+
 flow_t maxflow_result_recompute_flow(const FlowNetwork *net,
                                      MaxFlowResult *result) {
     flow_t flow = 0;
@@ -203,7 +221,7 @@ flow_t max_flow_single_pair(const FlowNetwork *net, MaxFlow *mf, int32_t s,
 
     case MAXFLOW_ALGO_RANDOM:
         for (int32_t i = 0; i < net->nnodes; i++) {
-            result->colors[i] = rand() % 2;
+            result->colors[i] = rng_next_int(&mf->rng, 2);
         }
         result->colors[s] = 1;
         result->colors[t] = 0;
@@ -64,6 +64,8 @@ typedef struct MaxFlow {
     int32_t t;
 
     MaxFlowAlgoKind kind;
+    /// Random state of `MAXFLOW_ALGO_RANDOM`
+    Rng rng;
     union {
         // bruteforce
         struct {
@@ -126,6 +128,8 @@ void flow_network_clear_caps(FlowNetwork *net);
 
 void max_flow_destroy(MaxFlow *mf);
 void max_flow_create(MaxFlow *mf, int32_t nnodes, MaxFlowAlgoKind kind);
+/// Reseeds the random state, which `max_flow_create` seeds from `nnodes`
+void max_flow_seed(MaxFlow *mf, uint64_t seed);
 
 void max_flow_result_create(MaxFlowResult *result, int32_t nnodes);
 flow_t maxflow_result_recompute_flow(const FlowNetwork *net,
@@ -134,6 +138,11 @@ void max_flow_result_destroy(MaxFlowResult *result);
 
 void max_flow_result_copy(MaxFlowResult *dest, const MaxFlowResult *src);
 
+/// Fills `out` (created with at least `result->nnodes` bits) with the nodes
+/// colored `color` in the bipartition. Returns the size of the set.
+int32_t max_flow_result_to_bitset(const MaxFlowResult *result, int32_t color,
+                                  Bitset *out);
+
 void gomory_hu_tree_create(GomoryHuTree *tree, int32_t nnodes);
 void gomory_hu_tree_destroy(GomoryHuTree *tree);
 flow_t gomory_hu_tree_query(GomoryHuTree *tree, MaxFlowResult *result,
@@ -40,14 +40,15 @@ void max_flow_create_push_relabel(MaxFlow *mf, int32_t nnodes) {
 
 #ifndef NDEBUG
     // randomly initialize the array to make accumulation errors apparent
+    Rng rng = rng_create((uint64_t)nnodes);
     for (int32_t i = 0; i < nnodes; i++) {
-        mf->payload.height[i] = rand();
-        mf->payload.excess_flow[i] = (flow_t)rand() % 40;
-        mf->payload.curr_neigh[i] = rand();
+        mf->payload.height[i] = rng_next_int(&rng, INT32_MAX);
+        mf->payload.excess_flow[i] = (flow_t)rng_next_int(&rng, 40);
+        mf->payload.curr_neigh[i] = rng_next_int(&rng, INT32_MAX);
     }
 
     for (int32_t i = 0; i < nnodes - 2; i++) {
-        mf->payload.list[i] = rand();
+        mf->payload.list[i] = rng_next_int(&rng, INT32_MAX);
     }
 #endif
 }
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <libgen.h>
 #elif defined _WIN64
 #include <windows.h>
@@ -323,3 +324,105 @@ char *os_dirname(const char *path, Path *p) {
 #error "TODO os_dirname for WINDOWS platform"
 #endif
 }
+
+int32_t os_get_num_cpus(void) {
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__OpenBSD__) ||      \
+    defined(__NetBSD__) || defined(__DragonFly__)
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return ncpus > 0 ? (int32_t)ncpus : 1;
+#elif __APPLE__
+#error "TODO os_get_num_cpus for APPLE platform"
+#else
+#error "TODO os_get_num_cpus for WINDOWS platform"
+#endif
+}
+
+static bool read_all(int fd, OsFileView *view) {
+    size_t capacity = 64 * 1024;
+    size_t size = 0;
+    char *buffer = malloc(capacity);
+
+    while (buffer) {
+        ssize_t amt = read(fd, buffer + size, capacity - size);
+        if (amt < 0 && errno == EINTR) {
+            continue;
+        } else if (amt < 0) {
+            break;
+        } else if (amt == 0) {
+            view->data = buffer;
+            view->size = size;
+            view->buffer = buffer;
+            return true;
+        }
+
+        size += (size_t)amt;
+        if (size == capacity) {
+            capacity *= 2;
+            char *grown = realloc(buffer, capacity);
+            if (!grown) {
+                break;
+            }
+            buffer = grown;
+        }
+    }
+
+    free(buffer);
+    return false;
+}
+
+bool os_file_view_open(int fd, OsFileView *view) {
+    memset(view, 0, sizeof(*view));
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__OpenBSD__) ||      \
+    defined(__NetBSD__) || defined(__DragonFly__)
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return false;
+    }
+
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (!S_ISREG(st.st_mode) || offset < 0 || offset > st.st_size) {
+        return read_all(fd, view);
+    }
+
+    // NOTE(dparo): mmap() refuses empty mappings
+    static const char EMPTY[1] = {0};
+    view->data = EMPTY;
+    view->size = (size_t)(st.st_size - offset);
+    if (view->size == 0) {
+        return true;
+    }
+
+    // The mapping must start at a page boundary
+    off_t page_size = (off_t)sysconf(_SC_PAGESIZE);
+    off_t map_offset = offset - offset % page_size;
+    size_t map_size = view->size + (size_t)(offset - map_offset);
+    void *addr = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (addr == MAP_FAILED) {
+        return read_all(fd, view);
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(addr, map_size, MADV_SEQUENTIAL);
+#endif
+
+    view->data = (char *)addr + (offset - map_offset);
+    view->map_size = map_size;
+    return true;
+#elif __APPLE__
+#error "TODO os_file_view_open for APPLE platform"
+#else
+#error "TODO os_file_view_open for WINDOWS platform"
+#endif
+}
+
+void os_file_view_close(OsFileView *view) {
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__OpenBSD__) ||      \
+    defined(__NetBSD__) || defined(__DragonFly__)
+    if (view->map_size) {
+        size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+        uintptr_t addr = (uintptr_t)view->data;
+        munmap((void *)(addr - addr % page_size), view->map_size);
+    }
+#endif
+    free(view->buffer);
+    memset(view, 0, sizeof(*view));
+}
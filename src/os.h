@@ -75,6 +75,25 @@ bool os_mkdir(char *path, bool exist_ok);
 char *os_basename(const char *path, Path *p);
 char *os_dirname(const char *path, Path *p);
 
+/// Number of online CPUs (at least 1)
+int32_t os_get_num_cpus(void);
+
+/// Read-only view over the whole content of a file
+typedef struct OsFileView {
+    const char *data;
+    size_t size;
+    /// Size of the mapping, 0 if `data` is not mapped
+    size_t map_size;
+    /// Heap buffer backing `data` for the files which cannot be mapped
+    char *buffer;
+} OsFileView;
+
+/// Maps the file opened as `fd` in memory, from its current offset up to
+/// its end. Files which cannot be mapped (eg pipes) are read into a heap
+/// buffer instead.
+bool os_file_view_open(int fd, OsFileView *view);
+void os_file_view_close(OsFileView *view);
+
 #if __cplusplus
 }
 #endif
@@ -27,7 +27,12 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <ctype.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 static bool expect_newline(FILE *filehandle, const char *filepath,
                            int32_t line_cnt) {
@@ -110,18 +115,8 @@ static bool parse_simplified_vrp_line(Instance *instance, FILE *filehandle,
     return true;
 }
 
-static bool prep_memory(Instance *instance) {
-
-    instance->positions =
-        calloc(instance->num_customers + 1, sizeof(*instance->positions));
-
-    instance->demands =
-        calloc(instance->num_customers + 1, sizeof(*instance->demands));
-
-    instance->profits =
-        calloc(instance->num_customers + 1, sizeof(*instance->profits));
-
-    return instance->positions && instance->demands && instance->profits;
+static bool prep_memory(Instance *instance, bool with_edge_weight) {
+    return instance_alloc(instance, with_edge_weight);
 }
 
 static bool parse_simplified_vrp_file(Instance *instance, FILE *filehandle,
@@ -138,7 +133,7 @@ static bool parse_simplified_vrp_file(Instance *instance, FILE *filehandle,
         return false;
     }
 
-    if (!prep_memory(instance)) {
+    if (!prep_memory(instance, false)) {
         fprintf(stderr, "%s: Failed to allocate memory for %d customers\n",
                 filepath, instance->num_customers);
         return false;
@@ -170,14 +165,65 @@ static struct {
     {"EXPLICIT", EDGE_WEIGHT_FORMAT_EXPLICIT},
 };
 
+/// Layout of the values in the `EDGE_WEIGHT_SECTION`
+typedef enum EdgeWeightLayout {
+    /// Custom format: one `i j weight` record per line, in any order
+    EDGE_WEIGHT_LAYOUT_TRIPLETS = 0,
+    /// TSPLIB matrix formats: a flat sequence of weights, in row order
+    EDGE_WEIGHT_LAYOUT_UPPER_ROW,
+    EDGE_WEIGHT_LAYOUT_LOWER_ROW,
+    EDGE_WEIGHT_LAYOUT_UPPER_DIAG_ROW,
+    EDGE_WEIGHT_LAYOUT_LOWER_DIAG_ROW,
+    EDGE_WEIGHT_LAYOUT_FULL_MATRIX,
+} EdgeWeightLayout;
+
+static struct {
+    char *name;
+    EdgeWeightLayout layout;
+} const SUPPORTED_EDGEW_LAYOUTS[] = {
+    {"UPPER_ROW", EDGE_WEIGHT_LAYOUT_UPPER_ROW},
+    {"LOWER_ROW", EDGE_WEIGHT_LAYOUT_LOWER_ROW},
+    {"UPPER_DIAG_ROW", EDGE_WEIGHT_LAYOUT_UPPER_DIAG_ROW},
+    {"LOWER_DIAG_ROW", EDGE_WEIGHT_LAYOUT_LOWER_DIAG_ROW},
+    {"FULL_MATRIX", EDGE_WEIGHT_LAYOUT_FULL_MATRIX},
+};
+
+enum {
+    /// Size of the reads of a streamed input, and thus its memory footprint
+    /// (it only grows to hold a longer line)
+    PARSER_STREAM_CHUNK_SIZE = 64 * 1024,
+};
+
+/// Input read incrementally from a pipe or a socket. The parser sees a
+/// window over `buf` always ending at a line boundary, so that a line is
+/// never split between two refills.
+typedef struct ParserStream {
+    int fd;
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool eof;
+    bool failed;
+} ParserStream;
+
 typedef struct VrplibParser {
     const char *filename;
-    char *base;
-    char *at;
+    const char *base;
+    const char *at;
     int32_t curline;
     size_t size;
 
     EdgeWeightType edgew_format;
+    EdgeWeightLayout edgew_layout;
+
+    /// When set, the first error is formatted here instead of being printed
+    /// (see the workers of the `EDGE_WEIGHT_SECTION`)
+    char *errbuf;
+    size_t errbuf_size;
+    int32_t errline;
+
+    /// NULL when the whole input is mapped in memory
+    ParserStream *stream;
 } VrplibParser;
 
 static inline size_t parser_remainder_size(const VrplibParser *p) {
@@ -194,10 +240,26 @@ static inline bool parser_is_eof(const VrplibParser *p) {
     return parser_remainder_size(p) == 0;
 }
 
+static inline const char *parser_end(const VrplibParser *p) {
+    return p->base + p->size;
+}
+
 static void parser_eat_whitespaces(VrplibParser *p) {
-    while (!parser_is_eof(p) && (*p->at == ' ' || *p->at == '\t')) {
-        parser_adv(p, 1);
+    const char *end = parser_end(p);
+    const char *at = p->at;
+    while (at < end && (*at == ' ' || *at == '\t')) {
+        at++;
     }
+    p->at = at;
+}
+
+/// First `\r` or `\n` of the current line (or the end of the input)
+static const char *parser_find_eol(const VrplibParser *p) {
+    const char *end = parser_end(p);
+    const char *eol = memchr(p->at, '\n', end - p->at);
+    eol = eol ? eol : end;
+    const char *cr = memchr(p->at, '\r', eol - p->at);
+    return cr ? cr : eol;
 }
 
 static void parser_eat_newline(VrplibParser *p) {
@@ -228,7 +290,7 @@ static bool parser_match_newline(VrplibParser *p) {
 }
 
 static void parser_eat_all_blanks(VrplibParser *p) {
-    char *at = NULL;
+    const char *at = NULL;
     do {
         at = p->at;
         parser_eat_whitespaces(p);
@@ -237,10 +299,105 @@ static void parser_eat_all_blanks(VrplibParser *p) {
     } while (p->at != at);
 }
 
+/// Reads (at least) one more line of a streamed input. The unparsed bytes
+/// are moved to the beginning of the buffer, invalidating any pointer into
+/// the previous window.
+static void parser_refill(VrplibParser *p) {
+    ParserStream *s = p->stream;
+    assert(s && !s->eof);
+
+    size_t keep = (size_t)(s->buf + s->len - p->at);
+    size_t window = parser_remainder_size(p);
+    memmove(s->buf, p->at, keep);
+    s->len = keep;
+
+    // The bytes past the window may already hold a complete line
+    bool has_newline = NULL != memchr(s->buf + window, '\n', keep - window);
+    while (!has_newline && !s->eof) {
+        if (s->len == s->cap) {
+            size_t cap = MAX((size_t)PARSER_STREAM_CHUNK_SIZE, 2 * s->cap);
+            char *buf = realloc(s->buf, cap);
+            if (!buf) {
+                log_fatal("%s :: Failed memory allocation", __func__);
+                s->eof = s->failed = true;
+                break;
+            }
+            s->buf = buf;
+            s->cap = cap;
+        }
+
+        ssize_t got = read(s->fd, s->buf + s->len, s->cap - s->len);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got < 0) {
+            log_fatal("%s :: Failed to read `%s`: %s", __func__, p->filename,
+                      strerror(errno));
+            s->eof = s->failed = true;
+        } else if (got == 0) {
+            s->eof = true;
+        } else {
+            has_newline = NULL != memchr(s->buf + s->len, '\n', (size_t)got);
+            s->len += (size_t)got;
+        }
+    }
+
+    // Cut the window right after the last newline: the partial line left
+    // out is completed by the next refill
+    window = s->len;
+    if (!s->eof) {
+        while (window > 0 && s->buf[window - 1] != '\n') {
+            window--;
+        }
+    }
+    p->base = s->buf;
+    p->at = s->buf;
+    p->size = window;
+}
+
+/// Makes sure that the line at `p->at` is buffered, unless the input is
+/// over. Since the window ends at a line boundary, it suffices to refill
+/// once the window was consumed.
+static inline void parser_fill(VrplibParser *p) {
+    while (p->stream && !p->stream->eof && parser_is_eof(p)) {
+        parser_refill(p);
+    }
+}
+
+/// Makes sure that the `num_lines` lines starting at `p->at` are buffered,
+/// unless the input is over
+static void parser_fill_lines(VrplibParser *p, int32_t num_lines) {
+    while (p->stream && !p->stream->eof) {
+        const char *at = p->at;
+        const char *end = parser_end(p);
+        int32_t found = 0;
+        while (found < num_lines && at < end) {
+            const char *nl = memchr(at, '\n', (size_t)(end - at));
+            if (!nl) {
+                break;
+            }
+            at = nl + 1;
+            found++;
+        }
+        if (found >= num_lines) {
+            break;
+        }
+        parser_refill(p);
+    }
+}
+
+/// `parser_eat_all_blanks` across the refills of a streamed input
+static void parser_skip_blanks(VrplibParser *p) {
+    do {
+        parser_fill(p);
+        parser_eat_all_blanks(p);
+    } while (p->stream && !p->stream->eof && parser_is_eof(p));
+}
+
 static bool parser_match_string(VrplibParser *p, char *string) {
     parser_eat_whitespaces(p);
-    size_t len = MIN(parser_remainder_size(p), strlen(string));
-    bool result = (0 == strncmp(string, p->at, len));
+    size_t len = strlen(string);
+    bool result = len <= parser_remainder_size(p) &&
+                  (0 == memcmp(string, p->at, len));
 
     if (result) {
         parser_adv(p, len);
@@ -251,12 +408,19 @@ static bool parser_match_string(VrplibParser *p, char *string) {
 
 ATTRIB_PRINTF(2, 3)
 static void parse_error(VrplibParser *p, char *fmt, ...) {
-    fprintf(stderr, "%s:%d: error: ", p->filename, p->curline);
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(stderr, fmt, ap);
+    if (p->errbuf) {
+        if (p->errbuf[0] == '\0') {
+            vsnprintf(p->errbuf, p->errbuf_size, fmt, ap);
+            p->errline = p->curline;
+        }
+    } else {
+        fprintf(stderr, "%s:%d: error: ", p->filename, p->curline);
+        vfprintf(stderr, fmt, ap);
+        fprintf(stderr, "\n");
+    }
     va_end(ap);
-    fprintf(stderr, "\n");
 }
 
 static bool parser_needs_edge_section(VrplibParser *p) {
@@ -268,15 +432,8 @@ static char *parse_hdr_field(VrplibParser *p, char *fieldname) {
         parser_eat_whitespaces(p);
 
         if (parser_match_string(p, ":")) {
-            char *at = p->at;
-
-            while (!parser_is_eof(p)) {
-                bool is_newline = (*p->at == '\r' || *p->at == '\n');
-                if (is_newline) {
-                    break;
-                }
-                parser_adv(p, 1);
-            }
+            const char *at = p->at;
+            p->at = parser_find_eol(p);
 
             ptrdiff_t namesize = p->at - at;
 
@@ -292,8 +449,10 @@ static char *parse_hdr_field(VrplibParser *p, char *fieldname) {
             }
 
             char *value = malloc(namesize + 1);
-            value[namesize] = 0;
-            strncpy(value, at, namesize);
+            if (value) {
+                memcpy(value, at, namesize);
+                value[namesize] = 0;
+            }
             return value;
         } else {
             return NULL;
@@ -306,14 +465,15 @@ static char *parse_hdr_field(VrplibParser *p, char *fieldname) {
 static bool parse_vrplib_hdr(VrplibParser *p, Instance *instance) {
     bool result = true;
     bool done = false;
-    while (!parser_is_eof(p) && !done) {
-        parser_eat_all_blanks(p);
+    while (!done) {
+        parser_skip_blanks(p);
+        if (parser_is_eof(p)) {
+            break;
+        }
         char *value = NULL;
         if (parser_match_string(p, "#")) {
             // Eat comment
-            while (!parser_is_eof(p) && !(*p->at == '\n' || *p->at == '\r')) {
-                parser_adv(p, 1);
-            }
+            p->at = parser_find_eol(p);
             parser_eat_newline(p);
             parser_eat_whitespaces(p);
         } else if ((value = parse_hdr_field(p, "NAME"))) {
@@ -363,11 +523,21 @@ static bool parse_vrplib_hdr(VrplibParser *p, Instance *instance) {
                 result = false;
             }
         } else if ((value = parse_hdr_field(p, "EDGE_WEIGHT_FORMAT"))) {
+            bool is_supported = false;
             if (0 == strcmp(value, "FUNCTION")) {
                 p->edgew_format = EDGE_WEIGHT_FORMAT_FUNCTION;
-            } else if (0 == strcmp(value, "UPPER_ROW")) {
-                p->edgew_format = EDGE_WEIGHT_FORMAT_EXPLICIT;
-            } else {
+                is_supported = true;
+            }
+            for (int32_t i = 0; i < ARRAY_LEN_i32(SUPPORTED_EDGEW_LAYOUTS);
+                 i++) {
+                if (0 == strcmp(value, SUPPORTED_EDGEW_LAYOUTS[i].name)) {
+                    p->edgew_format = EDGE_WEIGHT_FORMAT_EXPLICIT;
+                    p->edgew_layout = SUPPORTED_EDGEW_LAYOUTS[i].layout;
+                    is_supported = true;
+                    break;
+                }
+            }
+            if (!is_supported) {
                 parse_error(p, "unsupported format `%s` for EDGE_WEIGHT_FORMAT",
                             value);
                 result = false;
@@ -399,37 +569,33 @@ terminate:
     return result;
 }
 
-static char *get_token_lexeme(VrplibParser *p) {
-    parser_eat_whitespaces(p);
-    char *at = p->at;
-
-    while (!parser_is_eof(p) && (*p->at == '-' || *p->at == '+' ||
-                                 *p->at == '.' || isalnum(*p->at))) {
-        parser_adv(p, 1);
-    }
-
-    intptr_t toksize = p->at - at;
+static inline bool is_lexeme_char(char c) {
+    char lower = c | 0x20;
+    return (c >= '0' && c <= '9') || (lower >= 'a' && lower <= 'z') ||
+           c == '-' || c == '+' || c == '.';
+}
 
-    if (toksize != 0) {
-        char *lexeme = malloc(toksize + 1);
-        if (!lexeme) {
-            log_fatal("Failed memory allocation");
-            return NULL;
-        }
+/// Returns a view into the input of the next lexeme (empty if there's none).
+/// The lexemes are never copied: this is the hot path of the explicit
+/// instances, having O(n^2) lexemes in their `EDGE_WEIGHT_SECTION`.
+static StrView parser_next_lexeme(VrplibParser *p) {
+    parser_eat_whitespaces(p);
+    const char *end = parser_end(p);
+    const char *at = p->at;
 
-        strncpy(lexeme, at, toksize);
-        lexeme[toksize] = '\0';
-        parser_eat_whitespaces(p);
-        return lexeme;
+    while (at < end && is_lexeme_char(*at)) {
+        at++;
     }
 
+    StrView lexeme = {p->at, (size_t)(at - p->at)};
+    p->at = at;
     parser_eat_whitespaces(p);
-    return NULL;
+    return lexeme;
 }
 
-static bool parse_node_id(VrplibParser *p, char *lexeme, int32_t node_id) {
+static bool parse_node_id(VrplibParser *p, StrView lexeme, int32_t node_id) {
     int32_t value = 0;
-    if (!str_to_int32(lexeme, &value)) {
+    if (!strv_to_int32(lexeme, &value)) {
         parse_error(p, "Failed to retrieve integer");
         return false;
     }
@@ -449,9 +615,10 @@ static bool parse_vrplib_nodecoord_section(VrplibParser *p,
 
     for (int32_t node_id = 0;
          result && (node_id != (instance->num_customers + 1)); node_id++) {
+        parser_fill(p);
         for (int32_t i = 0; i < 3; i++) {
-            char *lexeme = get_token_lexeme(p);
-            if (!lexeme) {
+            StrView lexeme = parser_next_lexeme(p);
+            if (lexeme.len == 0) {
                 result = false;
             } else {
                 switch (i) {
@@ -462,7 +629,7 @@ static bool parse_vrplib_nodecoord_section(VrplibParser *p,
                 case 2: {
                     // Parsing the x, y coordinate
                     double coord = 0;
-                    if (!str_to_double(lexeme, &coord)) {
+                    if (!strv_to_double(lexeme, &coord)) {
                         parse_error(p, "Expected valid double for coordinate");
                         result = false;
                     } else {
@@ -475,10 +642,6 @@ static bool parse_vrplib_nodecoord_section(VrplibParser *p,
                     break;
                 }
                 }
-
-                if (lexeme) {
-                    free(lexeme);
-                }
             }
         }
 
@@ -498,9 +661,10 @@ static bool parse_node_double_tuple_section(VrplibParser *p, Instance *instance,
 
     for (int32_t node_id = 0;
          result && (node_id != (instance->num_customers + 1)); node_id++) {
+        parser_fill(p);
         for (int32_t i = 0; i < 2; i++) {
-            char *lexeme = get_token_lexeme(p);
-            if (!lexeme) {
+            StrView lexeme = parser_next_lexeme(p);
+            if (lexeme.len == 0) {
                 result = false;
             } else {
                 switch (i) {
@@ -510,7 +674,7 @@ static bool parse_node_double_tuple_section(VrplibParser *p, Instance *instance,
                 case 1: {
                     // Parse the value
                     double value = 0;
-                    if (!str_to_double(lexeme, &value)) {
+                    if (!strv_to_double(lexeme, &value)) {
                         parse_error(p, "Expected valid double for %s",
                                     valuename);
                         result = false;
@@ -521,10 +685,6 @@ static bool parse_node_double_tuple_section(VrplibParser *p, Instance *instance,
                 }
                 }
             }
-
-            if (lexeme) {
-                free(lexeme);
-            }
         }
 
         if (!parser_match_newline(p)) {
@@ -552,12 +712,13 @@ static bool parse_vrplib_depot_section(VrplibParser *p, Instance *instance) {
     UNUSED_PARAM(instance);
     bool result = true;
     for (int32_t i = 0; result && (i <= 1); i++) {
-        char *lexeme = get_token_lexeme(p);
-        if (!lexeme) {
+        parser_fill(p);
+        StrView lexeme = parser_next_lexeme(p);
+        if (lexeme.len == 0) {
             result = false;
         } else {
             int32_t nodeid = 0;
-            if (!str_to_int32(lexeme, &nodeid)) {
+            if (!strv_to_int32(lexeme, &nodeid)) {
                 parse_error(p, "Expected valid integer for DEPOT_SECTION");
                 result = false;
             } else {
@@ -581,10 +742,6 @@ static bool parse_vrplib_depot_section(VrplibParser *p, Instance *instance) {
             }
         }
 
-        if (lexeme) {
-            free(lexeme);
-        }
-
         if (!parser_match_newline(p)) {
             parse_error(p, "Expected newline");
             result = false;
@@ -594,126 +751,421 @@ static bool parse_vrplib_depot_section(VrplibParser *p, Instance *instance) {
     return result;
 }
 
-static bool parse_vrplib_edge_weight_section(VrplibParser *p,
-                                             Instance *instance) {
-    bool result = true;
-    int32_t n = instance->num_customers + 1;
+enum {
+    // Sections smaller than this are not worth spawning threads for
+    EDGE_WEIGHT_MIN_BYTES_PER_WORKER = 256 * 1024,
+    EDGE_WEIGHT_MAX_WORKERS = 16,
+    EDGE_WEIGHT_ERRBUF_SIZE = 256,
+};
 
-    bool needs_edge_section = parser_needs_edge_section(p);
-    if (!needs_edge_section) {
-        parse_error(p, "Found un-expected `EDGE_WEIGHT_SECTION`. "
-                       "EDGE_WEIGHT_TYPE should be set accordingly");
+/// A newline aligned byte range of the `EDGE_WEIGHT_SECTION`, parsed on its
+/// own thread
+typedef struct EdgeWeightChunk {
+    VrplibParser parser;
+    Instance *instance;
+    /// One flag per arc, shared among all the chunks
+    atomic_uchar *seen;
+    int64_t num_records;
+    bool result;
+    char errbuf[EDGE_WEIGHT_ERRBUF_SIZE];
+} EdgeWeightChunk;
+
+/// Parses a single `i j weight` record, which may appear in any order
+static bool parse_edge_weight_record(VrplibParser *p, Instance *instance,
+                                     atomic_uchar *seen) {
+    const int32_t n = instance->num_customers + 1;
+    int32_t ids[2] = {0};
+
+    for (int32_t k = 0; k < 2; k++) {
+        if (!strv_to_int32(parser_next_lexeme(p), &ids[k]) || ids[k] < 1 ||
+            ids[k] > n) {
+            parse_error(p, "Expected valid node id in the range [1, %d]", n);
+            return false;
+        }
+    }
+
+    if (ids[0] == ids[1]) {
+        parse_error(p, "Found weight for the self loop of node `%d`", ids[0]);
         return false;
     }
 
-    assert(instance->edge_weight);
+    double value = 0;
+    if (!strv_to_double(parser_next_lexeme(p), &value)) {
+        parse_error(p, "Expected valid double for the weight of arc `(%d, %d)`",
+                    ids[0], ids[1]);
+        return false;
+    }
 
-    for (int32_t i = 0; i < n; i++) {
-        for (int32_t j = i + 1; j < n; j++) {
-            int32_t idx = sxpos(n, i, j);
+    int64_t idx = sxpos(n, ids[0] - 1, ids[1] - 1);
+    if (atomic_exchange_explicit(&seen[idx], 1, memory_order_relaxed)) {
+        parse_error(p, "Found duplicate weight for arc `(%d, %d)`", ids[0],
+                    ids[1]);
+        return false;
+    }
+    instance->edge_weight[idx] = value;
 
-            for (int32_t lexid = 0; lexid < 3; lexid++) {
-                char *lexeme = get_token_lexeme(p);
-                if (lexid == 0 || lexid == 1) {
-                    result = parse_node_id(p, lexeme, lexid == 0 ? i : j);
-                } else {
-                    // Parse the reduced cost variable
-                    double value = 0;
-                    if (!str_to_double(lexeme, &value)) {
-                        parse_error(p,
-                                    "Expected valid double for reduced cost");
-                        result = false;
-                    } else {
-                        instance->edge_weight[idx] = value;
-                    }
-                }
+    if (!parser_match_newline(p) && !parser_is_eof(p)) {
+        parse_error(p,
+                    "Expected newline after the weight for arc `(%d, %d)`",
+                    ids[0], ids[1]);
+        return false;
+    }
 
-                if (lexeme) {
-                    free(lexeme);
-                }
+    return true;
+}
 
-                if (!result) {
-                    goto terminate;
-                }
-            }
+static void *parse_edge_weight_chunk(void *arg) {
+    EdgeWeightChunk *chunk = arg;
+    VrplibParser *p = &chunk->parser;
+    chunk->result = true;
 
-            if (!parser_match_newline(p)) {
-                parse_error(p,
-                            "Expected newline after reduced cost for arc "
-                            "`(%d, %d)``",
-                            i + 1, j + 1);
-                result = false;
-                goto terminate;
-            }
+    parser_eat_all_blanks(p);
+    while (!parser_is_eof(p)) {
+        if (!parse_edge_weight_record(p, chunk->instance, chunk->seen)) {
+            chunk->result = false;
+            break;
         }
+        chunk->num_records++;
+        parser_eat_all_blanks(p);
     }
+    return NULL;
+}
+
+/// End of the records of the section: the first line starting with a
+/// keyword (eg the next section, or `EOF`)
+static const char *find_edge_weight_section_end(const VrplibParser *p) {
+    VrplibParser scan = *p;
+    const char *end = parser_end(p);
+
+    while (scan.at < end) {
+        parser_eat_all_blanks(&scan);
+        if (scan.at >= end) {
+            break;
+        }
+        char lower = *scan.at | 0x20;
+        if (lower >= 'a' && lower <= 'z') {
+            break;
+        }
+        scan.at = parser_find_eol(&scan);
+    }
+    return scan.at;
+}
+
+/// Parses the records on several threads: the whole section must be mapped
+static bool parse_edge_weight_chunks(VrplibParser *p, Instance *instance,
+                                     atomic_uchar *seen,
+                                     int64_t *num_records) {
+    bool result = true;
+    const char *begin = p->at;
+    const char *end = find_edge_weight_section_end(p);
+    size_t size = (size_t)(end - begin);
+
+    int32_t num_workers =
+        (int32_t)MIN((size_t)EDGE_WEIGHT_MAX_WORKERS,
+                     size / EDGE_WEIGHT_MIN_BYTES_PER_WORKER);
+    num_workers = MAX(1, MIN(num_workers, os_get_num_cpus()));
+
+    EdgeWeightChunk *chunks = calloc(num_workers, sizeof(*chunks));
+    pthread_t *threads = calloc(num_workers, sizeof(*threads));
+    bool *started = calloc(num_workers, sizeof(*started));
+    if (!chunks || !threads || !started) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    // NOTE(dparo):
+    //     The records are independent of each other: the section is split
+    //     into newline aligned chunks, each written straight into its
+    //     `sxpos` slots.
+    const char *chunk_begin = begin;
+    for (int32_t i = 0; i < num_workers; i++) {
+        const char *chunk_end = end;
+        if (i < num_workers - 1) {
+            chunk_end = begin + (size * (i + 1)) / num_workers;
+            chunk_end = MAX(chunk_end, chunk_begin);
+            const char *nl = memchr(chunk_end, '\n', end - chunk_end);
+            chunk_end = nl ? nl + 1 : end;
+        }
+
+        EdgeWeightChunk *chunk = &chunks[i];
+        chunk->parser = *p;
+        chunk->parser.base = chunk_begin;
+        chunk->parser.at = chunk_begin;
+        chunk->parser.size = (size_t)(chunk_end - chunk_begin);
+        chunk->parser.curline = 0;
+        chunk->parser.errbuf = chunk->errbuf;
+        chunk->parser.errbuf_size = sizeof(chunk->errbuf);
+        chunk->instance = instance;
+        chunk->seen = seen;
+        chunk_begin = chunk_end;
+    }
+
+    for (int32_t i = 1; i < num_workers; i++) {
+        started[i] = 0 == pthread_create(&threads[i], NULL,
+                                         parse_edge_weight_chunk, &chunks[i]);
+    }
+    parse_edge_weight_chunk(&chunks[0]);
+
+    for (int32_t i = 1; i < num_workers; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            // Fallback to parsing the chunk on this thread
+            parse_edge_weight_chunk(&chunks[i]);
+        }
+    }
+
+    // Report the first error in file order. The chunks preceding the failed
+    // one were parsed in full, so their line counts are exact.
+    for (int32_t i = 0; i < num_workers; i++) {
+        if (!chunks[i].result) {
+            fprintf(stderr, "%s:%d: error: %s\n", p->filename,
+                    p->curline + chunks[i].parser.errline, chunks[i].errbuf);
+            result = false;
+            goto terminate;
+        }
+        *num_records += chunks[i].num_records;
+        p->curline += chunks[i].parser.curline;
+    }
+    p->at = end;
 
 terminate:
+    free(started);
+    free(threads);
+    free(chunks);
     return result;
 }
 
-bool parse_vrp_file(Instance *instance, FILE *filehandle,
-                    const char *filepath) {
+/// Parses the records of a streamed input, one line at a time, up to the
+/// first line starting with a keyword
+static bool parse_edge_weight_stream(VrplibParser *p, Instance *instance,
+                                     atomic_uchar *seen,
+                                     int64_t *num_records) {
+    for (;;) {
+        parser_skip_blanks(p);
+        char lower = parser_is_eof(p) ? 'a' : (*p->at | 0x20);
+        if (lower >= 'a' && lower <= 'z') {
+            return true;
+        }
+        if (!parse_edge_weight_record(p, instance, seen)) {
+            return false;
+        }
+        (*num_records)++;
+    }
+}
 
+static bool parse_edge_weight_triplets(VrplibParser *p, Instance *instance) {
     bool result = true;
-    size_t filesize = get_file_size(filehandle);
+    const int32_t n = instance->num_customers + 1;
+    const int64_t num_arcs = hm_nentries(n);
+    int64_t num_records = 0;
 
-    // + 1 for null termination
-    char *buffer = malloc(filesize + 1);
-    if (!buffer) {
+    atomic_uchar *seen = calloc(MAX(1, num_arcs), sizeof(*seen));
+    if (!seen) {
+        log_fatal("%s :: Failed memory allocation", __func__);
         result = false;
         goto terminate;
     }
 
-    size_t readamt = fread(buffer, 1, filesize, filehandle);
-    if (readamt != filesize) {
+    if (p->stream) {
+        result = parse_edge_weight_stream(p, instance, seen, &num_records);
+    } else {
+        result = parse_edge_weight_chunks(p, instance, seen, &num_records);
+    }
+
+    if (result && num_records != num_arcs) {
+        for (int64_t idx = 0; idx < num_arcs; idx++) {
+            if (!atomic_load_explicit(&seen[idx], memory_order_relaxed)) {
+                // Invert `sxpos` by a linear scan: this is the error path
+                int32_t i = 0;
+                while (sxpos(n, i, n - 1) < idx) {
+                    i++;
+                }
+                int32_t j = (int32_t)(idx - sxpos(n, i, i + 1)) + i + 1;
+                parse_error(p, "Missing weight for arc `(%d, %d)`", i + 1,
+                            j + 1);
+                break;
+            }
+        }
         result = false;
-        goto terminate;
     }
 
-    // NULL terminate the buffer
-    buffer[filesize] = 0;
-    VrplibParser parser = {0};
-    parser.filename = filepath;
-    parser.base = buffer;
-    parser.at = buffer;
-    parser.size = filesize;
+terminate:
+    free(seen);
+    return result;
+}
 
-    // First extract the header information
-    if (!parse_vrplib_hdr(&parser, instance)) {
-        result = false;
-        goto terminate;
+/// Parses the weights of a TSPLIB matrix format, which are laid out in row
+/// order and may be split among lines arbitrarily
+static bool parse_edge_weight_rows(VrplibParser *p, Instance *instance) {
+    const int32_t n = instance->num_customers + 1;
+    const EdgeWeightLayout layout = p->edgew_layout;
+    const bool is_full = layout == EDGE_WEIGHT_LAYOUT_FULL_MATRIX;
+    const bool with_diag = is_full ||
+                           layout == EDGE_WEIGHT_LAYOUT_UPPER_DIAG_ROW ||
+                           layout == EDGE_WEIGHT_LAYOUT_LOWER_DIAG_ROW;
+    const bool is_lower = layout == EDGE_WEIGHT_LAYOUT_LOWER_ROW ||
+                          layout == EDGE_WEIGHT_LAYOUT_LOWER_DIAG_ROW;
+
+    for (int32_t i = 0; i < n; i++) {
+        int32_t j_begin = 0, j_end = n;
+        if (!is_full) {
+            j_begin = is_lower ? 0 : (with_diag ? i : i + 1);
+            j_end = is_lower ? (with_diag ? i + 1 : i) : n;
+        }
+
+        for (int32_t j = j_begin; j < j_end; j++) {
+            parser_skip_blanks(p);
+            double value = 0;
+            if (!strv_to_double(parser_next_lexeme(p), &value)) {
+                parse_error(p,
+                            "Expected valid double for the weight of arc "
+                            "`(%d, %d)`",
+                            i + 1, j + 1);
+                return false;
+            }
+
+            // NOTE(dparo): The diagonal entries are not stored
+            if (i == j) {
+                continue;
+            }
+
+            int64_t idx = sxpos(n, i, j);
+            if (is_full && j < i) {
+                if (instance->edge_weight[idx] != value) {
+                    parse_error(p,
+                                "FULL_MATRIX is not symmetric: the weight of "
+                                "arc `(%d, %d)` differs from `(%d, %d)`",
+                                i + 1, j + 1, j + 1, i + 1);
+                    return false;
+                }
+            } else {
+                instance->edge_weight[idx] = value;
+            }
+        }
     }
 
+    parser_skip_blanks(p);
+    return true;
+}
+
+static bool lexeme_is_node_id(StrView lexeme, int32_t node_id) {
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%d", node_id + 1);
+    return lexeme.len == (size_t)len && 0 == memcmp(lexeme.ptr, buf, len);
+}
+
+/// Checks that the first `num_records` lines at `p` are the ones of the
+/// legacy triplets layout (see `is_legacy_triplets_section`). If
+/// `whole_section`, the section must also end right after them.
+static bool matches_legacy_triplets(const VrplibParser *p, int32_t n,
+                                    int64_t num_records, bool whole_section) {
+    VrplibParser scan = *p;
+    scan.errbuf = NULL;
+    int32_t i = 0;
+    int32_t j = 1;
+
+    for (int64_t r = 0; r < num_records; r++) {
+        parser_eat_all_blanks(&scan);
+        if (!lexeme_is_node_id(parser_next_lexeme(&scan), i) ||
+            !lexeme_is_node_id(parser_next_lexeme(&scan), j) ||
+            parser_next_lexeme(&scan).len == 0 ||
+            (!parser_match_newline(&scan) && !parser_is_eof(&scan))) {
+            return false;
+        }
+        if (++j == n) {
+            ++i;
+            j = i + 1;
+        }
+    }
+
+    if (whole_section) {
+        parser_eat_all_blanks(&scan);
+        char lower = parser_is_eof(&scan) ? 'a' : (*scan.at | 0x20);
+        return lower >= 'a' && lower <= 'z';
+    }
+    return true;
+}
+
+/// Files written before the row formats were supported declare
+/// `UPPER_ROW` but actually hold triplets: exactly one `i j w` line for each
+/// arc, in row order (`1 2 w`, `1 3 w`, ...). A true `UPPER_ROW` section
+/// holds a third of those numbers, so requiring the whole layout rules out
+/// row files which happen to start with the same numbers.
+static bool is_legacy_triplets_section(VrplibParser *p, int32_t n) {
+    const int64_t num_arcs = hm_nentries(n);
+    if (num_arcs <= 0 || num_arcs >= INT32_MAX) {
+        return false;
+    }
+
+    // NOTE(dparo):
+    //     Streamed inputs are buffered in full only once the first two
+    //     records already look like the legacy ones
+    parser_fill_lines(p, 2);
+    if (!matches_legacy_triplets(p, n, MIN(2, num_arcs), false)) {
+        return false;
+    }
+    parser_fill_lines(p, (int32_t)num_arcs + 1);
+    return matches_legacy_triplets(p, n, num_arcs, true);
+}
+
+static bool parse_vrplib_edge_weight_section(VrplibParser *p,
+                                             Instance *instance) {
+    bool needs_edge_section = parser_needs_edge_section(p);
+    if (!needs_edge_section) {
+        parse_error(p, "Found un-expected `EDGE_WEIGHT_SECTION`. "
+                       "EDGE_WEIGHT_TYPE should be set accordingly");
+        return false;
+    }
+
+    assert(instance->edge_weight);
+
+    const int32_t n = instance->num_customers + 1;
+
+    if (p->edgew_layout == EDGE_WEIGHT_LAYOUT_TRIPLETS ||
+        (p->edgew_layout == EDGE_WEIGHT_LAYOUT_UPPER_ROW &&
+         is_legacy_triplets_section(p, n))) {
+        return parse_edge_weight_triplets(p, instance);
+    }
+    return parse_edge_weight_rows(p, instance);
+}
+
+static bool validate_vrplib_hdr(VrplibParser *p, const Instance *instance) {
     if (instance->num_customers <= 0) {
-        parse_error(&parser, "couldn't deduce number of customers after "
-                             "parsing the VRPLIB header");
-        result = false;
-        goto terminate;
+        parse_error(p, "couldn't deduce number of customers after "
+                       "parsing the VRPLIB header");
+        return false;
     } else if (instance->vehicle_cap <= 0.0) {
-        parse_error(&parser, "couldn't deduce vehicle capacity after "
-                             "parsing the VRPLIB header");
+        parse_error(p, "couldn't deduce vehicle capacity after "
+                       "parsing the VRPLIB header");
+        return false;
+    }
+    return true;
+}
+
+/// Parses the VRPLIB input set up in `parser`, either mapped in memory or
+/// streamed
+static bool parse_vrp_input(Instance *instance, VrplibParser *parser) {
+    bool result = true;
+
+    // First extract the header information
+    if (!parse_vrplib_hdr(parser, instance)) {
         result = false;
         goto terminate;
     }
 
-    if (!prep_memory(instance)) {
-        log_fatal("Failed to prepare memory for storing instance");
+    if (!validate_vrplib_hdr(parser, instance)) {
         result = false;
         goto terminate;
     }
 
-    bool needs_edge_section = parser_needs_edge_section(&parser);
+    bool needs_edge_section = parser_needs_edge_section(parser);
 
-    if (needs_edge_section) {
-        instance->edge_weight =
-            malloc(hm_nentries(1 + instance->num_customers) *
-                   sizeof(*instance->edge_weight));
-        if (!instance->edge_weight) {
-            log_fatal("Failed to prepare memory for storing instance");
-            result = false;
-            goto terminate;
-        }
+    if (!prep_memory(instance, needs_edge_section)) {
+        log_fatal("Failed to prepare memory for storing instance");
+        result = false;
+        goto terminate;
     }
 
     struct {
@@ -731,18 +1183,19 @@ bool parse_vrp_file(Instance *instance, FILE *filehandle,
     };
 
     while (result) {
+        parser_fill(parser);
         bool done =
-            parser_is_eof(&parser) || parser_match_string(&parser, "EOF");
+            parser_is_eof(parser) || parser_match_string(parser, "EOF");
         if (done) {
             break;
         }
 
         bool found_matching_section = false;
         for (int32_t secid = 0; secid < ARRAY_LEN_i32(sections); secid++) {
-            if (parser_match_string(&parser, sections[secid].name) &&
-                parser_match_newline(&parser)) {
+            if (parser_match_string(parser, sections[secid].name) &&
+                parser_match_newline(parser)) {
                 if (sections[secid].found) {
-                    parse_error(&parser,
+                    parse_error(parser,
                                 "Multiple definitions for section `%s`",
                                 sections[secid].name);
                     result = false;
@@ -751,9 +1204,9 @@ bool parse_vrp_file(Instance *instance, FILE *filehandle,
 
                 sections[secid].found = true;
                 found_matching_section = true;
-                result = sections[secid].parse_fn(&parser, instance);
+                result = sections[secid].parse_fn(parser, instance);
                 if (!result) {
-                    parse_error(&parser, "Failure while parsing section `%s`",
+                    parse_error(parser, "Failure while parsing section `%s`",
                                 sections[secid].name);
                     result = false;
                 }
@@ -761,18 +1214,21 @@ bool parse_vrp_file(Instance *instance, FILE *filehandle,
             }
         }
         if (!found_matching_section) {
-            parse_error(&parser, "invalid input");
+            parse_error(parser, "invalid input");
             result = false;
         }
     }
 
     if (result) {
 
-        // Keep eating whitespaces and newlines while there are any
-        parser_eat_all_blanks(&parser);
+        // Keep eating whitespaces and newlines while there are any.
+        // NOTE(dparo):
+        //     A streamed input ends at the `EOF` keyword: the peer of a
+        //     socket may wait for the solution before closing it.
+        parser_eat_all_blanks(parser);
 
-        if (parser_remainder_size(&parser) != 0) {
-            parse_error(&parser, "Found premature `EOF` while more input "
+        if (parser_remainder_size(parser) != 0) {
+            parse_error(parser, "Found premature `EOF` while more input "
                                  "is still available");
             result = false;
             goto terminate;
@@ -780,7 +1236,7 @@ bool parse_vrp_file(Instance *instance, FILE *filehandle,
 
         for (int32_t secid = 0; secid < ARRAY_LEN_i32(sections); secid++) {
             if (sections[secid].required && !sections[secid].found) {
-                parse_error(&parser, "Required section `%s` was not found",
+                parse_error(parser, "Required section `%s` was not found",
                             sections[secid].name);
                 result = false;
                 goto terminate;
@@ -789,7 +1245,7 @@ bool parse_vrp_file(Instance *instance, FILE *filehandle,
 
         if (instance->demands[0] != 0) {
             parse_error(
-                &parser,
+                parser,
                 "demand for the depot node should be `0`. Got `%f` instead",
                 instance->demands[0]);
             result = false;
@@ -798,14 +1254,355 @@ bool parse_vrp_file(Instance *instance, FILE *filehandle,
     }
 
 terminate:
-    if (buffer) {
-        free(buffer);
+    return result;
+}
+
+uint64_t cptp_binary_hash(const void *data, size_t size) {
+    assert(size % sizeof(uint64_t) == 0);
+    const uint8_t *bytes = data;
+
+    // NOTE(dparo): Same word-wise FNV-1a style combine as `bitset_hash`
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)size;
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+        uint64_t x = 0;
+        memcpy(&x, bytes + i, sizeof(x));
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        x = x ^ (x >> 31);
+        h = (h ^ x) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+enum {
+    CPTP_BINARY_MAGIC_SIZE = sizeof(((CptpBinaryHeader *)0)->magic),
+};
+
+static bool is_binary_data(const char *data, size_t size) {
+    return size >= CPTP_BINARY_MAGIC_SIZE &&
+           0 == memcmp(data, CPTP_BINARY_MAGIC, CPTP_BINARY_MAGIC_SIZE);
+}
+
+/// Checks that the array at `offset` of `size` bytes lies within the payload
+static bool binary_array_is_valid(const CptpBinaryHeader *hdr,
+                                  uint64_t offset, uint64_t size) {
+    uint64_t end = (uint64_t)hdr->header_size + hdr->payload_size;
+    return offset >= hdr->header_size && offset % CPTP_BINARY_ALIGNMENT == 0 &&
+           offset <= end && size <= end - offset;
+}
+
+/// Reads the header of the binary instance in `view`, checking that the
+/// payload is there in full (but not its content)
+static bool read_binary_header(CptpBinaryHeader *hdr, const OsFileView *view,
+                               const char *filepath) {
+    if (view->size < sizeof(*hdr)) {
+        log_fatal("%s: Truncated binary instance header", filepath);
+        return false;
+    }
+    memcpy(hdr, view->data, sizeof(*hdr));
+
+    if (hdr->version != CPTP_BINARY_VERSION ||
+        hdr->header_size != sizeof(*hdr)) {
+        log_fatal("%s: Unsupported binary instance version %u (expected %d)",
+                  filepath, hdr->version, CPTP_BINARY_VERSION);
+        return false;
+    }
+
+    if (hdr->payload_size != view->size - hdr->header_size ||
+        hdr->payload_size % sizeof(uint64_t) != 0) {
+        log_fatal("%s: Truncated or corrupted binary instance", filepath);
+        return false;
+    }
+    return true;
+}
+
+static bool parse_binary_data(Instance *instance, const OsFileView *view,
+                              const char *filepath) {
+    bool result = false;
+    CptpBinaryHeader hdr = {0};
+
+    if (!read_binary_header(&hdr, view, filepath)) {
+        goto terminate;
+    }
+
+    if (hdr.payload_hash != cptp_binary_hash(view->data + hdr.header_size,
+                                             hdr.payload_size)) {
+        log_fatal("%s: Binary instance content hash mismatch", filepath);
+        goto terminate;
+    }
+
+    // NOTE(dparo):
+    //     The header is untrusted. Bound the number of nodes by the payload
+    //     (which must hold their positions) before any size arithmetic on
+    //     it: `num_customers + 1` and the entries of the edge weight triangle
+    //     could overflow otherwise.
+    if (hdr.num_customers <= 0 || hdr.num_customers == INT32_MAX ||
+        (uint64_t)hdr.num_customers + 1 >
+            hdr.payload_size / sizeof(*instance->positions)) {
+        log_fatal("%s: Invalid binary instance header", filepath);
+        goto terminate;
+    }
+
+    const int32_t n = hdr.num_customers + 1;
+    const bool has_edge_weight = hdr.edge_weight_offset != 0;
+    const DistStorage storage = (DistStorage)hdr.edge_weight_storage;
+    const DistanceRounding rounding = (DistanceRounding)hdr.rounding_strat;
+    bool valid =
+        hdr.num_vehicles >= 0 && hdr.vehicle_cap > 0.0 &&
+        (rounding == CPTP_DIST_ROUND || rounding == CPTP_DIST_NO_ROUND ||
+         rounding == CPTP_DIST_CEIL || rounding == CPTP_DIST_FLOOR) &&
+        (storage == CPTP_DIST_STORAGE_F64 ||
+         storage == CPTP_DIST_STORAGE_F32 ||
+         storage == CPTP_DIST_STORAGE_I32) &&
+        binary_array_is_valid(&hdr, hdr.positions_offset,
+                              n * sizeof(*instance->positions)) &&
+        binary_array_is_valid(&hdr, hdr.demands_offset,
+                              n * sizeof(*instance->demands)) &&
+        (!hdr.profits_offset ||
+         binary_array_is_valid(&hdr, hdr.profits_offset,
+                               n * sizeof(*instance->profits))) &&
+        (!has_edge_weight ||
+         ((uint64_t)hm_nentries(n) <=
+              hdr.payload_size / dist_storage_elem_size(storage) &&
+          binary_array_is_valid(&hdr, hdr.edge_weight_offset,
+                                hm_nentries(n) *
+                                    dist_storage_elem_size(storage)))) &&
+        // Fixed point weights are divided by their scale
+        (!has_edge_weight || storage != CPTP_DIST_STORAGE_I32 ||
+         (isfinite(hdr.edge_weight_scale) && hdr.edge_weight_scale >= 1.0)) &&
+        (!hdr.name_offset ||
+         binary_array_is_valid(&hdr, hdr.name_offset, hdr.name_len)) &&
+        (!hdr.comment_offset ||
+         binary_array_is_valid(&hdr, hdr.comment_offset, hdr.comment_len));
+
+    if (!valid) {
+        log_fatal("%s: Invalid binary instance header", filepath);
+        goto terminate;
+    }
+
+    instance->num_customers = hdr.num_customers;
+    instance->num_vehicles = hdr.num_vehicles;
+    instance->vehicle_cap = hdr.vehicle_cap;
+    instance->rounding_strat = rounding;
+
+    if (!instance_alloc_with_storage(instance, has_edge_weight, storage)) {
+        log_fatal("Failed to prepare memory for storing instance");
+        goto terminate;
+    }
+
+    memcpy(instance->positions, view->data + hdr.positions_offset,
+           n * sizeof(*instance->positions));
+    memcpy(instance->demands, view->data + hdr.demands_offset,
+           n * sizeof(*instance->demands));
+    if (hdr.profits_offset) {
+        memcpy(instance->profits, view->data + hdr.profits_offset,
+               n * sizeof(*instance->profits));
+    }
+    if (has_edge_weight) {
+        instance->edge_weight_scale = hdr.edge_weight_scale;
+        memcpy(instance->edge_weight, view->data + hdr.edge_weight_offset,
+               hm_nentries(n) * dist_storage_elem_size(storage));
+    }
+    if (hdr.name_offset) {
+        instance->name = strndup(view->data + hdr.name_offset, hdr.name_len);
+    }
+    if (hdr.comment_offset) {
+        instance->comment =
+            strndup(view->data + hdr.comment_offset, hdr.comment_len);
+    }
+
+    result = true;
+
+terminate:
+    return result;
+}
+
+/// Reads until `size` bytes of a streamed input are buffered (or the input
+/// is over), never past them. The buffer grows along with the bytes
+/// actually read, not to `size` upfront: it may come from an untrusted
+/// header.
+static void parser_stream_read(ParserStream *s, size_t size,
+                               const char *filepath) {
+    while (s->len < size && !s->eof) {
+        if (s->len == s->cap) {
+            size_t cap =
+                MIN(size, MAX((size_t)PARSER_STREAM_CHUNK_SIZE, 2 * s->cap));
+            char *buf = realloc(s->buf, cap);
+            if (!buf) {
+                log_fatal("%s :: Failed memory allocation", __func__);
+                s->eof = s->failed = true;
+                return;
+            }
+            s->buf = buf;
+            s->cap = cap;
+        }
+
+        size_t want = MIN(size, s->cap) - s->len;
+        ssize_t got = read(s->fd, s->buf + s->len, want);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got < 0) {
+            log_fatal("%s :: Failed to read `%s`: %s", __func__, filepath,
+                      strerror(errno));
+            s->eof = s->failed = true;
+        } else if (got == 0) {
+            s->eof = true;
+        } else {
+            s->len += (size_t)got;
+        }
+    }
+}
+
+/// Parses an input which cannot be mapped in memory (pipes, sockets, ...).
+/// Its format is told by peeking at its first bytes.
+static bool parse_stream(Instance *instance, int fd, const char *filepath) {
+    bool result = false;
+    ParserStream stream = {.fd = fd, .cap = PARSER_STREAM_CHUNK_SIZE};
+    stream.buf = malloc(stream.cap);
+    if (!stream.buf) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        goto terminate;
+    }
+
+    parser_stream_read(&stream, CPTP_BINARY_MAGIC_SIZE, filepath);
+    if (stream.failed) {
+        goto terminate;
+    }
+
+    if (is_binary_data(stream.buf, stream.len)) {
+        // NOTE(dparo):
+        //     The binary payload is buffered in full. A header lying about
+        //     its size costs at most the bytes actually sent, see
+        //     `parser_stream_read`.
+        CptpBinaryHeader hdr = {0};
+        parser_stream_read(&stream, sizeof(hdr), filepath);
+        if (stream.len == sizeof(hdr)) {
+            memcpy(&hdr, stream.buf, sizeof(hdr));
+            if (hdr.header_size == sizeof(hdr) &&
+                hdr.payload_size <= SIZE_MAX - sizeof(hdr)) {
+                parser_stream_read(&stream, sizeof(hdr) + hdr.payload_size,
+                                   filepath);
+            }
+        }
+        OsFileView view = {.data = stream.buf, .size = stream.len};
+        result = !stream.failed &&
+                 parse_binary_data(instance, &view, filepath);
+    } else {
+        VrplibParser parser = {0};
+        parser.filename = filepath;
+        parser.base = stream.buf;
+        parser.at = stream.buf;
+        parser.stream = &stream;
+        result = parse_vrp_input(instance, &parser) && !stream.failed;
+    }
+
+terminate:
+    free(stream.buf);
+    return result;
+}
+
+/// Parses the VRPLIB (or binary) instance read from `fd`. Regular files are
+/// mapped in memory, anything else is streamed.
+static bool parse_fd_impl(Instance *instance, int fd, const char *filepath) {
+    struct stat st;
+    if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+        return parse_stream(instance, fd, filepath);
     }
+
+    // NOTE(dparo):
+    //     The file is mapped in memory (not copied), and the lexemes are
+    //     views into the mapping. The input is thus *NOT* NUL terminated.
+    OsFileView view = {0};
+    if (!os_file_view_open(fd, &view)) {
+        log_fatal("%s :: Failed to read `%s`", __func__, filepath);
+        return false;
+    }
+
+    bool result = false;
+    if (is_binary_data(view.data, view.size)) {
+        result = parse_binary_data(instance, &view, filepath);
+    } else {
+        VrplibParser parser = {0};
+        parser.filename = filepath;
+        parser.base = view.data;
+        parser.at = view.data;
+        parser.size = view.size;
+        result = parse_vrp_input(instance, &parser);
+    }
+
+    os_file_view_close(&view);
     return result;
 }
 
+static bool parse_vrp_header(InstanceHeader *header, const OsFileView *view,
+                             const char *filepath) {
+    Instance instance = {0};
+    VrplibParser parser = {0};
+    parser.filename = filepath;
+    parser.base = view->data;
+    parser.at = view->data;
+    parser.size = view->size;
+
+    bool result = parse_vrplib_hdr(&parser, &instance) &&
+                  validate_vrplib_hdr(&parser, &instance);
+    if (result) {
+        header->name = instance.name;
+        instance.name = NULL;
+        header->num_customers = instance.num_customers;
+        header->num_vehicles = instance.num_vehicles;
+        header->vehicle_cap = instance.vehicle_cap;
+        header->has_edge_weight = parser_needs_edge_section(&parser);
+    }
+    instance_destroy(&instance);
+    return result;
+}
+
+static bool parse_binary_header(InstanceHeader *header,
+                                const OsFileView *view,
+                                const char *filepath) {
+    CptpBinaryHeader hdr = {0};
+    if (!read_binary_header(&hdr, view, filepath)) {
+        return false;
+    }
+
+    if (hdr.num_customers <= 0 || hdr.num_vehicles < 0 ||
+        hdr.vehicle_cap <= 0.0 ||
+        (hdr.name_offset &&
+         !binary_array_is_valid(&hdr, hdr.name_offset, hdr.name_len))) {
+        log_fatal("%s: Invalid binary instance header", filepath);
+        return false;
+    }
+
+    if (hdr.name_offset) {
+        header->name = strndup(view->data + hdr.name_offset, hdr.name_len);
+    }
+    header->num_customers = hdr.num_customers;
+    header->num_vehicles = hdr.num_vehicles;
+    header->vehicle_cap = hdr.vehicle_cap;
+    header->has_edge_weight = hdr.edge_weight_offset != 0;
+    return true;
+}
+
+static Instance finalize_parsed_instance(Instance instance, bool success,
+                                         const char *filepath) {
+    if (success) {
+        if (!instance.name || instance.name[0] == '\0') {
+            instance_set_name(&instance, filepath);
+        }
+        instance_compact_edge_weight(&instance);
+#if CPTP_DIST_CACHE_ENABLED
+        instance_build_dist_cache(&instance);
+#endif
+    } else {
+        instance_destroy(&instance);
+    }
+    return instance;
+}
+
 typedef enum {
     PARSING_FILE_EXT_AUTODETECT = 0,
+    /// VRPLIB, or binary as told by the magic number
     PARSING_FILE_EXT_VRPLIB = 1,
     PARSING_FILE_EXT_SIMPLIFIED_VRP = 2,
 } ParsingFileExt;
@@ -832,7 +1629,7 @@ static Instance parse_impl(const char *filepath, ParsingFileExt ext) {
             success = parse_simplified_vrp_file(&result, filehandle, filepath);
             break;
         case PARSING_FILE_EXT_VRPLIB:
-            success = parse_vrp_file(&result, filehandle, filepath);
+            success = parse_fd_impl(&result, fileno(filehandle), filepath);
             break;
         default:
             assert(!"Invalid code path");
@@ -841,17 +1638,70 @@ static Instance parse_impl(const char *filepath, ParsingFileExt ext) {
         fclose(filehandle);
     }
 
-    if (success) {
-        if (!result.name || result.name[0] == '\0') {
-            instance_set_name(&result, filepath);
-        }
-        return result;
-    } else {
-        instance_destroy(&result);
-        return result;
-    }
+    return finalize_parsed_instance(result, success, filepath);
 }
 
 Instance parse(const char *filepath) {
     return parse_impl(filepath, PARSING_FILE_EXT_AUTODETECT);
 }
+
+bool parse_header(const char *filepath, InstanceHeader *header) {
+    memset(header, 0, sizeof(*header));
+    FILE *filehandle = fopen(filepath, "r");
+    if (!filehandle) {
+        return false;
+    }
+
+    bool result = false;
+    const char *extstring = os_get_fext(filepath);
+    if (extstring && 0 == strcmp(extstring, "simplified-vrp")) {
+        Instance instance = {0};
+        int32_t line_cnt = 0;
+        result = parse_simplified_vrp_hdr(&instance, filehandle, filepath,
+                                          &line_cnt);
+        header->num_customers = instance.num_customers;
+        header->num_vehicles = instance.num_vehicles;
+        header->vehicle_cap = instance.vehicle_cap;
+    } else {
+        // NOTE(dparo):
+        //     The mapping is lazy: only the pages holding the header are
+        //     ever read from disk.
+        OsFileView view = {0};
+        if (os_file_view_open(fileno(filehandle), &view)) {
+            if (is_binary_data(view.data, view.size)) {
+                result = parse_binary_header(header, &view, filepath);
+            } else {
+                result = parse_vrp_header(header, &view, filepath);
+            }
+            os_file_view_close(&view);
+        } else {
+            log_fatal("%s :: Failed to read `%s`", __func__, filepath);
+        }
+    }
+    fclose(filehandle);
+
+    if (result && (!header->name || header->name[0] == '\0')) {
+        free(header->name);
+        header->name = strdup(filepath);
+    }
+    if (!result) {
+        instance_header_destroy(header);
+    }
+    return result;
+}
+
+void instance_header_destroy(InstanceHeader *header) {
+    free(header->name);
+    memset(header, 0, sizeof(*header));
+}
+
+Instance parse_fd(int fd, const char *name) {
+    Instance result = {0};
+    result.rounding_strat = CPTP_DIST_ROUND;
+    bool success = parse_fd_impl(&result, fd, name);
+    return finalize_parsed_instance(result, success, name);
+}
+
+Instance parse_file(FILE *filehandle, const char *name) {
+    return parse_fd(fileno(filehandle), name);
+}
@@ -24,4 +24,80 @@
 
 #include "core.h"
 
+/// Extension conventionally used by the binary instances (see
+/// `CptpBinaryHeader`). `parse` recognizes them by their magic number alone.
+#define CPTP_BINARY_FEXT "vrpbin"
+#define CPTP_BINARY_MAGIC "CPTPINST"
+
+enum {
+    CPTP_BINARY_VERSION = 1,
+    /// Alignment of the header size and of every array in the payload
+    CPTP_BINARY_ALIGNMENT = 64,
+};
+
+/// Header of the binary instance format. The payload follows, holding the
+/// arrays of the instance laid out exactly as in memory (SoA, native
+/// endianness), each one starting at a `CPTP_BINARY_ALIGNMENT` aligned
+/// offset. Loading it reduces to validating the header and copying the
+/// arrays.
+typedef struct CptpBinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    /// Size and `cptp_binary_hash` of the bytes following the header
+    uint64_t payload_size;
+    uint64_t payload_hash;
+
+    int32_t num_customers;
+    int32_t num_vehicles;
+    double vehicle_cap;
+    int32_t rounding_strat;
+    /// `DistStorage` of the `edge_weight` triangle, if any
+    int32_t edge_weight_storage;
+    double edge_weight_scale;
+
+    /// Offsets from the beginning of the file, 0 for the missing arrays.
+    /// The strings are NOT NUL terminated.
+    uint64_t name_offset;
+    uint64_t name_len;
+    uint64_t comment_offset;
+    uint64_t comment_len;
+    uint64_t positions_offset;
+    uint64_t demands_offset;
+    uint64_t profits_offset;
+    uint64_t edge_weight_offset;
+} CptpBinaryHeader;
+
+/// Content hash embedded in the binary instances. `size` must be a
+/// multiple of 8.
+uint64_t cptp_binary_hash(const void *data, size_t size);
+
 Instance parse(const char *filepath);
+
+/// Parses a VRPLIB or binary instance from `fd`. Regular files are mapped in
+/// memory, while pipes, sockets and terminals are read incrementally: a
+/// VRPLIB input is buffered one line at a time, and ends at its `EOF`
+/// keyword. `name` names the input in the diagnostics, and the instance if
+/// it doesn't declare one.
+Instance parse_fd(int fd, const char *name);
+
+/// Same as `parse_fd` over the descriptor of `filehandle`: nothing must have
+/// been read from it through stdio yet.
+Instance parse_file(FILE *filehandle, const char *name);
+
+/// Specification part of an instance, as probed by `parse_header`
+typedef struct InstanceHeader {
+    char *name;
+    int32_t num_customers;
+    int32_t num_vehicles;
+    double vehicle_cap;
+    /// Whether the distances are given explicitly (`EDGE_WEIGHT_SECTION`)
+    bool has_edge_weight;
+} InstanceHeader;
+
+/// Reads only the specification part of the instance at `filepath` (NAME,
+/// DIMENSION, CAPACITY, EDGE_WEIGHT_TYPE, ...), stopping before its first
+/// section: cheap enough to filter out instances before fully parsing them.
+/// The sections are not validated.
+bool parse_header(const char *filepath, InstanceHeader *header);
+void instance_header_destroy(InstanceHeader *header);
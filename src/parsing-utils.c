@@ -25,98 +25,101 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <errno.h>
-
-bool str_to_int32(const char *string, int32_t *out) {
-    size_t len = strlen(string);
-    int base = 10;
-
-    bool is_negated = false;
-    if (len >= 1 && (string[0] == '-' || string[0] == '+')) {
-        is_negated = string[0] == '-';
-
-        len -= 1;
-        string += 1;
+#include <locale.h>
+#include <pthread.h>
+
+/// Parses the digits of `s` in `base` (2, 10 or 16). Fails on empty input,
+/// invalid digits, or on values larger than `max`
+static bool parse_digits(StrView s, int base, uint64_t max, uint64_t *out) {
+    if (s.len == 0) {
+        return false;
     }
 
-    if (len >= 2 && string[0] == '0' && string[1] == 'x') {
-        base = 16;
-        string += 2;
-        len -= 2;
-    } else if (len >= 2 && string[0] == '0' && string[1] == 'b') {
-        base = 2;
-        string += 2;
-        len -= 2;
+    uint64_t value = 0;
+    for (size_t i = 0; i < s.len; i++) {
+        char c = s.ptr[i];
+        char lower = c | 0x20;
+        uint64_t digit = 0;
+        if (c >= '0' && c <= '9') {
+            digit = (uint64_t)(c - '0');
+        } else if (lower >= 'a' && lower <= 'f') {
+            digit = (uint64_t)(lower - 'a' + 10);
+        } else {
+            return false;
+        }
+
+        if (digit >= (uint64_t)base || value > (max - digit) / base) {
+            return false;
+        }
+        value = value * base + digit;
     }
 
-    STATIC_ASSERT(sizeof(long) >= sizeof(int32_t),
-                  "These sizes should match so that we can use the correct "
-                  "strtoXXX C function");
-
-    char *endptr = NULL;
-    errno = 0;
-    long conv_ret_val = strtol(string, &endptr, base);
-    conv_ret_val *= is_negated ? -1 : +1;
+    *out = value;
+    return true;
+}
 
-    bool out_of_range = (errno == ERANGE) || (conv_ret_val < INT32_MIN) ||
-                        (conv_ret_val > INT32_MAX);
+/// Eats the optional sign and base prefix (`0x` or `0b`) of an integer
+static StrView eat_integer_prefix(StrView s, bool *is_negated, int *base) {
+    *is_negated = false;
+    *base = 10;
 
-    bool failed =
-        len == 0 || out_of_range || endptr == string || endptr == NULL;
-    bool result = !failed && *endptr == '\0';
+    if (s.len >= 1 && (s.ptr[0] == '-' || s.ptr[0] == '+')) {
+        *is_negated = s.ptr[0] == '-';
+        s.ptr += 1;
+        s.len -= 1;
+    }
 
-    if (result) {
-        *out = conv_ret_val;
-    } else {
-        *out = INT32_MIN;
+    if (s.len >= 2 && s.ptr[0] == '0' && s.ptr[1] == 'x') {
+        *base = 16;
+        s.ptr += 2;
+        s.len -= 2;
+    } else if (s.len >= 2 && s.ptr[0] == '0' && s.ptr[1] == 'b') {
+        *base = 2;
+        s.ptr += 2;
+        s.len -= 2;
     }
 
-    return result;
+    return s;
 }
 
-bool str_to_usize(const char *string, size_t *out) {
-    size_t len = strlen(string);
-    int base = 10;
-
+bool strv_to_int32(StrView s, int32_t *out) {
     bool is_negated = false;
-    if (len >= 1 && (string[0] == '-' || string[0] == '+')) {
-        is_negated = string[0] == '-';
-
-        len -= 1;
-        string += 1;
-    }
+    int base = 10;
+    StrView digits = eat_integer_prefix(s, &is_negated, &base);
 
-    if (len >= 2 && string[0] == '0' && string[1] == 'x') {
-        base = 16;
-        string += 2;
-        len -= 2;
-    } else if (len >= 2 && string[0] == '0' && string[1] == 'b') {
-        base = 2;
-        string += 2;
-        len -= 2;
+    // NOTE(dparo): INT32_MIN has no positive counterpart
+    uint64_t max = is_negated ? (uint64_t)INT32_MAX + 1 : (uint64_t)INT32_MAX;
+    uint64_t value = 0;
+    if (!parse_digits(digits, base, max, &value)) {
+        *out = INT32_MIN;
+        return false;
     }
 
-    STATIC_ASSERT(sizeof(uintmax_t) >= sizeof(size_t),
-                  "These sizes should match so that we can use the correct "
-                  "strtoXXX C function");
-
-    char *endptr = NULL;
-    errno = 0;
-    uintmax_t conv_ret_val = strtoumax(string, &endptr, base);
-
-    bool out_of_range =
-        (errno == ERANGE) || (conv_ret_val > UINTMAX_MAX) || is_negated;
+    *out = is_negated ? (int32_t)(-(int64_t)value) : (int32_t)value;
+    return true;
+}
 
-    bool failed =
-        len == 0 || out_of_range || endptr == string || endptr == NULL;
-    bool result = !failed && *endptr == '\0';
+bool strv_to_usize(StrView s, size_t *out) {
+    bool is_negated = false;
+    int base = 10;
+    StrView digits = eat_integer_prefix(s, &is_negated, &base);
 
-    if (result) {
-        *out = conv_ret_val;
-    } else {
+    uint64_t value = 0;
+    if (is_negated || !parse_digits(digits, base, SIZE_MAX, &value)) {
         *out = 0;
+        return false;
     }
 
-    return result;
+    *out = (size_t)value;
+    return true;
+}
+
+bool str_to_int32(const char *string, int32_t *out) {
+    return strv_to_int32(strv_from_cstr(string), out);
+}
+
+bool str_to_usize(const char *string, size_t *out) {
+    return strv_to_usize(strv_from_cstr(string), out);
 }
 
 bool str_to_float(const char *string, float *out) {
@@ -147,34 +150,169 @@ bool str_to_float(const char *string, float *out) {
     return result;
 }
 
-bool str_to_double(const char *string, double *out) {
-    size_t len = strlen(string);
+static locale_t C_LOCALE = (locale_t)0;
+
+static void init_c_locale(void) {
+    C_LOCALE = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+}
+
+enum {
+    // Longest input handled by the slow path without heap allocations
+    MAX_STACK_NUMBER_LEN = 128,
+    // Up to 19 decimal digits always fit in an uint64_t
+    MAX_FAST_PATH_DIGITS = 19,
+    MAX_FAST_PATH_EXP10 = 22,
+};
+
+/// Exactly representable powers of 10
+static const double POW10[MAX_FAST_PATH_EXP10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/// Fast path for plain decimal numbers (`[+-]ddd.ddd[eE[+-]ddd][fF]`) whose
+/// value can be computed with a single correctly rounded operation (see
+/// Clinger, "How to Read Floating Point Numbers Accurately"). Returns false
+/// for everything else, which is handed to the exact slow path.
+static bool parse_double_fast(StrView s, double *out) {
+    const char *at = s.ptr;
+    const char *end = s.ptr + s.len;
+
+    if (at < end && (end[-1] == 'f' || end[-1] == 'F')) {
+        end--;
+    }
+
+    bool is_negated = false;
+    if (at < end && (*at == '-' || *at == '+')) {
+        is_negated = *at == '-';
+        at++;
+    }
+
+    uint64_t mantissa = 0;
+    int32_t num_digits = 0;
+    int32_t exp10 = 0;
+    bool any_digit = false;
+
+    for (; at < end && *at >= '0' && *at <= '9'; at++) {
+        any_digit = true;
+        if (mantissa != 0 || *at != '0') {
+            mantissa = mantissa * 10 + (uint64_t)(*at - '0');
+            num_digits++;
+        }
+        if (num_digits > MAX_FAST_PATH_DIGITS) {
+            return false;
+        }
+    }
+
+    if (at < end && *at == '.') {
+        for (at++; at < end && *at >= '0' && *at <= '9'; at++) {
+            any_digit = true;
+            if (mantissa != 0 || *at != '0') {
+                mantissa = mantissa * 10 + (uint64_t)(*at - '0');
+                num_digits++;
+            }
+            exp10--;
+            if (num_digits > MAX_FAST_PATH_DIGITS) {
+                return false;
+            }
+        }
+    }
+
+    if (!any_digit) {
+        return false;
+    }
+
+    if (at < end && (*at == 'e' || *at == 'E')) {
+        at++;
+        bool exp_negated = false;
+        if (at < end && (*at == '-' || *at == '+')) {
+            exp_negated = *at == '-';
+            at++;
+        }
+        if (at == end) {
+            return false;
+        }
+
+        int32_t e = 0;
+        for (; at < end && *at >= '0' && *at <= '9'; at++) {
+            if (e > 1000) {
+                return false;
+            }
+            e = e * 10 + (*at - '0');
+        }
+        exp10 += exp_negated ? -e : e;
+    }
+
+    // Trailing garbage, or a value needing more than one rounding
+    if (at != end || mantissa > (UINT64_C(1) << 53) ||
+        exp10 < -MAX_FAST_PATH_EXP10 || exp10 > MAX_FAST_PATH_EXP10) {
+        return false;
+    }
+
+    double value = (double)mantissa;
+    if (exp10 < 0) {
+        value /= POW10[-exp10];
+    } else {
+        value *= POW10[exp10];
+    }
+
+    *out = is_negated ? -value : value;
+    return true;
+}
+
+/// Exact (and slow) path: `strtod` on a NUL terminated copy of `s`. The
+/// conversion is run within the "C" locale, such that the decimal separator
+/// is always the dot.
+static bool parse_double_slow(StrView s, double *out) {
+    char stack_buf[MAX_STACK_NUMBER_LEN];
+    char *buf = s.len < sizeof(stack_buf) ? stack_buf : malloc(s.len + 1);
+    if (!buf) {
+        return false;
+    }
+    memcpy(buf, s.ptr, s.len);
+    buf[s.len] = 0;
+
+    static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+    pthread_once(&c_locale_once, init_c_locale);
+    locale_t prev_locale = C_LOCALE ? uselocale(C_LOCALE) : NULL;
 
     bool terminating_f =
-        len >= 1 && (string[len - 1] == 'f' || string[len - 1] == 'F');
+        s.len >= 1 && (buf[s.len - 1] == 'f' || buf[s.len - 1] == 'F');
 
     char *endptr = NULL;
-
     errno = 0;
-    double conv_ret_val = strtod(string, &endptr);
+    double conv_ret_val = strtod(buf, &endptr);
 
     bool out_of_range = (errno == ERANGE);
     bool failed =
-        len == 0 || out_of_range || endptr == string || endptr == NULL;
-
-    bool valid_endptr =
-        *endptr == '\0' || (terminating_f && endptr == string + len - 1);
+        s.len == 0 || out_of_range || endptr == buf || endptr == NULL;
+    bool valid_endptr = endptr == buf + s.len ||
+                        (terminating_f && endptr == buf + s.len - 1);
     bool result = !failed && valid_endptr;
 
-    if (result) {
-        *out = conv_ret_val;
-    } else {
-        *out = NAN;
+    if (prev_locale) {
+        uselocale(prev_locale);
+    }
+    if (buf != stack_buf) {
+        free(buf);
     }
 
+    *out = conv_ret_val;
     return result;
 }
 
+bool strv_to_double(StrView s, double *out) {
+    if (parse_double_fast(s, out) || parse_double_slow(s, out)) {
+        return true;
+    }
+    *out = NAN;
+    return false;
+}
+
+bool str_to_double(const char *string, double *out) {
+    return strv_to_double(strv_from_cstr(string), out);
+}
+
 bool str_to_bool(const char *string, bool *out) {
     if ((0 == strcasecmp(string, "true")) || (0 == strcmp(string, "1"))) {
         *out = true;
@@ -26,15 +26,34 @@
 extern "C" {
 #endif
 
+#include <string.h>
+
 #include "types.h"
 #include "misc.h"
 
+/// Non owning, not necessarily NUL terminated, view over a string
+typedef struct StrView {
+    const char *ptr;
+    size_t len;
+} StrView;
+
+static inline StrView strv_from_cstr(const char *string) {
+    return (StrView){string, strlen(string)};
+}
+
 bool str_to_int32(const char *string, int32_t *out);
 bool str_to_double(const char *string, double *out);
 bool str_to_float(const char *string, float *out);
 bool str_to_bool(const char *string, bool *out);
 bool str_to_usize(const char *string, size_t *out);
 
+/// Same as their `str_to_*` counterparts, but parse the view in place
+/// without requiring NUL termination. Plain decimal numbers take a fast
+/// path, and the result never depends on the current locale.
+bool strv_to_int32(StrView s, int32_t *out);
+bool strv_to_usize(StrView s, size_t *out);
+bool strv_to_double(StrView s, double *out);
+
 #if __cplusplus
 }
 #endif
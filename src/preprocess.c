@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "preprocess.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "core-utils.h"
+
+/// Upper bound on the amount by which the triangle inequality can be
+/// violated by the distances of the instance, due to rounding.
+static double triangle_inequality_slack(const Instance *instance) {
+    // NOTE(dparo): Explicit edge weights are not guaranteed to be metric
+    if (instance->edge_weight) {
+        return INFINITY;
+    }
+
+    // NOTE(dparo):
+    //     Given x + y >= z, with x, y, z euclidean distances:
+    //       - ceil(x) + ceil(y) >= ceil(z)
+    //       - round(x) + round(y) >= round(z) - 1
+    //       - floor(x) + floor(y) >= floor(z) - 1
+    switch (instance->rounding_strat) {
+    case CPTP_DIST_NO_ROUND:
+    case CPTP_DIST_CEIL:
+        return 0.0;
+    case CPTP_DIST_ROUND:
+    case CPTP_DIST_FLOOR:
+        return 1.0;
+    default:
+        assert(!"Invalid code path!");
+        return INFINITY;
+    }
+}
+
+/// Searches for a pair of nodes `(a, b)` such that visiting `i` in between
+/// them costs at most its profit. Returns true if no such pair exists.
+/// `di` holds the distances from `i`. Gives up (returning false) when the
+/// `budget` of pair evaluations is exhausted.
+static bool has_no_profitable_insertion(const Instance *instance, int32_t i,
+                                        const double *di, double pi,
+                                        int64_t *budget) {
+    const int32_t n = instance->num_customers + 1;
+    const double threshold = pi + COST_TOLERANCE;
+
+    for (int32_t a = 0; a < n; a++) {
+        if (a == i) {
+            continue;
+        }
+
+        if (*budget < n) {
+            return false;
+        }
+        *budget -= n - a;
+
+        for (int32_t b = a + 1; b < n; b++) {
+            if (b == i) {
+                continue;
+            }
+            double detour = di[a] + di[b] - cptp_dist(instance, a, b);
+            if (detour <= threshold) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/// Searches for the cheapest tour `0 -> i -> j -> 0` serving two customers
+/// within the vehicle capacity. Returns false if no such tour exists.
+static bool find_best_pair(const Instance *instance, int32_t *best_i,
+                           int32_t *best_j) {
+    const int32_t n = instance->num_customers + 1;
+    const double Q = instance->vehicle_cap;
+    double best_cost = INFINITY;
+
+    for (int32_t i = 1; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            if (instance->demands[i] + instance->demands[j] > Q) {
+                continue;
+            }
+            double cost = cptp_dist(instance, 0, i) +
+                          cptp_dist(instance, i, j) +
+                          cptp_dist(instance, j, 0) - instance->profits[i] -
+                          instance->profits[j];
+            if (cost < best_cost) {
+                best_cost = cost;
+                *best_i = i;
+                *best_j = j;
+            }
+        }
+    }
+
+    return best_cost < INFINITY;
+}
+
+int32_t eliminate_customers(const Instance *instance, Bitset *eliminated) {
+    const int32_t n = instance->num_customers + 1;
+    const double Q = instance->vehicle_cap;
+    const double slack = triangle_inequality_slack(instance);
+    int64_t budget = MIN(CUSTOMER_ELIMINATION_SCAN_BUDGET,
+                         CUSTOMER_ELIMINATION_SCAN_FACTOR * (int64_t)n * n);
+    int32_t num_eliminated = 0;
+
+    assert(eliminated->nbits >= n);
+    bitset_clear(eliminated);
+
+    // NOTE(dparo):
+    //     The tours of the MIP model serve at least two customers, thus
+    //     shortcutting a customer is only possible in the tours serving
+    //     three or more. The two customers of the cheapest pair tour are
+    //     kept, which bounds every two customers tour that is not reachable
+    //     through shortcuts.
+    int32_t pair_i = -1;
+    int32_t pair_j = -1;
+    if (!find_best_pair(instance, &pair_i, &pair_j)) {
+        log_warn("%s :: No tour serving two customers fits in the vehicle",
+                 __func__);
+        return 0;
+    }
+
+    double *di = malloc(n * sizeof(*di));
+    if (!di) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        return 0;
+    }
+
+    for (int32_t i = 1; i < n; i++) {
+        const double pi = instance->profits[i];
+        bool eliminate = false;
+
+        if (i == pair_i || i == pair_j) {
+            continue;
+        }
+
+        if (instance->demands[i] > Q) {
+            eliminate = true;
+        } else if (pi < -(slack + COST_TOLERANCE)) {
+            // NOTE(dparo): Every detour is at least -slack, which is already
+            //     more than the profit
+            eliminate = true;
+        } else {
+            for (int32_t j = 0; j < n; j++) {
+                di[j] = i == j ? 0.0 : cptp_dist(instance, i, j);
+            }
+            eliminate =
+                has_no_profitable_insertion(instance, i, di, pi, &budget);
+        }
+
+        if (eliminate) {
+            bitset_set(eliminated, i);
+            ++num_eliminated;
+        }
+    }
+
+    if (budget <= 0) {
+        log_warn("%s :: Exhausted the scan budget, the elimination may be "
+                 "incomplete",
+                 __func__);
+    }
+
+    free(di);
+    return num_eliminated;
+}
+
+bool reduced_instance_create(ReducedInstance *reduced,
+                             const Instance *instance,
+                             const Bitset *eliminated) {
+    const int32_t n = instance->num_customers + 1;
+    memset(reduced, 0, sizeof(*reduced));
+
+    assert(!bitset_test(eliminated, 0));
+    reduced->num_eliminated = bitset_popcount(eliminated);
+
+    const int32_t m = n - reduced->num_eliminated;
+    reduced->orig_node = malloc(m * sizeof(*reduced->orig_node));
+    if (!reduced->orig_node) {
+        goto fail;
+    }
+
+    for (int32_t i = 0, u = 0; i < n; i++) {
+        if (!bitset_test(eliminated, i)) {
+            reduced->orig_node[u++] = i;
+        }
+    }
+
+    Instance *sub = &reduced->instance;
+    sub->num_customers = m - 1;
+    sub->num_vehicles = instance->num_vehicles;
+    sub->vehicle_cap = instance->vehicle_cap;
+    sub->rounding_strat = instance->rounding_strat;
+    sub->name = instance->name ? strdup(instance->name) : NULL;
+    sub->comment = instance->comment ? strdup(instance->comment) : NULL;
+
+    const bool with_edge_weight = instance->edge_weight != NULL;
+    if (!instance_alloc(sub, with_edge_weight)) {
+        goto fail;
+    }
+
+    for (int32_t u = 0; u < m; u++) {
+        int32_t i = reduced->orig_node[u];
+        sub->positions[u] = instance->positions[i];
+        sub->demands[u] = instance->demands[i];
+        sub->profits[u] = instance->profits[i];
+    }
+
+    if (with_edge_weight) {
+        for (int32_t u = 0; u < m; u++) {
+            for (int32_t v = u + 1; v < m; v++) {
+                sub->edge_weight[sxpos(m, u, v)] =
+                    cptp_dist(instance, reduced->orig_node[u],
+                              reduced->orig_node[v]);
+            }
+        }
+        instance_compact_edge_weight(sub);
+    } else if (instance->dist_cache) {
+        instance_build_dist_cache(sub);
+    }
+
+    return true;
+
+fail:
+    log_fatal("%s :: Failed memory allocation", __func__);
+    reduced_instance_destroy(reduced);
+    return false;
+}
+
+void reduced_instance_destroy(ReducedInstance *reduced) {
+    instance_destroy(&reduced->instance);
+    free(reduced->orig_node);
+    memset(reduced, 0, sizeof(*reduced));
+}
+
+static void map_tour(const ReducedInstance *reduced, const Tour *src,
+                     Tour *dest) {
+    const int32_t m = reduced->instance.num_customers + 1;
+    assert(src->num_customers + 1 == m);
+
+    tour_clear(dest);
+    dest->num_comps = src->num_comps;
+
+    for (int32_t u = 0; u < m; u++) {
+        int32_t i = reduced->orig_node[u];
+        int32_t c = src->comp[u];
+        int32_t s = src->succ[u];
+
+        dest->comp[i] = c;
+        if (c >= 0 && s >= 0 && s < m) {
+            dest->succ[i] = reduced->orig_node[s];
+        }
+    }
+}
+
+void reduced_instance_map_solution(const ReducedInstance *reduced,
+                                   const Solution *src, Solution *dest) {
+    dest->primal_bound = src->primal_bound;
+    dest->dual_bound = src->dual_bound;
+    map_tour(reduced, &src->tour, &dest->tour);
+
+    dest->columns.num_columns = 0;
+    if (src->columns.num_columns > 0 && dest->columns.capacity > 0) {
+        Tour mapped = tour_copy(&dest->tour);
+        for (int32_t k = 0; k < src->columns.num_columns; k++) {
+            // NOTE(dparo):
+            //     The kept nodes have the same profits and distances in
+            //     both instances, so is the reduced cost of the columns
+            map_tour(reduced, &src->columns.tours[k], &mapped);
+            solution_add_column_with_cost(dest, &mapped,
+                                          src->columns.reduced_costs[k]);
+        }
+        tour_destroy(&mapped);
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+/// Sub-instance obtained by removing the customers which are proven
+/// redundant by `eliminate_customers`. Node `u` of `instance` corresponds to
+/// node `orig_node[u]` of the instance it was derived from. The depot is
+/// always kept, thus `orig_node[0] == 0`.
+typedef struct ReducedInstance {
+    Instance instance;
+    int32_t num_eliminated;
+    int32_t *orig_node;
+} ReducedInstance;
+
+/// Marks in `eliminated` (created with at least `num_customers + 1` bits) the
+/// customers which can be dropped without changing the optimal tour value.
+/// Tours serve at least two customers, as in the MIP model. The two
+/// customers of the cheapest two customers tour are always kept. Any other
+/// customer `i` is eliminated if:
+///   - its demand exceeds the vehicle capacity, or
+///   - for every pair of distinct nodes `(a, b)`, the detour
+///     `d(a, i) + d(i, b) - d(a, b)` exceeds its profit. Shortcutting `i` out
+///     of any tour serving three or more customers then strictly improves
+///     the tour.
+/// Nothing is eliminated when no two customers fit together in the vehicle.
+/// Returns the number of eliminated customers.
+int32_t eliminate_customers(const Instance *instance, Bitset *eliminated);
+
+/// Builds the compacted instance made of the nodes not in `eliminated`.
+bool reduced_instance_create(ReducedInstance *reduced,
+                             const Instance *instance,
+                             const Bitset *eliminated);
+void reduced_instance_destroy(ReducedInstance *reduced);
+
+/// Maps a solution of the reduced instance back to the original instance,
+/// columns included (up to the capacity of `dest`).
+void reduced_instance_map_solution(const ReducedInstance *reduced,
+                                   const Solution *src, Solution *dest);
+
+#if __cplusplus
+}
+#endif
@@ -22,6 +22,8 @@
 
 #include "render.h"
 #include "core-utils.h"
+#include "parser.h"
+#include "spatial-index.h"
 #include <stdio.h>
 
 static void compute_plotting_region(const Instance *instance, double *llx,
@@ -76,26 +78,23 @@ bool render_tour_image(const char *filepath, const Instance *instance,
     bool result = true;
 
     double min_dist = 9999999999;
-    double smaller_coord = 9999999999;
     double llx, lly, w, h;
 
     compute_plotting_region(instance, &llx, &lly, &w, &h);
 
-    for (int32_t i = 0; i < n; i++) {
-        for (int32_t j = 0; j < n; j++) {
-            if (i != j) {
-                const Vec2d *ipos = &instance->positions[i];
-                const Vec2d *jpos = &instance->positions[j];
-
-                smaller_coord = MIN(smaller_coord, ipos->x);
-                smaller_coord = MIN(smaller_coord, ipos->y);
-                smaller_coord = MIN(smaller_coord, jpos->x);
-                smaller_coord = MIN(smaller_coord, jpos->y);
-
-                double d = vec2d_dist(ipos, jpos);
+    // Minimum distance between any two distinct nodes, through the nearest
+    // neighbour of each node
+    {
+        SpatialIndex index = spatial_index_create(instance->positions, n);
+        for (int32_t i = 0; i < n; i++) {
+            int32_t nn;
+            double d;
+            if (spatial_index_knn(&index, instance->positions[i], 1, i, &nn,
+                                  &d) == 1) {
                 min_dist = MIN(min_dist, d);
             }
         }
+        spatial_index_destroy(&index);
     }
 
     min_dist = sqrt(min_dist) / MIN(w, h);
@@ -221,12 +220,15 @@ void render_instance_into_vrplib_file(FILE *fh, const Instance *instance,
     }
 
     if (instance->edge_weight) {
-        // Generate edge weight section
-        for (int32_t i = 0; i < n; i++) {
+        // Generate edge weight section: one row of the upper triangle per
+        // line, in the standard TSPLIB `UPPER_ROW` format
+        fprintf(fh, "EDGE_WEIGHT_SECTION\n");
+        for (int32_t i = 0; i < n - 1; i++) {
             for (int32_t j = i + 1; j < n; j++) {
-                fprintf(fh, "%d %d %.17f\n", i, j,
-                        instance->edge_weight[sxpos(n, i, j)]);
+                fprintf(fh, j == i + 1 ? "%.17g" : " %.17g",
+                        cptp_edge_weight(instance, sxpos(n, i, j)));
             }
+            fprintf(fh, "\n");
         }
     }
 
@@ -244,3 +246,93 @@ void render_instance_into_vrplib_file(FILE *fh, const Instance *instance,
     fprintf(fh, "%d\n", -1);
     fprintf(fh, "EOF");
 }
+
+/// Reserves `size` bytes at the end of the payload, returning their offset
+static uint64_t binary_reserve(uint64_t *payload_end, uint64_t size) {
+    uint64_t offset = *payload_end;
+    *payload_end =
+        POW2_ALIGN(uint64_t, offset + size, (uint64_t)CPTP_BINARY_ALIGNMENT);
+    return offset;
+}
+
+bool render_instance_into_binary_file(FILE *fh, const Instance *instance) {
+    const int32_t n = instance->num_customers + 1;
+    const size_t name_len = instance->name ? strlen(instance->name) : 0;
+    const size_t comment_len =
+        instance->comment ? strlen(instance->comment) : 0;
+    const size_t edge_weight_size =
+        instance->edge_weight
+            ? hm_nentries(n) *
+                  dist_storage_elem_size(instance->edge_weight_storage)
+            : 0;
+
+    CptpBinaryHeader hdr = {0};
+    STATIC_ASSERT(sizeof(hdr) % CPTP_BINARY_ALIGNMENT == 0,
+                  "The payload must start on an aligned offset");
+    memcpy(hdr.magic, CPTP_BINARY_MAGIC, sizeof(hdr.magic));
+    hdr.version = CPTP_BINARY_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.num_customers = instance->num_customers;
+    hdr.num_vehicles = instance->num_vehicles;
+    hdr.vehicle_cap = instance->vehicle_cap;
+    hdr.rounding_strat = instance->rounding_strat;
+    hdr.edge_weight_storage = instance->edge_weight_storage;
+    hdr.edge_weight_scale = instance->edge_weight_scale;
+
+    uint64_t end = sizeof(hdr);
+    hdr.positions_offset =
+        binary_reserve(&end, n * sizeof(*instance->positions));
+    hdr.demands_offset = binary_reserve(&end, n * sizeof(*instance->demands));
+    if (instance->profits) {
+        hdr.profits_offset =
+            binary_reserve(&end, n * sizeof(*instance->profits));
+    }
+    if (instance->edge_weight) {
+        hdr.edge_weight_offset = binary_reserve(&end, edge_weight_size);
+    }
+    if (name_len) {
+        hdr.name_len = name_len;
+        hdr.name_offset = binary_reserve(&end, name_len);
+    }
+    if (comment_len) {
+        hdr.comment_len = comment_len;
+        hdr.comment_offset = binary_reserve(&end, comment_len);
+    }
+    hdr.payload_size = end - sizeof(hdr);
+
+    // NOTE(dparo): Zeroed, such that the padding is deterministic
+    uint8_t *payload = calloc(1, hdr.payload_size);
+    if (!payload) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        return false;
+    }
+
+#define PAYLOAD_AT(offset) (payload + (offset) - sizeof(hdr))
+    memcpy(PAYLOAD_AT(hdr.positions_offset), instance->positions,
+           n * sizeof(*instance->positions));
+    memcpy(PAYLOAD_AT(hdr.demands_offset), instance->demands,
+           n * sizeof(*instance->demands));
+    if (hdr.profits_offset) {
+        memcpy(PAYLOAD_AT(hdr.profits_offset), instance->profits,
+               n * sizeof(*instance->profits));
+    }
+    if (hdr.edge_weight_offset) {
+        memcpy(PAYLOAD_AT(hdr.edge_weight_offset), instance->edge_weight,
+               edge_weight_size);
+    }
+    if (hdr.name_offset) {
+        memcpy(PAYLOAD_AT(hdr.name_offset), instance->name, name_len);
+    }
+    if (hdr.comment_offset) {
+        memcpy(PAYLOAD_AT(hdr.comment_offset), instance->comment,
+               comment_len);
+    }
+#undef PAYLOAD_AT
+
+    hdr.payload_hash = cptp_binary_hash(payload, hdr.payload_size);
+
+    bool result = 1 == fwrite(&hdr, sizeof(hdr), 1, fh) &&
+                  1 == fwrite(payload, hdr.payload_size, 1, fh);
+    free(payload);
+    return result;
+}
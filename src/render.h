@@ -34,6 +34,10 @@ bool render_tour_image(const char *filepath, const Instance *instance,
 void render_instance_into_vrplib_file(FILE *fh, const Instance *instance,
                                       bool dump_profit_section);
 
+/// Writes `instance` in the binary format described by `CptpBinaryHeader`.
+/// `fh` must be opened in binary mode.
+bool render_instance_into_binary_file(FILE *fh, const Instance *instance);
+
 #if __cplusplus
 }
 #endif
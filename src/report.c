@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "report.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core-utils.h"
+#include "misc.h"
+#include "os.h"
+
+#include <cJSON.h>
+#include <log.h>
+
+enum {
+    // Buffer size required by `ctime_r`
+    CTIME_BUFSIZE = 26,
+};
+
+cJSON *tour_to_json_column(const Instance *instance, Tour *tour) {
+    cJSON *column = cJSON_CreateObject();
+    if (!column) {
+        return NULL;
+    }
+
+    cJSON *route_array = cJSON_AddArrayToObject(column, "route");
+    int32_t curr_vertex = 0;
+    do {
+        cJSON_AddItemToArray(route_array, cJSON_CreateNumber(curr_vertex));
+        curr_vertex = *tsucc(tour, curr_vertex);
+    } while (curr_vertex != 0);
+
+    double reduced_cost = tour_eval(instance, tour);
+    double profit = tour_profit(instance, tour);
+    cJSON_AddNumberToObject(column, "cost", reduced_cost + profit);
+    cJSON_AddNumberToObject(column, "profit", profit);
+    cJSON_AddNumberToObject(column, "demand", tour_demand(instance, tour));
+    cJSON_AddNumberToObject(column, "reducedCost", reduced_cost);
+    return column;
+}
+
+bool write_json_report(const char *filepath, const SolveReport *report) {
+    bool result = false;
+    const Instance *instance = report->instance;
+    Solution *solution = report->solution;
+    SolveStatus status = report->status;
+    SolveTiming timing = report->timing;
+
+    cJSON *root = NULL;
+    FILE *fh = fopen(filepath, "w");
+    if (!fh) {
+        log_fatal("%s: failed to open file for writing JSON report", filepath);
+        goto cleanup;
+    }
+
+    root = cJSON_CreateObject();
+    if (!root) {
+        log_fatal("%s :: Failed to create JSON root object", __func__);
+        goto cleanup;
+    }
+
+    bool primal_sol_avail = BOOL(status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL);
+    bool sigterm_abortion = BOOL(status & SOLVE_STATUS_ABORTION_SIGTERM);
+    bool res_exhaustion_abortion =
+        BOOL(status & SOLVE_STATUS_ABORTION_RES_EXHAUSTED);
+    bool closed_problem = BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM);
+
+    bool s = true;
+    s &= cJSON_AddItemToObject(root, "solverName",
+                               cJSON_CreateString(report->solver_name));
+    s &= cJSON_AddItemToObject(root, "timeLimit",
+                               cJSON_CreateNumber(report->timelimit));
+    s &= cJSON_AddItemToObject(root, "randomSeed",
+                               cJSON_CreateNumber(report->randomseed));
+    s &= cJSON_AddItemToObject(
+        root, "cmdLineDefines",
+        cJSON_CreateStringArray(report->defines, report->num_defines));
+    s &= cJSON_AddItemToObject(
+        root, "inputFile", cJSON_CreateString(report->instance_filepath));
+
+    cJSON *instance_info_obj = cJSON_CreateObject();
+    s &= cJSON_AddItemToObject(root, "instanceInfo", instance_info_obj);
+    {
+        s &= cJSON_AddItemToObject(
+            instance_info_obj, "name",
+            cJSON_CreateString(instance->name ? instance->name : ""));
+        s &= cJSON_AddItemToObject(
+            instance_info_obj, "comment",
+            cJSON_CreateString(instance->comment ? instance->comment : ""));
+        s &= cJSON_AddItemToObject(instance_info_obj, "vehicleCap",
+                                   cJSON_CreateNumber(instance->vehicle_cap));
+        s &= cJSON_AddItemToObject(instance_info_obj, "numCustomers",
+                                   cJSON_CreateNumber(instance->num_customers));
+        s &= cJSON_AddItemToObject(instance_info_obj, "numVehicles",
+                                   cJSON_CreateNumber(instance->num_vehicles));
+    }
+
+    cJSON *status_obj = cJSON_CreateObject();
+    s &= cJSON_AddItemToObject(root, "solveStatus", status_obj);
+    {
+        s &= cJSON_AddItemToObject(status_obj, "code",
+                                   cJSON_CreateNumber(status));
+
+        s &= cJSON_AddItemToObject(
+            status_obj, "erroredOut",
+            cJSON_CreateBool(BOOL(status & SOLVE_STATUS_ERR)));
+
+        s &= cJSON_AddItemToObject(status_obj, "containsPrimalSolution",
+                                   cJSON_CreateBool(primal_sol_avail));
+
+        s &= cJSON_AddItemToObject(status_obj, "closedProblem",
+                                   cJSON_CreateBool(closed_problem));
+
+        s &= cJSON_AddItemToObject(status_obj, "resExhaustionAbortion",
+                                   cJSON_CreateBool(res_exhaustion_abortion));
+
+        s &= cJSON_AddItemToObject(status_obj, "sigTermAbortion",
+                                   cJSON_CreateBool(sigterm_abortion));
+    }
+
+    cJSON *timing_obj = cJSON_CreateObject();
+    s &= cJSON_AddItemToObject(root, "timingInfo", timing_obj);
+    {
+        enum {
+            TIMEREPR_LEN = 4096,
+        };
+
+        char timerepr_str[TIMEREPR_LEN];
+        TimeRepr timerepr = timerepr_from_usecs(timing.took_usecs);
+        timerepr_to_string(&timerepr, timerepr_str, ARRAY_LEN(timerepr_str));
+
+        s &= cJSON_AddItemToObject(
+            timing_obj, "took",
+            cJSON_CreateNumber((double)timing.took_usecs * USECS_TO_SECS));
+        s &= cJSON_AddItemToObject(timing_obj, "tookRepr",
+                                   cJSON_CreateString(timerepr_str));
+
+        // NOTE(dparo): `ctime_r` since reports may be written concurrently
+        char time[CTIME_BUFSIZE];
+        ctime_r(&timing.started, time);
+        // Remove newline introduced from ctime
+        time[strlen(time) - 1] = 0;
+
+        s &= cJSON_AddItemToObject(timing_obj, "started",
+                                   cJSON_CreateString(time));
+
+        ctime_r(&timing.ended, time);
+        // Remove newline introduced from ctime
+        time[strlen(time) - 1] = 0;
+        s &= cJSON_AddItemToObject(timing_obj, "ended",
+                                   cJSON_CreateString(time));
+    }
+
+    cJSON *bounds_obj = cJSON_CreateObject();
+    s &= cJSON_AddItemToObject(root, "bounds", bounds_obj);
+    {
+
+        s &= cJSON_AddItemToObject(bounds_obj, "dual",
+                                   cJSON_CreateNumber(solution->dual_bound));
+
+        s &= cJSON_AddItemToObject(bounds_obj, "primal",
+                                   cJSON_CreateNumber(solution->primal_bound));
+
+        s &= cJSON_AddItemToObject(
+            bounds_obj, "gap", cJSON_CreateNumber(solution_relgap(solution)));
+    }
+
+    if (primal_sol_avail) {
+        cJSON *tour_info_obj = cJSON_CreateObject();
+        s &= cJSON_AddItemToObject(root, "tourInfo", tour_info_obj);
+        {
+            double cost = tour_eval(instance, &solution->tour);
+            double profit = tour_profit(instance, &solution->tour);
+            double demand = tour_demand(instance, &solution->tour);
+
+            s &= cJSON_AddItemToObject(tour_info_obj, "cost",
+                                       cJSON_CreateNumber(cost));
+            s &= cJSON_AddItemToObject(tour_info_obj, "profit",
+                                       cJSON_CreateNumber(profit));
+            s &= cJSON_AddItemToObject(tour_info_obj, "demand",
+                                       cJSON_CreateNumber(demand));
+
+            cJSON *route_array = cJSON_CreateArray();
+            int32_t curr_vertex = 0;
+            int32_t next_vertex = curr_vertex;
+            do {
+                next_vertex = *tsucc(&solution->tour, curr_vertex);
+                cJSON_AddItemToArray(route_array,
+                                     cJSON_CreateNumber(curr_vertex));
+
+                curr_vertex = next_vertex;
+            } while (curr_vertex != 0);
+            s &= cJSON_AddItemToObject(tour_info_obj, "route", route_array);
+        }
+    }
+
+    if (solution->columns.num_columns > 0) {
+        cJSON *columns_array = cJSON_CreateArray();
+        s &= cJSON_AddItemToObject(root, "columns", columns_array);
+        for (int32_t k = 0; k < solution->columns.num_columns; k++) {
+            s &= cJSON_AddItemToArray(
+                columns_array,
+                tour_to_json_column(instance, &solution->columns.tours[k]));
+        }
+    }
+
+    cJSON *constants_obj = cJSON_CreateObject();
+    s &= cJSON_AddItemToObject(root, "constants", constants_obj);
+    {
+        s &= cJSON_AddItemToObject(constants_obj, "COST_TOLERANCE",
+                                   cJSON_CreateNumber(COST_TOLERANCE));
+    }
+
+    if (!s) {
+        log_fatal("%s :: Failed to add all the necessary JSON elements to the "
+                  "parent JSON root object",
+                  __func__);
+        goto cleanup;
+    }
+
+    char *content = cJSON_Print(root);
+    if (content) {
+        result = fprintf(fh, "%s", content) >= 0;
+        free(content);
+    }
+
+cleanup:
+    if (root)
+        cJSON_Delete(root);
+    if (fh)
+        fclose(fh);
+    return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include <time.h>
+
+#include "core.h"
+
+typedef struct SolveTiming {
+    time_t started;
+    time_t ended;
+    int64_t took_usecs;
+} SolveTiming;
+
+/// Everything that ends up in the JSON report of a single solve
+typedef struct SolveReport {
+    const char *solver_name;
+    double timelimit;
+    int32_t randomseed;
+    const char **defines;
+    int32_t num_defines;
+    const char *instance_filepath;
+    const Instance *instance;
+    Solution *solution;
+    SolveStatus status;
+    SolveTiming timing;
+} SolveReport;
+
+/// Writes the JSON report to `filepath`. Safe to call concurrently from
+/// multiple threads (on different files).
+struct cJSON;
+
+/// JSON object describing `tour` as a column: its `route` (starting from
+/// the depot), `cost`, `profit`, `demand` and `reducedCost`
+struct cJSON *tour_to_json_column(const Instance *instance, Tour *tour);
+
+bool write_json_report(const char *filepath, const SolveReport *report);
+
+#if __cplusplus
+}
+#endif
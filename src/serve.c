@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "serve.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "core-utils.h"
+#include "misc.h"
+#include "parser.h"
+#include "report.h"
+#include "shm-channel.h"
+
+#include <cJSON.h>
+#include <log.h>
+
+typedef struct ServeConn {
+    const ServeConfig *config;
+    CancellationToken *cancel;
+    bool has_session;
+    CptpSession session;
+    Solution solution;
+    /// Reused for each `profits` request
+    double *profits;
+} ServeConn;
+
+static void serve_conn_drop_session(ServeConn *conn) {
+    if (conn->has_session) {
+        solution_destroy(&conn->solution);
+        cptp_session_destroy(&conn->session);
+        free(conn->profits);
+        conn->profits = NULL;
+        conn->has_session = false;
+    }
+}
+
+static bool read_number_array(const cJSON *array, double *out, int32_t n) {
+    if (!cJSON_IsArray(array) || cJSON_GetArraySize(array) != n) {
+        return false;
+    }
+
+    int32_t i = 0;
+    const cJSON *elem = NULL;
+    cJSON_ArrayForEach(elem, array) {
+        if (!cJSON_IsNumber(elem)) {
+            return false;
+        }
+        out[i++] = elem->valuedouble;
+    }
+    return true;
+}
+
+static Instance instance_from_json(const cJSON *obj, const char **err) {
+    Instance result = {0};
+
+    const cJSON *cap = cJSON_GetObjectItemCaseSensitive(obj, "vehicleCap");
+    const cJSON *positions =
+        cJSON_GetObjectItemCaseSensitive(obj, "positions");
+    const cJSON *demands = cJSON_GetObjectItemCaseSensitive(obj, "demands");
+    const cJSON *profits = cJSON_GetObjectItemCaseSensitive(obj, "profits");
+    const cJSON *num_vehicles =
+        cJSON_GetObjectItemCaseSensitive(obj, "numVehicles");
+    const cJSON *name = cJSON_GetObjectItemCaseSensitive(obj, "name");
+
+    if (!cJSON_IsNumber(cap) || !cJSON_IsArray(positions) ||
+        cJSON_GetArraySize(positions) < 2) {
+        *err = "inline instance requires `vehicleCap` and at least two "
+               "`positions`";
+        goto fail;
+    }
+
+    int32_t n = cJSON_GetArraySize(positions);
+    result.num_customers = n - 1;
+    result.num_vehicles =
+        cJSON_IsNumber(num_vehicles) ? num_vehicles->valueint : 1;
+    result.vehicle_cap = cap->valuedouble;
+    result.rounding_strat = CPTP_DIST_ROUND;
+
+    if (!instance_alloc(&result, false)) {
+        *err = "out of memory";
+        goto fail;
+    }
+
+    int32_t i = 0;
+    const cJSON *pos = NULL;
+    cJSON_ArrayForEach(pos, positions) {
+        double xy[2];
+        if (!read_number_array(pos, xy, 2)) {
+            *err = "`positions` must be an array of [x, y] pairs";
+            goto fail;
+        }
+        result.positions[i++] = (Vec2d){xy[0], xy[1]};
+    }
+
+    if (!read_number_array(demands, result.demands, n)) {
+        *err = "`demands` must contain a number for each position";
+        goto fail;
+    }
+
+    if (profits && !read_number_array(profits, result.profits, n)) {
+        *err = "`profits` must contain a number for each position";
+        goto fail;
+    }
+
+    instance_set_name(&result, cJSON_IsString(name) ? name->valuestring
+                                                    : "inline");
+#if CPTP_DIST_CACHE_ENABLED
+    instance_build_dist_cache(&result);
+#endif
+    return result;
+
+fail:
+    instance_destroy(&result);
+    return result;
+}
+
+static bool handle_instance_request(ServeConn *conn, const cJSON *value,
+                                    cJSON *reply, const char **err) {
+    const ServeConfig *config = conn->config;
+    Instance instance = {0};
+
+    if (cJSON_IsString(value)) {
+        instance = parse(value->valuestring);
+        if (!is_valid_instance(&instance)) {
+            *err = "failed to parse the instance file";
+            goto fail;
+        }
+    } else if (cJSON_IsObject(value)) {
+        instance = instance_from_json(value, err);
+        if (!is_valid_instance(&instance)) {
+            if (!*err) {
+                *err = "invalid inline instance";
+            }
+            goto fail;
+        }
+    } else {
+        *err = "`instance` must be a file path or an object";
+        goto fail;
+    }
+
+    serve_conn_drop_session(conn);
+
+    if (!cptp_session_create(&conn->session, &instance, config->solver_name,
+                             config->params, config->timelimit,
+                             config->randomseed)) {
+        *err = "failed to create the solver";
+        goto fail;
+    }
+
+    conn->has_session = true;
+    conn->solution = solution_create(&conn->session.instance);
+    solution_reserve_columns(&conn->solution, config->num_columns);
+    conn->profits =
+        malloc(sizeof(*conn->profits) * (instance.num_customers + 1));
+    if (!conn->profits) {
+        *err = "out of memory";
+        serve_conn_drop_session(conn);
+        goto fail;
+    }
+
+    cJSON_AddStringToObject(reply, "name", conn->session.instance.name);
+    cJSON_AddNumberToObject(reply, "numCustomers", instance.num_customers);
+    instance_destroy(&instance);
+    return true;
+
+fail:
+    instance_destroy(&instance);
+    return false;
+}
+
+static bool handle_profits_request(ServeConn *conn, const cJSON *value,
+                                   cJSON *reply, const char **err) {
+    if (!conn->has_session) {
+        *err = "no instance was loaded";
+        return false;
+    }
+
+    const Instance *instance = &conn->session.instance;
+    if (!read_number_array(value, conn->profits,
+                           instance->num_customers + 1)) {
+        *err = "`profits` must contain a number for each node";
+        return false;
+    }
+
+    if (!cptp_session_update_profits(&conn->session, conn->profits)) {
+        *err = "failed to update the profits";
+        return false;
+    }
+
+    int64_t begin_time = os_get_usecs();
+    SolveStatus status =
+        cptp_session_solve(&conn->session, &conn->solution, conn->cancel);
+    int64_t took_usecs = os_get_usecs() - begin_time;
+
+    if (status == 0 || BOOL(status & SOLVE_STATUS_ERR)) {
+        *err = "failed to solve the pricing problem";
+        return false;
+    }
+
+    Solution *solution = &conn->solution;
+    cJSON_AddNumberToObject(reply, "status", status);
+    cJSON_AddBoolToObject(reply, "closedProblem",
+                          BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM));
+    cJSON_AddNumberToObject(reply, "primalBound", solution->primal_bound);
+    cJSON_AddNumberToObject(reply, "dualBound", solution->dual_bound);
+    cJSON_AddNumberToObject(reply, "took", (double)took_usecs / 1e6);
+
+    // NOTE(dparo):
+    //     The column pool holds only improving columns, the only ones of
+    //     any use to the master
+    cJSON *columns = cJSON_AddArrayToObject(reply, "columns");
+    for (int32_t k = 0; k < solution->columns.num_columns; k++) {
+        cJSON_AddItemToArray(
+            columns,
+            tour_to_json_column(instance, &solution->columns.tours[k]));
+    }
+
+    return true;
+}
+
+/// Handles a single request line, writing its reply line to `out`.
+/// Returns false if serving should stop.
+static bool handle_request(ServeConn *conn, const char *line, FILE *out) {
+    bool keep_serving = true;
+    const char *err = NULL;
+    cJSON *reply = cJSON_CreateObject();
+    cJSON *request = cJSON_Parse(line);
+
+    if (!cJSON_IsObject(request)) {
+        err = "malformed request";
+        goto reply;
+    }
+
+    const cJSON *id = cJSON_GetObjectItemCaseSensitive(request, "id");
+    if (cJSON_IsNumber(id)) {
+        cJSON_AddNumberToObject(reply, "id", id->valuedouble);
+    } else if (cJSON_IsString(id)) {
+        cJSON_AddStringToObject(reply, "id", id->valuestring);
+    }
+
+    const cJSON *instance =
+        cJSON_GetObjectItemCaseSensitive(request, "instance");
+    const cJSON *profits =
+        cJSON_GetObjectItemCaseSensitive(request, "profits");
+
+    if (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(request, "quit"))) {
+        keep_serving = false;
+    } else if (instance) {
+        handle_instance_request(conn, instance, reply, &err);
+    } else if (profits) {
+        handle_profits_request(conn, profits, reply, &err);
+    } else {
+        err = "unknown request";
+    }
+
+reply:
+    if (err) {
+        log_warn("%s :: %s", __func__, err);
+        cJSON_AddStringToObject(reply, "error", err);
+    } else {
+        cJSON_AddBoolToObject(reply, "ok", true);
+    }
+
+    char *text = cJSON_PrintUnformatted(reply);
+    if (text) {
+        fprintf(out, "%s\n", text);
+        cJSON_free(text);
+    }
+    fflush(out);
+
+    cJSON_Delete(request);
+    cJSON_Delete(reply);
+    return keep_serving;
+}
+
+bool serve_stream(const ServeConfig *config, CancellationToken *cancel,
+                  FILE *in, FILE *out) {
+    ServeConn conn = {.config = config, .cancel = cancel};
+    bool keep_serving = true;
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while (keep_serving && !cancellation_requested(cancel) &&
+           (len = getline(&line, &cap, in)) >= 0) {
+        // Skip blank lines
+        if (strspn(line, " \t\r\n") == (size_t)len) {
+            continue;
+        }
+        keep_serving = handle_request(&conn, line, out);
+    }
+
+    serve_conn_drop_session(&conn);
+    free(line);
+    return keep_serving && !cancellation_requested(cancel);
+}
+
+static int serve_stdio(const ServeConfig *config, CancellationToken *cancel) {
+    // NOTE(dparo):
+    //     The solvers (and CPLEX) freely print to stdout, which would corrupt
+    //     the replies. Keep the real stdout for the replies only, and send
+    //     everything else to stderr.
+    fflush(stdout);
+    int reply_fd = dup(STDOUT_FILENO);
+    if (reply_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        log_fatal("%s :: Failed to redirect stdout: %s", __func__,
+                  strerror(errno));
+        if (reply_fd >= 0) {
+            close(reply_fd);
+        }
+        return EXIT_FAILURE;
+    }
+
+    FILE *out = fdopen(reply_fd, "w");
+    if (!out) {
+        close(reply_fd);
+        return EXIT_FAILURE;
+    }
+
+    serve_stream(config, cancel, stdin, out);
+    fclose(out);
+    return EXIT_SUCCESS;
+}
+
+static int serve_socket(const ServeConfig *config, CancellationToken *cancel) {
+    int exitcode = EXIT_FAILURE;
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (strlen(config->socket_path) >= sizeof(addr.sun_path)) {
+        log_fatal("%s :: Socket path too long: %s", __func__,
+                  config->socket_path);
+        return EXIT_FAILURE;
+    }
+    strcpy(addr.sun_path, config->socket_path);
+
+    // A client going away must not kill the process
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        log_fatal("%s :: socket() failed: %s", __func__, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // Remove a stale socket left behind by a previous process
+    unlink(config->socket_path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 1) < 0) {
+        log_fatal("%s :: Failed to listen on %s: %s", __func__,
+                  config->socket_path, strerror(errno));
+        goto terminate;
+    }
+
+    log_info("%s :: Listening on %s", __func__, config->socket_path);
+
+    bool keep_serving = true;
+    while (keep_serving && !cancellation_requested(cancel)) {
+        int conn_fd = accept(listen_fd, NULL, NULL);
+        if (conn_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            log_fatal("%s :: accept() failed: %s", __func__, strerror(errno));
+            goto terminate;
+        }
+
+        int out_fd = dup(conn_fd);
+        FILE *in = fdopen(conn_fd, "r");
+        FILE *out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+        if (in && out) {
+            keep_serving = serve_stream(config, cancel, in, out);
+        }
+
+        if (in) {
+            fclose(in);
+        } else {
+            close(conn_fd);
+        }
+        if (out) {
+            fclose(out);
+        } else if (out_fd >= 0) {
+            close(out_fd);
+        }
+    }
+
+    exitcode = EXIT_SUCCESS;
+
+terminate:
+    close(listen_fd);
+    unlink(config->socket_path);
+    return exitcode;
+}
+
+static void write_shm_column(const ShmChannel *channel, const ShmSlot *slot,
+                             int32_t k, const Instance *instance, Tour *tour,
+                             double reduced_cost) {
+    int32_t *route = shm_slot_route(channel, slot, k);
+    int32_t route_len = 0;
+    int32_t curr_vertex = 0;
+    do {
+        route[route_len++] = curr_vertex;
+        curr_vertex = *tsucc(tour, curr_vertex);
+    } while (curr_vertex != 0);
+
+    ShmColumn *column = &slot->columns[k];
+    column->reduced_cost = reduced_cost;
+    column->profit = tour_profit(instance, tour);
+    column->cost = column->reduced_cost + column->profit;
+    column->demand = tour_demand(instance, tour);
+    column->route_len = route_len;
+}
+
+static int serve_shm(const ServeConfig *config, CancellationToken *cancel) {
+    int exitcode = EXIT_FAILURE;
+    bool has_session = false;
+    CptpSession session = {0};
+    Solution solution = {0};
+
+    ShmChannel channel = shm_channel_open(config->shm_name);
+    Instance instance = parse(config->instance_filepath);
+
+    if (!shm_channel_is_valid(&channel)) {
+        goto terminate;
+    }
+
+    if (!is_valid_instance(&instance)) {
+        log_fatal("%s :: %s: Failed to parse file", __func__,
+                  config->instance_filepath);
+        goto terminate;
+    }
+
+    if (channel.num_nodes != instance.num_customers + 1) {
+        log_fatal("%s :: The channel expects %d nodes, the instance has %d",
+                  __func__, channel.num_nodes, instance.num_customers + 1);
+        goto terminate;
+    }
+
+    if (!cptp_session_create(&session, &instance, config->solver_name,
+                             config->params, config->timelimit,
+                             config->randomseed)) {
+        goto terminate;
+    }
+    has_session = true;
+    solution = solution_create(&session.instance);
+    solution_reserve_columns(&solution,
+                             MIN(config->num_columns, channel.max_columns));
+
+    ShmSlot slot;
+    while (shm_channel_wait_request(&channel, cancel, &slot)) {
+        SolveStatus status = SOLVE_STATUS_ERR;
+        if (cptp_session_update_profits(&session, slot.profits)) {
+            status = cptp_session_solve(&session, &solution, cancel);
+        }
+
+        slot.reply->status = status;
+        slot.reply->num_columns = solution.columns.num_columns;
+        slot.reply->primal_bound = solution.primal_bound;
+        slot.reply->dual_bound = solution.dual_bound;
+
+        for (int32_t k = 0; k < solution.columns.num_columns; k++) {
+            write_shm_column(&channel, &slot, k, &session.instance,
+                             &solution.columns.tours[k],
+                             solution.columns.reduced_costs[k]);
+        }
+
+        shm_channel_commit_reply(&channel);
+    }
+
+    exitcode = EXIT_SUCCESS;
+
+terminate:
+    if (has_session) {
+        solution_destroy(&solution);
+        cptp_session_destroy(&session);
+    }
+    instance_destroy(&instance);
+    shm_channel_destroy(&channel);
+    return exitcode;
+}
+
+int serve_main(const ServeConfig *config, CancellationToken *cancel) {
+    if (config->shm_name) {
+        return serve_shm(config, cancel);
+    } else if (config->socket_path) {
+        return serve_socket(config, cancel);
+    } else {
+        return serve_stdio(config, cancel);
+    }
+}
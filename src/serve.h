@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+/// Configuration shared by all the sessions of a `cptp --serve` process
+typedef struct ServeConfig {
+    const char *solver_name;
+    const SolverParams *params;
+    double timelimit;
+    int32_t randomseed;
+    /// Maximum number of columns per reply (at least 1)
+    int32_t num_columns;
+    /// Listen on this Unix domain socket instead of stdin/stdout
+    const char *socket_path;
+    /// Answer the requests of the shared memory channel (see
+    /// `shm-channel.h`) created by the master with this name instead, for
+    /// the instance `instance_filepath`
+    const char *shm_name;
+    const char *instance_filepath;
+} ServeConfig;
+
+/// Keeps a pricing solver resident, answering requests encoded as one JSON
+/// object per line, and replying with one JSON object per line:
+///   - `{"instance": "path/to/file.vrp"}`, or an inline instance
+///     `{"instance": {"vehicleCap": Q, "positions": [[x, y], ...],
+///       "demands": [...], "profits": [...], "numVehicles": K}}`
+///     (node 0 is the depot, `profits` and `numVehicles` are optional).
+///     Loads the instance and creates the solver, replacing any previous one.
+///   - `{"profits": [...]}`: the profits of all the `num_customers + 1`
+///     nodes (eg the duals of the master). Solves the pricing problem and
+///     replies with up to `num_columns` distinct columns of negative
+///     reduced cost, best first.
+///   - `{"quit": true}`: stops serving.
+/// An optional `"id"` member of a request is echoed back in its reply.
+/// Failed requests are answered with `{"error": "..."}`.
+/// In shared memory mode the instance is given upfront, and the requests
+/// and replies are exchanged through the channel without any encoding.
+/// In socket mode the connections are served one at a time, each with its
+/// own session. Returns the exit code of the process.
+int serve_main(const ServeConfig *config, CancellationToken *cancel);
+
+/// Serves the JSON lines requests of `in` (see `serve_main`), writing the
+/// replies to `out`, until EOF, a `quit` request, or a cancellation.
+/// Returns false if serving should stop.
+bool serve_stream(const ServeConfig *config, CancellationToken *cancel,
+                  FILE *in, FILE *out);
+
+#if __cplusplus
+}
+#endif
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "shm-channel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "misc.h"
+#include "os.h"
+
+#include <log.h>
+
+#define SHM_CHANNEL_MAGIC ((uint32_t)0x43505450) // "CPTP"
+#define SHM_CHANNEL_VERSION ((uint32_t)1)
+
+enum {
+    // How often a blocked waiter checks for cancellation and shutdown
+    SHM_CHANNEL_POLL_USECS = 50 * 1000,
+};
+
+typedef struct ShmChannelHeader {
+    _Atomic uint32_t magic;
+    uint32_t version;
+    int32_t num_nodes;
+    int32_t max_columns;
+    int32_t num_slots;
+    int32_t reserved;
+    uint64_t slot_size;
+    uint8_t pad0[CACHE_LINE_SIZE - 32];
+
+    // NOTE(dparo):
+    //     Futex words, each on its own cache line since they are written by
+    //     different processes. They are free running counters: the slot of
+    //     the i-th request is `i % num_slots`.
+    /// Number of requests posted by the master
+    _Atomic uint32_t req_head;
+    uint8_t pad1[CACHE_LINE_SIZE - sizeof(uint32_t)];
+    /// Number of replies committed by the pricer
+    _Atomic uint32_t rep_head;
+    uint8_t pad2[CACHE_LINE_SIZE - sizeof(uint32_t)];
+    _Atomic uint32_t shutdown;
+    uint8_t pad3[CACHE_LINE_SIZE - sizeof(uint32_t)];
+} ShmChannelHeader;
+
+static inline size_t cache_align(size_t size) {
+    return POW2_ALIGN(size_t, size, CACHE_LINE_SIZE);
+}
+
+static inline size_t header_size(void) {
+    return cache_align(sizeof(ShmChannelHeader));
+}
+
+static size_t profits_offset(void) { return 0; }
+
+static size_t reply_offset(int32_t num_nodes) {
+    return profits_offset() + cache_align(sizeof(double) * num_nodes);
+}
+
+static size_t columns_offset(int32_t num_nodes) {
+    return reply_offset(num_nodes) + cache_align(sizeof(ShmReply));
+}
+
+static size_t routes_offset(int32_t num_nodes, int32_t max_columns) {
+    return columns_offset(num_nodes) +
+           cache_align(sizeof(ShmColumn) * max_columns);
+}
+
+static size_t compute_slot_size(int32_t num_nodes, int32_t max_columns) {
+    return routes_offset(num_nodes, max_columns) +
+           cache_align(sizeof(int32_t) * max_columns * num_nodes);
+}
+
+static ShmSlot get_slot(const ShmChannel *channel, uint32_t seq) {
+    uint8_t *base = (uint8_t *)channel->header + header_size() +
+                    channel->slot_size * (seq % (uint32_t)channel->num_slots);
+    ShmSlot slot = {
+        .profits = (double *)(base + profits_offset()),
+        .reply = (ShmReply *)(base + reply_offset(channel->num_nodes)),
+        .columns = (ShmColumn *)(base + columns_offset(channel->num_nodes)),
+        .routes = (int32_t *)(base + routes_offset(channel->num_nodes,
+                                                   channel->max_columns)),
+    };
+    return slot;
+}
+
+/// Blocks while `*word == expected`, at most for `timeout_usecs`. May
+/// return spuriously.
+static void futex_wait(_Atomic uint32_t *word, uint32_t expected,
+                       int64_t timeout_usecs) {
+#if __linux__
+    struct timespec ts = {.tv_sec = timeout_usecs / 1000000,
+                          .tv_nsec = (timeout_usecs % 1000000) * 1000};
+    // NOTE(dparo):
+    //     Not FUTEX_WAIT_PRIVATE: the word is shared among processes
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, &ts, NULL, 0);
+#else
+    if (atomic_load(word) == expected) {
+        os_sleep(MIN(timeout_usecs, 1000));
+    }
+#endif
+}
+
+static void futex_wake_all(_Atomic uint32_t *word) {
+#if __linux__
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    UNUSED_PARAM(word);
+#endif
+}
+
+static ShmChannel map_channel(int fd, size_t map_size) {
+    ShmChannel result = {0};
+    void *addr =
+        mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        log_fatal("%s :: mmap() failed: %s", __func__, strerror(errno));
+        return result;
+    }
+    result.header = addr;
+    result.map_size = map_size;
+    return result;
+}
+
+ShmChannel shm_channel_create(const char *name, int32_t num_nodes,
+                              int32_t max_columns, int32_t num_slots) {
+    ShmChannel result = {0};
+    assert(num_nodes > 0 && max_columns > 0 && num_slots > 0);
+
+    size_t slot_size = compute_slot_size(num_nodes, max_columns);
+    size_t map_size = header_size() + slot_size * num_slots;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        log_fatal("%s :: shm_open(%s) failed: %s", __func__, name,
+                  strerror(errno));
+        return result;
+    }
+
+    if (ftruncate(fd, (off_t)map_size) < 0) {
+        log_fatal("%s :: ftruncate() failed: %s", __func__, strerror(errno));
+        goto fail;
+    }
+
+    result = map_channel(fd, map_size);
+    if (!shm_channel_is_valid(&result)) {
+        goto fail;
+    }
+    close(fd);
+
+    // NOTE(dparo): The memory is already zeroed by `ftruncate`
+    ShmChannelHeader *header = result.header;
+    header->version = SHM_CHANNEL_VERSION;
+    header->num_nodes = num_nodes;
+    header->max_columns = max_columns;
+    header->num_slots = num_slots;
+    header->slot_size = slot_size;
+    // Publishes the header to `shm_channel_open`
+    atomic_store_explicit(&header->magic, SHM_CHANNEL_MAGIC,
+                          memory_order_release);
+
+    result.slot_size = slot_size;
+    result.num_nodes = num_nodes;
+    result.max_columns = max_columns;
+    result.num_slots = num_slots;
+    result.owned_name = strdup(name);
+    return result;
+
+fail:
+    close(fd);
+    shm_unlink(name);
+    return result;
+}
+
+ShmChannel shm_channel_open(const char *name) {
+    ShmChannel result = {0};
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        log_fatal("%s :: shm_open(%s) failed: %s", __func__, name,
+                  strerror(errno));
+        return result;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < header_size()) {
+        log_fatal("%s :: %s: not a valid channel", __func__, name);
+        close(fd);
+        return result;
+    }
+
+    result = map_channel(fd, (size_t)st.st_size);
+    close(fd);
+    if (!shm_channel_is_valid(&result)) {
+        return result;
+    }
+
+    // NOTE(dparo):
+    //     The header comes from another process: bound each of its sizes by
+    //     the mapped capacity before multiplying them, so that no product
+    //     can overflow. `map_size >= header_size()` was checked above.
+    ShmChannelHeader *header = result.header;
+    size_t capacity = result.map_size - header_size();
+    bool valid =
+        atomic_load_explicit(&header->magic, memory_order_acquire) ==
+            SHM_CHANNEL_MAGIC &&
+        header->version == SHM_CHANNEL_VERSION && header->num_nodes > 0 &&
+        header->max_columns > 0 && header->num_slots > 0 &&
+        (uint64_t)header->num_nodes * (uint64_t)header->max_columns <=
+            capacity / sizeof(int32_t) &&
+        header->slot_size <= capacity / (uint64_t)header->num_slots &&
+        header->slot_size ==
+            compute_slot_size(header->num_nodes, header->max_columns);
+
+    if (!valid) {
+        log_fatal("%s :: %s: not a valid channel", __func__, name);
+        shm_channel_destroy(&result);
+        return result;
+    }
+
+    result.slot_size = header->slot_size;
+    result.num_nodes = header->num_nodes;
+    result.max_columns = header->max_columns;
+    result.num_slots = header->num_slots;
+    // NOTE(dparo):
+    //     A pricer attaching late answers the requests not yet answered
+    result.next_request = atomic_load(&header->rep_head);
+    result.next_reply = result.next_request;
+    return result;
+}
+
+void shm_channel_destroy(ShmChannel *channel) {
+    if (channel->header) {
+        munmap(channel->header, channel->map_size);
+    }
+    if (channel->owned_name) {
+        shm_unlink(channel->owned_name);
+        free(channel->owned_name);
+    }
+    memset(channel, 0, sizeof(*channel));
+}
+
+bool shm_channel_post_request(ShmChannel *channel, const double *profits) {
+    ShmChannelHeader *header = channel->header;
+    uint32_t seq =
+        atomic_load_explicit(&header->req_head, memory_order_relaxed);
+
+    if (seq - channel->next_reply >= (uint32_t)channel->num_slots) {
+        return false;
+    }
+
+    ShmSlot slot = get_slot(channel, seq);
+    memcpy(slot.profits, profits, sizeof(*profits) * channel->num_nodes);
+    memset(slot.reply, 0, sizeof(*slot.reply));
+
+    atomic_store_explicit(&header->req_head, seq + 1, memory_order_release);
+    futex_wake_all(&header->req_head);
+    return true;
+}
+
+bool shm_channel_wait_reply(ShmChannel *channel, int64_t timeout_usecs,
+                            ShmSlot *slot) {
+    ShmChannelHeader *header = channel->header;
+    uint32_t seq = channel->next_reply;
+
+    if (seq == atomic_load_explicit(&header->req_head, memory_order_relaxed)) {
+        // Nothing was posted
+        return false;
+    }
+
+    int64_t begin_time = os_get_usecs();
+    uint32_t head;
+    while ((head = atomic_load_explicit(&header->rep_head,
+                                        memory_order_acquire)) == seq) {
+        int64_t wait_usecs = SHM_CHANNEL_POLL_USECS;
+        if (timeout_usecs >= 0) {
+            int64_t left = timeout_usecs - (os_get_usecs() - begin_time);
+            if (left <= 0) {
+                return false;
+            }
+            wait_usecs = MIN(wait_usecs, left);
+        }
+        futex_wait(&header->rep_head, seq, wait_usecs);
+    }
+
+    *slot = get_slot(channel, seq);
+    return true;
+}
+
+void shm_channel_consume_reply(ShmChannel *channel) {
+    assert(channel->next_reply !=
+           atomic_load(&channel->header->rep_head));
+    ++channel->next_reply;
+}
+
+void shm_channel_shutdown(ShmChannel *channel) {
+    atomic_store(&channel->header->shutdown, 1);
+    futex_wake_all(&channel->header->req_head);
+}
+
+bool shm_channel_wait_request(ShmChannel *channel, CancellationToken *cancel,
+                              ShmSlot *slot) {
+    ShmChannelHeader *header = channel->header;
+    uint32_t seq = channel->next_request;
+
+    while (atomic_load_explicit(&header->req_head, memory_order_acquire) ==
+           seq) {
+        if (atomic_load(&header->shutdown) ||
+            (cancel && cancellation_requested(cancel))) {
+            return false;
+        }
+        futex_wait(&header->req_head, seq, SHM_CHANNEL_POLL_USECS);
+    }
+
+    if (cancel && cancellation_requested(cancel)) {
+        return false;
+    }
+
+    *slot = get_slot(channel, seq);
+    return true;
+}
+
+void shm_channel_commit_reply(ShmChannel *channel) {
+    ShmChannelHeader *header = channel->header;
+    uint32_t seq = channel->next_request++;
+    atomic_store_explicit(&header->rep_head, seq + 1, memory_order_release);
+    futex_wake_all(&header->rep_head);
+}
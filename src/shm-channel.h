@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+/// Column of a pricing reply, as stored in the shared memory
+typedef struct ShmColumn {
+    double cost;
+    double profit;
+    double demand;
+    double reduced_cost;
+    /// Number of nodes of the route, the depot included
+    int32_t route_len;
+    int32_t reserved;
+} ShmColumn;
+
+typedef struct ShmReply {
+    int32_t status;
+    int32_t num_columns;
+    double primal_bound;
+    double dual_bound;
+} ShmReply;
+
+/// View of one slot of the ring. Each slot holds a request (the profits of
+/// the `num_nodes` nodes) and, once answered, its reply: up to
+/// `max_columns` columns, the route of the k-th column being stored in
+/// `routes + k * num_nodes`, starting from the depot.
+typedef struct ShmSlot {
+    double *profits;
+    ShmReply *reply;
+    ShmColumn *columns;
+    int32_t *routes;
+} ShmSlot;
+
+struct ShmChannelHeader;
+
+/// Exchange of pricing requests (dual vectors) and replies (columns)
+/// between a master and a pricer living on the same host, through a POSIX
+/// shared memory ring of `num_slots` slots. The master can post up to
+/// `num_slots` requests before waiting for their replies, which are
+/// delivered in order. The two processes wait for each other on futexes
+/// living in the shared memory itself.
+typedef struct ShmChannel {
+    struct ShmChannelHeader *header;
+    size_t map_size;
+    size_t slot_size;
+    int32_t num_nodes;
+    int32_t max_columns;
+    int32_t num_slots;
+    /// Process local cursors: next request to answer (pricer side) and
+    /// next reply to consume (master side)
+    uint32_t next_request;
+    uint32_t next_reply;
+    /// Set for the channel created by `shm_channel_create`, which removes
+    /// the shared memory object on destroy
+    char *owned_name;
+} ShmChannel;
+
+/// Creates a new shared memory object (`name` of the form `/some-name`).
+/// Fails if it already exists. Returns a zeroed channel on failure.
+ShmChannel shm_channel_create(const char *name, int32_t num_nodes,
+                              int32_t max_columns, int32_t num_slots);
+/// Maps an existing channel, eg the one created by the other process.
+/// Returns a zeroed channel on failure.
+ShmChannel shm_channel_open(const char *name);
+void shm_channel_destroy(ShmChannel *channel);
+
+static inline bool shm_channel_is_valid(const ShmChannel *channel) {
+    return channel->header != NULL;
+}
+
+static inline int32_t *shm_slot_route(const ShmChannel *channel,
+                                      const ShmSlot *slot, int32_t k) {
+    assert(k >= 0 && k < channel->max_columns);
+    return slot->routes + (int64_t)k * channel->num_nodes;
+}
+
+/// Master side: posts the profits of the next request without blocking.
+/// Returns false if all the slots are waiting for a reply to be consumed.
+bool shm_channel_post_request(ShmChannel *channel, const double *profits);
+/// Master side: waits (at most `timeout_usecs`, or forever if negative) for
+/// the reply of the oldest posted request not consumed yet. The slot
+/// remains valid until `shm_channel_consume_reply`.
+bool shm_channel_wait_reply(ShmChannel *channel, int64_t timeout_usecs,
+                            ShmSlot *slot);
+void shm_channel_consume_reply(ShmChannel *channel);
+/// Master side: asks the pricer to stop
+void shm_channel_shutdown(ShmChannel *channel);
+
+/// Pricer side: waits for the next request. Returns false once the master
+/// asked to stop, or `cancel` (can be NULL) is requested.
+bool shm_channel_wait_request(ShmChannel *channel, CancellationToken *cancel,
+                              ShmSlot *slot);
+/// Pricer side: publishes the reply written in the slot of the request
+/// returned by the last `shm_channel_wait_request`.
+void shm_channel_commit_reply(ShmChannel *channel);
+
+#if __cplusplus
+}
+#endif
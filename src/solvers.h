@@ -53,6 +53,24 @@ static const SolverDescriptor MIP_SOLVER_DESCRIPTOR = {
         {"INS_HEUR_WARM_START", TYPED_PARAM_BOOL, "true",
          "Warm start the MIP solver by using an insertion heuristic for "
          "finding an initial solution"},
+        {"NUM_CANDIDATES", TYPED_PARAM_INT32, "0",
+         "Number of reduced cost candidate neighbours kept for each node. "
+         "The warm start insertion heuristic and 2-opt restrict their scans "
+         "to these candidates. Default 0, means scan all the nodes"},
+        {"SPARSE_MIP", TYPED_PARAM_BOOL, "false",
+         "Fix to zero the edges not appearing in any candidate list (except "
+         "the ones incident to the depot). The resulting solution is not "
+         "guaranteed to be optimal. Param `NUM_CANDIDATES` must also be "
+         "positive for this to take effect."},
+        {"CUSTOMER_ELIMINATION", TYPED_PARAM_BOOL, "false",
+         "Before solving, drop the customers which cannot improve any tour "
+         "by being visited, and solve the resulting smaller instance. Costs "
+         "up to O(n^3) distance evaluations per solve."},
+        {"EDGE_ELIMINATION", TYPED_PARAM_BOOL, "false",
+         "Fix to zero the edges which cannot be part of a tour cheaper than "
+         "the best warm start solution, using a reduced cost lower bound. "
+         "Edges joining customers whose demands exceed the vehicle capacity "
+         "are then always fixed to zero."},
         {"APPLY_POLISHING_AFTER_WARM_START", TYPED_PARAM_BOOL, "false",
          "Polish the initial warm start solutions right away before "
          "beginning "
@@ -81,15 +99,58 @@ static const SolverDescriptor MIP_SOLVER_DESCRIPTOR = {
         {0},
     }};
 
-static const SolverDescriptor STUB_SOLVER_DESCRIPTOR = {"stub",
-                                                        {
-                                                            {0},
-                                                        }};
+static const SolverDescriptor STUB_SOLVER_DESCRIPTOR = {
+    "stub",
+    {
+        {"ROUTE_LEN", TYPED_PARAM_INT32, "0",
+         "Report the route visiting the first ROUTE_LEN customers fitting in "
+         "the vehicle, by increasing index. Default 0, means report nothing"},
+        {"DUAL_BOUND", TYPED_PARAM_DOUBLE, NULL,
+         "Dual bound reported alongside the route. Default -inf"},
+        {"CLOSE_PROBLEM", TYPED_PARAM_BOOL, "false",
+         "Report the route as the optimal one, closing the problem"},
+        {"WAIT_FOR_CANCEL", TYPED_PARAM_BOOL, "false",
+         "Once the route is reported, keep solving until the solve is "
+         "cancelled or the time limit is reached"},
+        {"SHARED_INCUMBENT", TYPED_PARAM_BOOL, "false",
+         "Before building the route, wait for a tour shared by the solves "
+         "racing alongside (up to the time limit), then report the route "
+         "only if it improves on the shared incumbent"},
+        {0},
+    }};
+
+// NOTE(dparo):
+//     The default members need CPLEX. Without it, the members must always be
+//     given explicitly.
+#if COMPILED_WITH_CPLEX
+#define PORTFOLIO_DEFAULT_SOLVERS "mip,mip:HEUR_PRICER_MODE=true"
+#else
+#define PORTFOLIO_DEFAULT_SOLVERS NULL
+#endif
+
+static const SolverDescriptor PORTFOLIO_SOLVER_DESCRIPTOR = {
+    "portfolio",
+    {
+        {"SOLVERS", TYPED_PARAM_STR, PORTFOLIO_DEFAULT_SOLVERS,
+         "Comma separated list of the solvers raced concurrently on the same "
+         "instance. The params of each solver follow its name, separated by "
+         "colons, eg `mip:NUM_THREADS=2:SPARSE_MIP=true,mip`. Members "
+         "accepting a NUM_THREADS param and not given one split the cores "
+         "evenly. The members share a common incumbent: the best tour found "
+         "by any of them bounds the search of the others"},
+        {"HEUR_PRICER_MODE", TYPED_PARAM_BOOL, "false",
+         "Stop the race as soon as any solver finds a reduced cost route, "
+         "instead of waiting for the optimality to be proven"},
+        {0},
+    }};
 
 Solver mip_solver_create(const Instance *instance, SolverTypedParams *tparams,
                          double timelimit, int32_t seed);
 Solver stub_solver_create(const Instance *instance, SolverTypedParams *tparams,
                           double timelimit, int32_t randomseed);
+Solver portfolio_solver_create(const Instance *instance,
+                               SolverTypedParams *tparams, double timelimit,
+                               int32_t randomseed);
 
 #if __cplusplus
 }
@@ -30,6 +30,7 @@ ATTRIB_MAYBE_UNUSED static const double EPS = 1e-6;
 
 struct CutSeparationPrivCtx {
     CutSeparationPrivCtxCommon super;
+    Bitset set_s;
 };
 
 static inline CPXNNZ get_nnz_upper_bound(const Instance *instance) {
@@ -40,6 +41,7 @@ static inline CPXNNZ get_nnz_upper_bound(const Instance *instance) {
 static void deactivate(CutSeparationPrivCtx *ctx) {
     free(ctx->super.index);
     free(ctx->super.value);
+    bitset_destroy(&ctx->set_s);
     free(ctx);
 }
 
@@ -52,8 +54,9 @@ static CutSeparationPrivCtx *activate(const Instance *instance,
 
     ctx->super.index = malloc(nnz_ub * sizeof(*ctx->super.index));
     ctx->super.value = malloc(nnz_ub * sizeof(*ctx->super.value));
+    ctx->set_s = bitset_create(instance->num_customers + 1);
 
-    if (!ctx->super.index || !ctx->super.value) {
+    if (!ctx->super.index || !ctx->super.value || !ctx->set_s.words) {
         deactivate(ctx);
         return NULL;
     }
@@ -62,55 +65,37 @@ static CutSeparationPrivCtx *activate(const Instance *instance,
 }
 
 static inline SeparationInfo separate(CutSeparationFunctor *self,
-                                      const double *vstar, int32_t *colors,
-                                      int32_t curr_color, double max_flow,
-                                      double tolerance) {
+                                      const double *vstar,
+                                      const Bitset *set_s, int32_t set_s_size,
+                                      double max_flow, double tolerance) {
     UNUSED_PARAM(max_flow);
     SeparationInfo info = {0};
     CutSeparationPrivCtx *ctx = self->ctx;
     const Instance *instance = self->instance;
-    const int32_t n = instance->num_customers + 1;
+    const EdgeGraph *edges = &self->solver->data->edges;
     const double Q = instance->vehicle_cap;
 
     info.sense = 'G';
 
-    assert(curr_color != colors[0]);
+    assert(!bitset_test(set_s, 0));
     assert(demand(instance, 0) == 0.0);
 
-    int32_t set_s_size = 0;
-    for (int32_t i = 0; i < n; i++) {
-        bool i_in_s = (colors[i] == curr_color);
-        if (i_in_s) {
-            ++set_s_size;
-        }
-    }
-
     assert(set_s_size >= 1);
+    assert(set_s_size == bitset_popcount(set_s));
 
     if (set_s_size >= 2) {
-        for (int32_t i = 0; i < n; i++) {
-            bool i_in_s = colors[i] == curr_color;
-
-            if (!i_in_s) {
-                continue;
-            }
-
-            for (int32_t j = 0; j < n; j++) {
-                if (i == j) {
-                    continue;
-                }
-
-                bool j_in_s = colors[j] == curr_color;
+        BITSET_FOREACH(set_s, i) {
+            assert(i != 0);
 
-                if (j_in_s) {
+            const int32_t *nbrs = edge_graph_neighbors(edges, i);
+            const int32_t deg = edge_graph_degree(edges, i);
+            for (int32_t k = 0; k < deg; k++) {
+                int32_t j = nbrs[k];
+                if (bitset_test(set_s, j)) {
                     continue;
                 }
 
-                assert(i_in_s && !j_in_s);
-                assert(i != 0);
-                assert(colors[i] != colors[j]);
-                assert(colors[i] == curr_color);
-                assert(colors[j] != curr_color);
+                assert(i != j);
 
                 double qj = demand(instance, j);
 
@@ -123,7 +108,6 @@ static inline SeparationInfo separate(CutSeparationFunctor *self,
                              (CPXDIM)get_x_mip_var_idx(instance, i, j));
             }
 
-            assert(i != 0);
             double qi = demand(instance, i);
             double value = -2.0 * qi / Q;
             push_var_lhs(&ctx->super, &info, vstar, value,
@@ -148,9 +132,11 @@ static bool fractional_sep(CutSeparationFunctor *self, const double obj_p,
 
     CutSeparationPrivCtx *ctx = self->ctx;
     int32_t depot_color = mf->colors[0];
+    int32_t set_s_size = max_flow_result_to_bitset(
+        mf, depot_color == BLACK ? WHITE : BLACK, &ctx->set_s);
     SeparationInfo info =
-        separate(self, vstar, mf->colors, depot_color == BLACK ? WHITE : BLACK,
-                 max_flow, FRACTIONAL_VIOLATION_TOLERANCE);
+        separate(self, vstar, &ctx->set_s, set_s_size, max_flow,
+                 FRACTIONAL_VIOLATION_TOLERANCE);
     if (!push_fractional_cut("GLM", self, &ctx->super, &info)) {
         return false;
     }
@@ -172,8 +158,9 @@ static bool integral_sep(CutSeparationFunctor *self, const double obj_p,
     // NOTE:
     // Start from c = 1. GLM cuts that include the depot node are NOT valid.
     for (int32_t c = 1; c < tour->num_comps; c++) {
-        SeparationInfo info = separate(self, vstar, tour->comp, c, 0.0,
-                                       INTEGRAL_VIOLATION_TOLERANCE);
+        int32_t set_s_size = tour_comp_to_bitset(tour, c, &ctx->set_s);
+        SeparationInfo info = separate(self, vstar, &ctx->set_s, set_s_size,
+                                       0.0, INTEGRAL_VIOLATION_TOLERANCE);
         if (!push_integral_cut("GLM", self, &ctx->super, &info)) {
             return false;
         }
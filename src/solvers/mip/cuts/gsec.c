@@ -74,6 +74,7 @@ struct CutSeparationPrivCtx {
     CPXDIM *index;
     double *value;
     int32_t *cnnodes;
+    Bitset set_s;
 };
 
 static inline void validate_index_array(CutSeparationPrivCtx *ctx, CPXNNZ nnz) {
@@ -105,6 +106,7 @@ static void deactivate(CutSeparationPrivCtx *ctx) {
     free(ctx->index);
     free(ctx->value);
     free(ctx->cnnodes);
+    bitset_destroy(&ctx->set_s);
     free(ctx);
 }
 
@@ -117,8 +119,9 @@ static CutSeparationPrivCtx *activate(const Instance *instance,
     ctx->index = malloc(nnz_ub * sizeof(*ctx->index));
     ctx->value = malloc(nnz_ub * sizeof(*ctx->value));
     ctx->cnnodes = malloc(n * sizeof(*ctx->cnnodes));
+    ctx->set_s = bitset_create(n);
 
-    if (!ctx->index || !ctx->value || !ctx->cnnodes) {
+    if (!ctx->index || !ctx->value || !ctx->cnnodes || !ctx->set_s.words) {
         deactivate(ctx);
         return NULL;
     }
@@ -131,7 +134,7 @@ static bool fractional_sep(CutSeparationFunctor *self, const double obj_p,
                            double max_flow) {
     CutSeparationPrivCtx *ctx = self->ctx;
     const Instance *instance = self->instance;
-    const int32_t n = instance->num_customers + 1;
+    const EdgeGraph *edges = &self->solver->data->edges;
 
     int32_t added_cuts = 0;
 
@@ -144,8 +147,6 @@ static bool fractional_sep(CutSeparationFunctor *self, const double obj_p,
     assert(mf->colors[source_vertex] == BLACK);
     assert(mf->colors[sink_vertex] == WHITE);
 
-    int32_t set_s_size = 0;
-
     // No way anything will be violated, so don't pay the cost
     // of the function
     if (mf->maxflow >= 2.0 - FRACTIONAL_VIOLATION_TOLERANCE) {
@@ -159,20 +160,19 @@ static bool fractional_sep(CutSeparationFunctor *self, const double obj_p,
     int32_t best_violated_idx = -1;
     double max_violation_amt = INFINITY;
 
-    for (int32_t i = 0; i < n; i++) {
-        int32_t i_color = mf->colors[i];
-        bool i_in_s = i_color != depot_color;
-        if (i_in_s) {
-            assert(i != 0);
-            ++set_s_size;
-            double y_i = vstar[get_y_mip_var_idx(instance, i)];
+    const Bitset *set_s = &ctx->set_s;
+    int32_t set_s_size = max_flow_result_to_bitset(
+        mf, depot_color == BLACK ? WHITE : BLACK, &ctx->set_s);
 
-            double violation_amt = mf->maxflow - 2 * y_i;
-            if (is_violated_fractional_cut(mf->maxflow, y_i) &&
-                violation_amt < max_violation_amt) {
-                max_violation_amt = violation_amt;
-                best_violated_idx = i;
-            }
+    BITSET_FOREACH(set_s, i) {
+        assert(i != 0);
+        double y_i = vstar[get_y_mip_var_idx(instance, i)];
+
+        double violation_amt = mf->maxflow - 2 * y_i;
+        if (is_violated_fractional_cut(mf->maxflow, y_i) &&
+            violation_amt < max_violation_amt) {
+            max_violation_amt = violation_amt;
+            best_violated_idx = i;
         }
     }
 
@@ -193,30 +193,19 @@ static bool fractional_sep(CutSeparationFunctor *self, const double obj_p,
         const int local_validity = 0; // (Globally valid)
 
         double flow = 0.0;
-        for (int32_t i = 0; i < n; i++) {
-            int32_t i_color = mf->colors[i];
-            bool i_in_s = i_color != depot_color;
-
-            if (!i_in_s) {
-                continue;
-            }
-
-            for (int32_t j = 0; j < n; j++) {
-                if (i == j) {
-                    continue;
-                }
-
-                int32_t j_color = mf->colors[j];
-                bool j_in_s = j_color != depot_color;
+        BITSET_FOREACH(set_s, i) {
+            assert(i != 0);
 
-                if (j_in_s) {
+            const int32_t *nbrs = edge_graph_neighbors(edges, i);
+            const int32_t deg = edge_graph_degree(edges, i);
+            for (int32_t k = 0; k < deg; k++) {
+                int32_t j = nbrs[k];
+                if (bitset_test(set_s, j)) {
                     continue;
                 }
 
-                assert(i != 0);
-                assert(i_color != j_color);
-                assert(i_color != depot_color);
-                assert(j_color == depot_color);
+                assert(i != j);
+                assert(mf->colors[j] == depot_color);
                 ctx->index[nnz] = (CPXDIM)get_x_mip_var_idx(instance, i, j);
                 ctx->value[nnz] = +1.0;
                 double x = vstar[get_x_mip_var_idx(instance, i, j)];
@@ -270,6 +259,7 @@ static bool integral_sep(CutSeparationFunctor *self, const double obj_p,
 
     CutSeparationPrivCtx *ctx = self->ctx;
     const Instance *instance = self->instance;
+    const EdgeGraph *edges = &self->solver->data->edges;
     const int32_t n = instance->num_customers + 1;
 
     for (int32_t c = 0; c < tour->num_comps; c++) {
@@ -300,7 +290,8 @@ static bool integral_sep(CutSeparationFunctor *self, const double obj_p,
     assert(tour->comp[0] == 0);
 
     int32_t depot_color = 0;
-    CPXNNZ nnz_upper_bound = get_nnz_upper_bound(instance);
+    ATTRIB_MAYBE_UNUSED CPXNNZ nnz_upper_bound =
+        get_nnz_upper_bound(instance);
     int32_t total_num_added_cuts = 0;
 
     // NOTE: The set S cannot contain the depot. Component index 0 always
@@ -310,28 +301,20 @@ static bool integral_sep(CutSeparationFunctor *self, const double obj_p,
         assert(ctx->cnnodes[c] >= 2);
 
         double flow = 0.0;
-        const CPXNNZ nnz = 1 + ctx->cnnodes[c] * (n - ctx->cnnodes[c]);
         CPXNNZ pos = 0;
 
-        assert(nnz <= nnz_upper_bound);
-
-        for (int32_t i = 0; i < n; i++) {
-            bool i_is_customer = i > 0;
-            bool i_in_s = (tour->comp[i] == c) && i_is_customer;
-
-            if (!i_in_s) {
-                continue;
-            }
-
-            for (int32_t j = 0; j < n; j++) {
-                if (i == j) {
-                    continue;
-                }
-
-                bool j_is_customer = j > 0;
-                bool j_in_s = (tour->comp[j] == c) && j_is_customer;
-
-                if (j_in_s) {
+        const Bitset *set_s = &ctx->set_s;
+        ATTRIB_MAYBE_UNUSED int32_t set_s_size =
+            tour_comp_to_bitset(tour, c, &ctx->set_s);
+        assert(set_s_size == ctx->cnnodes[c]);
+        assert(!bitset_test(set_s, 0));
+
+        BITSET_FOREACH(set_s, i) {
+            const int32_t *nbrs = edge_graph_neighbors(edges, i);
+            const int32_t deg = edge_graph_degree(edges, i);
+            for (int32_t k = 0; k < deg; k++) {
+                int32_t j = nbrs[k];
+                if (bitset_test(set_s, j)) {
                     continue;
                 }
 
@@ -348,22 +331,17 @@ static bool integral_sep(CutSeparationFunctor *self, const double obj_p,
             }
         }
 
+        // NOTE(dparo): Only the edges of the candidate graph are part of
+        //     the cut, the others are fixed to zero in the formulation
+        const CPXNNZ nnz = pos + 1;
         assert(feq(flow, 0.0, EPS));
-        assert(pos < nnz_upper_bound);
-        assert(pos == nnz - 1);
+        assert(nnz <= nnz_upper_bound);
 
         validate_index_array(ctx, nnz - 1);
 
         int32_t added_cuts = 0;
 
-        for (int32_t i = 0; i < n; i++) {
-            bool i_is_customer = i > 0;
-            bool i_in_s = (tour->comp[i] == c) && i_is_customer;
-
-            if (!i_in_s) {
-                continue;
-            }
-
+        BITSET_FOREACH(set_s, i) {
             double y_i = vstar[get_y_mip_var_idx(instance, i)];
             assert(tour->comp[i] >= 1);
 
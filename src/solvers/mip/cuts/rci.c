@@ -30,6 +30,7 @@ ATTRIB_MAYBE_UNUSED static const double EPS = 1e-6;
 
 struct CutSeparationPrivCtx {
     CutSeparationPrivCtxCommon super;
+    Bitset set_s;
 };
 
 static inline CPXNNZ get_nnz_upper_bound(const Instance *instance) {
@@ -40,36 +41,34 @@ static inline CPXNNZ get_nnz_upper_bound(const Instance *instance) {
 static void deactivate(CutSeparationPrivCtx *ctx) {
     free(ctx->super.index);
     free(ctx->super.value);
+    bitset_destroy(&ctx->set_s);
     free(ctx);
 }
 
 static inline SeparationInfo separate(CutSeparationFunctor *self,
-                                      const double *vstar, int32_t *colors,
-                                      int32_t curr_color, double max_flow,
-                                      double tolerance) {
+                                      const double *vstar,
+                                      const Bitset *set_s, int32_t set_s_size,
+                                      double max_flow, double tolerance) {
     SeparationInfo info = {0};
     CutSeparationPrivCtx *ctx = self->ctx;
     const Instance *instance = self->instance;
-    const int32_t n = instance->num_customers + 1;
+    const EdgeGraph *edges = &self->solver->data->edges;
     const double Q = instance->vehicle_cap;
 
     info.sense = 'G';
 
-    assert(curr_color != colors[0]);
+    assert(!bitset_test(set_s, 0));
     assert(demand(instance, 0) == 0.0);
 
+    assert(set_s_size == bitset_popcount(set_s));
+
     double Qs = 0.0;
-    int32_t set_s_size = 0;
     double served_demand = 0.0;
 
-    for (int32_t i = 0; i < n; i++) {
-        bool i_in_s = (colors[i] == curr_color);
-        if (i_in_s) {
-            ++set_s_size;
-            Qs += demand(instance, i);
-            served_demand =
-                demand(instance, i) * vstar[get_y_mip_var_idx(instance, i)];
-        }
+    BITSET_FOREACH(set_s, i) {
+        Qs += demand(instance, i);
+        served_demand =
+            demand(instance, i) * vstar[get_y_mip_var_idx(instance, i)];
     }
 
     double Qr = fmod(Qs, Q);
@@ -90,35 +89,23 @@ static inline SeparationInfo separate(CutSeparationFunctor *self,
             add_term_rhs(&ctx->super, &info, rhs);
         }
 
-        for (int32_t i = 0; i < n; i++) {
-            bool i_in_s = (colors[i] == curr_color);
-
-            if (!i_in_s) {
-                continue;
-            }
-
+        BITSET_FOREACH(set_s, i) {
             assert(i != 0);
-            assert(colors[i] == curr_color);
 
             double qi = demand(instance, i);
             double value = -2.0 * qi / Qr;
             push_var_lhs(&ctx->super, &info, vstar, value,
                          (CPXDIM)get_y_mip_var_idx(instance, i));
 
-            for (int32_t j = 0; j < n; j++) {
-                if (i == j) {
-                    continue;
-                }
-                bool j_in_s = (colors[j] == curr_color);
-
-                if (j_in_s) {
+            const int32_t *nbrs = edge_graph_neighbors(edges, i);
+            const int32_t deg = edge_graph_degree(edges, i);
+            for (int32_t k = 0; k < deg; k++) {
+                int32_t j = nbrs[k];
+                if (bitset_test(set_s, j)) {
                     continue;
                 }
 
-                assert(i != 0);
-                assert(colors[i] != colors[j]);
-                assert(colors[i] == curr_color);
-                assert(colors[j] != curr_color);
+                assert(i != j);
 
                 double value = 1.0;
                 push_var_lhs(&ctx->super, &info, vstar, value,
@@ -144,9 +131,11 @@ static bool fractional_sep(CutSeparationFunctor *self, const double obj_p,
 
     CutSeparationPrivCtx *ctx = self->ctx;
     int32_t depot_color = mf->colors[0];
+    int32_t set_s_size = max_flow_result_to_bitset(
+        mf, depot_color == BLACK ? WHITE : BLACK, &ctx->set_s);
     SeparationInfo info =
-        separate(self, vstar, mf->colors, depot_color == BLACK ? WHITE : BLACK,
-                 max_flow, FRACTIONAL_VIOLATION_TOLERANCE);
+        separate(self, vstar, &ctx->set_s, set_s_size, max_flow,
+                 FRACTIONAL_VIOLATION_TOLERANCE);
     if (!push_fractional_cut("RCI", self, &ctx->super, &info)) {
         return false;
     }
@@ -168,8 +157,9 @@ static bool integral_sep(CutSeparationFunctor *self, const double obj_p,
     // NOTE:
     // Start from c = 1. RCI cuts that include the depot node are NOT valid.
     for (int32_t c = 1; c < tour->num_comps; c++) {
-        SeparationInfo info = separate(self, vstar, tour->comp, c, 0.0,
-                                       INTEGRAL_VIOLATION_TOLERANCE);
+        int32_t set_s_size = tour_comp_to_bitset(tour, c, &ctx->set_s);
+        SeparationInfo info = separate(self, vstar, &ctx->set_s, set_s_size,
+                                       0.0, INTEGRAL_VIOLATION_TOLERANCE);
         if (!push_integral_cut("RCI", self, &ctx->super, &info)) {
             return false;
         }
@@ -189,8 +179,9 @@ static CutSeparationPrivCtx *activate(const Instance *instance,
 
     ctx->super.index = malloc(nnz_ub * sizeof(*ctx->super.index));
     ctx->super.value = malloc(nnz_ub * sizeof(*ctx->super.value));
+    ctx->set_s = bitset_create(instance->num_customers + 1);
 
-    if (!ctx->super.index || !ctx->super.value) {
+    if (!ctx->super.index || !ctx->super.value || !ctx->set_s.words) {
         deactivate(ctx);
         return NULL;
     }
@@ -21,6 +21,7 @@
  */
 
 #include "solvers.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -54,6 +55,7 @@ Solver mip_solver_create(const Instance *instance, SolverTypedParams *tparams,
 #include "warm-start.h"
 #include "maxflow.h"
 #include "validation.h"
+#include "dist-kernel.h"
 
 ATTRIB_MAYBE_UNUSED static void show_lp_file(Solver *self) {
     (void)self;
@@ -74,35 +76,19 @@ ATTRIB_MAYBE_UNUSED static void show_lp_file(Solver *self) {
 // (whichever is smaller).
 #define MAX_NUM_CORES 32
 
-typedef enum {
-    // NOTE:
-    //         This enum should remain packed. Enum fields should maintain a
-    //         monotonically increasing
-    //         value without any holes
-    GSEC_CUT_ID = 0,
-    GLM_CUT_ID,
-    RCI_CUT_ID,
-    NUM_CUTS,
-} CutId;
-
-// TODO: This struct is not thread safe
-static struct {
-    const CutDescriptor *descr;
-    bool enabled;
-    bool fractional_sep_enabled;
-} G_cuts[] = {
-    [GSEC_CUT_ID] = {&CUT_GSEC_DESCRIPTOR, true, false},
-    [GLM_CUT_ID] = {&CUT_GLM_DESCRIPTOR, false, false},
-    [RCI_CUT_ID] = {&CUT_RCI_DESCRIPTOR, false, false},
+static const CutDescriptor *const CUT_DESCRIPTORS[NUM_CUTS] = {
+    [GSEC_CUT_ID] = &CUT_GSEC_DESCRIPTOR,
+    [GLM_CUT_ID] = &CUT_GLM_DESCRIPTOR,
+    [RCI_CUT_ID] = &CUT_RCI_DESCRIPTOR,
 };
 
-static inline bool is_active_cut(CutId id) {
-    return G_cuts[id].enabled && G_cuts[id].descr->name &&
-           G_cuts[id].descr->iface;
+static inline bool is_active_cut(const SolverData *data, CutId id) {
+    return data->cuts[id].enabled && CUT_DESCRIPTORS[id]->name &&
+           CUT_DESCRIPTORS[id]->iface;
 }
 
-static inline bool is_fractional_cut_active(CutId id) {
-    return is_active_cut(id) && G_cuts[id].fractional_sep_enabled;
+static inline bool is_fractional_cut_active(const SolverData *data, CutId id) {
+    return is_active_cut(data, id) && data->cuts[id].fractional_sep_enabled;
 }
 
 typedef struct {
@@ -113,6 +99,9 @@ typedef struct {
     GomoryHuTree gh_tree;
     MaxFlow maxflow;
     MaxFlowResult maxflow_result;
+    Bitset bipartition;
+    int32_t seen_bipartitions_cap;
+    uint64_t *seen_bipartitions;
     Tour tour;
     CutSeparationFunctor functors[NUM_CUTS];
 
@@ -122,9 +111,16 @@ typedef struct {
 
 /// Struct that is used as a userhandle to be passed to the cplex generic
 /// callback
-typedef struct {
+typedef struct CplexCallbackCtx {
     Solver *solver;
     const Instance *instance;
+    /// Solution of the running solve, whose columns are filled with the
+    /// accepted candidate points under `columns_mutex`
+    Solution *solution;
+    pthread_mutex_t columns_mutex;
+    /// Drawn from the solver `rng`: the max-flow of each thread is seeded
+    /// from it and the thread id
+    uint64_t maxflow_seed;
     CallbackThreadLocalData thread_local_data[MAX_NUM_CORES];
 } CplexCallbackCtx;
 
@@ -135,13 +131,12 @@ destroy_callback_thread_local_data(CallbackThreadLocalData *thread_local_data) {
     }
 
     for (int32_t cut_id = 0; cut_id < (int32_t)NUM_CUTS; cut_id++) {
-        if (is_active_cut(cut_id)) {
-            if (thread_local_data->functors[cut_id].ctx) {
-                const CutSeparationIface *iface = G_cuts[cut_id].descr->iface;
-                iface->deactivate(thread_local_data->functors[cut_id].ctx);
-                memset(&thread_local_data->functors[cut_id], 0,
-                       sizeof(thread_local_data->functors[cut_id]));
-            }
+        // NOTE(dparo): Only the functors of the active cuts have a context
+        if (thread_local_data->functors[cut_id].ctx) {
+            const CutSeparationIface *iface = CUT_DESCRIPTORS[cut_id]->iface;
+            iface->deactivate(thread_local_data->functors[cut_id].ctx);
+            memset(&thread_local_data->functors[cut_id], 0,
+                   sizeof(thread_local_data->functors[cut_id]));
         }
     }
 
@@ -153,6 +148,8 @@ destroy_callback_thread_local_data(CallbackThreadLocalData *thread_local_data) {
     max_flow_destroy(&thread_local_data->maxflow);
     gomory_hu_tree_destroy(&thread_local_data->gh_tree);
     max_flow_result_destroy(&thread_local_data->maxflow_result);
+    bitset_destroy(&thread_local_data->bipartition);
+    free(thread_local_data->seen_bipartitions);
     thread_local_data->valid = false;
 }
 
@@ -167,15 +164,28 @@ static void destroy_all_callback_thread_local_data(CplexCallbackCtx *ctx) {
 static bool
 create_callback_thread_local_data(CallbackThreadLocalData *thread_local_data,
                                   CPXCALLBACKCONTEXTptr cplex_cb_ctx,
-                                  const Instance *instance, Solver *solver) {
+                                  const Instance *instance, Solver *solver,
+                                  uint64_t maxflow_seed) {
     bool success = true;
     const int32_t n = instance->num_customers + 1;
     memset(thread_local_data, 0, sizeof(*thread_local_data));
 
     flow_network_create(&thread_local_data->network, n);
     max_flow_create(&thread_local_data->maxflow, n, MAXFLOW_ALGO_PUSH_RELABEL);
+    max_flow_seed(&thread_local_data->maxflow, maxflow_seed);
     max_flow_result_create(&thread_local_data->maxflow_result, n);
     gomory_hu_tree_create(&thread_local_data->gh_tree, n);
+    thread_local_data->bipartition = bitset_create(n);
+
+    // NOTE(dparo): A Gomory-Hu tree encodes at most n - 1 distinct
+    //     bipartitions. Keep the open addressing table at most half full.
+    thread_local_data->seen_bipartitions_cap = 1;
+    while (thread_local_data->seen_bipartitions_cap < 2 * n) {
+        thread_local_data->seen_bipartitions_cap *= 2;
+    }
+    thread_local_data->seen_bipartitions =
+        calloc(thread_local_data->seen_bipartitions_cap,
+               sizeof(*thread_local_data->seen_bipartitions));
 
     thread_local_data->tour = tour_create(instance);
 
@@ -188,8 +198,8 @@ create_callback_thread_local_data(CallbackThreadLocalData *thread_local_data,
         malloc(solver->data->num_mip_vars * sizeof(*thread_local_data->value));
 
     for (int32_t cut_id = 0; cut_id < (int32_t)NUM_CUTS; cut_id++) {
-        if (is_active_cut(cut_id)) {
-            const CutSeparationIface *iface = G_cuts[cut_id].descr->iface;
+        if (is_active_cut(solver->data, cut_id)) {
+            const CutSeparationIface *iface = CUT_DESCRIPTORS[cut_id]->iface;
             CutSeparationFunctor *functor =
                 &thread_local_data->functors[cut_id];
 
@@ -201,6 +211,8 @@ create_callback_thread_local_data(CallbackThreadLocalData *thread_local_data,
             success &= functor->ctx && thread_local_data->vstar &&
                        thread_local_data->network.caps &&
                        thread_local_data->maxflow_result.colors &&
+                       thread_local_data->bipartition.words &&
+                       thread_local_data->seen_bipartitions &&
                        tour_is_valid(&thread_local_data->tour);
         }
     }
@@ -388,6 +400,116 @@ static bool add_depot_is_part_of_tour_constraint(Solver *self,
     return result;
 }
 
+static bool restrict_to_candidate_edges(Solver *self,
+                                        const Instance *instance) {
+    bool result = true;
+    const int32_t n = instance->num_customers + 1;
+    const CandidateLists *candidates = &self->data->candidates;
+    assert(candidates->lists);
+
+    CPXDIM *indices = malloc(hm_nentries(n) * sizeof(*indices));
+    char *lu = malloc(hm_nentries(n) * sizeof(*lu));
+    double *bd = malloc(hm_nentries(n) * sizeof(*bd));
+    CPXDIM cnt = 0;
+
+    if (!indices || !lu || !bd) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    // NOTE(dparo):
+    //     The edges incident to the depot are always kept: the depot must be
+    //     part of the tour and may be far from every customer in reduced
+    //     cost terms.
+    for (int32_t i = 1; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            if (!candidate_lists_contains_edge(candidates, i, j)) {
+                indices[cnt] = (CPXDIM)get_x_mip_var_idx(instance, i, j);
+                lu[cnt] = 'U';
+                bd[cnt] = 0.0;
+                ++cnt;
+            }
+        }
+    }
+
+    log_info("%s :: Fixing %lld out of %lld edges to zero", __func__,
+             (long long)cnt, (long long)hm_nentries(n));
+
+    if (cnt > 0 &&
+        CPXXchgbds(self->data->env, self->data->lp, cnt, indices, lu, bd)) {
+        log_fatal("%s :: Cannot change bounds for the non candidate edges",
+                  __func__);
+        result = false;
+    }
+
+terminate:
+    free(bd);
+    free(lu);
+    free(indices);
+    return result;
+}
+
+/// Shrinks the edge graph to the edges which may be part of a tour cheaper
+/// than `cutoff`, and fixes to zero the x variables of the removed ones.
+static bool eliminate_edges(Solver *self, const Instance *instance,
+                            double cutoff) {
+    bool result = true;
+    const int32_t n = instance->num_customers + 1;
+    EdgeGraph *edges = &self->data->edges;
+
+    EdgeEliminationParams params = {0};
+    params.cutoff = cutoff;
+    EdgeGraph pruned = edge_graph_create(instance, &params);
+
+    CPXDIM *indices = malloc(hm_nentries(n) * sizeof(*indices));
+    char *lu = malloc(hm_nentries(n) * sizeof(*lu));
+    double *bd = malloc(hm_nentries(n) * sizeof(*bd));
+    CPXDIM cnt = 0;
+
+    if (!pruned.adj || !indices || !lu || !bd) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        const int32_t *nbrs = edge_graph_neighbors(edges, i);
+        const int32_t deg = edge_graph_degree(edges, i);
+        for (int32_t k = 0; k < deg; k++) {
+            int32_t j = nbrs[k];
+            if (i < j && !edge_graph_contains(&pruned, i, j)) {
+                indices[cnt] = (CPXDIM)get_x_mip_var_idx(instance, i, j);
+                lu[cnt] = 'U';
+                bd[cnt] = 0.0;
+                ++cnt;
+            }
+        }
+    }
+
+    log_info("%s :: Fixing %lld more edges to zero (cutoff %f)", __func__,
+             (long long)cnt, cutoff);
+
+    if (cnt > 0 &&
+        CPXXchgbds(self->data->env, self->data->lp, cnt, indices, lu, bd)) {
+        log_fatal("%s :: Cannot change bounds for the eliminated edges",
+                  __func__);
+        result = false;
+        goto terminate;
+    }
+
+    edge_graph_destroy(edges);
+    *edges = pruned;
+    pruned = (EdgeGraph){0};
+
+terminate:
+    edge_graph_destroy(&pruned);
+    free(bd);
+    free(lu);
+    free(indices);
+    return result;
+}
+
 static bool add_capacity_ub(Solver *self, const Instance *instance) {
     bool result = true;
 
@@ -552,23 +674,40 @@ bool build_mip_formulation(Solver *self, const Instance *instance) {
         char cname[128];
         const char *pcname[] = {(const char *)cname};
 
+        // NOTE(dparo):
+        //     The objective coefficients are computed one row at a time
+        //     with the vectorized distance kernels
+        const int32_t n = instance->num_customers + 1;
+        double *costs_row = malloc(n * sizeof(*costs_row));
+        if (!costs_row) {
+            log_fatal("%s :: Failed memory allocation", __func__);
+            return false;
+        }
+
         int32_t cnt = 0;
-        for (int32_t i = 0; i < instance->num_customers + 1; i++) {
-            for (int32_t j = i + 1; j < instance->num_customers + 1; j++) {
+        for (int32_t i = 0; i < n; i++) {
+            dist_block(instance, i, i + 1, i + 1, n, costs_row, n);
+
+            for (int32_t j = i + 1; j < n; j++) {
                 if (i == j)
                     continue;
 
                 snprintf_safe(cname, sizeof(cname), "x(%d,%d)", i, j);
-                obj[0] = cost(instance, i, j);
+                obj[0] = costs_row[j - (i + 1)];
+                ub[0] = edge_graph_contains(&self->data->edges, i, j) ? 1.0
+                                                                      : 0.0;
+                assert(obj[0] == cost(instance, i, j));
 
                 if (CPXXnewcols(self->data->env, self->data->lp, 1, obj, lb, ub,
                                 xctype, pcname)) {
                     log_fatal("%s :: CPXXnewcols returned an error", __func__);
+                    free(costs_row);
                     return false;
                 }
                 cnt++;
             }
         }
+        free(costs_row);
         assert(cnt == hm_nentries(instance->num_customers + 1));
     }
 
@@ -629,15 +768,20 @@ bool build_mip_formulation(Solver *self, const Instance *instance) {
 
 #define CAP_DOUBLE_TO_INT (1 << 24)
 
-static void init_flow_network(FlowNetwork *net, const Instance *instance,
-                              const double *vstar) {
+static void init_flow_network(FlowNetwork *net, const EdgeGraph *edges,
+                              const Instance *instance, const double *vstar) {
 
     const int32_t n = instance->num_customers + 1;
 
+    // NOTE(dparo): The edges outside of the graph are fixed to zero
+    flow_network_clear_caps(net);
+
     for (int32_t i = 0; i < n; i++) {
-        for (int32_t j = 0; j < n; j++) {
-            double cap =
-                i == j ? 0.0 : vstar[get_x_mip_var_idx(instance, i, j)];
+        const int32_t *nbrs = edge_graph_neighbors(edges, i);
+        const int32_t deg = edge_graph_degree(edges, i);
+        for (int32_t k = 0; k < deg; k++) {
+            int32_t j = nbrs[k];
+            double cap = vstar[get_x_mip_var_idx(instance, i, j)];
             assert(fgte(cap, 0.0, 1e-5));
             // NOTE: Fix floating point rounding errors. In fact cap may be
             // slightly negative...
@@ -653,10 +797,10 @@ static void init_flow_network(FlowNetwork *net, const Instance *instance,
 }
 
 static inline bool
-is_any_fractional_cut_enabled(const CallbackThreadLocalData *tld) {
+is_any_fractional_cut_enabled(const SolverData *data) {
     for (int32_t cut_id = 0; cut_id < (int32_t)NUM_CUTS; cut_id++) {
-        if (is_fractional_cut_active(cut_id)) {
-            const CutSeparationIface *iface = G_cuts[cut_id].descr->iface;
+        if (is_fractional_cut_active(data, cut_id)) {
+            const CutSeparationIface *iface = CUT_DESCRIPTORS[cut_id]->iface;
             if (iface->fractional_sep) {
                 return true;
             }
@@ -665,6 +809,31 @@ is_any_fractional_cut_enabled(const CallbackThreadLocalData *tld) {
     return false;
 }
 
+/// Records the set S (the side of the last max-flow bipartition not
+/// containing the depot) among the ones already separated in the current
+/// round. Returns false if S was already seen.
+static bool mark_bipartition_as_seen(CallbackThreadLocalData *tld) {
+    const MaxFlowResult *mf = &tld->maxflow_result;
+    int32_t depot_color = mf->colors[0];
+    max_flow_result_to_bitset(mf, depot_color == BLACK ? WHITE : BLACK,
+                              &tld->bipartition);
+
+    // NOTE(dparo): Only the hashes are stored: a collision can only cause a
+    //     skipped separation, which is recovered in the following rounds.
+    uint64_t h = bitset_hash(&tld->bipartition);
+    h = h != 0 ? h : 1;
+
+    const uint64_t mask = (uint64_t)tld->seen_bipartitions_cap - 1;
+    for (uint64_t slot = h & mask;; slot = (slot + 1) & mask) {
+        if (tld->seen_bipartitions[slot] == h) {
+            return false;
+        } else if (tld->seen_bipartitions[slot] == 0) {
+            tld->seen_bipartitions[slot] = h;
+            return true;
+        }
+    }
+}
+
 static int cplex_on_new_relaxation(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
                                    CplexCallbackCtx *ctx, int32_t threadid,
                                    int32_t numthreads) {
@@ -696,7 +865,7 @@ static int cplex_on_new_relaxation(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
         goto terminate;
     }
 
-    const bool any_fractional = is_any_fractional_cut_enabled(tld);
+    const bool any_fractional = is_any_fractional_cut_enabled(solver->data);
     bool do_fractional_sep = true;
     if (solver->data->amortized_fractional_labeling) {
         do_fractional_sep =
@@ -707,9 +876,11 @@ static int cplex_on_new_relaxation(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
 
     if (any_fractional && do_fractional_sep) {
         FlowNetwork *net = &tld->network;
-        init_flow_network(net, instance, vstar);
+        init_flow_network(net, &solver->data->edges, instance, vstar);
 
         max_flow_all_pairs(net, &tld->maxflow, &tld->gh_tree);
+        memset(tld->seen_bipartitions, 0,
+               tld->seen_bipartitions_cap * sizeof(*tld->seen_bipartitions));
 
         for (int32_t s = 0; s < instance->num_customers + 1; s++) {
             for (int32_t t = 0; t < instance->num_customers + 1; t++) {
@@ -748,11 +919,18 @@ static int cplex_on_new_relaxation(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
                 assert(tld->maxflow_result.colors[s] == BLACK);
                 assert(tld->maxflow_result.colors[t] == WHITE);
 
+                // NOTE(dparo): Many (s, t) pairs induce the same set S, and
+                //     every separator only depends on S (and on the max flow
+                //     value, which is the capacity of the cut of S).
+                if (!mark_bipartition_as_seen(tld)) {
+                    continue;
+                }
+
                 for (int32_t cut_id = 0; cut_id < (int32_t)NUM_CUTS; cut_id++) {
-                    if (is_fractional_cut_active(cut_id)) {
+                    if (is_fractional_cut_active(solver->data, cut_id)) {
                         CutSeparationFunctor *functor = &tld->functors[cut_id];
                         const CutSeparationIface *iface =
-                            G_cuts[cut_id].descr->iface;
+                            CUT_DESCRIPTORS[cut_id]->iface;
                         if (iface->fractional_sep) {
                             const int64_t begin_time = os_get_usecs();
                             // NOTE: We need to reset the cplex_cb_ctx since
@@ -770,7 +948,7 @@ static int cplex_on_new_relaxation(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
                             if (!separation_success) {
                                 log_fatal("Separation of fractional cut `%s` "
                                           "failed",
-                                          G_cuts[cut_id].descr->name);
+                                          CUT_DESCRIPTORS[cut_id]->name);
                                 goto terminate;
                             }
                         }
@@ -849,6 +1027,22 @@ static int cplex_on_branching(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
 
     log_trace("%s :: obj_p = %f", __func__, obj_p);
 
+    // NOTE(dparo):
+    //     The nodes whose relaxation cannot improve on the tours found by the
+    //     solves racing alongside (eg the other portfolio members) are pruned
+    if (solver->shared_incumbent_cost &&
+        obj_p >= solver->shared_incumbent_cost(
+                     solver->shared_incumbent_user_data) -
+                     COST_TOLERANCE) {
+        log_trace("%s :: obj_p = %f, pruning node against the shared "
+                  "incumbent",
+                  __func__, obj_p);
+        if (0 != CPXXcallbackprunenode(cplex_cb_ctx)) {
+            log_fatal("%s :: CPXXcallbackprunenode() failed", __func__);
+            goto terminate;
+        }
+    }
+
     return 0;
 terminate:
     log_fatal("%s :: Fatal termination error", __func__);
@@ -897,9 +1091,10 @@ static int cplex_on_new_candidate_point(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
                   __func__, obj_p, tour->num_comps);
 
         for (int32_t cut_id = 0; cut_id < (int32_t)NUM_CUTS; cut_id++) {
-            if (is_active_cut(cut_id)) {
+            if (is_active_cut(solver->data, cut_id)) {
                 CutSeparationFunctor *functor = &tld->functors[cut_id];
-                const CutSeparationIface *iface = G_cuts[cut_id].descr->iface;
+                const CutSeparationIface *iface =
+                    CUT_DESCRIPTORS[cut_id]->iface;
                 if (iface->integral_sep) {
                     const int64_t begin_time = os_get_usecs();
                     // NOTE: We need to reset the cplex_cb_ctx since it might
@@ -915,7 +1110,7 @@ static int cplex_on_new_candidate_point(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
                     if (!separation_success) {
                         log_fatal("Separation of integral cut `%s` "
                                   "failed",
-                                  G_cuts[cut_id].descr->name);
+                                  CUT_DESCRIPTORS[cut_id]->name);
                         goto terminate;
                     }
                 }
@@ -926,6 +1121,18 @@ static int cplex_on_new_candidate_point(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
         log_trace("%s :: num_comps of unpacked tour is %d -- accepting "
                   "candidate point...",
                   __func__, tour->num_comps);
+
+        if (solver->on_incumbent) {
+            solver->on_incumbent(solver->on_incumbent_user_data, instance,
+                                 tour, obj_p);
+        }
+
+        Solution *solution = ctx->solution;
+        if (solution && solution->columns.capacity > 0) {
+            pthread_mutex_lock(&ctx->columns_mutex);
+            solution_add_column(solution, instance, tour);
+            pthread_mutex_unlock(&ctx->columns_mutex);
+        }
     }
 
     return 0;
@@ -1022,18 +1229,29 @@ static int cplex_on_thread_activation(int activation,
                   "%lld, numthreads = %lld",
                   threadid, numthreads);
 
+        // NOTE(dparo):
+        //     The buffers of a thread survive the previous solves, as long
+        //     as the solver is alive (see `update_profits`)
+        if (thread_local_data->valid) {
+            return 0;
+        }
+
+        Rng thread_rng = rng_create(ctx->maxflow_seed + (uint64_t)threadid);
         if (!create_callback_thread_local_data(thread_local_data, cplex_cb_ctx,
-                                               ctx->instance, ctx->solver)) {
+                                               ctx->instance, ctx->solver,
+                                               rng_next(&thread_rng))) {
             destroy_callback_thread_local_data(thread_local_data);
             log_fatal("%s :: Failed create_callback_thread_local_data()",
                       __func__);
             return 1;
         }
     } else if (activation < 0) {
+        // NOTE(dparo):
+        //     Keep the buffers for the thread activations of the next solves.
+        //     They are released once the solver is destroyed.
         log_trace("cplex_callback deactivated an old thread :: threadid = "
                   "%lld, numthreads = %lld\n",
                   threadid, numthreads);
-        destroy_callback_thread_local_data(thread_local_data);
     } else {
         assert(!"Invalid code path");
     }
@@ -1108,7 +1326,7 @@ CPXPUBLIC static int cplex_callback(CPXCALLBACKCONTEXTptr cplex_cb_ctx,
         break;
     }
 
-    if (ctx->solver->sigterm_occured) {
+    if (cancellation_requested(ctx->solver->cancel)) {
         CPXXcallbackabort(cplex_cb_ctx);
     }
 
@@ -1168,7 +1386,7 @@ static bool on_solve_start(Solver *self, const Instance *instance,
     // ignored. Use CPXXsetterminate and CPXsetterminate if you want to make
     // sure CPLEX terminates even in that case.
     //
-    if (0 != CPXXsetterminate(self->data->env, &self->sigterm_occured_int)) {
+    if (0 != CPXXsetterminate(self->data->env, &self->cancel->requested)) {
         log_fatal("%s :: Failed CPXXsetterminate()", __func__);
         goto fail;
     }
@@ -1181,6 +1399,7 @@ fail:
 static bool on_solve_end(Solver *self, const Instance *instance,
                          CplexCallbackCtx *callback_ctx) {
     UNUSED_PARAM(instance);
+    UNUSED_PARAM(callback_ctx);
 
     // Reset termination signal
     if (0 != CPXXsetterminate(self->data->env, NULL)) {
@@ -1189,8 +1408,6 @@ static bool on_solve_end(Solver *self, const Instance *instance,
         goto fail;
     }
 
-    destroy_all_callback_thread_local_data(callback_ctx);
-
     return true;
 fail:
     return false;
@@ -1295,6 +1512,39 @@ failure:
     return false;
 }
 
+/// Offers to the columns of `solution` the tours of the CPLEX solution pool
+/// and the ones of the warm start. The accepted candidate points were
+/// already offered during the solve.
+static void collect_columns(Solver *self, const Instance *instance,
+                            Solution *solution, double *vstar) {
+    SolverData *data = self->data;
+    if (solution->columns.capacity <= 0) {
+        return;
+    }
+
+    for (int64_t i = 0; i < arrlen(data->heur_columns); i++) {
+        solution_add_column(solution, instance, &data->heur_columns[i]);
+    }
+
+    int num_solns = CPXXgetsolnpoolnumsolns(data->env, data->lp);
+    if (num_solns <= 0) {
+        return;
+    }
+
+    Tour tour = tour_create(instance);
+    for (int soln = 0; soln < num_solns && tour_is_valid(&tour); soln++) {
+        if (0 != CPXXgetsolnpoolx(data->env, data->lp, soln, vstar, 0,
+                                  data->num_mip_vars - 1)) {
+            log_warn("%s :: Failed CPXXgetsolnpoolx() of solution %d",
+                     __func__, soln);
+            break;
+        }
+        unpack_mip_solution(instance, &tour, vstar);
+        solution_add_column(solution, instance, &tour);
+    }
+    tour_destroy(&tour);
+}
+
 SolveStatus convert_mip_lpstat_to_solvestatus(int lpstat,
                                               const char *lpstat_str) {
     // Usefull reference docs:
@@ -1374,11 +1624,12 @@ SolveStatus solve(Solver *self, const Instance *instance, Solution *solution,
 
     SolveStatus status = SOLVE_STATUS_ERR;
 
-    CplexCallbackCtx callback_ctx = {0};
-    callback_ctx.solver = self;
-    callback_ctx.instance = instance;
+    CplexCallbackCtx *callback_ctx = self->data->callback_ctx;
+    callback_ctx->solver = self;
+    callback_ctx->instance = instance;
+    callback_ctx->solution = solution;
 
-    if (!on_solve_start(self, instance, &callback_ctx)) {
+    if (!on_solve_start(self, instance, callback_ctx)) {
         return SOLVE_STATUS_ERR;
     }
 
@@ -1387,7 +1638,7 @@ SolveStatus solve(Solver *self, const Instance *instance, Solution *solution,
         return SOLVE_STATUS_ERR;
     }
 
-    if (!on_solve_end(self, instance, &callback_ctx)) {
+    if (!on_solve_end(self, instance, callback_ctx)) {
         return SOLVE_STATUS_ERR;
     }
 
@@ -1414,25 +1665,30 @@ SolveStatus solve(Solver *self, const Instance *instance, Solution *solution,
         goto terminate;
     }
 
+    if (status != 0 && !BOOL(status & SOLVE_STATUS_ERR)) {
+        collect_columns(self, instance, solution, vstar);
+    }
+
 terminate:
+    callback_ctx->solution = NULL;
     free(vstar);
     return status;
 }
 
-// NOTE: Not thread safe
-static void enable_cuts(SolverTypedParams *tparams) {
-    G_cuts[GSEC_CUT_ID].enabled = solver_params_get_bool(tparams, "GSEC_CUTS");
-    G_cuts[GLM_CUT_ID].enabled = solver_params_get_bool(tparams, "GLM_CUTS");
-    G_cuts[RCI_CUT_ID].enabled = solver_params_get_bool(tparams, "RCI_CUTS");
+static void enable_cuts(SolverData *data, SolverTypedParams *tparams) {
+    CutConfig *cuts = data->cuts;
+    cuts[GSEC_CUT_ID].enabled = solver_params_get_bool(tparams, "GSEC_CUTS");
+    cuts[GLM_CUT_ID].enabled = solver_params_get_bool(tparams, "GLM_CUTS");
+    cuts[RCI_CUT_ID].enabled = solver_params_get_bool(tparams, "RCI_CUTS");
 
-    G_cuts[GSEC_CUT_ID].fractional_sep_enabled =
-        G_cuts[GSEC_CUT_ID].enabled &&
+    cuts[GSEC_CUT_ID].fractional_sep_enabled =
+        cuts[GSEC_CUT_ID].enabled &&
         solver_params_get_bool(tparams, "GSEC_FRAC_CUTS");
-    G_cuts[GLM_CUT_ID].fractional_sep_enabled =
-        G_cuts[GLM_CUT_ID].enabled &&
+    cuts[GLM_CUT_ID].fractional_sep_enabled =
+        cuts[GLM_CUT_ID].enabled &&
         solver_params_get_bool(tparams, "GLM_FRAC_CUTS");
-    G_cuts[RCI_CUT_ID].fractional_sep_enabled =
-        G_cuts[RCI_CUT_ID].enabled &&
+    cuts[RCI_CUT_ID].fractional_sep_enabled =
+        cuts[RCI_CUT_ID].enabled &&
         solver_params_get_bool(tparams, "RCI_FRAC_CUTS");
 }
 
@@ -1445,6 +1701,217 @@ static inline double compute_trivial_lower_cutoff(const Instance *instance) {
     return sum;
 }
 
+static bool set_lower_cutoff(Solver *solver, const Instance *instance) {
+    const double cutoff_value = compute_trivial_lower_cutoff(instance);
+    log_info("%s :: Setting LOWER_CUTOFF to %f", __func__, cutoff_value);
+
+    // FIXME:
+    //      Reference:
+    //      https://www.ibm.com/docs/en/icos/22.1.0?topic=parameters-lower-cutoff
+    //  The CPX_PARAM_CUTLO applies only to maximimization problems. In
+    //  our case we have a minimization problem, therefore we need to
+    //  implement the lower_cutoff value as an explicit constraint (i.e
+    //  a dedicated row in the tablue).
+    if (0 !=
+        CPXXsetdblparam(solver->data->env, CPX_PARAM_CUTLO, cutoff_value)) {
+        log_fatal("%s :: CPXXsetdblparam -- Failed to setup CPX_PARAM_CUTLO "
+                  "(upper cuttoff value) to value %f",
+                  __func__, cutoff_value);
+        return false;
+    }
+    return true;
+}
+
+static void clear_heur_columns(SolverData *data) {
+    for (int64_t i = 0; i < arrlen(data->heur_columns); i++) {
+        tour_destroy(&data->heur_columns[i]);
+    }
+    arrfree(data->heur_columns);
+}
+
+/// Everything of the formulation depending on the profits, other than the
+/// objective: the candidate edges restriction of the sparse MIP, the warm
+/// start (and the edge elimination that it enables) and the time limit left.
+static bool setup_profits_dependent_state(Solver *solver,
+                                          const Instance *instance) {
+    SolverData *data = solver->data;
+    double timelimit = data->timelimit;
+
+    if (data->candidates.lists && data->sparse_mip &&
+        !restrict_to_candidate_edges(solver, instance)) {
+        log_fatal("%s : Failed to restrict the formulation to the "
+                  "candidate edges",
+                  __func__);
+        return false;
+    }
+
+    clear_heur_columns(data);
+
+    // WARM start
+    if (data->ins_heur_warm_start) {
+        int64_t begin_time = os_get_usecs();
+        double warm_start_ub = INFINITY;
+        if (!mip_ins_heur_warm_start(solver, instance, data->heur_pricer_mode,
+                                     &warm_start_ub)) {
+            log_fatal("%s :: WARM start failed", __func__);
+            return false;
+        }
+
+        if (data->edge_elimination && warm_start_ub < INFINITY &&
+            !eliminate_edges(solver, instance, warm_start_ub)) {
+            log_fatal("%s :: Edge elimination failed", __func__);
+            return false;
+        }
+        double diff_secs =
+            (double)(os_get_usecs() - begin_time) * USECS_TO_SECS;
+        printf("WARM START took %f secs\n", diff_secs);
+        log_info("%s :: mip_ins_heur_warm_start took %f secs", __func__,
+                 diff_secs);
+
+        timelimit = timelimit - diff_secs;
+
+        if (data->polish_after_warm_start) {
+            log_info("%s :: CPXXsetdblparam -- Setting "
+                     "CPX_PARAM_POLISHAFTERTIME to "
+                     "0.0 (polish the warm start solutions)",
+                     __func__);
+            if (0 !=
+                CPXXsetdblparam(data->env, CPX_PARAM_POLISHAFTERTIME, 0.0)) {
+                log_fatal("%s :: CPXXsetdbparam -- Failed to setup "
+                          "CPX_PARAM_POLISHAFTERTIME "
+                          "(timelimit) to value 0.0",
+                          __func__);
+            }
+        }
+    }
+
+    log_info("%s :: CPXXsetdblparam -- Setting TIMELIMIT to %f", __func__,
+             timelimit);
+    if (CPXXsetdblparam(data->env, CPX_PARAM_TILIM, timelimit) != 0) {
+        log_fatal("%s :: CPXXsetdbparam -- Failed to setup CPX_PARAM_TILIM "
+                  "(timelimit) to value %f",
+                  __func__, timelimit);
+        return false;
+    }
+
+    return true;
+}
+
+/// Frees again the x variables of every edge which passes the (profits
+/// independent) demand test, undoing the fixings of the candidate edges
+/// restriction and of the edge elimination.
+static bool reset_edges(Solver *self, const Instance *instance) {
+    bool result = true;
+    const int32_t n = instance->num_customers + 1;
+    EdgeGraph all_edges = edge_graph_create(instance, NULL);
+
+    CPXDIM *indices = malloc(hm_nentries(n) * sizeof(*indices));
+    char *lu = malloc(hm_nentries(n) * sizeof(*lu));
+    double *bd = malloc(hm_nentries(n) * sizeof(*bd));
+    CPXDIM cnt = 0;
+
+    if (!all_edges.adj || !indices || !lu || !bd) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        const int32_t *nbrs = edge_graph_neighbors(&all_edges, i);
+        const int32_t deg = edge_graph_degree(&all_edges, i);
+        for (int32_t k = 0; k < deg; k++) {
+            if (i < nbrs[k]) {
+                indices[cnt] = (CPXDIM)get_x_mip_var_idx(instance, i, nbrs[k]);
+                lu[cnt] = 'U';
+                bd[cnt] = 1.0;
+                ++cnt;
+            }
+        }
+    }
+
+    if (cnt > 0 &&
+        CPXXchgbds(self->data->env, self->data->lp, cnt, indices, lu, bd)) {
+        log_fatal("%s :: Cannot reset the bounds of the edges", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    edge_graph_destroy(&self->data->edges);
+    self->data->edges = all_edges;
+    all_edges = (EdgeGraph){0};
+
+terminate:
+    edge_graph_destroy(&all_edges);
+    free(bd);
+    free(lu);
+    free(indices);
+    return result;
+}
+
+// NOTE(dparo):
+//     Successive pricing problems differ only in the profits, namely in the
+//     objective coefficients of the y variables. The CPLEX environment, the
+//     problem (with the stored information CPLEX uses for its advanced
+//     start) and the callback buffers are all kept: only the objective and
+//     the profits dependent state are recomputed.
+static bool update_profits(Solver *self, const Instance *instance) {
+    bool result = true;
+    const int32_t n = instance->num_customers + 1;
+    SolverData *data = self->data;
+
+    CPXDIM *indices = malloc(n * sizeof(*indices));
+    double *obj = malloc(n * sizeof(*obj));
+
+    if (!indices || !obj) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        indices[i] = (CPXDIM)get_y_mip_var_idx(instance, i);
+        obj[i] = -1.0 * profit(instance, i);
+    }
+
+    if (CPXXchgobj(data->env, data->lp, n, indices, obj)) {
+        log_fatal("%s :: CPXXchgobj failed", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    // The MIP starts remain feasible, but were selected for the old profits
+    int num_mip_starts = CPXXgetnummipstarts(data->env, data->lp);
+    if (num_mip_starts > 0 &&
+        CPXXdelmipstarts(data->env, data->lp, 0, num_mip_starts - 1)) {
+        log_fatal("%s :: CPXXdelmipstarts failed", __func__);
+        result = false;
+        goto terminate;
+    }
+
+    if (!reset_edges(self, instance)) {
+        result = false;
+        goto terminate;
+    }
+
+    if (data->candidates.lists &&
+        !candidate_lists_update(&data->candidates, instance)) {
+        result = false;
+        goto terminate;
+    }
+
+    if (data->apply_lower_cutoff && !set_lower_cutoff(self, instance)) {
+        result = false;
+        goto terminate;
+    }
+
+    result = setup_profits_dependent_state(self, instance);
+
+terminate:
+    free(obj);
+    free(indices);
+    return result;
+}
+
 bool cplex_setup(Solver *solver, const Instance *instance,
                  SolverTypedParams *tparams, double timelimit,
                  int32_t randomseed) {
@@ -1572,22 +2039,7 @@ bool cplex_setup(Solver *solver, const Instance *instance,
         // (MIP). It does not have the expected effect when branch and bound
         // is not invoked.
 
-        const double cutoff_value = compute_trivial_lower_cutoff(instance);
-        log_info("%s :: Setting LOWER_CUTOFF to %f", __func__, cutoff_value);
-
-        // FIXME:
-        //      Reference:
-        //      https://www.ibm.com/docs/en/icos/22.1.0?topic=parameters-lower-cutoff
-        //  The CPX_PARAM_CUTLO applies only to maximimization problems. In
-        //  our case we have a minimization problem, therefore we need to
-        //  implement the lower_cutoff value as an explicit constraint (i.e
-        //  a dedicated row in the tablue).
-        if (0 !=
-            CPXXsetdblparam(solver->data->env, CPX_PARAM_CUTLO, cutoff_value)) {
-            log_fatal(
-                "%s :: CPXXsetdblparam -- Failed to setup CPX_PARAM_CUTLO "
-                "(upper cuttoff value) to value %f",
-                __func__, cutoff_value);
+        if (!set_lower_cutoff(solver, instance)) {
             goto fail;
         }
     }
@@ -1604,7 +2056,7 @@ bool cplex_setup(Solver *solver, const Instance *instance,
         solver->data->fractional_separation_enabled = true;
     }
 
-    enable_cuts(tparams);
+    enable_cuts(solver->data, tparams);
 
     return true;
 
@@ -1624,6 +2076,16 @@ static void mip_solver_destroy(Solver *self) {
             CPXXcloseCPLEX(&self->data->env);
         }
 
+        if (self->data->callback_ctx) {
+            destroy_all_callback_thread_local_data(self->data->callback_ctx);
+            pthread_mutex_destroy(&self->data->callback_ctx->columns_mutex);
+            free(self->data->callback_ctx);
+        }
+
+        clear_heur_columns(self->data);
+
+        candidate_lists_destroy(&self->data->candidates);
+        edge_graph_destroy(&self->data->edges);
         free(self->data);
     }
 
@@ -1637,67 +2099,65 @@ Solver mip_solver_create(const Instance *instance, SolverTypedParams *tparams,
     log_trace("%s", __func__);
 
     Solver solver = {0};
+    solver.rng = rng_create((uint64_t)randomseed);
     solver.solve = solve;
+    solver.update_profits = update_profits;
     solver.destroy = mip_solver_destroy;
     solver.data = calloc(1, sizeof(*solver.data));
     if (!solver.data) {
         goto fail;
     }
 
+    solver.data->callback_ctx = calloc(1, sizeof(*solver.data->callback_ctx));
+    if (!solver.data->callback_ctx) {
+        goto fail;
+    }
+    pthread_mutex_init(&solver.data->callback_ctx->columns_mutex, NULL);
+    solver.data->callback_ctx->maxflow_seed = rng_next(&solver.rng);
+
     if (!cplex_setup(&solver, instance, tparams, timelimit, randomseed)) {
         log_fatal("%s : Failed to initialize cplex", __func__);
         goto fail;
     }
 
+    solver.data->edges = edge_graph_create(instance, NULL);
+    if (!solver.data->edges.adj) {
+        log_fatal("%s : Failed to build the edge graph", __func__);
+        goto fail;
+    }
+
     if (!build_mip_formulation(&solver, instance)) {
         log_fatal("%s : Failed to build mip formulation", __func__);
         goto fail;
     }
 
+    int32_t num_candidates = solver_params_get_int32(tparams, "NUM_CANDIDATES");
+    if (num_candidates > 0) {
+        solver.data->candidates =
+            candidate_lists_create(instance, num_candidates);
+        if (!solver.data->candidates.lists) {
+            log_fatal("%s : Failed to build the candidate lists", __func__);
+            goto fail;
+        }
+    }
+
     solver.data->num_mip_vars =
         CPXXgetnumcols(solver.data->env, solver.data->lp);
     solver.data->num_mip_constraints =
         CPXXgetnumrows(solver.data->env, solver.data->lp);
 
-    // WARM start
-    if (solver_params_get_bool(tparams, "INS_HEUR_WARM_START")) {
-        int64_t begin_time = os_get_usecs();
-        if (!mip_ins_heur_warm_start(&solver, instance,
-                                     solver.data->heur_pricer_mode)) {
-            log_fatal("%s :: WARM start failed", __func__);
-            goto fail;
-        }
-        double diff_secs =
-            (double)(os_get_usecs() - begin_time) * USECS_TO_SECS;
-        printf("WARM START took %f secs\n", diff_secs);
-        log_info("%s :: mip_ins_heur_warm_start took %f secs", __func__,
-                 diff_secs);
-
-        timelimit = timelimit - diff_secs;
-
-        if (solver_params_get_bool(tparams,
-                                   "APPLY_POLISHING_AFTER_WARM_START")) {
-
-            log_info("%s :: CPXXsetdblparam -- Setting "
-                     "CPX_PARAM_POLISHAFTERTIME to "
-                     "0.0 (polish the warm start solutions)",
-                     __func__);
-            if (0 != CPXXsetdblparam(solver.data->env,
-                                     CPX_PARAM_POLISHAFTERTIME, 0.0)) {
-                log_fatal("%s :: CPXXsetdbparam -- Failed to setup "
-                          "CPX_PARAM_POLISHAFTERTIME "
-                          "(timelimit) to value 0.0",
-                          __func__);
-            }
-        }
-    }
-
-    log_info("%s :: CPXXsetdblparam -- Setting TIMELIMIT to %f", __func__,
-             timelimit);
-    if (CPXXsetdblparam(solver.data->env, CPX_PARAM_TILIM, timelimit) != 0) {
-        log_fatal("%s :: CPXXsetdbparam -- Failed to setup CPX_PARAM_TILIM "
-                  "(timelimit) to value %f",
-                  __func__, timelimit);
+    solver.data->timelimit = timelimit;
+    solver.data->sparse_mip = solver_params_get_bool(tparams, "SPARSE_MIP");
+    solver.data->ins_heur_warm_start =
+        solver_params_get_bool(tparams, "INS_HEUR_WARM_START");
+    solver.data->edge_elimination =
+        solver_params_get_bool(tparams, "EDGE_ELIMINATION");
+    solver.data->apply_lower_cutoff =
+        solver_params_get_bool(tparams, "APPLY_LOWER_CUTOFF");
+    solver.data->polish_after_warm_start =
+        solver_params_get_bool(tparams, "APPLY_POLISHING_AFTER_WARM_START");
+
+    if (!setup_profits_dependent_state(&solver, instance)) {
         goto fail;
     }
 
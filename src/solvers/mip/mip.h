@@ -30,6 +30,8 @@ extern "C" {
 #include "core.h"
 #include "core-utils.h"
 #include "maxflow.h"
+#include "candidates.h"
+#include "edge-graph.h"
 
 #ifdef COMPILED_WITH_CPLEX
 
@@ -42,6 +44,23 @@ extern "C" {
 struct CutSeparationPrivCtx;
 typedef struct CutSeparationPrivCtx CutSeparationPrivCtx;
 
+typedef enum {
+    // NOTE:
+    //         This enum should remain packed. Enum fields should maintain a
+    //         monotonically increasing
+    //         value without any holes
+    GSEC_CUT_ID = 0,
+    GLM_CUT_ID,
+    RCI_CUT_ID,
+    NUM_CUTS,
+} CutId;
+
+/// Per solver activation of a family of cuts
+typedef struct {
+    bool enabled;
+    bool fractional_sep_enabled;
+} CutConfig;
+
 typedef struct SolverData {
     int64_t begin_time;
     CPXENVptr env;
@@ -52,6 +71,27 @@ typedef struct SolverData {
     CPXDIM num_mip_constraints;
     bool fractional_separation_enabled;
     bool amortized_fractional_labeling;
+    /// Reduced cost candidate lists (`lists` is NULL when disabled)
+    CandidateLists candidates;
+    /// Edges which may be part of an improving tour. The x variables of the
+    /// other edges are fixed to zero, and the separators skip them.
+    EdgeGraph edges;
+    CutConfig cuts[NUM_CUTS];
+    /// Generic callback context, whose per thread buffers are kept alive
+    /// across the solves of the same solver
+    struct CplexCallbackCtx *callback_ctx;
+    /// Improving tours found by the warm start heuristic, offered to the
+    /// columns of the solution at the end of the solve. Uses <stb_ds.h>
+    /// arrpush() and alike.
+    Tour *heur_columns;
+
+    /// Settings re-applied whenever the profits change
+    double timelimit;
+    bool sparse_mip;
+    bool ins_heur_warm_start;
+    bool edge_elimination;
+    bool apply_lower_cutoff;
+    bool polish_after_warm_start;
 } SolverData;
 
 struct CutSeparationIface;
@@ -22,6 +22,8 @@
 
 #include "warm-start.h"
 #include "validation.h"
+#include "dist-kernel.h"
+#include "array-tour.h"
 
 #define WARM_START_MIN_NUM_CUSTOMERS_SERVED (2)
 
@@ -138,7 +140,7 @@ static bool valid_starting_pair(const Instance *instance,
     }
 }
 
-static bool random_insheur_starting_pair(const Instance *instance,
+static bool random_insheur_starting_pair(const Instance *instance, Rng *rng,
                                          InsHeurNodePair *start_pair) {
     const int32_t n = instance->num_customers + 1;
     const double Q = instance->vehicle_cap;
@@ -168,7 +170,7 @@ static bool random_insheur_starting_pair(const Instance *instance,
 
     e = -1;
     do {
-        e = rand() % n;
+        e = rng_next_int(rng, n);
     } while (e == s || instance->demands[e] > rel_Q);
 
     start_pair->u = s;
@@ -177,10 +179,10 @@ static bool random_insheur_starting_pair(const Instance *instance,
     return true;
 }
 
-static void ins_heur(const Instance *instance, Solution *solution,
+static bool ins_heur(const Instance *instance,
+                     const CandidateLists *candidates, Solution *solution,
                      InsHeurNodePair starting_pair) {
-    Tour *const tour = &solution->tour;
-
+    bool result = true;
     const int32_t n = instance->num_customers + 1;
     const double Q = instance->vehicle_cap;
 
@@ -191,25 +193,54 @@ static void ins_heur(const Instance *instance, Solution *solution,
     assert(end >= 0 && end < n);
     assert(start != end);
 
-    tour_clear(tour);
-    tour->num_comps = 1;
-    tour->comp[start] = 0;
-    tour->comp[end] = 0;
-    tour->succ[start] = end;
-    tour->succ[end] = start;
+    // NOTE(dparo):
+    //     The route is built on an array tour, which tracks the cost, profit
+    //     and demand of the route as nodes get inserted
+    tour_clear(&solution->tour);
+    ArrayTour at = array_tour_adopt(instance, &solution->tour);
+    if (!at.pred) {
+        return false;
+    }
+    Tour *const tour = &at.tour;
+    array_tour_insert(&at, start, -1);
+    array_tour_insert(&at, end, start);
 
-    double cost = cptp_dist(instance, start, end) +
-                  cptp_dist(instance, end, start) - instance->profits[start] -
-                  instance->profits[end];
-    double sum_demands = instance->demands[start] + instance->demands[end];
+    // NOTE(dparo):
+    //     When the distances are neither explicit nor cached (too many
+    //     nodes), compute the distances from `h` to every node once with the
+    //     vectorized row kernel, instead of evaluating `c_ah` and `c_hb`
+    //     from scratch for each candidate edge `(a, b)`.
+    double *h_dists = NULL;
+    DistRowKernel h_dists_kernel = NULL;
+    int32_t *positions = NULL;
+    if (!candidates && !instance->edge_weight && !instance->dist_cache) {
+        h_dists = malloc(n * sizeof(*h_dists));
+        h_dists_kernel = dist_row_kernel(instance->rounding_strat);
+        if (!h_dists) {
+            log_fatal("%s :: Failed memory allocation", __func__);
+            result = false;
+            goto terminate;
+        }
+    }
 
-    int32_t num_visited = 2;
+    // NOTE(dparo):
+    //     With the candidate lists, a node `h` is only considered for
+    //     insertion in the edges `(a, succ(a))` and `(pred(a), a)` incident
+    //     to the visited nodes `a` of its candidate list.
+    if (candidates) {
+        positions = malloc(2 * candidates->k * sizeof(*positions));
+        if (!positions) {
+            log_fatal("%s :: Failed memory allocation", __func__);
+            result = false;
+            goto terminate;
+        }
+    }
+    bool use_candidates = candidates != NULL;
 
     while (true) {
         double best_delta_cost = -COST_TOLERANCE;
         int32_t best_h = -1;
         int32_t best_a = -1;
-        int32_t best_b = -1;
 
         // Scan for nodes to be inserted
         for (int32_t h = 0; h < n; h++) {
@@ -218,7 +249,23 @@ static void ins_heur(const Instance *instance, Solution *solution,
                 continue;
             }
 
-            for (int32_t a = 0; a < n; a++) {
+            int32_t num_positions = n;
+            if (use_candidates) {
+                num_positions = 0;
+                const int32_t *list = candidate_list(candidates, h);
+                for (int32_t t = 0; t < candidates->k; t++) {
+                    int32_t c = list[t];
+                    if (tour->comp[c] == 0) {
+                        positions[num_positions++] = c;
+                        positions[num_positions++] = array_tour_pred(&at, c);
+                    }
+                }
+            } else if (h_dists && instance->demands[h] <= Q - at.demand) {
+                h_dists_kernel(instance->positions, h, 0, n, h_dists);
+            }
+
+            for (int32_t p = 0; p < num_positions; p++) {
+                int32_t a = use_candidates ? positions[p] : p;
                 bool a_is_visited = tour->comp[a] == 0;
                 if (!a_is_visited) {
                     continue;
@@ -228,12 +275,14 @@ static void ins_heur(const Instance *instance, Solution *solution,
                 assert(b >= 0 && b < n);
                 assert(tour->succ[a] == b);
 
-                const double rel_Q = Q - sum_demands;
+                const double rel_Q = Q - at.demand;
                 double delta_cost = INFINITY;
 
                 if (instance->demands[h] <= rel_Q) {
-                    double c_ah = cptp_dist(instance, a, h);
-                    double c_hb = cptp_dist(instance, h, b);
+                    double c_ah =
+                        h_dists ? h_dists[a] : cptp_dist(instance, a, h);
+                    double c_hb =
+                        h_dists ? h_dists[b] : cptp_dist(instance, h, b);
                     double c_ab = cptp_dist(instance, a, b);
                     delta_cost = c_ah + c_hb - c_ab - instance->profits[h];
                 } else {
@@ -270,17 +319,26 @@ static void ins_heur(const Instance *instance, Solution *solution,
                         : delta_cost < (best_delta_cost - COST_TOLERANCE);
 
                 bool good_candidate_for_insertion =
-                    h == 0 || num_visited == 2 || improving_delta_cost;
+                    h == 0 || at.len == 2 || improving_delta_cost;
 
                 if (good_candidate_for_insertion) {
                     best_delta_cost = delta_cost;
                     best_h = h;
                     best_a = a;
-                    best_b = b;
                 }
             }
         }
 
+        if (best_h < 0 && use_candidates &&
+            (at.len == 2 || tour->comp[0] != 0)) {
+            // NOTE(dparo):
+            //     A mandatory insertion has no visited node among its
+            //     candidates. Fallback to a full scan for this iteration.
+            use_candidates = false;
+            continue;
+        }
+        use_candidates = candidates != NULL;
+
         if (best_h < 0) {
             assert(tour->comp[0] == 0);
             break;
@@ -288,30 +346,33 @@ static void ins_heur(const Instance *instance, Solution *solution,
 
         assert(best_h >= 0 && best_h < n);
         assert(best_a >= 0 && best_a < n);
-        assert(best_b >= 0 && best_b < n);
-        assert(tour->succ[best_a] == best_b);
-
-        assert(best_delta_cost < 0.0 || num_visited == 2 || best_h == 0);
-        cost += best_delta_cost;
-        sum_demands += instance->demands[best_h];
 
-        tour->comp[best_h] = 0;
-        tour->succ[best_a] = best_h;
-        tour->succ[best_h] = best_b;
-        ++num_visited;
+        assert(best_delta_cost < 0.0 || at.len == 2 || best_h == 0);
+        array_tour_insert(&at, best_h, best_a);
 
 #ifndef NDEBUG
         if (tour->comp[0] == 0) {
             validate_tour(instance, tour, WARM_START_MIN_NUM_CUSTOMERS_SERVED);
-            assert(feq(tour_eval(instance, tour), cost, 1e-5));
+            assert(at.demand > Q ||
+                   feq(tour_eval(instance, tour), array_tour_objective(&at),
+                       1e-5));
         }
 #endif
     }
 
-    solution->primal_bound = cost;
+terminate:
+    free(positions);
+    free(h_dists);
+    solution->primal_bound =
+        at.demand > Q ? INFINITY : array_tour_objective(&at);
+    solution->tour = array_tour_release(&at);
+    if (!result) {
+        return false;
+    }
 
 #ifndef NDEBUG
-    validate_tour(instance, tour, WARM_START_MIN_NUM_CUSTOMERS_SERVED);
+    validate_tour(instance, &solution->tour,
+                  WARM_START_MIN_NUM_CUSTOMERS_SERVED);
     validate_primal_solution(instance, solution, WARM_START_MIN_NUM_CUSTOMERS_SERVED);
 
     // NOTE(dparo):
@@ -320,56 +381,31 @@ static void ins_heur(const Instance *instance, Solution *solution,
     {
         int32_t num_visited = 0;
         for (int32_t i = 0; i < n; i++) {
-            if (tour->comp[i] >= 0) {
-                assert(tour->succ[i] >= 0);
+            if (solution->tour.comp[i] >= 0) {
+                assert(solution->tour.succ[i] >= 0);
                 ++num_visited;
             }
         }
         assert(num_visited >= 2);
     }
 #endif
+    return true;
 }
 
-static void twoopt_exchange(Solver *solver, const Instance *instance,
-                            Tour *tour, int32_t a, int32_t b) {
+static bool twoopt_refine(const Instance *instance,
+                          const CandidateLists *candidates,
+                          Solution *solution) {
     const int32_t n = instance->num_customers + 1;
-    assert(a >= 0 && a < n);
-    assert(b >= 0 && b < n);
-
-    int32_t succ_a = tour->succ[a];
-    int32_t succ_b = tour->succ[b];
 
-    assert(succ_a >= 0 && succ_a < n);
-    assert(succ_b >= 0 && succ_b < n);
-
-    // Reverse part of the tour
-    {
-        int32_t prev = succ_a;
-        int32_t current = tour->succ[succ_a];
-        assert(current >= 0 && current < n);
-
-        while (current != succ_b) {
-            int32_t next = tour->succ[current];
-            assert(next >= 0 && next < n);
-            tour->succ[current] = prev;
-            prev = current;
-            current = next;
-        }
+    // NOTE(dparo):
+    //      The array tour reverses the shorter side of each exchange in place,
+    //      instead of walking the successors. The tour arrays are handed
+    //      back to the solution once done.
+    ArrayTour at = array_tour_adopt(instance, &solution->tour);
+    if (!at.pred) {
+        return false;
     }
 
-    // Fix the edge crossing
-    tour->succ[a] = b;
-    tour->succ[succ_a] = succ_b;
-
-#ifndef NDEBUG
-    validate_tour(instance, tour, WARM_START_MIN_NUM_CUSTOMERS_SERVED);
-#endif
-}
-
-static void twoopt_refine(Solver *solver, const Instance *instance,
-                          Solution *solution) {
-    const int32_t n = instance->num_customers + 1;
-
     // NOTE(dparo):
     //      A two-opt exchange maintain feasibiliby of the original solution.
     //      After a two-opt exchange the same set of vertices are visited,
@@ -390,29 +426,30 @@ static void twoopt_refine(Solver *solver, const Instance *instance,
         // Scan for the best NodePair to perform the 2-opt exchange
         //
         for (int32_t a = 0; a < n; a++) {
-            for (int32_t b = 0; b < n; b++) {
+            // NOTE(dparo):
+            //     With the candidate lists, only the exchanges introducing
+            //     an edge `(a, b)` with `b` a candidate of `a` are evaluated
+            const int32_t *list =
+                candidates ? candidate_list(candidates, a) : NULL;
+            const int32_t num_b = candidates ? candidates->k : n;
+
+            for (int32_t t = 0; t < num_b; t++) {
+                int32_t b = list ? list[t] : t;
                 if (a == b) {
                     continue;
                 }
 
                 // Vertices a,b are valid 2opt exchange candidates only if they
                 // are visited in the tour
-                if (solution->tour.comp[a] < 0 || solution->tour.comp[b] < 0) {
+                if (!array_tour_contains(&at, a) ||
+                    !array_tour_contains(&at, b)) {
                     continue;
                 }
 
-                int32_t succ_a = solution->tour.succ[a];
-                int32_t succ_b = solution->tour.succ[b];
-
-                assert(succ_a >= 0 && succ_a < n);
-                assert(succ_b >= 0 && succ_b < n);
-                assert(succ_a != succ_b);
+                assert(array_tour_succ(&at, a) != array_tour_succ(&at, b));
 
                 // Compute delta_cost
-                double delta_cost = cptp_dist(instance, a, b) +
-                                    cptp_dist(instance, succ_a, succ_b) -
-                                    cptp_dist(instance, a, succ_a) -
-                                    cptp_dist(instance, b, succ_b);
+                double delta_cost = array_tour_2opt_delta(&at, a, b);
 
                 if (delta_cost < best_delta_cost) {
                     best_delta_cost = delta_cost;
@@ -427,11 +464,13 @@ static void twoopt_refine(Solver *solver, const Instance *instance,
             assert(best_b >= 0);
 
             // Perform the two-opt exchange and reverse part of the tour
-            twoopt_exchange(solver, instance, &solution->tour, best_a, best_b);
+            array_tour_2opt_move(&at, best_a, best_b);
             solution->primal_bound += best_delta_cost;
 #ifndef NDEBUG
-            validate_primal_solution(instance, solution,
-                              WARM_START_MIN_NUM_CUSTOMERS_SERVED);
+            validate_tour(instance, &at.tour,
+                          WARM_START_MIN_NUM_CUSTOMERS_SERVED);
+            assert(feq(tour_eval(instance, &at.tour), solution->primal_bound,
+                       1e-5));
 #endif
         } else {
             // NOTE(dparo): No more 2-opt exchanges are available
@@ -439,19 +478,25 @@ static void twoopt_refine(Solver *solver, const Instance *instance,
         }
     }
 
+    solution->tour = array_tour_release(&at);
+
 #ifndef NDEBUG
     validate_primal_solution(instance, solution, WARM_START_MIN_NUM_CUSTOMERS_SERVED);
 #endif
+    return true;
 }
 
 bool mip_ins_heur_warm_start(Solver *solver, const Instance *instance,
-                             bool heur_pricer_mode) {
+                             bool heur_pricer_mode,
+                             double *best_primal_bound) {
     bool result = true;
     const int32_t n = instance->num_customers + 1;
 
     double min_ub_found = INFINITY;
     Solution solution = solution_create(instance);
     InsHeurNodePair starting_pair;
+    const CandidateLists *candidates =
+        solver->data->candidates.lists ? &solver->data->candidates : NULL;
 
     //   ((Instance *)instance)->vehicle_cap += instance->vehicle_cap * 1.0;
 
@@ -461,7 +506,10 @@ bool mip_ins_heur_warm_start(Solver *solver, const Instance *instance,
             continue;
         }
         if (valid_starting_pair(instance, &starting_pair)) {
-            ins_heur(instance, &solution, starting_pair);
+            if (!ins_heur(instance, candidates, &solution, starting_pair)) {
+                result = false;
+                goto terminate;
+            }
             log_info("%s :: ins_heur -- found a solution of cost %f, demand %f",
                      __func__, solution.primal_bound,
                      tour_demand(instance, &solution.tour));
@@ -475,7 +523,10 @@ bool mip_ins_heur_warm_start(Solver *solver, const Instance *instance,
                 !is_valid_reduced_cost(solution.primal_bound)) {
                 // Try to improve the solution using 2opt
                 double prev_ub = solution.primal_bound;
-                twoopt_refine(solver, instance, &solution);
+                if (!twoopt_refine(instance, candidates, &solution)) {
+                    result = false;
+                    goto terminate;
+                }
                 log_trace("%s :: two opt refine -- Improved solution from %f "
                           "to %f (%f delta improvement)",
                           __func__, prev_ub, solution.primal_bound,
@@ -488,6 +539,10 @@ bool mip_ins_heur_warm_start(Solver *solver, const Instance *instance,
                 goto terminate;
             }
 
+            if (is_valid_reduced_cost(solution.primal_bound)) {
+                arrpush(solver->data->heur_columns, tour_copy(&solution.tour));
+            }
+
             // NOTE(dparo):
             //     Whenever we find a reduced cost tour and we are in pricer
             //     mode, there's no point in continuining feeding other warm
@@ -506,6 +561,7 @@ bool mip_ins_heur_warm_start(Solver *solver, const Instance *instance,
     }
 
 terminate:
+    *best_primal_bound = min_ub_found;
     solution_destroy(&solution);
     return result;
 }
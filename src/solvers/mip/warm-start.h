@@ -28,8 +28,11 @@ extern "C" {
 
 #include "mip.h"
 
+/// Feeds the warm start solutions to CPLEX. `best_primal_bound` receives the
+/// cost of the best one (INFINITY if none was found).
 bool mip_ins_heur_warm_start(Solver *solver, const Instance *instance,
-                             bool pricer_mode_enabled);
+                             bool pricer_mode_enabled,
+                             double *best_primal_bound);
 
 #if __cplusplus
 }
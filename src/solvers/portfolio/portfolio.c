@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "solvers.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core-utils.h"
+#include "misc.h"
+
+#include <log.h>
+
+enum {
+    // How often the race checks for the cancellation of the whole solve
+    PORTFOLIO_POLL_USECS = 50 * 1000,
+};
+
+typedef struct PortfolioMember {
+    /// Points into `SolverData::spec`
+    const char *name;
+    SolverParams params;
+    /// Backs the `NUM_THREADS` param injected into `params`, if any
+    char num_threads[16];
+    SolverTypedParams tparams;
+    Solver solver;
+    Solution solution;
+    SolveStatus status;
+
+    struct SolverData *portfolio;
+    const Instance *instance;
+    int64_t begin_time;
+    pthread_t thread;
+    bool running;
+} PortfolioMember;
+
+struct SolverData {
+    /// Copy of the `SOLVERS` param, tokenized in place
+    char *spec;
+    bool heur_pricer_mode;
+    /// <stb_ds.h> array
+    PortfolioMember *members;
+
+    /// Shared by all the members: requested once the race is decided
+    CancellationToken members_cancel;
+
+    /// Protects everything below
+    pthread_mutex_t mutex;
+    pthread_cond_t member_done;
+    int32_t num_done;
+    /// Best tour reported by any of the members while solving
+    Tour incumbent;
+    double incumbent_cost;
+
+    /// Listener of the portfolio itself, relayed the tours of the members
+    void (*on_incumbent)(void *user_data, const Instance *instance,
+                         Tour *tour, double cost);
+    void *on_incumbent_user_data;
+};
+
+static bool is_valid_status(SolveStatus status) {
+    return status != SOLVE_STATUS_NULL && !BOOL(status & SOLVE_STATUS_ERR);
+}
+
+static void copy_tour(Tour *dest, const Tour *src) {
+    assert(dest->num_customers == src->num_customers);
+    const int32_t n = src->num_customers + 1;
+    memcpy(dest->succ, src->succ, n * sizeof(*dest->succ));
+    memcpy(dest->comp, src->comp, n * sizeof(*dest->comp));
+    dest->num_comps = src->num_comps;
+}
+
+/// Parses `spec` (see `PORTFOLIO_SOLVER_DESCRIPTOR`) into the members
+static bool parse_members(struct SolverData *data, const char *spec) {
+    data->spec = strdup(spec);
+    if (!data->spec) {
+        return false;
+    }
+
+    char *members_save = NULL;
+    for (char *member = strtok_r(data->spec, ",", &members_save); member;
+         member = strtok_r(NULL, ",", &members_save)) {
+        char *params_save = NULL;
+        PortfolioMember m = {0};
+        m.name = strtok_r(member, ":", &params_save);
+
+        for (char *def = strtok_r(NULL, ":", &params_save); def;
+             def = strtok_r(NULL, ":", &params_save)) {
+            char *equal = strchr(def, '=');
+            if (!equal || m.params.num_params >= MAX_NUM_SOLVER_PARAMS) {
+                log_fatal("%s :: Invalid param `%s` of solver `%s`", __func__,
+                          def, m.name);
+                return false;
+            }
+            *equal = 0;
+            m.params.params[m.params.num_params].name = def;
+            m.params.params[m.params.num_params].value = equal + 1;
+            m.params.num_params++;
+        }
+
+        if (!m.name || 0 == strcmp(m.name, PORTFOLIO_SOLVER_DESCRIPTOR.name)) {
+            log_fatal("%s :: Invalid portfolio member `%s`", __func__,
+                      m.name ? m.name : "");
+            return false;
+        }
+        arrpush(data->members, m);
+    }
+
+    return arrlen(data->members) > 0;
+}
+
+/// The members race concurrently: split the cores among the members left
+/// free to pick their `NUM_THREADS`, instead of each one grabbing them all
+static void split_num_threads(struct SolverData *data) {
+    const int32_t num_members = (int32_t)arrlen(data->members);
+    const int32_t share = MAX(1, os_get_num_cpus() / num_members);
+
+    for (int32_t i = 0; i < num_members; i++) {
+        PortfolioMember *m = &data->members[i];
+        solver_params_default_num_threads(&m->params, m->name, share,
+                                          m->num_threads,
+                                          sizeof(m->num_threads));
+    }
+}
+
+/// Keeps track of the best tour of the race, relaying it to the listener of
+/// the portfolio
+static void on_member_incumbent(void *user_data, const Instance *instance,
+                                Tour *tour, double cost) {
+    struct SolverData *data = user_data;
+    if (data->on_incumbent) {
+        data->on_incumbent(data->on_incumbent_user_data, instance, tour, cost);
+    }
+
+    // NOTE(dparo):
+    //     The incumbent is published to all the members through
+    //     `shared_incumbent_cost`, bounding their search. In heuristic pricer
+    //     mode the first column stops the race.
+    pthread_mutex_lock(&data->mutex);
+    if (cost < data->incumbent_cost && tour->num_comps == 1) {
+        copy_tour(&data->incumbent, tour);
+        data->incumbent_cost = cost;
+        if (data->heur_pricer_mode && is_valid_reduced_cost(cost)) {
+            cancellation_token_request(&data->members_cancel);
+        }
+    }
+    pthread_mutex_unlock(&data->mutex);
+}
+
+/// The cost of the best tour of the race, shared among the members
+static double shared_incumbent_cost(void *user_data) {
+    struct SolverData *data = user_data;
+    pthread_mutex_lock(&data->mutex);
+    double cost = data->incumbent_cost;
+    pthread_mutex_unlock(&data->mutex);
+    return cost;
+}
+
+static void *run_member(void *arg) {
+    PortfolioMember *m = arg;
+    struct SolverData *data = m->portfolio;
+
+    SolveStatus status = m->solver.solve(&m->solver, m->instance,
+                                         &m->solution, m->begin_time);
+
+    pthread_mutex_lock(&data->mutex);
+    m->status = status;
+    data->num_done++;
+
+    bool found_column =
+        BOOL(status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL) &&
+        is_valid_reduced_cost(m->solution.primal_bound);
+    if (is_valid_status(status) &&
+        (BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM) ||
+         (data->heur_pricer_mode && found_column))) {
+        log_info("%s :: `%s` decided the race (status %x)", __func__, m->name,
+                 status);
+        cancellation_token_request(&data->members_cancel);
+    }
+
+    pthread_cond_signal(&data->member_done);
+    pthread_mutex_unlock(&data->mutex);
+    return NULL;
+}
+
+/// Waits for all the running members, relaying the cancellation of the
+/// whole solve
+static void wait_members(Solver *self) {
+    struct SolverData *data = self->data;
+    int32_t num_running = 0;
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        num_running += data->members[i].running ? 1 : 0;
+    }
+
+    pthread_mutex_lock(&data->mutex);
+    while (data->num_done < num_running) {
+        if (cancellation_requested(self->cancel)) {
+            cancellation_token_request(&data->members_cancel);
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += PORTFOLIO_POLL_USECS * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&data->member_done, &data->mutex, &deadline);
+    }
+    pthread_mutex_unlock(&data->mutex);
+
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        if (data->members[i].running) {
+            pthread_join(data->members[i].thread, NULL);
+            data->members[i].running = false;
+        }
+    }
+}
+
+/// Combines the results of the members: the solution of a member which
+/// closed the problem wins, otherwise the best tour and the best dual bound
+/// among all of them are reported
+static SolveStatus combine_results(Solver *self, const Instance *instance,
+                                   Solution *solution) {
+    struct SolverData *data = self->data;
+    SolveStatus status = SOLVE_STATUS_NULL;
+    PortfolioMember *best_primal = NULL;
+    double dual_bound = -INFINITY;
+    bool any_valid = false;
+    bool any_error = false;
+
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        PortfolioMember *m = &data->members[i];
+        if (!is_valid_status(m->status)) {
+            any_error |= BOOL(m->status & SOLVE_STATUS_ERR);
+            continue;
+        }
+
+        any_valid = true;
+        if (BOOL(m->status & SOLVE_STATUS_CLOSED_PROBLEM)) {
+            solution->primal_bound = m->solution.primal_bound;
+            solution->dual_bound = m->solution.dual_bound;
+            copy_tour(&solution->tour, &m->solution.tour);
+            status = m->status;
+            best_primal = NULL;
+            dual_bound = INFINITY;
+
+            // NOTE(dparo):
+            //     A member pruning its search against the shared incumbent
+            //     may close the problem without a tour of its own: the
+            //     incumbent is then the optimal tour
+            if (!BOOL(m->status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL) &&
+                data->incumbent_cost < INFINITY) {
+                solution->primal_bound = tour_eval(instance, &data->incumbent);
+                solution->dual_bound =
+                    MIN(solution->dual_bound, solution->primal_bound);
+                copy_tour(&solution->tour, &data->incumbent);
+                status |= SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL;
+            }
+            break;
+        }
+
+        status |= m->status & SOLVE_STATUS_ABORTION_RES_EXHAUSTED;
+        dual_bound = MAX(dual_bound, m->solution.dual_bound);
+        if (BOOL(m->status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL) &&
+            (!best_primal ||
+             m->solution.primal_bound < best_primal->solution.primal_bound)) {
+            best_primal = m;
+        }
+    }
+
+    if (!any_valid) {
+        return any_error ? SOLVE_STATUS_ERR : SOLVE_STATUS_NULL;
+    }
+    if (!BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM) &&
+        cancellation_requested(self->cancel)) {
+        status |= SOLVE_STATUS_ABORTION_SIGTERM;
+    }
+
+    if (!BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM)) {
+        solution->dual_bound = dual_bound;
+        if (best_primal) {
+            solution->primal_bound = best_primal->solution.primal_bound;
+            copy_tour(&solution->tour, &best_primal->solution.tour);
+            status |= SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL;
+        }
+
+        // NOTE(dparo):
+        //     A member stopped early may have found a better tour than the
+        //     one it reported
+        if (data->incumbent_cost < INFINITY &&
+            (!best_primal || data->incumbent_cost < solution->primal_bound)) {
+            solution->primal_bound = tour_eval(instance, &data->incumbent);
+            copy_tour(&solution->tour, &data->incumbent);
+            status |= SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL;
+        }
+    }
+
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        const ColumnPool *pool = &data->members[i].solution.columns;
+        for (int32_t k = 0; k < pool->num_columns; k++) {
+            solution_add_column_with_cost(solution, &pool->tours[k],
+                                          pool->reduced_costs[k]);
+        }
+    }
+    if (data->incumbent_cost < INFINITY) {
+        solution_add_column(solution, instance, &data->incumbent);
+    }
+
+    return status;
+}
+
+static SolveStatus solve(Solver *self, const Instance *instance,
+                         Solution *solution, int64_t begin_time) {
+    struct SolverData *data = self->data;
+
+    data->members_cancel.requested = 0;
+    data->num_done = 0;
+    data->incumbent_cost = INFINITY;
+    tour_clear(&data->incumbent);
+    data->on_incumbent = self->on_incumbent;
+    data->on_incumbent_user_data = self->on_incumbent_user_data;
+
+    bool started = true;
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        PortfolioMember *m = &data->members[i];
+        solution_clear(&m->solution);
+        if (m->solution.columns.capacity != solution->columns.capacity) {
+            solution_reserve_columns(&m->solution,
+                                     solution->columns.capacity);
+        }
+
+        m->status = SOLVE_STATUS_NULL;
+        m->instance = instance;
+        m->begin_time = begin_time;
+        m->solver.cancel = &data->members_cancel;
+        m->solver.on_incumbent = on_member_incumbent;
+        m->solver.on_incumbent_user_data = data;
+        m->solver.shared_incumbent_cost = shared_incumbent_cost;
+        m->solver.shared_incumbent_user_data = data;
+
+        if (0 != pthread_create(&m->thread, NULL, run_member, m)) {
+            log_fatal("%s :: Failed to start solver `%s`", __func__, m->name);
+            cancellation_token_request(&data->members_cancel);
+            started = false;
+            break;
+        }
+        m->running = true;
+    }
+
+    wait_members(self);
+
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        data->members[i].solver.cancel = NULL;
+    }
+
+    if (!started) {
+        return SOLVE_STATUS_ERR;
+    }
+    return combine_results(self, instance, solution);
+}
+
+static bool update_profits(Solver *self, const Instance *instance) {
+    struct SolverData *data = self->data;
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        Solver *solver = &data->members[i].solver;
+        if (!solver->update_profits ||
+            !solver->update_profits(solver, instance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void destroy(Solver *self) {
+    struct SolverData *data = self->data;
+    if (data) {
+        for (int64_t i = 0; i < arrlen(data->members); i++) {
+            PortfolioMember *m = &data->members[i];
+            if (m->solver.destroy) {
+                m->solver.destroy(&m->solver);
+            }
+            solver_typed_params_destroy(&m->tparams);
+            solution_destroy(&m->solution);
+        }
+        arrfree(data->members);
+        tour_destroy(&data->incumbent);
+        pthread_cond_destroy(&data->member_done);
+        pthread_mutex_destroy(&data->mutex);
+        free(data->spec);
+        free(data);
+    }
+    memset(self, 0, sizeof(*self));
+}
+
+Solver portfolio_solver_create(const Instance *instance,
+                               SolverTypedParams *tparams, double timelimit,
+                               int32_t randomseed) {
+    Solver solver = {0};
+    solver.rng = rng_create((uint64_t)randomseed);
+    solver.solve = solve;
+    solver.update_profits = update_profits;
+    solver.destroy = destroy;
+
+    struct SolverData *data = calloc(1, sizeof(*data));
+    if (!data) {
+        goto fail;
+    }
+    solver.data = data;
+    pthread_mutex_init(&data->mutex, NULL);
+    pthread_cond_init(&data->member_done, NULL);
+    data->heur_pricer_mode =
+        solver_params_get_bool(tparams, "HEUR_PRICER_MODE");
+    data->incumbent = tour_create(instance);
+    data->incumbent_cost = INFINITY;
+
+    if (!solver_params_contains(tparams, "SOLVERS")) {
+        log_fatal("%s :: The `SOLVERS` param is required", __func__);
+        goto fail;
+    }
+    if (!parse_members(data, solver_params_get_str(tparams, "SOLVERS"))) {
+        log_fatal("%s :: Invalid `SOLVERS` param", __func__);
+        goto fail;
+    }
+    split_num_threads(data);
+
+    for (int64_t i = 0; i < arrlen(data->members); i++) {
+        PortfolioMember *m = &data->members[i];
+        m->portfolio = data;
+        m->solution = solution_create(instance);
+        // NOTE(dparo): Different seeds make identical members diverge
+        m->solver = cptp_solver_create(m->name, instance, &m->params,
+                                       &m->tparams, timelimit,
+                                       randomseed + (int32_t)i);
+        if (!m->solver.solve) {
+            goto fail;
+        }
+        log_info("%s :: Portfolio member %d: `%s`", __func__, (int32_t)i,
+                 m->name);
+    }
+
+    return solver;
+
+fail:
+    log_fatal("%s :: Failed to create the portfolio", __func__);
+    destroy(&solver);
+    return solver;
+}
@@ -22,24 +22,149 @@
 
 #include "solvers.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "core-utils.h"
+
+#include <log.h>
+
+enum {
+    // How often a waiting stub checks for its cancellation
+    STUB_POLL_USECS = 1000,
+};
+
+struct SolverData {
+    int32_t route_len;
+    double dual_bound;
+    bool close_problem;
+    bool wait_for_cancel;
+    bool shared_incumbent;
+    double timelimit;
+};
+
+/// Visits the first `route_len` customers fitting in the vehicle, by
+/// increasing index. Returns the number of visited customers.
+static int32_t build_route(const Instance *instance, int32_t route_len,
+                           Tour *tour) {
+    const int32_t n = instance->num_customers + 1;
+    double demand = 0.0;
+    int32_t prev = 0;
+    int32_t num_visited = 0;
+
+    tour_clear(tour);
+    for (int32_t i = 1; i < n && num_visited < route_len; i++) {
+        if (demand + instance->demands[i] > instance->vehicle_cap) {
+            continue;
+        }
+        demand += instance->demands[i];
+        tour->comp[i] = 0;
+        tour->succ[prev] = i;
+        prev = i;
+        ++num_visited;
+    }
+
+    if (num_visited > 0) {
+        tour->comp[0] = 0;
+        tour->succ[prev] = 0;
+        tour->num_comps = 1;
+    }
+    return num_visited;
+}
+
+/// Waits for a tour shared by the solves racing alongside, returning its
+/// cost, or +INFINITY if none was shared before the cancellation or the time
+/// limit
+static double await_shared_incumbent(Solver *self, int64_t begin_time) {
+    double cost = INFINITY;
+    if (!self->shared_incumbent_cost) {
+        return cost;
+    }
+
+    while (!cancellation_requested(self->cancel) &&
+           os_get_elapsed_secs(begin_time) < self->data->timelimit) {
+        cost = self->shared_incumbent_cost(self->shared_incumbent_user_data);
+        if (cost < INFINITY) {
+            break;
+        }
+        os_sleep(STUB_POLL_USECS);
+    }
+    return cost;
+}
+
 static SolveStatus solve(Solver *self, const Instance *instance,
                          Solution *solution, int64_t begin_time) {
-    UNUSED_PARAM(self);
-    UNUSED_PARAM(instance);
-    UNUSED_PARAM(solution);
-    UNUSED_PARAM(begin_time);
-    return SOLVE_STATUS_NULL;
+    struct SolverData *data = self->data;
+    SolveStatus status = SOLVE_STATUS_NULL;
+    solution->dual_bound = data->dual_bound;
+
+    const double cutoff = data->shared_incumbent
+                              ? await_shared_incumbent(self, begin_time)
+                              : INFINITY;
+
+    bool has_route =
+        data->route_len > 0 &&
+        build_route(instance, data->route_len, &solution->tour) > 0;
+    if (has_route && tour_eval(instance, &solution->tour) >= cutoff) {
+        // The route cannot improve on the shared incumbent
+        tour_clear(&solution->tour);
+        has_route = false;
+    }
+
+    if (has_route) {
+        solution->primal_bound = tour_eval(instance, &solution->tour);
+        status = SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL;
+        if (data->close_problem) {
+            solution->dual_bound = solution->primal_bound;
+            status |= SOLVE_STATUS_CLOSED_PROBLEM;
+        }
+
+        if (self->on_incumbent) {
+            self->on_incumbent(self->on_incumbent_user_data, instance,
+                               &solution->tour, solution->primal_bound);
+        }
+    }
+
+    if (data->wait_for_cancel) {
+        while (!cancellation_requested(self->cancel)) {
+            if (os_get_elapsed_secs(begin_time) >= data->timelimit) {
+                status |= SOLVE_STATUS_ABORTION_RES_EXHAUSTED;
+                break;
+            }
+            os_sleep(STUB_POLL_USECS);
+        }
+    }
+
+    return status;
 }
 
-static void destroy(ATTRIB_MAYBE_UNUSED Solver *self) {}
+static void destroy(Solver *self) {
+    free(self->data);
+    memset(self, 0, sizeof(*self));
+}
 
 Solver stub_solver_create(const Instance *instance, SolverTypedParams *tparams,
                           double timelimit, int32_t randomseed) {
     UNUSED_PARAM(instance);
-    UNUSED_PARAM(tparams);
-    UNUSED_PARAM(timelimit);
-    UNUSED_PARAM(randomseed);
     Solver solver = {0};
+    solver.data = calloc(1, sizeof(*solver.data));
+    if (!solver.data) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        return solver;
+    }
+    solver.data->route_len = solver_params_get_int32(tparams, "ROUTE_LEN");
+    solver.data->dual_bound =
+        solver_params_contains(tparams, "DUAL_BOUND")
+            ? solver_params_get_double(tparams, "DUAL_BOUND")
+            : -INFINITY;
+    solver.data->close_problem =
+        solver_params_get_bool(tparams, "CLOSE_PROBLEM");
+    solver.data->wait_for_cancel =
+        solver_params_get_bool(tparams, "WAIT_FOR_CANCEL");
+    solver.data->shared_incumbent =
+        solver_params_get_bool(tparams, "SHARED_INCUMBENT");
+    solver.data->timelimit = timelimit;
+    solver.rng = rng_create((uint64_t)randomseed);
     solver.solve = solve;
     solver.destroy = destroy;
     return solver;
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "spatial-index.h"
+
+#define SPATIAL_INDEX_LEAF_SIZE (8)
+
+typedef struct {
+    Vec2d p;
+    int32_t idx;
+} IndexedPoint;
+
+static inline double axis_coord(const Vec2d *p, int32_t axis) {
+    return axis == 0 ? p->x : p->y;
+}
+
+static inline bool point_less(const IndexedPoint *a, const IndexedPoint *b,
+                              int32_t axis) {
+    double ca = axis_coord(&a->p, axis);
+    double cb = axis_coord(&b->p, axis);
+    return ca < cb || (ca == cb && a->idx < b->idx);
+}
+
+static inline void swap_points(IndexedPoint *a, IndexedPoint *b) {
+    IndexedPoint tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/// Places in `pts[nth]` the element that would be there if `pts[lo, hi)`
+/// was sorted along `axis`, with all the smaller ones before it.
+static void select_nth(IndexedPoint *pts, int32_t lo, int32_t hi, int32_t nth,
+                       int32_t axis) {
+    hi = hi - 1;
+    while (lo < hi) {
+        IndexedPoint pivot = pts[lo + (hi - lo) / 2];
+        int32_t i = lo;
+        int32_t j = hi;
+        while (i <= j) {
+            while (point_less(&pts[i], &pivot, axis)) {
+                ++i;
+            }
+            while (point_less(&pivot, &pts[j], axis)) {
+                --j;
+            }
+            if (i <= j) {
+                swap_points(&pts[i], &pts[j]);
+                ++i;
+                --j;
+            }
+        }
+
+        if (nth <= j) {
+            hi = j;
+        } else if (nth >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+}
+
+static void build_rec(IndexedPoint *pts, uint8_t *split_axis, int32_t lo,
+                      int32_t hi) {
+    if (hi - lo <= SPATIAL_INDEX_LEAF_SIZE) {
+        return;
+    }
+
+    Vec2d bmin = pts[lo].p;
+    Vec2d bmax = pts[lo].p;
+    for (int32_t t = lo + 1; t < hi; t++) {
+        bmin.x = MIN(bmin.x, pts[t].p.x);
+        bmin.y = MIN(bmin.y, pts[t].p.y);
+        bmax.x = MAX(bmax.x, pts[t].p.x);
+        bmax.y = MAX(bmax.y, pts[t].p.y);
+    }
+
+    // Split along the axis with the largest extent
+    int32_t axis = (bmax.x - bmin.x) >= (bmax.y - bmin.y) ? 0 : 1;
+    int32_t mid = lo + (hi - lo) / 2;
+    select_nth(pts, lo, hi, mid, axis);
+    split_axis[mid] = (uint8_t)axis;
+
+    build_rec(pts, split_axis, lo, mid);
+    build_rec(pts, split_axis, mid + 1, hi);
+}
+
+SpatialIndex spatial_index_create(const Vec2d *points, int32_t num_points) {
+    SpatialIndex index = {0};
+    IndexedPoint *pts = malloc(MAX(1, num_points) * sizeof(*pts));
+
+    index.num_points = num_points;
+    index.points = malloc(MAX(1, num_points) * sizeof(*index.points));
+    index.perm = malloc(MAX(1, num_points) * sizeof(*index.perm));
+    index.split_axis = calloc(MAX(1, num_points), sizeof(*index.split_axis));
+
+    if (!pts || !index.points || !index.perm || !index.split_axis) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        free(pts);
+        spatial_index_destroy(&index);
+        return index;
+    }
+
+    for (int32_t i = 0; i < num_points; i++) {
+        pts[i] = (IndexedPoint){points[i], i};
+    }
+
+    build_rec(pts, index.split_axis, 0, num_points);
+
+    for (int32_t t = 0; t < num_points; t++) {
+        index.points[t] = pts[t].p;
+        index.perm[t] = pts[t].idx;
+    }
+
+    free(pts);
+    return index;
+}
+
+void spatial_index_destroy(SpatialIndex *index) {
+    free(index->points);
+    free(index->perm);
+    free(index->split_axis);
+    memset(index, 0, sizeof(*index));
+}
+
+typedef struct {
+    const SpatialIndex *index;
+    Vec2d query;
+    int32_t k;
+    int32_t exclude;
+    int32_t len;
+    int32_t *indices;
+    double *sq_dists;
+} KnnCtx;
+
+static inline double sq_dist(Vec2d const *a, Vec2d const *b) {
+    double dx = b->x - a->x;
+    double dy = b->y - a->y;
+    return dx * dx + dy * dy;
+}
+
+static inline bool knn_less(double da, int32_t a, double db, int32_t b) {
+    return da < db || (da == db && a < b);
+}
+
+static inline void knn_consider(KnnCtx *ctx, int32_t t) {
+    const int32_t idx = ctx->index->perm[t];
+    if (idx == ctx->exclude) {
+        return;
+    }
+
+    const double d = sq_dist(&ctx->query, &ctx->index->points[t]);
+    const int32_t k = ctx->k;
+    if (ctx->len == k &&
+        !knn_less(d, idx, ctx->sq_dists[k - 1], ctx->indices[k - 1])) {
+        return;
+    }
+
+    int32_t pos = ctx->len < k ? ctx->len++ : k - 1;
+    while (pos > 0 && knn_less(d, idx, ctx->sq_dists[pos - 1],
+                               ctx->indices[pos - 1])) {
+        ctx->sq_dists[pos] = ctx->sq_dists[pos - 1];
+        ctx->indices[pos] = ctx->indices[pos - 1];
+        --pos;
+    }
+    ctx->sq_dists[pos] = d;
+    ctx->indices[pos] = idx;
+}
+
+static void knn_rec(KnnCtx *ctx, int32_t lo, int32_t hi) {
+    if (hi - lo <= SPATIAL_INDEX_LEAF_SIZE) {
+        for (int32_t t = lo; t < hi; t++) {
+            knn_consider(ctx, t);
+        }
+        return;
+    }
+
+    const int32_t mid = lo + (hi - lo) / 2;
+    const int32_t axis = ctx->index->split_axis[mid];
+    knn_consider(ctx, mid);
+
+    const double diff = axis_coord(&ctx->query, axis) -
+                        axis_coord(&ctx->index->points[mid], axis);
+
+    // Descend first in the half containing the query point. The other half
+    // is visited only if it may contain a point closer than the k-th one
+    if (diff < 0.0) {
+        knn_rec(ctx, lo, mid);
+        if (ctx->len < ctx->k || diff * diff <= ctx->sq_dists[ctx->len - 1]) {
+            knn_rec(ctx, mid + 1, hi);
+        }
+    } else {
+        knn_rec(ctx, mid + 1, hi);
+        if (ctx->len < ctx->k || diff * diff <= ctx->sq_dists[ctx->len - 1]) {
+            knn_rec(ctx, lo, mid);
+        }
+    }
+}
+
+int32_t spatial_index_knn(const SpatialIndex *index, Vec2d query, int32_t k,
+                          int32_t exclude, int32_t *out_indices,
+                          double *out_dists) {
+    if (k <= 0 || index->num_points <= 0) {
+        return 0;
+    }
+
+    KnnCtx ctx = {0};
+    ctx.index = index;
+    ctx.query = query;
+    ctx.k = k;
+    ctx.exclude = exclude;
+    ctx.indices = out_indices;
+    ctx.sq_dists = malloc(k * sizeof(*ctx.sq_dists));
+    if (!ctx.sq_dists) {
+        log_fatal("%s :: Failed memory allocation", __func__);
+        return -1;
+    }
+
+    knn_rec(&ctx, 0, index->num_points);
+
+    if (out_dists) {
+        for (int32_t t = 0; t < ctx.len; t++) {
+            out_dists[t] = sqrt(ctx.sq_dists[t]);
+        }
+    }
+
+    free(ctx.sq_dists);
+    return ctx.len;
+}
+
+static int32_t radius_rec(const SpatialIndex *index, Vec2d const *query,
+                          double radius, int32_t lo, int32_t hi,
+                          int32_t *out, int32_t len) {
+    if (hi - lo <= SPATIAL_INDEX_LEAF_SIZE) {
+        for (int32_t t = lo; t < hi; t++) {
+            if (vec2d_dist(query, &index->points[t]) <= radius) {
+                out[len++] = index->perm[t];
+            }
+        }
+        return len;
+    }
+
+    const int32_t mid = lo + (hi - lo) / 2;
+    const int32_t axis = index->split_axis[mid];
+    const double diff =
+        axis_coord(query, axis) - axis_coord(&index->points[mid], axis);
+
+    if (vec2d_dist(query, &index->points[mid]) <= radius) {
+        out[len++] = index->perm[mid];
+    }
+    if (diff <= radius) {
+        len = radius_rec(index, query, radius, lo, mid, out, len);
+    }
+    if (-diff <= radius) {
+        len = radius_rec(index, query, radius, mid + 1, hi, out, len);
+    }
+    return len;
+}
+
+int32_t spatial_index_radius(const SpatialIndex *index, Vec2d query,
+                             double radius, int32_t *out_indices) {
+    return radius_rec(index, &query, radius, 0, index->num_points,
+                      out_indices, 0);
+}
+
+static inline bool in_rect(Vec2d const *p, Vec2d const *lo, Vec2d const *hi) {
+    return p->x >= lo->x && p->x <= hi->x && p->y >= lo->y && p->y <= hi->y;
+}
+
+static int32_t rect_rec(const SpatialIndex *index, Vec2d const *rlo,
+                        Vec2d const *rhi, int32_t lo, int32_t hi, int32_t *out,
+                        int32_t len) {
+    if (hi - lo <= SPATIAL_INDEX_LEAF_SIZE) {
+        for (int32_t t = lo; t < hi; t++) {
+            if (in_rect(&index->points[t], rlo, rhi)) {
+                out[len++] = index->perm[t];
+            }
+        }
+        return len;
+    }
+
+    const int32_t mid = lo + (hi - lo) / 2;
+    const int32_t axis = index->split_axis[mid];
+    const double split = axis_coord(&index->points[mid], axis);
+
+    if (in_rect(&index->points[mid], rlo, rhi)) {
+        out[len++] = index->perm[mid];
+    }
+    if (axis_coord(rlo, axis) <= split) {
+        len = rect_rec(index, rlo, rhi, lo, mid, out, len);
+    }
+    if (axis_coord(rhi, axis) >= split) {
+        len = rect_rec(index, rlo, rhi, mid + 1, hi, out, len);
+    }
+    return len;
+}
+
+int32_t spatial_index_rect(const SpatialIndex *index, Vec2d lo, Vec2d hi,
+                           int32_t *out_indices) {
+    return rect_rec(index, &lo, &hi, 0, index->num_points, out_indices, 0);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+/// Static 2D k-d tree built over a set of points (eg `Instance.positions`).
+/// The tree is implicit: the points are reordered such that each subrange
+/// `[lo, hi)` is split at its median `mid = lo + (hi - lo) / 2` along the
+/// axis `split_axis[mid]`. Small subranges are scanned linearly.
+///
+/// Every query reports the indices of the points in the original array.
+typedef struct SpatialIndex {
+    int32_t num_points;
+    /// Points stored in tree order
+    Vec2d *points;
+    /// Maps the tree order to the index of the point in the original array
+    int32_t *perm;
+    /// 0 for the x axis, 1 for the y axis
+    uint8_t *split_axis;
+} SpatialIndex;
+
+/// Returns a zeroed struct on failure.
+SpatialIndex spatial_index_create(const Vec2d *points, int32_t num_points);
+void spatial_index_destroy(SpatialIndex *index);
+
+/// Finds the (at most) `k` points nearest to `query`, sorted by increasing
+/// distance (ties are broken by the smaller index). The point with index
+/// `exclude` is never reported: pass -1 to consider all of them.
+/// `out_dists` can be NULL. Distances are computed as in `vec2d_dist`.
+/// Returns the number of points written in `out_indices`, or -1 on
+/// allocation failure.
+int32_t spatial_index_knn(const SpatialIndex *index, Vec2d query, int32_t k,
+                          int32_t exclude, int32_t *out_indices,
+                          double *out_dists);
+
+/// Reports all the points with `vec2d_dist(query, p) <= radius`, in no
+/// particular order. `out_indices` must have room for `num_points` entries.
+/// Returns the number of points reported.
+int32_t spatial_index_radius(const SpatialIndex *index, Vec2d query,
+                             double radius, int32_t *out_indices);
+
+/// Reports all the points inside the closed rectangle `[lo, hi]`, in no
+/// particular order. `out_indices` must have room for `num_points` entries.
+/// Returns the number of points reported.
+int32_t spatial_index_rect(const SpatialIndex *index, Vec2d lo, Vec2d hi,
+                           int32_t *out_indices);
+
+#if __cplusplus
+}
+#endif
@@ -38,7 +38,8 @@ typedef struct {
 } AppCtx;
 
 Instance process_instance(const Instance *instance, const AppCtx *ctx) {
-    Instance result = instance_copy(instance, true, true);
+    // Only the scalar fields change: share the geometry and edge weights
+    Instance result = instance_view(instance);
 
     if (ctx->cap_scale_factor != 1.0) {
         result.vehicle_cap = result.vehicle_cap * ctx->cap_scale_factor;
@@ -60,8 +60,19 @@ Hash hash_instance(const Instance *instance) {
     }
 
     if (instance->edge_weight) {
-        SHA256_UPDATE_WITH_ARRAY(&shactx, instance->edge_weight,
-                                 hm_nentries(n));
+        // NOTE(dparo):
+        //     Hash the edge weights as doubles regardless of the storage
+        //     they are kept in, such that the hash only depends on the
+        //     problem being represented.
+        double chunk[256];
+        const int64_t len = hm_nentries(n);
+        for (int64_t base = 0; base < len; base += ARRAY_LEN_i32(chunk)) {
+            int64_t chunk_len = MIN(len - base, ARRAY_LEN_i32(chunk));
+            for (int64_t k = 0; k < chunk_len; k++) {
+                chunk[k] = cptp_edge_weight(instance, base + k);
+            }
+            SHA256_UPDATE_WITH_ARRAY(&shactx, chunk, chunk_len);
+        }
     }
 
     Hash result = {0};
@@ -373,12 +373,12 @@ void handle_vrp_instance(AppCtx *ctx, PerfProfInput *input) {
     }
 }
 
-static bool is_filtered_instance(Filter *f, const Instance *instance) {
-    if (instance->num_customers < f->ncustomers.a ||
-        instance->num_customers > f->ncustomers.b) {
+static bool is_filtered_instance(Filter *f, const InstanceHeader *header) {
+    if (header->num_customers < f->ncustomers.a ||
+        header->num_customers > f->ncustomers.b) {
         return true;
-    } else if (instance->num_vehicles < f->nvehicles.a ||
-               instance->num_vehicles > f->nvehicles.b) {
+    } else if (header->num_vehicles < f->nvehicles.a ||
+               header->num_vehicles > f->nvehicles.b) {
         return true;
     }
     return false;
@@ -394,47 +394,56 @@ int file_walk_cb(const char *fpath, const struct stat *sb, int typeflag,
     if (typeflag == FTW_F || typeflag == FTW_SL) {
         // Is a regular file
         const char *ext = os_get_fext(fpath);
-        if (ext && (0 == strcmp(ext, "vrp"))) {
+        if (ext &&
+            (0 == strcmp(ext, "vrp") || 0 == strcmp(ext, CPTP_BINARY_FEXT))) {
             // printf("Found file: %s\n", fpath);
 
-            Instance instance = parse(fpath);
-            if (is_valid_instance(&instance)) {
-                Filter *filter = &ctx->current_batch->filter;
-                if (!is_filtered_instance(filter, &instance)) {
+            // NOTE(dparo):
+            //     Only the header is needed to filter the instances: the
+            //     full parse (and hash) is paid for the selected ones only.
+            InstanceHeader header = {0};
+            if (!parse_header(fpath, &header)) {
+                log_fatal("%s: Failed to parse input file\n", fpath);
+                exit(EXIT_FAILURE);
+            }
+
+            Filter *filter = &ctx->current_batch->filter;
+            if (!is_filtered_instance(filter, &header)) {
+                Instance instance = parse(fpath);
+                if (!is_valid_instance(&instance)) {
+                    log_fatal("%s: Failed to parse input file\n", fpath);
+                    exit(EXIT_FAILURE);
+                }
 
-                    PerfProfInput input = {0};
-                    strncpy_safe(input.filepath, fpath,
-                                 ARRAY_LEN(input.filepath));
+                PerfProfInput input = {0};
+                strncpy_safe(input.filepath, fpath, ARRAY_LEN(input.filepath));
 
-                    strncpy_safe(input.instance_name, instance.name,
-                                 ARRAY_LEN(input.instance_name));
+                strncpy_safe(input.instance_name, instance.name,
+                             ARRAY_LEN(input.instance_name));
 
-                    input.uid.hash = hash_instance(&instance);
+                input.uid.hash = hash_instance(&instance);
+                instance_destroy(&instance);
 
-                    printf("--- instance_hash :: computed_hash = %s\n",
-                           input.uid.hash.cstr);
+                printf("--- instance_hash :: computed_hash = %s\n",
+                       input.uid.hash.cstr);
 
-                    const uint8_t num_seeds = (uint8_t)(MIN(
-                        UINT8_MAX, MIN(ctx->current_batch->nseeds,
-                                       ARRAY_LEN_i32(RANDOM_SEEDS))));
+                const uint8_t num_seeds = (uint8_t)(MIN(
+                    UINT8_MAX, MIN(ctx->current_batch->nseeds,
+                                   ARRAY_LEN_i32(RANDOM_SEEDS))));
 
-                    for (uint8_t seedidx = 0;
-                         seedidx < num_seeds && !ctx->should_terminate;
-                         seedidx++) {
-                        input.uid.seedidx = seedidx;
+                for (uint8_t seedidx = 0;
+                     seedidx < num_seeds && !ctx->should_terminate;
+                     seedidx++) {
+                    input.uid.seedidx = seedidx;
 
-                        input.seed = RANDOM_SEEDS[seedidx];
-                        handle_vrp_instance(ctx, &input);
-                    }
-                } else {
-                    printf("%s: Skipping since it does not match filter\n",
-                           fpath);
+                    input.seed = RANDOM_SEEDS[seedidx];
+                    handle_vrp_instance(ctx, &input);
                 }
-                instance_destroy(&instance);
             } else {
-                log_fatal("%s: Failed to parse input file\n", fpath);
-                exit(EXIT_FAILURE);
+                printf("%s: Skipping since it does not match filter\n",
+                       fpath);
             }
+            instance_header_destroy(&header);
         }
     } else if (typeflag == FTW_D) {
         printf("Found dir: %s\n", fpath);
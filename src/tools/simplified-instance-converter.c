@@ -27,6 +27,8 @@
 
 static void print_usage(FILE *fh, char *progname) {
     fprintf(fh, "%s [INPUT-TEST-INSTANCE] [OUTPUT-TEST-INSTANCE]\n", progname);
+    fprintf(fh, "An OUTPUT-TEST-INSTANCE with the `." CPTP_BINARY_FEXT
+                "` extension is written in the binary format\n");
     exit(EXIT_FAILURE);
 }
 
@@ -45,14 +47,27 @@ int main(int argc, char **argv) {
         exit(EXIT_FAILURE);
     }
 
-    FILE *fh = fopen(output, "w");
+    const char *ext = os_get_fext(output);
+    bool binary = ext && 0 == strcmp(ext, CPTP_BINARY_FEXT);
+
+    FILE *fh = fopen(output, binary ? "wb" : "w");
     if (!fh) {
         fprintf(stderr, "%s: failed to open file for writing\n", output);
         instance_destroy(&instance);
         exit(EXIT_FAILURE);
     }
 
-    render_instance_into_vrplib_file(fh, &instance, true);
+    bool success = true;
+    if (binary) {
+        success = render_instance_into_binary_file(fh, &instance);
+    } else {
+        render_instance_into_vrplib_file(fh, &instance, true);
+    }
+    success &= 0 == fclose(fh);
+    if (!success) {
+        fprintf(stderr, "%s: failed to write the instance\n", output);
+    }
+
     instance_destroy(&instance);
-    return EXIT_SUCCESS;
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -49,6 +49,80 @@ int32_t *mati32_copy(int32_t *other, int32_t w, int32_t h) {
     return result;
 }
 
+Bitset bitset_create(int64_t nbits) {
+    Bitset result = {0};
+    assert(nbits >= 0);
+    int64_t nwords = bitset_nwords(nbits);
+    result.words = calloc((size_t)MAX(1, nwords), sizeof(*result.words));
+    if (!result.words) {
+        return result;
+    }
+    result.nbits = nbits;
+    result.nwords = nwords;
+    return result;
+}
+
+void bitset_destroy(Bitset *bs) {
+    free(bs->words);
+    memset(bs, 0, sizeof(*bs));
+}
+
+Bitset bitset_copy(const Bitset *other) {
+    Bitset result = bitset_create(other->nbits);
+    if (result.words) {
+        memcpy(result.words, other->words,
+               other->nwords * sizeof(*result.words));
+    }
+    return result;
+}
+
+void bitset_union(Bitset *dest, const Bitset *a, const Bitset *b) {
+    assert(dest->nbits == a->nbits && a->nbits == b->nbits);
+    for (int64_t w = 0; w < dest->nwords; w++)
+        dest->words[w] = a->words[w] | b->words[w];
+}
+
+void bitset_intersection(Bitset *dest, const Bitset *a, const Bitset *b) {
+    assert(dest->nbits == a->nbits && a->nbits == b->nbits);
+    for (int64_t w = 0; w < dest->nwords; w++)
+        dest->words[w] = a->words[w] & b->words[w];
+}
+
+void bitset_complement(Bitset *dest, const Bitset *src) {
+    assert(dest->nbits == src->nbits);
+    for (int64_t w = 0; w < dest->nwords; w++)
+        dest->words[w] = ~src->words[w];
+
+    // Keep the padding bits of the last word cleared, otherwise popcount,
+    // equality and hashing would observe them.
+    int32_t tail = (int32_t)(dest->nbits % BITSET_WORD_BITS);
+    if (tail != 0) {
+        dest->words[dest->nwords - 1] &= ((uint64_t)1 << tail) - 1;
+    }
+}
+
+bool bitset_equal(const Bitset *a, const Bitset *b) {
+    if (a->nbits != b->nbits) {
+        return false;
+    }
+    return 0 == memcmp(a->words, b->words, a->nwords * sizeof(*a->words));
+}
+
+uint64_t bitset_hash(const Bitset *bs) {
+    // NOTE(dparo): FNV-1a style combine, with each word first passed through
+    //     the splitmix64 finalizer so that sets differing by a single bit
+    //     land far apart.
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)bs->nbits;
+    for (int64_t w = 0; w < bs->nwords; w++) {
+        uint64_t x = bs->words[w] + 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        x = x ^ (x >> 31);
+        h = (h ^ x) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
 const char *__enum_to_str(const EnumToStrMapping *table, int32_t table_len,
                           int32_t value) {
     for (int32_t i = 0; i < table_len; i++)
@@ -134,6 +134,114 @@ static inline double vec2d_dist(Vec2d const *a, Vec2d const *b) {
     return sqrt(dx * dx + dy * dy);
 }
 
+// NOTE(dparo):
+//     Compact set of node indices in [0, nbits). Used to represent the
+//     S side of a bipartition (max-flow results) or a tour component,
+//     such that membership tests, set sizes and hashing reduce to word
+//     operations instead of rescanning a per node int32_t labelling.
+//     Bits past `nbits` in the last word are always kept cleared.
+typedef struct Bitset {
+    int64_t nbits;
+    int64_t nwords;
+    uint64_t *words;
+} Bitset;
+
+#define BITSET_WORD_BITS 64
+
+static inline int64_t bitset_nwords(int64_t nbits) {
+    return (nbits + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+}
+
+Bitset bitset_create(int64_t nbits);
+void bitset_destroy(Bitset *bs);
+Bitset bitset_copy(const Bitset *other);
+
+void bitset_union(Bitset *dest, const Bitset *a, const Bitset *b);
+void bitset_intersection(Bitset *dest, const Bitset *a, const Bitset *b);
+void bitset_complement(Bitset *dest, const Bitset *src);
+bool bitset_equal(const Bitset *a, const Bitset *b);
+uint64_t bitset_hash(const Bitset *bs);
+
+static inline void bitset_clear(Bitset *bs) {
+    for (int64_t w = 0; w < bs->nwords; w++)
+        bs->words[w] = 0;
+}
+
+static inline bool bitset_test(const Bitset *bs, int64_t i) {
+    assert(i >= 0 && i < bs->nbits);
+    return (bs->words[i / BITSET_WORD_BITS] >> (i % BITSET_WORD_BITS)) & 1;
+}
+
+static inline void bitset_set(Bitset *bs, int64_t i) {
+    assert(i >= 0 && i < bs->nbits);
+    bs->words[i / BITSET_WORD_BITS] |= (uint64_t)1 << (i % BITSET_WORD_BITS);
+}
+
+static inline void bitset_unset(Bitset *bs, int64_t i) {
+    assert(i >= 0 && i < bs->nbits);
+    bs->words[i / BITSET_WORD_BITS] &=
+        ~((uint64_t)1 << (i % BITSET_WORD_BITS));
+}
+
+static inline int64_t bitset_popcount(const Bitset *bs) {
+    int64_t result = 0;
+    for (int64_t w = 0; w < bs->nwords; w++)
+        result += __builtin_popcountll(bs->words[w]);
+    return result;
+}
+
+/// Returns the smallest set bit >= `from`, or -1 if there is none.
+static inline int32_t bitset_next(const Bitset *bs, int32_t from) {
+    if (from >= bs->nbits) {
+        return -1;
+    }
+    assert(from >= 0);
+
+    int32_t w = from / BITSET_WORD_BITS;
+    uint64_t mask = ~(uint64_t)0 << (from % BITSET_WORD_BITS);
+    uint64_t word = bs->words[w] & mask;
+
+    while (word == 0) {
+        if (++w >= bs->nwords) {
+            return -1;
+        }
+        word = bs->words[w];
+    }
+
+    return w * BITSET_WORD_BITS + __builtin_ctzll(word);
+}
+
+/// Iterate `i` over the set bits of `bs` in increasing order.
+#define BITSET_FOREACH(bs, i)                                                  \
+    for (int32_t i = bitset_next((bs), 0); i >= 0; i = bitset_next((bs), i + 1))
+
+// NOTE(dparo):
+//     Pseudo random generator (splitmix64) owned by whoever needs random
+//     numbers, replacing the process wide `rand()`. Solves running
+//     concurrently each keep their own state, and are reproducible from
+//     their seed alone.
+typedef struct Rng {
+    uint64_t state;
+} Rng;
+
+static inline Rng rng_create(uint64_t seed) {
+    Rng rng = {seed};
+    return rng;
+}
+
+static inline uint64_t rng_next(Rng *rng) {
+    uint64_t x = (rng->state += 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/// Uniform integer in `[0, n)`. `n` must be positive.
+static inline int32_t rng_next_int(Rng *rng, int32_t n) {
+    assert(n > 0);
+    return (int32_t)(((rng_next(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
 typedef struct EnumToStrMapping {
     int32_t value;
     const char *name;
@@ -30,6 +30,11 @@ extern "C" {
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <assert.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
 #define BOOL(x) (!!(x))
 
@@ -84,6 +89,28 @@ extern "C" {
 
 #define ZERO_STRUCT(S) memclr(S, sizeof(*(S)))
 
+#define CACHE_LINE_SIZE 64
+
+/// Allocates `size` bytes aligned to `alignment`, which must be a power of 2.
+/// The returned memory must be released with `aligned_free`.
+static inline void *aligned_malloc(size_t alignment, size_t size) {
+    assert(IS_POW2(alignment));
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    // C11 aligned_alloc requires the size to be a multiple of the alignment
+    return aligned_alloc(alignment, POW2_ALIGN(size_t, size, alignment));
+#endif
+}
+
+static inline void aligned_free(void *ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
 #include "log.h"
 
 #define FATAL(...)                                                             \
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2021 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/// Micro benchmarks of the hot paths: distance evaluation, nearest neighbour
+/// queries and instance parsing. Not registered with CTest: run it by hand
+/// from the repository root, with an optimized build, as `tests/bench`.
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "parser.h"
+#include "parsing-utils.h"
+#include "core.h"
+#include "core-utils.h"
+#include "dist-kernel.h"
+#include "spatial-index.h"
+#include "types.h"
+#include "os.h"
+
+#define BENCH_INSTANCE_FILEPATH "data/CVRP/X/X-n895-k37.vrp"
+
+static StrView view(const char *string, size_t len) {
+    return (StrView){string, len};
+}
+
+static double bench_dist_evals(const Instance *instance, int32_t num_reps,
+                               int64_t *elapsed_usecs) {
+    const int32_t n = instance->num_customers + 1;
+    double sum = 0.0;
+
+    int64_t begin = os_get_usecs();
+    for (int32_t rep = 0; rep < num_reps; rep++) {
+        // Mimics the insertion heuristic access pattern: c_ah + c_hb - c_ab
+        for (int32_t h = 1; h < n; h++) {
+            for (int32_t a = 0; a < n; a++) {
+                int32_t b = (a + 1) % n;
+                if (a != h && b != h) {
+                    sum += cptp_dist(instance, a, h) +
+                           cptp_dist(instance, h, b) -
+                           cptp_dist(instance, a, b);
+                }
+            }
+        }
+    }
+    *elapsed_usecs = os_get_usecs() - begin;
+    return sum;
+}
+
+static bool bench_dist_cache(void) {
+    const int32_t NUM_REPS = 16;
+    Instance instance = parse(BENCH_INSTANCE_FILEPATH);
+    if (!instance.positions) {
+        return false;
+    }
+
+    instance_drop_dist_cache(&instance);
+    int64_t uncached_usecs = 0;
+    double uncached_sum =
+        bench_dist_evals(&instance, NUM_REPS, &uncached_usecs);
+
+    int64_t build_begin = os_get_usecs();
+    bool success = instance_build_dist_cache(&instance);
+    int64_t build_usecs = os_get_usecs() - build_begin;
+
+    int64_t cached_usecs = 0;
+    double cached_sum = bench_dist_evals(&instance, NUM_REPS, &cached_usecs);
+    success = success && uncached_sum == cached_sum;
+
+    printf("%s :: %s (%d nodes): uncached %.3f ms, cached %.3f ms (+ %.3f ms "
+           "build), speedup %.2fx\n",
+           __func__, BENCH_INSTANCE_FILEPATH, instance.num_customers + 1,
+           uncached_usecs / 1000.0, cached_usecs / 1000.0,
+           build_usecs / 1000.0,
+           (double)uncached_usecs / (double)MAX(1, cached_usecs));
+
+    instance_destroy(&instance);
+    return success;
+}
+
+static bool bench_dist_kernels(void) {
+    static const DistKernelIsa ISAS[] = {
+        DIST_KERNEL_ISA_SCALAR,
+        DIST_KERNEL_ISA_AVX2,
+        DIST_KERNEL_ISA_AVX512,
+    };
+    const int32_t NUM_REPS = 64;
+
+    Instance instance = parse(BENCH_INSTANCE_FILEPATH);
+    if (!instance.positions) {
+        return false;
+    }
+
+    const int32_t n = instance.num_customers + 1;
+    double *row = malloc(n * sizeof(*row));
+
+    for (int32_t k = 0; k < ARRAY_LEN_i32(ISAS); k++) {
+        DistRowKernel kernel =
+            dist_row_kernel_for_isa(ISAS[k], instance.rounding_strat);
+        if (!kernel) {
+            continue;
+        }
+
+        int64_t begin = os_get_usecs();
+        for (int32_t rep = 0; rep < NUM_REPS; rep++) {
+            for (int32_t i = 0; i < n; i++) {
+                kernel(instance.positions, i, 0, n, row);
+            }
+        }
+        int64_t elapsed = os_get_usecs() - begin;
+
+        printf("%s :: %s (%d nodes), %s kernel: %.3f ms per full matrix\n",
+               __func__, BENCH_INSTANCE_FILEPATH, n,
+               dist_kernel_isa_name(ISAS[k]), elapsed / 1000.0 / NUM_REPS);
+    }
+
+    free(row);
+    instance_destroy(&instance);
+    return true;
+}
+
+static bool bench_spatial_index(void) {
+    const char *filepath = "data/CVRP/X/X-n1001-k43.vrp";
+    Instance instance = parse(filepath);
+    if (!instance.positions) {
+        return false;
+    }
+
+    const int32_t n = instance.num_customers + 1;
+    const int32_t k = 16;
+    int32_t *nn = malloc(k * sizeof(*nn));
+    double *dists = malloc(n * sizeof(*dists));
+
+    int64_t begin = os_get_usecs();
+    SpatialIndex index = spatial_index_create(instance.positions, n);
+    int64_t build_usecs = os_get_usecs() - begin;
+
+    int64_t checksum = 0;
+    begin = os_get_usecs();
+    for (int32_t i = 0; i < n; i++) {
+        int32_t len =
+            spatial_index_knn(&index, instance.positions[i], k, i, nn, NULL);
+        checksum += nn[len - 1];
+    }
+    int64_t knn_usecs = os_get_usecs() - begin;
+
+    // Brute force: a full distance row and a partial selection per node
+    begin = os_get_usecs();
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = 0; j < n; j++) {
+            dists[j] =
+                vec2d_dist(&instance.positions[i], &instance.positions[j]);
+        }
+        dists[i] = INFINITY;
+        double last = -1.0;
+        for (int32_t t = 0; t < k; t++) {
+            double best = INFINITY;
+            for (int32_t j = 0; j < n; j++) {
+                if (dists[j] > last && dists[j] < best) {
+                    best = dists[j];
+                }
+            }
+            last = best;
+        }
+        checksum += (int64_t)last;
+    }
+    int64_t brute_usecs = os_get_usecs() - begin;
+
+    printf("%s :: %s (%d nodes): build %.3f ms, %d-nn for every node %.3f ms "
+           "(brute force %.3f ms) [checksum %lld]\n",
+           __func__, filepath, n, build_usecs / 1000.0, k, knn_usecs / 1000.0,
+           brute_usecs / 1000.0, (long long)checksum);
+
+    spatial_index_destroy(&index);
+    free(dists);
+    free(nn);
+    instance_destroy(&instance);
+    return true;
+}
+
+static bool bench_number_parsing(void) {
+    const int32_t NUM_NUMBERS = 2000000;
+
+    // Edge weights as found in the `EDGE_WEIGHT_SECTION` of the explicit
+    // instances
+    enum { STRIDE = 32 };
+    char *numbers = malloc((size_t)NUM_NUMBERS * STRIDE);
+    int32_t *lens = malloc((size_t)NUM_NUMBERS * sizeof(*lens));
+    if (!numbers || !lens) {
+        free(lens);
+        free(numbers);
+        return false;
+    }
+
+    Rng rng = rng_create(7);
+    size_t num_bytes = 0;
+    for (int32_t i = 0; i < NUM_NUMBERS; i++) {
+        double x = (double)rng_next_int(&rng, 100000000) / 1000.0;
+        lens[i] = snprintf(numbers + (size_t)i * STRIDE, STRIDE, "%.3f", x);
+        num_bytes += (size_t)lens[i];
+    }
+
+    double strtod_sum = 0.0;
+    int64_t begin = os_get_usecs();
+    for (int32_t i = 0; i < NUM_NUMBERS; i++) {
+        // The old code path: a NUL terminated copy of each lexeme
+        char *copy = strndup(numbers + (size_t)i * STRIDE, lens[i]);
+        strtod_sum += strtod(copy, NULL);
+        free(copy);
+    }
+    int64_t strtod_usecs = os_get_usecs() - begin;
+
+    double strv_sum = 0.0;
+    begin = os_get_usecs();
+    for (int32_t i = 0; i < NUM_NUMBERS; i++) {
+        double x = 0.0;
+        strv_to_double(view(numbers + (size_t)i * STRIDE, lens[i]), &x);
+        strv_sum += x;
+    }
+    int64_t strv_usecs = os_get_usecs() - begin;
+
+    printf("%s :: %d numbers (%.1f MB): strtod %.3f ms, strv %.3f ms (%.1f "
+           "MB/s), speedup %.2fx\n",
+           __func__, NUM_NUMBERS, num_bytes / 1e6, strtod_usecs / 1000.0,
+           strv_usecs / 1000.0, num_bytes / (double)MAX(1, strv_usecs),
+           (double)strtod_usecs / (double)MAX(1, strv_usecs));
+
+    free(lens);
+    free(numbers);
+    return strtod_sum == strv_sum;
+}
+
+static bool bench_explicit_parsing(void) {
+    const char *filepath = "bench-explicit.vrp";
+    const int32_t n = 1000;
+
+    FILE *fh = fopen(filepath, "w");
+    if (!fh) {
+        return false;
+    }
+    fprintf(fh, "NAME : bench-explicit\nTYPE : CVRP\nDIMENSION : %d\n", n);
+    fprintf(fh, "VEHICLES : 2\nCAPACITY : 100\n");
+    fprintf(fh, "EDGE_WEIGHT_TYPE : EXPLICIT\nNODE_COORD_SECTION\n");
+    for (int32_t i = 0; i < n; i++) {
+        fprintf(fh, "%d 0 0\n", i + 1);
+    }
+    fprintf(fh, "DEMAND_SECTION\n");
+    for (int32_t i = 0; i < n; i++) {
+        fprintf(fh, "%d %d\n", i + 1, i == 0 ? 0 : 1);
+    }
+    fprintf(fh, "EDGE_WEIGHT_SECTION\n");
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            fprintf(fh, "%d %d %.17g\n", i + 1, j + 1, 1000.0 * i + j + 0.25);
+        }
+    }
+    fprintf(fh, "DEPOT_SECTION\n1\n-1\nEOF\n");
+    fclose(fh);
+
+    int64_t begin = os_get_usecs();
+    Instance instance = parse(filepath);
+    int64_t elapsed = os_get_usecs() - begin;
+    remove(filepath);
+
+    bool success = instance.edge_weight != NULL;
+    printf("%s :: %d nodes parsed in %.3f ms\n", __func__, n,
+           elapsed / 1000.0);
+    instance_destroy(&instance);
+    return success;
+}
+
+int main(void) {
+    bool success = true;
+    success &= bench_dist_cache();
+    success &= bench_dist_kernels();
+    success &= bench_spatial_index();
+    success &= bench_number_parsing();
+    success &= bench_explicit_parsing();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "core.h"
+#include "core-utils.h"
+#include "array-tour.h"
+
+#define NUM_NODES 40
+
+/// Reference route, stored as a plain sequence of nodes
+typedef struct {
+    int32_t len;
+    int32_t nodes[NUM_NODES];
+} RefRoute;
+
+static int32_t ref_index_of(const RefRoute *r, int32_t node) {
+    for (int32_t t = 0; t < r->len; t++) {
+        if (r->nodes[t] == node) {
+            return t;
+        }
+    }
+    return -1;
+}
+
+/// Rotates the reference route such that it starts from `node`
+static void ref_rotate(RefRoute *r, int32_t node) {
+    RefRoute tmp = *r;
+    int32_t p = ref_index_of(r, node);
+    for (int32_t t = 0; t < r->len; t++) {
+        r->nodes[t] = tmp.nodes[(p + t) % r->len];
+    }
+}
+
+/// The array tour must describe the same cycle as the reference route, in
+/// either orientation
+static greatest_test_res check_same_cycle(const ArrayTour *at,
+                                          const RefRoute *r) {
+    array_tour_validate(at);
+    ASSERT_EQ(r->len, at->len);
+    if (r->len == 0) {
+        PASS();
+    }
+
+    const int32_t first = r->nodes[0];
+    ASSERT(array_tour_contains(at, first));
+
+    bool forward = true, backward = true;
+    int32_t fwd = first, bwd = first;
+    for (int32_t t = 0; t < r->len; t++) {
+        forward = forward && fwd == r->nodes[t];
+        backward = backward && bwd == r->nodes[t];
+        fwd = array_tour_succ(at, fwd);
+        bwd = array_tour_pred(at, bwd);
+    }
+    ASSERT(forward || backward);
+
+    // Incrementally maintained metrics against a full recompute
+    double cost = 0.0, profit = 0.0, demand = 0.0;
+    for (int32_t t = 0; t < r->len; t++) {
+        const int32_t i = r->nodes[t];
+        cost += cptp_dist(at->instance, i, r->nodes[(t + 1) % r->len]);
+        profit += at->instance->profits[i];
+        demand += at->instance->demands[i];
+    }
+    ASSERT_IN_RANGE(cost, at->cost, 1e-6);
+    ASSERT_IN_RANGE(profit, at->profit, 1e-6);
+    ASSERT_IN_RANGE(demand, at->demand, 1e-6);
+    PASS();
+}
+
+static Instance G_instance;
+
+static void setup_instance(void) {
+    G_instance = (Instance){0};
+    G_instance.num_customers = NUM_NODES - 1;
+    G_instance.vehicle_cap = 1000.0;
+    G_instance.rounding_strat = CPTP_DIST_NO_ROUND;
+    instance_alloc(&G_instance, false);
+
+    srand(0);
+    for (int32_t i = 0; i < NUM_NODES; i++) {
+        G_instance.positions[i].x = rand() % 100;
+        G_instance.positions[i].y = rand() % 100;
+        G_instance.demands[i] = 1 + rand() % 10;
+        G_instance.profits[i] = rand() % 50;
+    }
+}
+
+static void teardown_instance(void) {
+    instance_destroy(&G_instance);
+}
+
+static ArrayTour make_array_tour(void) {
+    return array_tour_create(&G_instance);
+}
+
+TEST array_tour_insert_remove(void) {
+    ArrayTour at = make_array_tour();
+    RefRoute r = {0};
+
+    ASSERT_EQ(0, at.len);
+    array_tour_insert(&at, 0, -1);
+    r.nodes[r.len++] = 0;
+    CHECK_CALL(check_same_cycle(&at, &r));
+    ASSERT_EQ(0, array_tour_succ(&at, 0));
+
+    srand(1);
+    for (int32_t h = 1; h < NUM_NODES; h++) {
+        int32_t a = r.nodes[rand() % r.len];
+        double delta = array_tour_insert_delta(&at, h, a);
+        double prev_cost = at.cost;
+        array_tour_insert(&at, h, a);
+        ASSERT_EQ(prev_cost + delta, at.cost);
+        ref_rotate(&r, a);
+        memmove(&r.nodes[2], &r.nodes[1], (r.len - 1) * sizeof(r.nodes[0]));
+        r.nodes[1] = h;
+        r.len++;
+        CHECK_CALL(check_same_cycle(&at, &r));
+    }
+
+    for (int32_t it = 0; it < NUM_NODES - 1; it++) {
+        int32_t h = r.nodes[rand() % r.len];
+        double delta = array_tour_remove_delta(&at, h);
+        double prev_cost = at.cost;
+        array_tour_remove(&at, h);
+        ASSERT_EQ(prev_cost + delta, at.cost);
+        ref_rotate(&r, h);
+        memmove(&r.nodes[0], &r.nodes[1], (r.len - 1) * sizeof(r.nodes[0]));
+        r.len--;
+        ASSERT_FALSE(array_tour_contains(&at, h));
+        ASSERT(at.tour.comp[h] < 0);
+        CHECK_CALL(check_same_cycle(&at, &r));
+    }
+
+    array_tour_destroy(&at);
+    PASS();
+}
+
+static void fill_identity(ArrayTour *at, RefRoute *r, int32_t len) {
+    array_tour_clear(at);
+    r->len = 0;
+    for (int32_t i = 0; i < len; i++) {
+        array_tour_insert(at, i, i - 1);
+        r->nodes[r->len++] = i;
+    }
+}
+
+TEST array_tour_2opt_moves(void) {
+    ArrayTour at = make_array_tour();
+    RefRoute r = {0};
+    fill_identity(&at, &r, NUM_NODES - 3);
+
+    srand(2);
+    for (int32_t it = 0; it < 500; it++) {
+        int32_t a = r.nodes[rand() % r.len];
+        int32_t b = r.nodes[rand() % r.len];
+        if (a == b) {
+            continue;
+        }
+
+        // Expected: a, reversed(succ(a) .. b), succ(b) .. pred(a), following
+        // the current orientation of the array tour
+        r.len = 0;
+        int32_t v = a;
+        do {
+            r.nodes[r.len++] = v;
+            v = array_tour_succ(&at, v);
+        } while (v != a);
+        int32_t pb = ref_index_of(&r, b);
+        for (int32_t i = 1, j = pb; i < j; i++, j--) {
+            SWAP(int32_t, r.nodes[i], r.nodes[j]);
+        }
+
+        double delta = array_tour_2opt_delta(&at, a, b);
+        double prev_cost = at.cost;
+        array_tour_2opt_move(&at, a, b);
+        ASSERT_EQ(prev_cost + delta, at.cost);
+        CHECK_CALL(check_same_cycle(&at, &r));
+    }
+
+    array_tour_destroy(&at);
+    PASS();
+}
+
+TEST array_tour_or_moves(void) {
+    ArrayTour at = make_array_tour();
+    RefRoute r = {0};
+    fill_identity(&at, &r, NUM_NODES);
+
+    srand(3);
+    for (int32_t it = 0; it < 1000; it++) {
+        int32_t s = r.nodes[rand() % r.len];
+        int32_t seg_len = 1 + rand() % 4;
+        bool reversed = rand() % 2;
+
+        // Segment going forward from `s` in the array tour orientation
+        int32_t seg[4];
+        seg[0] = s;
+        for (int32_t t = 1; t < seg_len; t++) {
+            seg[t] = array_tour_succ(&at, seg[t - 1]);
+        }
+        int32_t e = seg[seg_len - 1];
+
+        int32_t c = -1;
+        do {
+            c = r.nodes[rand() % r.len];
+        } while (array_tour_between(&at, s, c, e));
+
+        // Rebuild the expected route following the array tour orientation
+        RefRoute rest = {0};
+        for (int32_t v = array_tour_succ(&at, e); v != s;
+             v = array_tour_succ(&at, v)) {
+            rest.nodes[rest.len++] = v;
+        }
+        r.len = 0;
+        for (int32_t t = 0; t < rest.len; t++) {
+            r.nodes[r.len++] = rest.nodes[t];
+            if (rest.nodes[t] == c) {
+                for (int32_t k = 0; k < seg_len; k++) {
+                    r.nodes[r.len++] =
+                        reversed ? seg[seg_len - 1 - k] : seg[k];
+                }
+            }
+        }
+
+        double delta = array_tour_or_move_delta(&at, s, e, c, reversed);
+        double prev_cost = at.cost;
+        array_tour_or_move(&at, s, e, c, reversed);
+        ASSERT_EQ(prev_cost + delta, at.cost);
+        CHECK_CALL(check_same_cycle(&at, &r));
+    }
+
+    array_tour_destroy(&at);
+    PASS();
+}
+
+TEST array_tour_between_queries(void) {
+    ArrayTour at = make_array_tour();
+    RefRoute r = {0};
+    fill_identity(&at, &r, 10);
+
+    ASSERT(array_tour_between(&at, 2, 5, 7));
+    ASSERT(array_tour_between(&at, 2, 2, 7));
+    ASSERT(array_tour_between(&at, 2, 7, 7));
+    ASSERT_FALSE(array_tour_between(&at, 2, 8, 7));
+    ASSERT(array_tour_between(&at, 8, 9, 1));
+    ASSERT(array_tour_between(&at, 8, 0, 1));
+    ASSERT_FALSE(array_tour_between(&at, 8, 5, 1));
+
+    array_tour_destroy(&at);
+    PASS();
+}
+
+TEST array_tour_tour_conversion(void) {
+    Instance instance = {0};
+    instance.num_customers = 7;
+    instance.vehicle_cap = 100.0;
+    ASSERT(instance_alloc(&instance, false));
+    for (int32_t i = 0; i < 8; i++) {
+        instance.positions[i] = (Vec2d){i, i % 3};
+        instance.demands[i] = 1.0;
+        instance.profits[i] = 2.0 * i;
+    }
+    Tour tour = tour_create(&instance);
+
+    // Route 0 -> 3 -> 5 -> 1 -> 0, the other nodes are not visited
+    tour.num_comps = 1;
+    tour.comp[0] = tour.comp[3] = tour.comp[5] = tour.comp[1] = 0;
+    tour.succ[0] = 3;
+    tour.succ[3] = 5;
+    tour.succ[5] = 1;
+    tour.succ[1] = 0;
+    int32_t *succ = tour.succ;
+
+    ArrayTour at = array_tour_adopt(&instance, &tour);
+    ASSERT_EQ(NULL, tour.succ);
+    ASSERT_EQ(4.0, at.demand);
+    ASSERT_EQ(18.0, at.profit);
+    ASSERT_EQ(succ, at.tour.succ);
+    ASSERT_EQ(4, at.len);
+    ASSERT_EQ(0, at.order[0]);
+    ASSERT_EQ(5, at.order[2]);
+    ASSERT_EQ(1, array_tour_pred(&at, 0));
+    ASSERT_EQ(-1, at.pos[2]);
+
+    array_tour_insert(&at, 2, 5);
+    array_tour_2opt_move(&at, 0, 5);
+
+    const double objective = array_tour_objective(&at);
+    tour = array_tour_release(&at);
+    ASSERT_EQ(succ, tour.succ);
+    ASSERT_EQ(NULL, at.tour.succ);
+    ASSERT_EQ(1, tour.num_comps);
+    ASSERT_EQ(0, tour.comp[2]);
+
+    int32_t num_visited = 1;
+    for (int32_t v = tour.succ[0]; v != 0; v = tour.succ[v]) {
+        ++num_visited;
+    }
+    ASSERT_EQ(5, num_visited);
+    ASSERT_IN_RANGE(tour_eval(&instance, &tour), objective, 1e-9);
+
+    tour_destroy(&tour);
+    instance_destroy(&instance);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    setup_instance();
+    RUN_TEST(array_tour_insert_remove);
+    RUN_TEST(array_tour_2opt_moves);
+    RUN_TEST(array_tour_or_moves);
+    RUN_TEST(array_tour_between_queries);
+    teardown_instance();
+    RUN_TEST(array_tour_tour_conversion);
+
+    GREATEST_MAIN_END(); /* display results */
+}
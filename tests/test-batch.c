@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "batch.h"
+
+#define NUM_JOBS 16
+
+typedef struct {
+    int32_t num_calls;
+    int32_t num_parsed;
+    int32_t times_called[NUM_JOBS];
+    const CptpJob *jobs;
+} CallbackCtx;
+
+static void on_job_done(const CptpJob *job, const CptpJobResult *result,
+                        const Instance *instance, Solution *solution,
+                        void *user_data) {
+    CallbackCtx *ctx = user_data;
+    // NOTE(dparo): Invocations are serialized, no need for atomics
+    ctx->num_calls++;
+    ctx->times_called[job - ctx->jobs]++;
+    if (result->parsed && instance && solution) {
+        ctx->num_parsed++;
+    }
+}
+
+static void make_jobs(CptpJob *jobs) {
+    for (int32_t i = 0; i < NUM_JOBS; i++) {
+        jobs[i] = (CptpJob){
+            .instance_filepath = (i % 4 == 3) ? "data/CVRP/missing.vrp"
+                                              : "data/CVRP/toy.vrp",
+            .solver_name = "stub",
+            .timelimit = 1.0,
+            .randomseed = i + 1,
+        };
+    }
+}
+
+static greatest_test_res check_batch(int32_t num_workers) {
+    CptpJob jobs[NUM_JOBS];
+    CptpJobResult results[NUM_JOBS];
+    CallbackCtx ctx = {.jobs = jobs};
+    make_jobs(jobs);
+
+    ASSERT(cptp_solve_many(jobs, NUM_JOBS, num_workers, NULL, results,
+                           on_job_done, &ctx));
+
+    ASSERT_EQ(NUM_JOBS, ctx.num_calls);
+    ASSERT_EQ(NUM_JOBS - NUM_JOBS / 4, ctx.num_parsed);
+
+    for (int32_t i = 0; i < NUM_JOBS; i++) {
+        ASSERT_EQ(1, ctx.times_called[i]);
+        if (i % 4 == 3) {
+            ASSERT_FALSE(results[i].parsed);
+            ASSERT(results[i].status & SOLVE_STATUS_ERR);
+        } else {
+            ASSERT(results[i].parsed);
+            // The stub solver never produces a solution
+            ASSERT_EQ(SOLVE_STATUS_NULL, results[i].status);
+            ASSERT(results[i].timing.took_usecs >= 0);
+        }
+    }
+
+    PASS();
+}
+
+TEST batch_single_worker(void) {
+    CHECK_CALL(check_batch(1));
+    PASS();
+}
+
+TEST batch_multiple_workers(void) {
+    CHECK_CALL(check_batch(4));
+    PASS();
+}
+
+TEST batch_more_workers_than_jobs(void) {
+    CHECK_CALL(check_batch(2 * NUM_JOBS));
+    PASS();
+}
+
+TEST batch_without_results_and_callback(void) {
+    CptpJob jobs[NUM_JOBS];
+    make_jobs(jobs);
+    ASSERT(cptp_solve_many(jobs, NUM_JOBS, 0, NULL, NULL, NULL, NULL));
+    ASSERT(cptp_solve_many(jobs, 0, 4, NULL, NULL, NULL, NULL));
+    PASS();
+}
+
+TEST batch_cancelled_before_start(void) {
+    CptpJob jobs[NUM_JOBS];
+    CptpJobResult results[NUM_JOBS];
+    CallbackCtx ctx = {.jobs = jobs};
+    CancellationToken cancel = {0};
+    make_jobs(jobs);
+
+    cancellation_token_request(&cancel);
+    ASSERT(cptp_solve_many(jobs, NUM_JOBS, 4, &cancel, results, on_job_done,
+                           &ctx));
+
+    ASSERT_EQ(0, ctx.num_calls);
+    for (int32_t i = 0; i < NUM_JOBS; i++) {
+        ASSERT_FALSE(results[i].parsed);
+        ASSERT_EQ(SOLVE_STATUS_NULL, results[i].status);
+    }
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    /* If tests are run outside of a suite, a default suite is used. */
+    RUN_TEST(batch_single_worker);
+    RUN_TEST(batch_multiple_workers);
+    RUN_TEST(batch_more_workers_than_jobs);
+    RUN_TEST(batch_without_results_and_callback);
+    RUN_TEST(batch_cancelled_before_start);
+
+    GREATEST_MAIN_END(); /* display results */
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "parser.h"
+#include "core.h"
+#include "core-utils.h"
+#include "candidates.h"
+
+static greatest_test_res check_against_brute_force(const Instance *instance,
+                                                   const CandidateLists *cl) {
+    const int32_t n = instance->num_customers + 1;
+    int32_t *expected = malloc(cl->k * sizeof(*expected));
+    double *keys = malloc(cl->k * sizeof(*keys));
+
+    for (int32_t i = 0; i < n; i++) {
+        // Brute force selection of the k best nodes, ranked by
+        // (reduced cost, node index)
+        int32_t len = 0;
+        for (int32_t j = 0; j < n; j++) {
+            if (j == i) {
+                continue;
+            }
+            double key = cptp_reduced_cost(instance, i, j);
+            int32_t pos = len < cl->k ? len++ : cl->k;
+            while (pos > 0 &&
+                   (key < keys[pos - 1] ||
+                    (key == keys[pos - 1] && j < expected[pos - 1]))) {
+                if (pos < cl->k) {
+                    keys[pos] = keys[pos - 1];
+                    expected[pos] = expected[pos - 1];
+                }
+                --pos;
+            }
+            if (pos < cl->k) {
+                keys[pos] = key;
+                expected[pos] = j;
+            }
+        }
+
+        ASSERT_EQ(cl->k, len);
+        const int32_t *list = candidate_list(cl, i);
+        for (int32_t t = 0; t < cl->k; t++) {
+            ASSERT_EQ(expected[t], list[t]);
+        }
+    }
+
+    free(keys);
+    free(expected);
+    PASS();
+}
+
+TEST candidate_lists_match_brute_force(void) {
+    Instance instance =
+        parse("data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp");
+    ASSERT(instance.positions);
+    const int32_t n = instance.num_customers + 1;
+
+    CandidateLists cl = candidate_lists_create(&instance, 10);
+    ASSERT(cl.lists);
+    ASSERT_EQ(10, cl.k);
+    ASSERT_EQ(n, cl.num_nodes);
+    CHECK_CALL(check_against_brute_force(&instance, &cl));
+
+    // Profits in the same scale of the distances are mostly resolved within
+    // the pool, while very spread profits force the full row scans
+    const double spreads[] = {0.0, 10.0, 50.0, 1e4};
+    srand(0);
+    for (int32_t s = 0; s < ARRAY_LEN_i32(spreads); s++) {
+        for (int32_t i = 0; i < n; i++) {
+            instance.profits[i] = spreads[s] * (double)rand() / RAND_MAX;
+        }
+        ASSERT(candidate_lists_update(&cl, &instance));
+        CHECK_CALL(check_against_brute_force(&instance, &cl));
+    }
+
+    candidate_lists_destroy(&cl);
+    ASSERT_EQ(NULL, cl.lists);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST candidate_lists_small_instance(void) {
+    Instance instance = parse("data/CVRP/toy.vrp");
+    ASSERT(instance.positions);
+    const int32_t n = instance.num_customers + 1;
+
+    // k is clamped to the number of other nodes
+    CandidateLists cl = candidate_lists_create(&instance, 100);
+    ASSERT(cl.lists);
+    ASSERT_EQ(n - 1, cl.k);
+    CHECK_CALL(check_against_brute_force(&instance, &cl));
+
+    // Every node is a candidate of every other node
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = 0; j < n; j++) {
+            if (i != j) {
+                ASSERT(candidate_lists_contains_edge(&cl, i, j));
+            }
+        }
+    }
+    candidate_lists_destroy(&cl);
+
+    cl = candidate_lists_create(&instance, 1);
+    ASSERT(cl.lists);
+    for (int32_t i = 0; i < n; i++) {
+        int32_t j = candidate_list(&cl, i)[0];
+        ASSERT(candidate_lists_contains_edge(&cl, i, j));
+        ASSERT(candidate_lists_contains_edge(&cl, j, i));
+    }
+    candidate_lists_destroy(&cl);
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    RUN_TEST(candidate_lists_match_brute_force);
+    RUN_TEST(candidate_lists_small_instance);
+
+    GREATEST_MAIN_END(); /* display results */
+}
@@ -59,6 +59,455 @@ TEST calling_sxpos(void) {
     PASS();
 }
 
+TEST instance_arena_layout(void) {
+    Instance instance = parse("data/CVRP/toy.vrp");
+    ASSERT(instance.positions);
+
+    // Every array starts on its own cache line
+    ASSERT_EQ(0, (uintptr_t)instance.positions % CACHE_LINE_SIZE);
+    ASSERT_EQ(0, (uintptr_t)instance.demands % CACHE_LINE_SIZE);
+    ASSERT_EQ(0, (uintptr_t)instance.profits % CACHE_LINE_SIZE);
+    ASSERT(instance.geometry_arena);
+    ASSERT(instance.nodes_arena);
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST instance_view_shares_geometry(void) {
+    const char *filepath = "data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp";
+    Instance instance = parse(filepath);
+    ASSERT(instance.positions);
+    const int32_t n = instance.num_customers + 1;
+
+    Instance view = instance_view(&instance);
+    ASSERT(view.profits);
+    ASSERT_EQ(instance.num_customers, view.num_customers);
+    ASSERT_EQ(instance.vehicle_cap, view.vehicle_cap);
+    ASSERT_STR_EQ(instance.name, view.name);
+
+    // Geometry and distance cache are shared, the node data is owned
+    ASSERT_EQ(instance.positions, view.positions);
+    ASSERT_EQ(instance.dist_cache, view.dist_cache);
+    ASSERT(instance.profits != view.profits);
+    ASSERT(instance.demands != view.demands);
+
+    // Modifying the view does not affect the original instance
+    double profit1 = instance.profits[1];
+    view.profits[1] += 1000.0;
+    view.vehicle_cap *= 2.0;
+    ASSERT_EQ(profit1, instance.profits[1]);
+    ASSERT_EQ(profit1 + 1000.0, view.profits[1]);
+
+    // Views of views, and views outliving the original instance
+    Instance view2 = instance_view(&view);
+    ASSERT_EQ(view.profits[1], view2.profits[1]);
+    Instance copy = instance_copy(&instance, true, true);
+    instance_destroy(&instance);
+    instance_destroy(&view);
+
+    for (int32_t i = 0; i < n; i++) {
+        ASSERT_EQ(copy.positions[i].x, view2.positions[i].x);
+        ASSERT_EQ(copy.positions[i].y, view2.positions[i].y);
+        for (int32_t j = 0; j < n; j++) {
+            ASSERT_EQ(cptp_dist(&copy, i, j), cptp_dist(&view2, i, j));
+        }
+    }
+
+    instance_destroy(&view2);
+    instance_destroy(&copy);
+    PASS();
+}
+
+TEST instance_view_of_explicit_instance(void) {
+    Instance instance = {0};
+    instance.num_customers = 3;
+    ASSERT(instance_alloc(&instance, true));
+    const int32_t n = instance.num_customers + 1;
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            instance.edge_weight[sxpos(n, i, j)] = 10.0 * i + j;
+        }
+    }
+
+    Instance view = instance_view(&instance);
+    ASSERT_EQ(instance.edge_weight, view.edge_weight);
+    instance_destroy(&instance);
+    ASSERT_EQ(12.0, cptp_dist(&view, 2, 1));
+    instance_destroy(&view);
+    PASS();
+}
+
+static void set_route(Tour *tour, const int32_t *route, int32_t len) {
+    tour_clear(tour);
+    for (int32_t i = 0; i < len; i++) {
+        tour->comp[route[i]] = 0;
+        tour->succ[route[i]] = route[(i + 1) % len];
+    }
+    tour->num_comps = 1;
+}
+
+TEST column_pool(void) {
+    // Unit distances: the reduced cost of a route of `len` nodes is
+    // `len - sum(profits)`
+    Instance instance = {0};
+    instance.num_customers = 4;
+    instance.num_vehicles = 1;
+    instance.vehicle_cap = 100.0;
+    ASSERT(instance_alloc(&instance, true));
+    const int32_t n = instance.num_customers + 1;
+    for (int32_t i = 0; i < hm_nentries(n); i++) {
+        instance.edge_weight[i] = 1.0;
+    }
+    const double profits[] = {0.0, 5.0, 4.0, 3.0, 0.5};
+    memcpy(instance.profits, profits, sizeof(profits));
+
+    Solution solution = solution_create(&instance);
+    Tour tour = tour_create(&instance);
+    const int32_t r01[] = {0, 1};
+    const int32_t r03[] = {0, 3};
+    const int32_t r04[] = {0, 4};
+    const int32_t r012[] = {0, 1, 2};
+    const int32_t r021[] = {0, 2, 1};
+    const int32_t r0123[] = {0, 1, 2, 3};
+
+    // Disabled by default
+    set_route(&tour, r01, ARRAY_LEN(r01));
+    ASSERT_FALSE(solution_add_column(&solution, &instance, &tour));
+
+    ASSERT(solution_reserve_columns(&solution, 3));
+    ASSERT(solution_add_column(&solution, &instance, &tour));
+    set_route(&tour, r03, ARRAY_LEN(r03));
+    ASSERT(solution_add_column(&solution, &instance, &tour));
+    set_route(&tour, r012, ARRAY_LEN(r012));
+    ASSERT(solution_add_column(&solution, &instance, &tour));
+
+    ASSERT_EQ(3, solution.columns.num_columns);
+    ASSERT_EQ(-6.0, solution.columns.reduced_costs[0]);
+    ASSERT_EQ(-3.0, solution.columns.reduced_costs[1]);
+    ASSERT_EQ(-1.0, solution.columns.reduced_costs[2]);
+    ASSERT_EQ(-6.0, tour_eval(&instance, &solution.columns.tours[0]));
+
+    // Same nodes and not better, or not an improving column
+    set_route(&tour, r021, ARRAY_LEN(r021));
+    ASSERT_FALSE(solution_add_column(&solution, &instance, &tour));
+    set_route(&tour, r04, ARRAY_LEN(r04));
+    ASSERT_FALSE(solution_add_column(&solution, &instance, &tour));
+
+    // Better than the worst column of the full pool
+    set_route(&tour, r0123, ARRAY_LEN(r0123));
+    ASSERT(solution_add_column(&solution, &instance, &tour));
+    ASSERT_EQ(3, solution.columns.num_columns);
+    ASSERT_EQ(-8.0, solution.columns.reduced_costs[0]);
+    ASSERT_EQ(-6.0, solution.columns.reduced_costs[1]);
+    ASSERT_EQ(-3.0, solution.columns.reduced_costs[2]);
+    set_route(&tour, r03, ARRAY_LEN(r03));
+    ASSERT_FALSE(solution_add_column(&solution, &instance, &tour));
+
+    // A better tour over the same nodes replaces the column
+    set_route(&tour, r021, ARRAY_LEN(r021));
+    ASSERT(solution_add_column_with_cost(&solution, &tour, -7.0));
+    ASSERT_EQ(3, solution.columns.num_columns);
+    ASSERT_EQ(-7.0, solution.columns.reduced_costs[1]);
+    ASSERT_EQ(1, solution.columns.tours[1].succ[2]);
+
+    solution_clear(&solution);
+    ASSERT_EQ(0, solution.columns.num_columns);
+    ASSERT_EQ(3, solution.columns.capacity);
+
+    tour_destroy(&tour);
+    solution_destroy(&solution);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST session_update_profits(void) {
+    Instance instance = parse("data/CVRP/toy.vrp");
+    ASSERT(is_valid_instance(&instance));
+    const int32_t n = instance.num_customers + 1;
+
+    SolverParams params = {0};
+    CptpSession session = {0};
+    ASSERT(cptp_session_create(&session, &instance, "stub", &params, 1.0, 1));
+    ASSERT_FALSE(session.stale);
+
+    Solution solution = solution_create(&session.instance);
+    ASSERT_EQ(SOLVE_STATUS_NULL,
+              cptp_session_solve(&session, &solution, NULL));
+
+    double *profits = malloc(n * sizeof(*profits));
+    for (int32_t i = 0; i < n; i++) {
+        profits[i] = 10.0 * i;
+    }
+    ASSERT(cptp_session_update_profits(&session, profits));
+
+    // The stub solver cannot update its profits in place
+    ASSERT(session.stale);
+    for (int32_t i = 0; i < n; i++) {
+        ASSERT_EQ(profits[i], session.instance.profits[i]);
+        ASSERT(instance.profits[i] != profits[i] || i == 0);
+    }
+
+    ASSERT_EQ(SOLVE_STATUS_NULL,
+              cptp_session_solve(&session, &solution, NULL));
+    ASSERT_FALSE(session.stale);
+    ASSERT(session.solver.solve);
+
+    free(profits);
+    solution_destroy(&solution);
+    cptp_session_destroy(&session);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST session_with_unknown_solver(void) {
+    Instance instance = parse("data/CVRP/toy.vrp");
+    SolverParams params = {0};
+    CptpSession session = {0};
+    ASSERT_FALSE(cptp_session_create(&session, &instance, "does-not-exist",
+                                     &params, 1.0, 1));
+    ASSERT_FALSE(session.solver.solve);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST default_num_threads(void) {
+    SolverParams params = {0};
+    char buf[16];
+
+    // Neither the stub nor an unknown solver take a `NUM_THREADS`
+    ASSERT_FALSE(solver_params_default_num_threads(&params, "stub", 4, buf,
+                                                   sizeof(buf)));
+    ASSERT_FALSE(solver_params_default_num_threads(&params, "does-not-exist",
+                                                   4, buf, sizeof(buf)));
+    ASSERT_EQ(0, params.num_params);
+
+#if COMPILED_WITH_CPLEX
+    ASSERT(solver_params_default_num_threads(&params, "mip", 4, buf,
+                                             sizeof(buf)));
+    ASSERT_EQ(1, params.num_params);
+    ASSERT_STR_EQ("NUM_THREADS", params.params[0].name);
+    ASSERT_STR_EQ("4", params.params[0].value);
+
+    // An explicit value is never overridden
+    params.params[0].value = "2";
+    ASSERT_FALSE(solver_params_default_num_threads(&params, "mip", 4, buf,
+                                                   sizeof(buf)));
+    ASSERT_EQ(1, params.num_params);
+    ASSERT_STR_EQ("2", params.params[0].value);
+#endif
+    PASS();
+}
+
+static bool create_portfolio_ex(const Instance *instance, const char *members,
+                                bool heur_pricer_mode, double timelimit,
+                                CptpSession *session) {
+    SolverParams params = {0};
+    params.num_params = 2;
+    params.params[0].name = "SOLVERS";
+    params.params[0].value = members;
+    params.params[1].name = "HEUR_PRICER_MODE";
+    params.params[1].value = heur_pricer_mode ? "true" : "false";
+    return cptp_session_create(session, instance, "portfolio", &params,
+                               timelimit, 1);
+}
+
+static bool create_portfolio(const Instance *instance, const char *members,
+                             CptpSession *session) {
+    return create_portfolio_ex(instance, members, false, 1.0, session);
+}
+
+/// Solves the toy instance with the given portfolio, where the customers 1
+/// and 3 are worth `profit` each. The stubs report the routes `0 -> 1 -> 0`
+/// (ROUTE_LEN=1, cost 42) and `0 -> 1 -> 3 -> 0` (ROUTE_LEN=2, cost 57).
+static SolveStatus solve_toy_portfolio(const char *members,
+                                       bool heur_pricer_mode, double timelimit,
+                                       double profit, Solution *solution,
+                                       double *elapsed) {
+    SolveStatus status = SOLVE_STATUS_ERR;
+    Instance instance = parse("data/CVRP/toy.vrp");
+    for (int32_t i = 0; i <= instance.num_customers; i++) {
+        instance.profits[i] = (i == 1 || i == 3) ? profit : 0.0;
+    }
+
+    CptpSession session = {0};
+    if (create_portfolio_ex(&instance, members, heur_pricer_mode, timelimit,
+                            &session)) {
+        *solution = solution_create(&session.instance);
+        solution_reserve_columns(solution, 4);
+        int64_t begin_time = os_get_usecs();
+        status = cptp_session_solve(&session, solution, NULL);
+        *elapsed = os_get_elapsed_secs(begin_time);
+        cptp_session_destroy(&session);
+    }
+
+    instance_destroy(&instance);
+    return status;
+}
+
+TEST portfolio_of_stubs(void) {
+    Instance instance = parse("data/CVRP/toy.vrp");
+    ASSERT(is_valid_instance(&instance));
+
+    CptpSession session = {0};
+    ASSERT(create_portfolio(&instance, "stub,stub,stub", &session));
+    Solution solution = solution_create(&session.instance);
+    ASSERT_EQ(SOLVE_STATUS_NULL,
+              cptp_session_solve(&session, &solution, NULL));
+
+    // Solving again reuses the same members
+    ASSERT_EQ(SOLVE_STATUS_NULL,
+              cptp_session_solve(&session, &solution, NULL));
+
+    solution_destroy(&solution);
+    cptp_session_destroy(&session);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST portfolio_with_invalid_members(void) {
+    Instance instance = parse("data/CVRP/toy.vrp");
+    CptpSession session = {0};
+    ASSERT_FALSE(create_portfolio(&instance, "stub,does-not-exist", &session));
+    ASSERT_FALSE(create_portfolio(&instance, "stub,portfolio", &session));
+    ASSERT_FALSE(create_portfolio(&instance, "stub:NOVALUE", &session));
+    ASSERT_FALSE(create_portfolio(&instance, "", &session));
+    ASSERT_FALSE(session.solver.solve);
+
+#if !COMPILED_WITH_CPLEX
+    // The default members need CPLEX
+    SolverParams params = {0};
+    ASSERT_FALSE(cptp_session_create(&session, &instance, "portfolio",
+                                     &params, 1.0, 1));
+#endif
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST portfolio_combines_results(void) {
+    Solution solution = {0};
+    double elapsed = 0.0;
+
+    // The best tour and the best dual bound, possibly of different members
+    SolveStatus status = solve_toy_portfolio(
+        "stub:ROUTE_LEN=2:DUAL_BOUND=-300,stub:ROUTE_LEN=1:DUAL_BOUND=-500,"
+        "stub",
+        false, 1.0, 0.0, &solution, &elapsed);
+    ASSERT_EQ(SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL, status);
+    ASSERT_EQ(42.0, solution.primal_bound);
+    ASSERT_EQ(-300.0, solution.dual_bound);
+    ASSERT_EQ(1, solution.tour.succ[0]);
+    ASSERT_EQ(0, solution.tour.succ[1]);
+    solution_destroy(&solution);
+
+    // The member which closed the problem wins, even over a better tour
+    status = solve_toy_portfolio(
+        "stub:ROUTE_LEN=1,stub:ROUTE_LEN=2:CLOSE_PROBLEM=true", false, 1.0,
+        0.0, &solution, &elapsed);
+    ASSERT(status & SOLVE_STATUS_CLOSED_PROBLEM);
+    ASSERT(status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL);
+    ASSERT_EQ(57.0, solution.primal_bound);
+    ASSERT_EQ(57.0, solution.dual_bound);
+    ASSERT_EQ(1, solution.tour.succ[0]);
+    ASSERT_EQ(3, solution.tour.succ[1]);
+    ASSERT_EQ(0, solution.tour.succ[3]);
+    solution_destroy(&solution);
+
+    // Members failing to report anything do not spoil the others
+    status = solve_toy_portfolio("stub,stub:ROUTE_LEN=1", false, 1.0, 0.0,
+                                 &solution, &elapsed);
+    ASSERT_EQ(SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL, status);
+    ASSERT_EQ(42.0, solution.primal_bound);
+    ASSERT_EQ(-INFINITY, solution.dual_bound);
+    solution_destroy(&solution);
+    PASS();
+}
+
+TEST portfolio_race(void) {
+    Solution solution = {0};
+    double elapsed = 0.0;
+
+    // Closing the problem cancels the members still searching
+    SolveStatus status = solve_toy_portfolio(
+        "stub:WAIT_FOR_CANCEL=true,stub:ROUTE_LEN=2:CLOSE_PROBLEM=true", false,
+        30.0, 0.0, &solution, &elapsed);
+    ASSERT(status & SOLVE_STATUS_CLOSED_PROBLEM);
+    ASSERT(elapsed < 10.0);
+    solution_destroy(&solution);
+
+    // Otherwise the race lasts until the time limit
+    status = solve_toy_portfolio("stub:WAIT_FOR_CANCEL=true,stub:ROUTE_LEN=2",
+                                 false, 0.2, 100.0, &solution, &elapsed);
+    ASSERT_EQ(SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL |
+                  SOLVE_STATUS_ABORTION_RES_EXHAUSTED,
+              status);
+    ASSERT(elapsed >= 0.2);
+    solution_destroy(&solution);
+    PASS();
+}
+
+TEST portfolio_heur_pricer_mode(void) {
+    Solution solution = {0};
+    double elapsed = 0.0;
+
+    // The first column (route of negative reduced cost) cancels the other
+    // members, which do not reach their time limit
+    SolveStatus status =
+        solve_toy_portfolio("stub:WAIT_FOR_CANCEL=true,stub:ROUTE_LEN=2",
+                            true, 30.0, 100.0, &solution, &elapsed);
+    ASSERT_EQ(SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL, status);
+    ASSERT_EQ(57.0 - 200.0, solution.primal_bound);
+    ASSERT_EQ(1, solution.columns.num_columns);
+    ASSERT(elapsed < 10.0);
+    solution_destroy(&solution);
+
+    // A route which is not a column does not decide the race
+    status = solve_toy_portfolio("stub:WAIT_FOR_CANCEL=true,stub:ROUTE_LEN=2",
+                                 true, 0.2, 0.0, &solution, &elapsed);
+    ASSERT_EQ(SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL |
+                  SOLVE_STATUS_ABORTION_RES_EXHAUSTED,
+              status);
+    ASSERT_EQ(57.0, solution.primal_bound);
+    ASSERT_EQ(0, solution.columns.num_columns);
+    ASSERT(elapsed >= 0.2);
+    solution_destroy(&solution);
+    PASS();
+}
+
+TEST portfolio_shared_incumbent(void) {
+    Solution solution = {0};
+    double elapsed = 0.0;
+
+    // Without the shared incumbent the worse route closes the problem
+    SolveStatus status = solve_toy_portfolio(
+        "stub:ROUTE_LEN=2,stub:ROUTE_LEN=1:CLOSE_PROBLEM=true", false, 30.0,
+        50.0, &solution, &elapsed);
+    ASSERT(status & SOLVE_STATUS_CLOSED_PROBLEM);
+    ASSERT_EQ(42.0 - 50.0, solution.primal_bound);
+    solution_destroy(&solution);
+
+    // The tour of the first member prunes the worse route of the second one
+    status = solve_toy_portfolio(
+        "stub:ROUTE_LEN=2,stub:ROUTE_LEN=1:CLOSE_PROBLEM=true:"
+        "SHARED_INCUMBENT=true",
+        false, 30.0, 50.0, &solution, &elapsed);
+    ASSERT_EQ(SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL, status);
+    ASSERT_EQ(57.0 - 100.0, solution.primal_bound);
+    ASSERT(elapsed < 10.0);
+    solution_destroy(&solution);
+
+    // A route improving on the shared incumbent is still reported
+    status = solve_toy_portfolio(
+        "stub:ROUTE_LEN=1,stub:ROUTE_LEN=2:CLOSE_PROBLEM=true:"
+        "SHARED_INCUMBENT=true",
+        false, 30.0, 50.0, &solution, &elapsed);
+    ASSERT(status & SOLVE_STATUS_CLOSED_PROBLEM);
+    ASSERT_EQ(57.0 - 100.0, solution.primal_bound);
+    ASSERT(elapsed < 10.0);
+    solution_destroy(&solution);
+    PASS();
+}
+
 /* Add all the definitions that need to be in the test runner's main file. */
 GREATEST_MAIN_DEFS();
 
@@ -68,6 +517,19 @@ int main(int argc, char **argv) {
     /* If tests are run outside of a suite, a default suite is used. */
     RUN_TEST(tour_creation);
     RUN_TEST(calling_sxpos);
+    RUN_TEST(instance_arena_layout);
+    RUN_TEST(instance_view_shares_geometry);
+    RUN_TEST(instance_view_of_explicit_instance);
+    RUN_TEST(column_pool);
+    RUN_TEST(session_update_profits);
+    RUN_TEST(session_with_unknown_solver);
+    RUN_TEST(default_num_threads);
+    RUN_TEST(portfolio_of_stubs);
+    RUN_TEST(portfolio_with_invalid_members);
+    RUN_TEST(portfolio_combines_results);
+    RUN_TEST(portfolio_race);
+    RUN_TEST(portfolio_heur_pricer_mode);
+    RUN_TEST(portfolio_shared_incumbent);
 
     GREATEST_MAIN_END(); /* display results */
 }
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2021 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "parser.h"
+#include "core.h"
+#include "core-utils.h"
+#include "render.h"
+
+static const DistanceRounding ROUNDING_STRATS[] = {
+    CPTP_DIST_ROUND,
+    CPTP_DIST_NO_ROUND,
+    CPTP_DIST_CEIL,
+    CPTP_DIST_FLOOR,
+};
+
+TEST dist_cache_matches_uncached_distances(void) {
+    Instance instance =
+        parse("data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp");
+    ASSERT(instance.positions);
+    const int32_t n = instance.num_customers + 1;
+
+    for (int32_t r = 0; r < ARRAY_LEN_i32(ROUNDING_STRATS); r++) {
+        Instance uncached = instance_copy(&instance, true, true);
+        instance_drop_dist_cache(&uncached);
+        uncached.rounding_strat = ROUNDING_STRATS[r];
+        instance.rounding_strat = ROUNDING_STRATS[r];
+
+        ASSERT(instance_build_dist_cache(&instance));
+        ASSERT(instance.dist_cache);
+        ASSERT_EQ(0, (uintptr_t)instance.dist_cache % CACHE_LINE_SIZE);
+
+        for (int32_t i = 0; i < n; i++) {
+            for (int32_t j = 0; j < n; j++) {
+                ASSERT_EQ(cptp_dist(&uncached, i, j),
+                          cptp_dist(&instance, i, j));
+            }
+        }
+        instance_destroy(&uncached);
+    }
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST dist_cache_is_not_built_for_explicit_instances(void) {
+    Vec2d positions[3] = {{0, 0}, {3, 4}, {6, 8}};
+    double edge_weight[3] = {1.0, 2.0, 3.0};
+
+    Instance instance = {0};
+    instance.num_customers = 2;
+    instance.positions = positions;
+    instance.edge_weight = edge_weight;
+
+    ASSERT_FALSE(instance_build_dist_cache(&instance));
+    ASSERT_EQ(NULL, instance.dist_cache);
+    ASSERT_EQ(2.0, cptp_dist(&instance, 0, 2));
+    PASS();
+}
+
+TEST dist_cache_storage_follows_rounding(void) {
+    Instance instance =
+        parse("data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp");
+    ASSERT(instance.positions);
+
+    for (int32_t r = 0; r < ARRAY_LEN_i32(ROUNDING_STRATS); r++) {
+        instance.rounding_strat = ROUNDING_STRATS[r];
+        ASSERT(instance_build_dist_cache(&instance));
+        if (ROUNDING_STRATS[r] == CPTP_DIST_NO_ROUND) {
+            ASSERT_EQ(CPTP_DIST_STORAGE_F64, instance.dist_cache_storage);
+        } else {
+            ASSERT_EQ(CPTP_DIST_STORAGE_I32, instance.dist_cache_storage);
+        }
+    }
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+static Instance make_explicit_instance(int32_t num_customers,
+                                       double (*weight_fn)(int32_t i,
+                                                           int32_t j)) {
+    const int32_t n = num_customers + 1;
+    Instance instance = {0};
+    instance_set_name(&instance, "explicit");
+    instance.num_customers = num_customers;
+    instance.num_vehicles = 1;
+    instance.vehicle_cap = 100.0;
+    instance_alloc(&instance, true);
+
+    for (int32_t i = 1; i < n; i++) {
+        instance.demands[i] = 1.0;
+        instance.profits[i] = i * 0.5;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            instance.edge_weight[sxpos(n, i, j)] = weight_fn(i, j);
+        }
+    }
+    return instance;
+}
+
+static double integral_weight(int32_t i, int32_t j) { return i * 7 + j * 3; }
+static double decimal_weight(int32_t i, int32_t j) {
+    return (i * 1013 - j * 7) / 1000.0;
+}
+static double irrational_weight(int32_t i, int32_t j) {
+    return sqrt(i + 2.0) * sqrt(j + 3.0);
+}
+
+static greatest_test_res check_compaction(double (*weight_fn)(int32_t i,
+                                                              int32_t j),
+                                          DistStorage expected_storage,
+                                          double expected_scale) {
+    const int32_t num_customers = 40;
+    const int32_t n = num_customers + 1;
+
+    Instance instance = make_explicit_instance(num_customers, weight_fn);
+    bool compacted = instance_compact_edge_weight(&instance);
+
+    ASSERT_EQ(expected_storage != CPTP_DIST_STORAGE_F64, compacted);
+    ASSERT_EQ(expected_storage, instance.edge_weight_storage);
+    if (expected_storage == CPTP_DIST_STORAGE_I32) {
+        ASSERT_EQ(expected_scale, instance.edge_weight_scale);
+    }
+
+    // Values must be recovered exactly, including through instance_copy
+    Instance copy = instance_copy(&instance, true, true);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(weight_fn(i, j), cptp_dist(&instance, i, j));
+            ASSERT_EQ(weight_fn(i, j), cptp_dist(&copy, j, i));
+        }
+    }
+
+    // Rendering and parsing back must yield the same distances
+    const char *filepath = "test-dist-storage-roundtrip.vrp";
+    FILE *fh = fopen(filepath, "w");
+    ASSERT(fh);
+    render_instance_into_vrplib_file(fh, &instance, true);
+    fclose(fh);
+
+    Instance parsed = parse(filepath);
+    remove(filepath);
+    ASSERT(is_valid_instance(&parsed));
+    ASSERT(parsed.edge_weight);
+    ASSERT_EQ(expected_storage, parsed.edge_weight_storage);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(weight_fn(i, j), cptp_dist(&parsed, i, j));
+        }
+    }
+
+    instance_destroy(&parsed);
+    instance_destroy(&copy);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST edge_weight_compaction(void) {
+    CHECK_CALL(check_compaction(integral_weight, CPTP_DIST_STORAGE_I32, 1.0));
+    CHECK_CALL(
+        check_compaction(decimal_weight, CPTP_DIST_STORAGE_I32, 1000.0));
+    CHECK_CALL(check_compaction(irrational_weight, CPTP_DIST_STORAGE_F64, 0.0));
+    PASS();
+}
+
+static double insertion_dist_sum(const Instance *instance) {
+    const int32_t n = instance->num_customers + 1;
+    double sum = 0.0;
+
+    // Mimics the insertion heuristic access pattern: c_ah + c_hb - c_ab
+    for (int32_t h = 1; h < n; h++) {
+        for (int32_t a = 0; a < n; a++) {
+            int32_t b = (a + 1) % n;
+            if (a != h && b != h) {
+                sum += cptp_dist(instance, a, h) + cptp_dist(instance, h, b) -
+                       cptp_dist(instance, a, b);
+            }
+        }
+    }
+    return sum;
+}
+
+TEST dist_cache_preserves_insertion_sums(void) {
+    Instance instance =
+        parse("data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp");
+    ASSERT(instance.positions);
+
+    instance_drop_dist_cache(&instance);
+    double uncached_sum = insertion_dist_sum(&instance);
+    ASSERT(instance_build_dist_cache(&instance));
+    double cached_sum = insertion_dist_sum(&instance);
+    ASSERT_EQ(uncached_sum, cached_sum);
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    RUN_TEST(dist_cache_matches_uncached_distances);
+    RUN_TEST(dist_cache_is_not_built_for_explicit_instances);
+    RUN_TEST(dist_cache_storage_follows_rounding);
+    RUN_TEST(edge_weight_compaction);
+    RUN_TEST(dist_cache_preserves_insertion_sums);
+
+    GREATEST_MAIN_END(); /* display results */
+}
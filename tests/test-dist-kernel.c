@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "parser.h"
+#include "core.h"
+#include "core-utils.h"
+#include "dist-kernel.h"
+
+static const DistanceRounding ROUNDING_STRATS[] = {
+    CPTP_DIST_ROUND,
+    CPTP_DIST_NO_ROUND,
+    CPTP_DIST_CEIL,
+    CPTP_DIST_FLOOR,
+};
+
+static const DistKernelIsa ISAS[] = {
+    DIST_KERNEL_ISA_SCALAR,
+    DIST_KERNEL_ISA_AVX2,
+    DIST_KERNEL_ISA_AVX512,
+};
+
+static greatest_test_res check_kernels_against_cptp_dist(Instance *instance) {
+    const int32_t n = instance->num_customers + 1;
+    double *row = malloc(n * sizeof(*row));
+
+    for (int32_t r = 0; r < ARRAY_LEN_i32(ROUNDING_STRATS); r++) {
+        instance->rounding_strat = ROUNDING_STRATS[r];
+
+        for (int32_t k = 0; k < ARRAY_LEN_i32(ISAS); k++) {
+            DistRowKernel kernel =
+                dist_row_kernel_for_isa(ISAS[k], ROUNDING_STRATS[r]);
+            if (!kernel) {
+                // Not supported by the running CPU
+                continue;
+            }
+
+            for (int32_t i = 0; i < n; i++) {
+                // Odd ranges exercise the scalar remainder loops
+                int32_t jbegin = i % 3;
+                kernel(instance->positions, i, jbegin, n, row);
+                for (int32_t j = jbegin; j < n; j++) {
+                    double expected = i == j ? 0.0 : cptp_dist(instance, i, j);
+                    ASSERT_EQ(expected, row[j - jbegin]);
+                }
+            }
+        }
+    }
+
+    free(row);
+    PASS();
+}
+
+TEST dist_kernels_match_cptp_dist(void) {
+    Instance instance =
+        parse("data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp");
+    ASSERT(instance.positions);
+    instance_drop_dist_cache(&instance);
+
+    CHECK_CALL(check_kernels_against_cptp_dist(&instance));
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST dist_kernels_rounding_ties(void) {
+    // Distances from the first node land exactly on `.5` ties and on
+    // integral values, where the rounding modes disagree the most
+    Vec2d positions[] = {
+        {0.0, 0.0}, {0.5, 0.0}, {1.5, 0.0}, {2.5, 0.0}, {0.0, 3.5},
+        {3.0, 4.0}, {0.0, 0.25}, {7.5, 0.0}, {0.0, 1e6 + 0.5}, {2.0, 0.0},
+        {-0.5, 0.0}, {0.0, -2.5}, {6.0, 8.0},
+    };
+
+    Instance instance = {0};
+    instance.num_customers = ARRAY_LEN_i32(positions) - 1;
+    instance.positions = positions;
+
+    CHECK_CALL(check_kernels_against_cptp_dist(&instance));
+    PASS();
+}
+
+TEST dist_block_matches_cptp_dist(void) {
+    Instance instance =
+        parse("data/ESPPRC - Test Instances/vrps/E-n101-k14_a.vrp");
+    ASSERT(instance.positions);
+
+    const int32_t ibegin = 3, iend = 17, jbegin = 5, jend = 42;
+    const int64_t ld = 64;
+    double *block = malloc((iend - ibegin) * ld * sizeof(*block));
+
+    dist_block(&instance, ibegin, iend, jbegin, jend, block, ld);
+    for (int32_t i = ibegin; i < iend; i++) {
+        for (int32_t j = jbegin; j < jend; j++) {
+            double expected = i == j ? 0.0 : cptp_dist(&instance, i, j);
+            ASSERT_EQ(expected, block[(i - ibegin) * ld + (j - jbegin)]);
+        }
+    }
+
+    free(block);
+    instance_destroy(&instance);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    RUN_TEST(dist_kernels_match_cptp_dist);
+    RUN_TEST(dist_kernels_rounding_ties);
+    RUN_TEST(dist_block_matches_cptp_dist);
+
+    GREATEST_MAIN_END(); /* display results */
+}
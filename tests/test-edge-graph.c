@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "core.h"
+#include "core-utils.h"
+#include "edge-graph.h"
+
+#define NUM_CUSTOMERS 8
+#define NUM_NODES (NUM_CUSTOMERS + 1)
+#define NUM_RANDOM_INSTANCES 32
+
+typedef struct {
+    int32_t path[NUM_NODES];
+    double best_with_edge[NUM_NODES][NUM_NODES];
+    double best_cost;
+} BruteForceCtx;
+
+/// Enumerates every elementary tour from the depot serving at least two
+/// customers within the vehicle capacity, recording for each edge the
+/// cheapest tour using it.
+static void brute_force_rec(const Instance *instance, BruteForceCtx *ctx,
+                            int32_t len, uint32_t visited, double cost,
+                            double load) {
+    int32_t last = ctx->path[len - 1];
+
+    if (len >= 3) {
+        double total = cost + cptp_dist(instance, last, 0);
+        ctx->best_cost = MIN(ctx->best_cost, total);
+        for (int32_t k = 0; k < len; k++) {
+            int32_t a = ctx->path[k];
+            int32_t b = ctx->path[(k + 1) % len];
+            double *best = &ctx->best_with_edge[MIN(a, b)][MAX(a, b)];
+            *best = MIN(*best, total);
+        }
+    }
+
+    for (int32_t j = 1; j < NUM_NODES; j++) {
+        if ((visited >> j) & 1) {
+            continue;
+        }
+        double q = load + instance->demands[j];
+        if (q > instance->vehicle_cap) {
+            continue;
+        }
+        ctx->path[len] = j;
+        brute_force_rec(instance, ctx, len + 1, visited | (1u << j),
+                        cost + cptp_dist(instance, last, j) -
+                            instance->profits[j],
+                        q);
+    }
+}
+
+static void brute_force(const Instance *instance, BruteForceCtx *ctx) {
+    for (int32_t i = 0; i < NUM_NODES; i++)
+        for (int32_t j = 0; j < NUM_NODES; j++)
+            ctx->best_with_edge[i][j] = INFINITY;
+    ctx->best_cost = INFINITY;
+    ctx->path[0] = 0;
+    brute_force_rec(instance, ctx, 1, 1, 0.0, 0.0);
+}
+
+static Instance make_random_instance(void) {
+    Instance instance = {0};
+    instance.num_customers = NUM_CUSTOMERS;
+    instance.num_vehicles = 1;
+    instance.vehicle_cap = 50.0;
+    instance.rounding_strat = CPTP_DIST_ROUND;
+    instance_alloc(&instance, false);
+
+    for (int32_t i = 0; i < NUM_NODES; i++) {
+        instance.positions[i].x = rand() % 100;
+        instance.positions[i].y = rand() % 100;
+        if (i > 0) {
+            instance.demands[i] = 1 + rand() % 30;
+            instance.profits[i] = rand() % 120;
+        }
+    }
+
+    return instance;
+}
+
+static greatest_test_res check_csr(const EdgeGraph *graph) {
+    const int32_t n = graph->num_nodes;
+    ASSERT_EQ(0, graph->offsets[0]);
+    ASSERT_EQ(2 * graph->num_edges, graph->offsets[n]);
+
+    for (int32_t i = 0; i < n; i++) {
+        const int32_t *nbrs = edge_graph_neighbors(graph, i);
+        for (int32_t k = 0; k < edge_graph_degree(graph, i); k++) {
+            ASSERT(nbrs[k] != i);
+            if (k > 0) {
+                ASSERT(nbrs[k - 1] < nbrs[k]);
+            }
+            ASSERT(edge_graph_contains(graph, nbrs[k], i));
+        }
+    }
+    PASS();
+}
+
+TEST demand_elimination(void) {
+    srand(7);
+    Instance instance = make_random_instance();
+    instance.demands[3] = 45.0;
+    instance.demands[5] = 10.0;
+    instance.demands[6] = 5.0;
+
+    EdgeGraph graph = edge_graph_create(&instance, NULL);
+    ASSERT(graph.adj);
+    CHECK_CALL(check_csr(&graph));
+
+    int64_t expected_num_edges = 0;
+    for (int32_t i = 0; i < NUM_NODES; i++) {
+        for (int32_t j = i + 1; j < NUM_NODES; j++) {
+            bool fits = instance.demands[i] + instance.demands[j] <=
+                        instance.vehicle_cap;
+            ASSERT_EQ(fits, edge_graph_contains(&graph, i, j));
+            ASSERT_EQ(fits, edge_graph_contains(&graph, j, i));
+            expected_num_edges += fits;
+        }
+    }
+    ASSERT_EQ(expected_num_edges, graph.num_edges);
+    ASSERT(!edge_graph_contains(&graph, 3, 5));
+    ASSERT(edge_graph_contains(&graph, 3, 6));
+    ASSERT(edge_graph_contains(&graph, 0, 3));
+
+    edge_graph_destroy(&graph);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST reduced_cost_elimination_is_valid(void) {
+    BruteForceCtx *ctx = malloc(sizeof(*ctx));
+    int64_t total_removed = 0;
+
+    srand(42);
+    for (int32_t it = 0; it < NUM_RANDOM_INSTANCES; it++) {
+        Instance instance = make_random_instance();
+        brute_force(&instance, ctx);
+
+        // Pretend a primal tour slightly worse than the optimum is known
+        EdgeEliminationParams params = {0};
+        params.cutoff = ctx->best_cost + 10.0;
+
+        EdgeGraph graph = edge_graph_create(&instance, &params);
+        ASSERT(graph.adj);
+        CHECK_CALL(check_csr(&graph));
+
+        for (int32_t i = 0; i < NUM_NODES; i++) {
+            for (int32_t j = i + 1; j < NUM_NODES; j++) {
+                if (ctx->best_with_edge[i][j] < params.cutoff) {
+                    ASSERT(edge_graph_contains(&graph, i, j));
+                }
+            }
+        }
+
+        total_removed += hm_nentries(NUM_NODES) - graph.num_edges;
+        edge_graph_destroy(&graph);
+        instance_destroy(&instance);
+    }
+
+    ASSERT(total_removed > 0);
+
+    free(ctx);
+    PASS();
+}
+
+TEST lp_reduced_cost_elimination(void) {
+    srand(3);
+    Instance instance = make_random_instance();
+    for (int32_t i = 1; i < NUM_NODES; i++) {
+        instance.demands[i] = 1.0;
+    }
+
+    double lp_rc[hm_nentries(NUM_NODES)];
+    for (int32_t i = 0; i < NUM_NODES; i++) {
+        for (int32_t j = i + 1; j < NUM_NODES; j++) {
+            lp_rc[sxpos(NUM_NODES, i, j)] = (i + j) % 3 == 0 ? 100.0 : 0.0;
+        }
+    }
+
+    EdgeEliminationParams params = {0};
+    params.cutoff = -5.0;
+    params.lp_obj = -50.0;
+    params.lp_reduced_costs = lp_rc;
+
+    EdgeGraph graph = edge_graph_create(&instance, &params);
+    ASSERT(graph.adj);
+    CHECK_CALL(check_csr(&graph));
+
+    for (int32_t i = 0; i < NUM_NODES; i++) {
+        for (int32_t j = i + 1; j < NUM_NODES; j++) {
+            if ((i + j) % 3 == 0) {
+                ASSERT(!edge_graph_contains(&graph, i, j));
+            }
+        }
+    }
+
+    edge_graph_destroy(&graph);
+    instance_destroy(&instance);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    /* If tests are run outside of a suite, a default suite is used. */
+    RUN_TEST(demand_elimination);
+    RUN_TEST(reduced_cost_elimination_is_valid);
+    RUN_TEST(lp_reduced_cost_elimination);
+
+    GREATEST_MAIN_END(); /* display results */
+}
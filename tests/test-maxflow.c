@@ -470,6 +470,49 @@ TEST no_path_flow(void) {
     PASS();
 }
 
+TEST bipartition_to_bitset(void) {
+    int32_t nnodes = 70;
+    FlowNetwork net = {0};
+    MaxFlow mf = {0};
+    MaxFlowResult result = {0};
+
+    flow_network_create(&net, nnodes);
+    max_flow_create(&mf, nnodes, MAXFLOW_ALGO_PUSH_RELABEL);
+    max_flow_result_create(&result, nnodes);
+
+    // Single path network with a bottleneck between node 40 and 41
+    for (int32_t i = 0; i < nnodes - 1; i++) {
+        flow_t cap = i == 40 ? 1 : 10;
+        flow_net_set_cap(&net, i, i + 1, cap);
+        flow_net_set_cap(&net, i + 1, i, cap);
+    }
+
+    max_flow_single_pair(&net, &mf, 0, nnodes - 1, &result);
+
+    Bitset black = bitset_create(nnodes);
+    Bitset white = bitset_create(nnodes);
+    ASSERT_EQ(41, max_flow_result_to_bitset(&result, BLACK, &black));
+    ASSERT_EQ(nnodes - 41, max_flow_result_to_bitset(&result, WHITE, &white));
+
+    for (int32_t i = 0; i < nnodes; i++) {
+        ASSERT_EQ(result.colors[i] == BLACK, bitset_test(&black, i));
+        ASSERT_EQ(result.colors[i] == WHITE, bitset_test(&white, i));
+    }
+
+    Bitset complement = bitset_create(nnodes);
+    bitset_complement(&complement, &black);
+    ASSERT(bitset_equal(&complement, &white));
+
+    bitset_destroy(&complement);
+    bitset_destroy(&white);
+    bitset_destroy(&black);
+    max_flow_result_destroy(&result);
+    max_flow_destroy(&mf);
+    flow_network_destroy(&net);
+
+    PASS();
+}
+
 TEST single_path_flow(void) {
     for (int32_t nnodes = 2; nnodes < MAX_NUM_NODES_TO_TEST; nnodes++) {
         FlowNetwork net = {0};
@@ -636,6 +679,7 @@ int main(int argc, char **argv) {
     RUN_TEST(non_trivial_network2);
     RUN_TEST(non_trivial_network3);
     RUN_TEST(no_path_flow);
+    RUN_TEST(bipartition_to_bitset);
     RUN_TEST(single_path_flow);
     RUN_TEST(two_path_flow);
     RUN_TEST(random_networks);
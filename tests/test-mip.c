@@ -68,7 +68,7 @@ TEST solve_test_instances(void) {
         SolverParams params = {0};
         Solution solution = solution_create(&instance);
         SolveStatus status = cptp_solve(&instance, "mip", &params, &solution,
-                                        TIMELIMIT, RANDOMSEED);
+                                        TIMELIMIT, RANDOMSEED, NULL);
         const bool success = status != 0 &&
                              BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM) &&
                              !BOOL(status & SOLVE_STATUS_ERR);
@@ -89,6 +89,45 @@ TEST solve_test_instances(void) {
     PASS();
 }
 
+TEST session_matches_fresh_solves(void) {
+    Instance instance = parse(G_TEST_INSTANCES[0].filepath);
+    ASSERT(is_valid_instance(&instance));
+    const int32_t n = instance.num_customers + 1;
+    const double scales[] = {1.0, 0.5, 1.5, 1.0};
+
+    SolverParams params = {0};
+    CptpSession session = {0};
+    ASSERT(cptp_session_create(&session, &instance, "mip", &params, TIMELIMIT,
+                               RANDOMSEED));
+    double *profits = malloc(n * sizeof(*profits));
+    Solution solution = solution_create(&session.instance);
+
+    for (int32_t s = 0; s < ARRAY_LEN_i32(scales); s++) {
+        for (int32_t i = 0; i < n; i++) {
+            profits[i] = scales[s] * instance.profits[i];
+        }
+        ASSERT(cptp_session_update_profits(&session, profits));
+        // The MIP solver applies the new profits in place
+        ASSERT_FALSE(session.stale);
+
+        SolveStatus status = cptp_session_solve(&session, &solution, NULL);
+        ASSERT(BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM));
+
+        Solution expected = solution_create(&session.instance);
+        status = cptp_solve(&session.instance, "mip", &params, &expected,
+                            TIMELIMIT, RANDOMSEED, NULL);
+        ASSERT(BOOL(status & SOLVE_STATUS_CLOSED_PROBLEM));
+        ASSERT(feq(solution.primal_bound, expected.primal_bound, 1e-3));
+        solution_destroy(&expected);
+    }
+
+    solution_destroy(&solution);
+    free(profits);
+    cptp_session_destroy(&session);
+    instance_destroy(&instance);
+    PASS();
+}
+
 #endif
 
 GREATEST_MAIN_DEFS();
@@ -100,6 +139,7 @@ int main(int argc, char **argv) {
 #if COMPILED_WITH_CPLEX
     RUN_TEST(creation);
     RUN_TEST(solve_test_instances);
+    RUN_TEST(session_matches_fresh_solves);
 #endif
     GREATEST_MAIN_END(); /* display results */
 }
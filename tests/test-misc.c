@@ -82,6 +82,162 @@ TEST calling_enum_lookup(void) {
     PASS();
 }
 
+TEST bitset_basic_operations(void) {
+    Bitset bs = bitset_create(130);
+    ASSERT(bs.words);
+    ASSERT_EQ(3, bs.nwords);
+    ASSERT_EQ(0, bitset_popcount(&bs));
+    ASSERT_EQ(-1, bitset_next(&bs, 0));
+
+    int32_t expected[] = {0, 5, 63, 64, 65, 127, 128, 129};
+    for (int32_t i = 0; i < ARRAY_LEN_i32(expected); i++)
+        bitset_set(&bs, expected[i]);
+
+    ASSERT_EQ(ARRAY_LEN_i32(expected), bitset_popcount(&bs));
+
+    int32_t cnt = 0;
+    BITSET_FOREACH(&bs, i) {
+        ASSERT(cnt < ARRAY_LEN_i32(expected));
+        ASSERT_EQ(expected[cnt], i);
+        ++cnt;
+    }
+    ASSERT_EQ(ARRAY_LEN_i32(expected), cnt);
+
+    ASSERT_EQ(63, bitset_next(&bs, 6));
+    ASSERT_EQ(127, bitset_next(&bs, 66));
+    ASSERT_EQ(-1, bitset_next(&bs, 130));
+
+    bitset_unset(&bs, 64);
+    ASSERT(!bitset_test(&bs, 64));
+    ASSERT(bitset_test(&bs, 65));
+
+    Bitset complement = bitset_create(130);
+    bitset_complement(&complement, &bs);
+    ASSERT_EQ(130 - bitset_popcount(&bs), bitset_popcount(&complement));
+
+    bitset_clear(&bs);
+    ASSERT_EQ(0, bitset_popcount(&bs));
+
+    bitset_destroy(&complement);
+    bitset_destroy(&bs);
+    PASS();
+}
+
+TEST bitset_set_operations(void) {
+    enum { NBITS = 200 };
+    bool ref_a[NBITS], ref_b[NBITS];
+
+    Bitset a = bitset_create(NBITS);
+    Bitset b = bitset_create(NBITS);
+    Bitset u = bitset_create(NBITS);
+    Bitset x = bitset_create(NBITS);
+
+    srand(17);
+    for (int32_t it = 0; it < 64; it++) {
+        bitset_clear(&a);
+        bitset_clear(&b);
+        for (int32_t i = 0; i < NBITS; i++) {
+            ref_a[i] = rand() % 3 == 0;
+            ref_b[i] = rand() % 2 == 0;
+            if (ref_a[i])
+                bitset_set(&a, i);
+            if (ref_b[i])
+                bitset_set(&b, i);
+        }
+
+        bitset_union(&u, &a, &b);
+        bitset_intersection(&x, &a, &b);
+
+        int32_t ucnt = 0, xcnt = 0;
+        for (int32_t i = 0; i < NBITS; i++) {
+            ASSERT_EQ(ref_a[i] || ref_b[i], bitset_test(&u, i));
+            ASSERT_EQ(ref_a[i] && ref_b[i], bitset_test(&x, i));
+            ucnt += ref_a[i] || ref_b[i];
+            xcnt += ref_a[i] && ref_b[i];
+        }
+        ASSERT_EQ(ucnt, bitset_popcount(&u));
+        ASSERT_EQ(xcnt, bitset_popcount(&x));
+    }
+
+    bitset_destroy(&x);
+    bitset_destroy(&u);
+    bitset_destroy(&b);
+    bitset_destroy(&a);
+    PASS();
+}
+
+TEST bitset_equality_and_hashing(void) {
+    Bitset a = bitset_create(100);
+    Bitset b = bitset_create(100);
+
+    ASSERT(bitset_equal(&a, &b));
+    ASSERT_EQ(bitset_hash(&a), bitset_hash(&b));
+
+    bitset_set(&a, 3);
+    bitset_set(&a, 99);
+    ASSERT(!bitset_equal(&a, &b));
+    ASSERT(bitset_hash(&a) != bitset_hash(&b));
+
+    Bitset c = bitset_copy(&a);
+    ASSERT(bitset_equal(&a, &c));
+    ASSERT_EQ(bitset_hash(&a), bitset_hash(&c));
+
+    // Every single bit set must hash differently
+    uint64_t hashes[100];
+    for (int32_t i = 0; i < 100; i++) {
+        bitset_clear(&b);
+        bitset_set(&b, i);
+        hashes[i] = bitset_hash(&b);
+        for (int32_t j = 0; j < i; j++)
+            ASSERT(hashes[i] != hashes[j]);
+    }
+
+    // Complementing twice is the identity, also on the padding bits
+    Bitset d = bitset_create(100);
+    bitset_complement(&d, &a);
+    bitset_complement(&d, &d);
+    ASSERT(bitset_equal(&a, &d));
+    ASSERT_EQ(bitset_hash(&a), bitset_hash(&d));
+
+    bitset_destroy(&d);
+    bitset_destroy(&c);
+    bitset_destroy(&b);
+    bitset_destroy(&a);
+    PASS();
+}
+
+TEST rng_is_reproducible(void) {
+    Rng a = rng_create(42);
+    Rng b = rng_create(42);
+    Rng c = rng_create(43);
+    bool any_different = false;
+
+    for (int32_t i = 0; i < 1000; i++) {
+        uint64_t x = rng_next(&a);
+        ASSERT_EQ(x, rng_next(&b));
+        any_different |= x != rng_next(&c);
+    }
+    ASSERT(any_different);
+    PASS();
+}
+
+TEST rng_next_int_in_range(void) {
+    Rng rng = rng_create(7);
+    int32_t hits[10] = {0};
+
+    for (int32_t i = 0; i < 10000; i++) {
+        int32_t x = rng_next_int(&rng, 10);
+        ASSERT(x >= 0 && x < 10);
+        hits[x]++;
+    }
+
+    for (int32_t i = 0; i < 10; i++) {
+        ASSERT_GT(hits[i], 0);
+    }
+    ASSERT_EQ(0, rng_next_int(&rng, 1));
+    PASS();
+}
+
 /* Add all the definitions that need to be in the test runner's main file. */
 GREATEST_MAIN_DEFS();
 
@@ -94,6 +250,11 @@ int main(int argc, char **argv) {
     RUN_TEST(calling_calloc_0_0);
     RUN_TEST(calling_malloc_0);
     RUN_TEST(calling_enum_lookup);
+    RUN_TEST(bitset_basic_operations);
+    RUN_TEST(bitset_set_operations);
+    RUN_TEST(bitset_equality_and_hashing);
+    RUN_TEST(rng_is_reproducible);
+    RUN_TEST(rng_next_int_in_range);
 
     GREATEST_MAIN_END(); /* display results */
 }
@@ -30,6 +30,8 @@
 
 #include "parser.h"
 #include "misc.h"
+#include "render.h"
+#include "core-utils.h"
 #include "instances.h"
 
 TEST validate_instance(Instance *instance, int32_t expected_num_customers,
@@ -104,6 +106,214 @@ TEST parsing_all_instances(void) {
     PASS();
 }
 
+static bool write_binary(const char *filepath, const Instance *instance) {
+    FILE *fh = fopen(filepath, "wb");
+    if (!fh) {
+        return false;
+    }
+    bool result = render_instance_into_binary_file(fh, instance);
+    return (0 == fclose(fh)) && result;
+}
+
+static greatest_test_res check_binary_round_trip(const Instance *instance) {
+    const char *filepath = "test-parser-roundtrip." CPTP_BINARY_FEXT;
+    ASSERT(write_binary(filepath, instance));
+    Instance loaded = parse(filepath);
+    remove(filepath);
+
+    const int32_t n = instance->num_customers + 1;
+    ASSERT(is_valid_instance(&loaded));
+    ASSERT_STR_EQ(instance->name, loaded.name);
+    ASSERT_EQ(instance->num_customers, loaded.num_customers);
+    ASSERT_EQ(instance->num_vehicles, loaded.num_vehicles);
+    ASSERT_EQ(instance->vehicle_cap, loaded.vehicle_cap);
+    ASSERT_EQ(instance->rounding_strat, loaded.rounding_strat);
+    ASSERT_MEM_EQ(instance->positions, loaded.positions,
+                  n * sizeof(*instance->positions));
+    ASSERT_MEM_EQ(instance->demands, loaded.demands,
+                  n * sizeof(*instance->demands));
+    ASSERT_MEM_EQ(instance->profits, loaded.profits,
+                  n * sizeof(*instance->profits));
+
+    ASSERT_EQ(instance->edge_weight != NULL, loaded.edge_weight != NULL);
+    ASSERT_EQ(instance->edge_weight_storage, loaded.edge_weight_storage);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(cptp_dist(instance, i, j), cptp_dist(&loaded, i, j));
+        }
+    }
+
+    instance_destroy(&loaded);
+    PASS();
+}
+
+/// An explicit instance whose triangle is compacted to fixed point
+static bool create_fixed_point_instance(Instance *instance) {
+    instance->num_customers = 30;
+    instance->num_vehicles = 2;
+    instance->vehicle_cap = 10.0;
+    if (!instance_alloc(instance, true)) {
+        return false;
+    }
+    const int32_t n = instance->num_customers + 1;
+    for (int32_t i = 0; i < n; i++) {
+        instance->demands[i] = i == 0 ? 0.0 : 1.0;
+        instance->profits[i] = 0.5 * i;
+        for (int32_t j = i + 1; j < n; j++) {
+            instance->edge_weight[sxpos(n, i, j)] = 0.25 * (i + j);
+        }
+    }
+    instance_set_name(instance, "explicit");
+    return instance_compact_edge_weight(instance) &&
+           instance->edge_weight_storage == CPTP_DIST_STORAGE_I32;
+}
+
+TEST binary_round_trip(void) {
+    for (int32_t i = 0; i < ARRAY_LEN_i32(G_TEST_INSTANCES); i++) {
+        Instance instance = parse(G_TEST_INSTANCES[i].filepath);
+        ASSERT(is_valid_instance(&instance));
+        CHECK_CALL(check_binary_round_trip(&instance));
+        instance_destroy(&instance);
+    }
+
+    // Explicit instance, with a compacted fixed point triangle
+    Instance instance = {0};
+    ASSERT(create_fixed_point_instance(&instance));
+    CHECK_CALL(check_binary_round_trip(&instance));
+    instance_destroy(&instance);
+    PASS();
+}
+
+static bool write_content(const char *filepath, const char *content,
+                          size_t size) {
+    FILE *fh = fopen(filepath, "wb");
+    if (!fh) {
+        return false;
+    }
+    bool result = fwrite(content, 1, size, fh) == size;
+    return (0 == fclose(fh)) && result;
+}
+
+/// Loads `content` with its header patched by `patch`. The content hash
+/// only covers the payload, so only the header validation stands in the way.
+static bool loads_with_header(const char *filepath, const char *content,
+                              size_t size,
+                              void (*patch)(CptpBinaryHeader *hdr)) {
+    char *patched = malloc(size);
+    if (!patched) {
+        return false;
+    }
+    memcpy(patched, content, size);
+    CptpBinaryHeader hdr;
+    memcpy(&hdr, patched, sizeof(hdr));
+    patch(&hdr);
+    memcpy(patched, &hdr, sizeof(hdr));
+
+    bool written = write_content(filepath, patched, size);
+    free(patched);
+    Instance loaded = parse(filepath);
+    bool result = written && loaded.positions != NULL;
+    instance_destroy(&loaded);
+    return result;
+}
+
+static void patch_nothing(CptpBinaryHeader *hdr) { (void)hdr; }
+static void patch_rounding(CptpBinaryHeader *hdr) { hdr->rounding_strat = 7; }
+static void patch_negative_rounding(CptpBinaryHeader *hdr) {
+    hdr->rounding_strat = -1;
+}
+static void patch_max_customers(CptpBinaryHeader *hdr) {
+    hdr->num_customers = INT32_MAX;
+}
+static void patch_many_customers(CptpBinaryHeader *hdr) {
+    hdr->num_customers = 1 << 30;
+}
+static void patch_zero_scale(CptpBinaryHeader *hdr) {
+    hdr->edge_weight_scale = 0.0;
+}
+static void patch_negative_scale(CptpBinaryHeader *hdr) {
+    hdr->edge_weight_scale = -4.0;
+}
+static void patch_fractional_scale(CptpBinaryHeader *hdr) {
+    hdr->edge_weight_scale = 0.5;
+}
+static void patch_nan_scale(CptpBinaryHeader *hdr) {
+    hdr->edge_weight_scale = NAN;
+}
+static void patch_infinite_scale(CptpBinaryHeader *hdr) {
+    hdr->edge_weight_scale = INFINITY;
+}
+
+TEST binary_corrupted(void) {
+    Instance instance = parse(G_TEST_INSTANCES[0].filepath);
+    ASSERT(is_valid_instance(&instance));
+
+    const char *filepath = "test-parser-corrupted." CPTP_BINARY_FEXT;
+    ASSERT(write_binary(filepath, &instance));
+    size_t size = 0;
+    char *content = fread_all_into_cstr(filepath, &size);
+    ASSERT(content && size > sizeof(CptpBinaryHeader));
+
+    // A flipped bit anywhere in the payload breaks the content hash
+    content[size - 1] ^= 1;
+    FILE *fh = fopen(filepath, "wb");
+    ASSERT(fh);
+    fwrite(content, 1, size, fh);
+    fclose(fh);
+    Instance loaded = parse(filepath);
+    ASSERT_FALSE(loaded.positions);
+
+    // Truncated payload
+    content[size - 1] ^= 1;
+    fh = fopen(filepath, "wb");
+    ASSERT(fh);
+    fwrite(content, 1, size - 8, fh);
+    fclose(fh);
+    loaded = parse(filepath);
+    ASSERT_FALSE(loaded.positions);
+
+    // Header fields out of range
+    ASSERT(loads_with_header(filepath, content, size, patch_nothing));
+    ASSERT_FALSE(loads_with_header(filepath, content, size, patch_rounding));
+    ASSERT_FALSE(
+        loads_with_header(filepath, content, size, patch_negative_rounding));
+    ASSERT_FALSE(
+        loads_with_header(filepath, content, size, patch_max_customers));
+    ASSERT_FALSE(
+        loads_with_header(filepath, content, size, patch_many_customers));
+
+    remove(filepath);
+    free(content);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST binary_corrupted_edge_weight_scale(void) {
+    Instance instance = {0};
+    ASSERT(create_fixed_point_instance(&instance));
+
+    const char *filepath = "test-parser-corrupted." CPTP_BINARY_FEXT;
+    ASSERT(write_binary(filepath, &instance));
+    size_t size = 0;
+    char *content = fread_all_into_cstr(filepath, &size);
+    ASSERT(content && size > sizeof(CptpBinaryHeader));
+
+    ASSERT(loads_with_header(filepath, content, size, patch_nothing));
+    ASSERT_FALSE(loads_with_header(filepath, content, size, patch_zero_scale));
+    ASSERT_FALSE(
+        loads_with_header(filepath, content, size, patch_negative_scale));
+    ASSERT_FALSE(
+        loads_with_header(filepath, content, size, patch_fractional_scale));
+    ASSERT_FALSE(loads_with_header(filepath, content, size, patch_nan_scale));
+    ASSERT_FALSE(
+        loads_with_header(filepath, content, size, patch_infinite_scale));
+
+    remove(filepath);
+    free(content);
+    instance_destroy(&instance);
+    PASS();
+}
+
 /* Add all the definitions that need to be in the test runner's main file. */
 GREATEST_MAIN_DEFS();
 
@@ -113,6 +323,9 @@ int main(int argc, char **argv) {
     /* If tests are run outside of a suite, a default suite is used. */
     RUN_TEST(parsing_single_instance);
     RUN_TEST(parsing_all_instances);
+    RUN_TEST(binary_round_trip);
+    RUN_TEST(binary_corrupted);
+    RUN_TEST(binary_corrupted_edge_weight_scale);
 
     GREATEST_MAIN_END(); /* display results */
 }
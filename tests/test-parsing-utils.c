@@ -432,6 +432,152 @@ TEST parsing_bool(void) {
     PASS();
 }
 
+static StrView view(const char *string, size_t len) {
+    return (StrView){string, len};
+}
+
+TEST parsing_views(void) {
+    int32_t ival = 0;
+    size_t uval = 0;
+    double dval = 0.0;
+
+    // Views need not be NUL terminated
+    ASSERT(strv_to_int32(view("12345", 3), &ival));
+    ASSERT_EQ(123, ival);
+    ASSERT(strv_to_usize(view("0xffzz", 4), &uval));
+    ASSERT_EQ(255, uval);
+    ASSERT(strv_to_double(view("1.5e3xyz", 5), &dval));
+    ASSERT_EQ(1500.0, dval);
+    ASSERT(strv_to_double(view("2.25 3", 4), &dval));
+    ASSERT_EQ(2.25, dval);
+    ASSERT_FALSE(strv_to_int32(view("12", 0), &ival));
+    ASSERT_FALSE(strv_to_double(view("1.0", 0), &dval));
+
+    // Integer limits
+    ASSERT(str_to_int32("2147483647", &ival));
+    ASSERT_EQ(INT32_MAX, ival);
+    ASSERT(str_to_int32("-2147483648", &ival));
+    ASSERT_EQ(INT32_MIN, ival);
+    ASSERT_FALSE(str_to_int32("2147483648", &ival));
+    ASSERT_FALSE(str_to_int32("-2147483649", &ival));
+    ASSERT_FALSE(str_to_int32("99999999999999999999", &ival));
+    ASSERT(str_to_usize("18446744073709551615", &uval));
+    ASSERT_EQ(SIZE_MAX, uval);
+    ASSERT_FALSE(str_to_usize("18446744073709551616", &uval));
+
+    // Hard cases handled by the exact slow path
+    ASSERT(str_to_double("0.1", &dval));
+    ASSERT_EQ(0.1, dval);
+    ASSERT(str_to_double("123456789012345678901234567890", &dval));
+    ASSERT_EQ(123456789012345678901234567890.0, dval);
+    ASSERT(str_to_double("9007199254740993", &dval));
+    ASSERT_EQ(9007199254740992.0, dval);
+    ASSERT(str_to_double("2.2250738585072014e-308", &dval));
+    ASSERT_EQ(2.2250738585072014e-308, dval);
+    ASSERT(str_to_double("1.7976931348623157e308", &dval));
+    ASSERT_EQ(1.7976931348623157e308, dval);
+    ASSERT(str_to_double("0x1p3", &dval));
+    ASSERT_EQ(8.0, dval);
+    ASSERT_FALSE(str_to_double("1e400", &dval));
+    ASSERT_FALSE(str_to_double("1e", &dval));
+    ASSERT_FALSE(str_to_double("1e+", &dval));
+    ASSERT_FALSE(str_to_double(".", &dval));
+    ASSERT_FALSE(str_to_double("1.0ff", &dval));
+    ASSERT_FALSE(str_to_double("1,5", &dval));
+
+    // The sign of zero is preserved
+    ASSERT(str_to_double("-0.0", &dval));
+    ASSERT(dval == 0.0 && signbit(dval));
+    ASSERT(str_to_double("0000.000e5", &dval));
+    ASSERT(dval == 0.0 && !signbit(dval));
+    PASS();
+}
+
+/// Parses `string` with `strtod`, as done before the in-place parsers
+static double reference_strtod(const char *string) {
+    char *endptr = NULL;
+    return strtod(string, &endptr);
+}
+
+TEST parsing_double_round_trip(void) {
+    static const char *FORMATS[] = {"%.17g", "%.3f", "%g", "%.0f", "%.6e"};
+    Rng rng = rng_create(42);
+    // Large enough for `%.0f` of DBL_MAX
+    char buf[512];
+
+    for (int32_t i = 0; i < 100000; i++) {
+        // Mixes coordinates, demands and edge weights like magnitudes with
+        // arbitrary bit patterns
+        double x = 0.0;
+        switch (i % 3) {
+        case 0:
+            x = (double)(rng_next(&rng) >> 11) * 0x1.0p-53 * 1e4;
+            break;
+        case 1:
+            x = (double)rng_next_int(&rng, 1000000) / 1000.0;
+            break;
+        default: {
+            uint64_t bits = rng_next(&rng);
+            memcpy(&x, &bits, sizeof(x));
+            if (!isfinite(x)) {
+                x = 1.0;
+            }
+            break;
+        }
+        }
+        x = (i % 2) ? -x : x;
+
+        const char *fmt = FORMATS[i % ARRAY_LEN_i32(FORMATS)];
+        int len = snprintf(buf, sizeof(buf), fmt, x);
+        ASSERT(len > 0 && len < (int)sizeof(buf));
+
+        double expected = reference_strtod(buf);
+        double obtained = 0.0;
+        bool success = strv_to_double(view(buf, (size_t)len), &obtained);
+        if (isfinite(expected) && (expected == 0.0 || isnormal(expected))) {
+            ASSERT(success);
+            ASSERT_MEM_EQ(&expected, &obtained, sizeof(expected));
+        }
+
+        if (0 == strcmp(fmt, "%.17g") && success) {
+            // Shortest round trip representation
+            ASSERT_MEM_EQ(&x, &obtained, sizeof(x));
+        }
+    }
+
+    for (int32_t i = -100000; i <= 100000; i += 7) {
+        int len = snprintf(buf, sizeof(buf), "%d", i);
+        int32_t ival = 0;
+        ASSERT(strv_to_int32(view(buf, (size_t)len), &ival));
+        ASSERT_EQ(i, ival);
+    }
+
+    PASS();
+}
+
+TEST parsing_edge_weight_section(void) {
+    const int32_t NUM_NUMBERS = 20000;
+
+    // Edge weights as found in the `EDGE_WEIGHT_SECTION` of the explicit
+    // instances
+    Rng rng = rng_create(7);
+    char buf[32];
+    double strtod_sum = 0.0;
+    double strv_sum = 0.0;
+    for (int32_t i = 0; i < NUM_NUMBERS; i++) {
+        double x = (double)rng_next_int(&rng, 100000000) / 1000.0;
+        int len = snprintf(buf, sizeof(buf), "%.3f", x);
+        strtod_sum += reference_strtod(buf);
+
+        double y = 0.0;
+        ASSERT(strv_to_double(view(buf, (size_t)len), &y));
+        strv_sum += y;
+    }
+
+    ASSERT_EQ(strtod_sum, strv_sum);
+    PASS();
+}
+
 /* Add all the definitions that need to be in the test runner's main file. */
 GREATEST_MAIN_DEFS();
 
@@ -444,6 +590,9 @@ int main(int argc, char **argv) {
     RUN_TEST(parsing_double);
     RUN_TEST(parsing_usize);
     RUN_TEST(parsing_bool);
+    RUN_TEST(parsing_views);
+    RUN_TEST(parsing_double_round_trip);
+    RUN_TEST(parsing_edge_weight_section);
 
     GREATEST_MAIN_END(); /* display results */
 }
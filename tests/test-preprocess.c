@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "core.h"
+#include "core-utils.h"
+#include "preprocess.h"
+
+#define NUM_CUSTOMERS 8
+#define NUM_RANDOM_INSTANCES 64
+
+typedef struct {
+    double best_cost;
+    int32_t best_len;
+    int32_t best_path[NUM_CUSTOMERS + 1];
+    int32_t path[NUM_CUSTOMERS + 1];
+} BruteForceCtx;
+
+/// Enumerates every elementary tour from the depot serving at least two
+/// customers within the vehicle capacity, as the tours of the MIP model.
+static void brute_force_rec(const Instance *instance, BruteForceCtx *ctx,
+                            int32_t len, uint32_t visited, double cost,
+                            double load) {
+    const int32_t n = instance->num_customers + 1;
+    int32_t last = ctx->path[len - 1];
+
+    if (len >= 3) {
+        double total = cost + cptp_dist(instance, last, 0);
+        if (total < ctx->best_cost) {
+            ctx->best_cost = total;
+            ctx->best_len = len;
+            memcpy(ctx->best_path, ctx->path, len * sizeof(*ctx->path));
+        }
+    }
+
+    for (int32_t j = 1; j < n; j++) {
+        if ((visited >> j) & 1) {
+            continue;
+        }
+        double q = load + instance->demands[j];
+        if (q > instance->vehicle_cap) {
+            continue;
+        }
+        ctx->path[len] = j;
+        brute_force_rec(instance, ctx, len + 1, visited | (1u << j),
+                        cost + cptp_dist(instance, last, j) -
+                            instance->profits[j],
+                        q);
+    }
+}
+
+static BruteForceCtx brute_force(const Instance *instance) {
+    BruteForceCtx ctx = {0};
+    ctx.best_cost = INFINITY;
+    ctx.path[0] = 0;
+    brute_force_rec(instance, &ctx, 1, 1, 0.0, 0.0);
+    return ctx;
+}
+
+static Instance make_random_instance(bool explicit_weights) {
+    const int32_t n = NUM_CUSTOMERS + 1;
+    Instance instance = {0};
+    instance.num_customers = NUM_CUSTOMERS;
+    instance.num_vehicles = 1;
+    instance.vehicle_cap = 50.0;
+    instance.rounding_strat = CPTP_DIST_ROUND;
+    instance_alloc(&instance, false);
+
+    for (int32_t i = 0; i < n; i++) {
+        instance.positions[i].x = rand() % 100;
+        instance.positions[i].y = rand() % 100;
+        if (i > 0) {
+            instance.demands[i] = 1 + rand() % 30;
+            instance.profits[i] = -20.0 + rand() % 100;
+        }
+    }
+    // A customer which never fits in the vehicle
+    instance.demands[1 + rand() % NUM_CUSTOMERS] = 60.0;
+
+    if (explicit_weights) {
+        // Same distances, but read back from an explicit triangle
+        Instance geometric = instance;
+        instance = (Instance){0};
+        instance.num_customers = geometric.num_customers;
+        instance.num_vehicles = geometric.num_vehicles;
+        instance.vehicle_cap = geometric.vehicle_cap;
+        instance.rounding_strat = geometric.rounding_strat;
+        instance_alloc(&instance, true);
+        memcpy(instance.positions, geometric.positions,
+               n * sizeof(*instance.positions));
+        memcpy(instance.demands, geometric.demands,
+               n * sizeof(*instance.demands));
+        memcpy(instance.profits, geometric.profits,
+               n * sizeof(*instance.profits));
+        for (int32_t i = 0; i < n; i++) {
+            for (int32_t j = i + 1; j < n; j++) {
+                instance.edge_weight[sxpos(n, i, j)] =
+                    cptp_dist(&geometric, i, j);
+            }
+        }
+        instance_destroy(&geometric);
+    }
+
+    return instance;
+}
+
+static greatest_test_res check_elimination(bool explicit_weights) {
+    int32_t total_eliminated = 0;
+    int32_t num_negative = 0;
+
+    srand(1234);
+    for (int32_t it = 0; it < NUM_RANDOM_INSTANCES; it++) {
+        Instance instance = make_random_instance(explicit_weights);
+        const int32_t n = instance.num_customers + 1;
+
+        Bitset eliminated = bitset_create(n);
+        int32_t num_eliminated = eliminate_customers(&instance, &eliminated);
+        ASSERT_EQ(num_eliminated, bitset_popcount(&eliminated));
+        ASSERT(num_eliminated <= instance.num_customers - 2);
+        ASSERT(!bitset_test(&eliminated, 0));
+
+        // Customers exceeding the capacity are always dropped
+        for (int32_t i = 1; i < n; i++) {
+            if (instance.demands[i] > instance.vehicle_cap) {
+                ASSERT(bitset_test(&eliminated, i));
+            }
+        }
+
+        ReducedInstance reduced = {0};
+        ASSERT(reduced_instance_create(&reduced, &instance, &eliminated));
+        ASSERT_EQ(n - num_eliminated, reduced.instance.num_customers + 1);
+        ASSERT_EQ(0, reduced.orig_node[0]);
+
+        for (int32_t u = 0; u < reduced.instance.num_customers + 1; u++) {
+            for (int32_t v = 0; v < reduced.instance.num_customers + 1; v++) {
+                if (u != v) {
+                    ASSERT_EQ(cptp_dist(&instance, reduced.orig_node[u],
+                                        reduced.orig_node[v]),
+                              cptp_dist(&reduced.instance, u, v));
+                }
+            }
+        }
+
+        BruteForceCtx full = brute_force(&instance);
+        BruteForceCtx sub = brute_force(&reduced.instance);
+
+        // The optimum is preserved
+        ASSERT(full.best_cost < INFINITY);
+        ASSERT_IN_RANGE(full.best_cost, sub.best_cost, 1e-9);
+        if (full.best_cost < -COST_TOLERANCE) {
+            ++num_negative;
+        }
+
+        // Map the reduced optimal tour back to the original instance
+        Solution reduced_solution = solution_create(&reduced.instance);
+        Solution solution = solution_create(&instance);
+        ASSERT(solution_reserve_columns(&reduced_solution, 2));
+        ASSERT(solution_reserve_columns(&solution, 2));
+        for (int32_t k = 0; k < sub.best_len; k++) {
+            int32_t u = sub.best_path[k];
+            reduced_solution.tour.comp[u] = 0;
+            reduced_solution.tour.succ[u] =
+                sub.best_path[(k + 1) % sub.best_len];
+        }
+        reduced_solution.tour.num_comps = 1;
+        reduced_solution.primal_bound = sub.best_cost;
+        bool negative_tour = solution_add_column(
+            &reduced_solution, &reduced.instance, &reduced_solution.tour);
+
+        reduced_instance_map_solution(&reduced, &reduced_solution, &solution);
+        ASSERT_EQ(1, solution.tour.num_comps);
+        ASSERT_EQ(sub.best_cost, solution.primal_bound);
+        ASSERT_IN_RANGE(sub.best_cost, tour_eval(&instance, &solution.tour),
+                        1e-9);
+
+        // The columns are mapped as well
+        ASSERT_EQ(negative_tour ? 1 : 0, solution.columns.num_columns);
+        if (negative_tour) {
+            ASSERT_IN_RANGE(
+                sub.best_cost,
+                tour_eval(&instance, &solution.columns.tours[0]), 1e-9);
+        }
+        for (int32_t i = 0; i < n; i++) {
+            if (bitset_test(&eliminated, i)) {
+                ASSERT(solution.tour.comp[i] < 0);
+            }
+        }
+
+        total_eliminated += num_eliminated;
+
+        solution_destroy(&solution);
+        solution_destroy(&reduced_solution);
+        reduced_instance_destroy(&reduced);
+        bitset_destroy(&eliminated);
+        instance_destroy(&instance);
+    }
+
+    ASSERT(total_eliminated > NUM_RANDOM_INSTANCES);
+    ASSERT(num_negative > 0);
+    PASS();
+}
+
+TEST elimination_preserves_negative_optimum(void) {
+    CHECK_CALL(check_elimination(false));
+    PASS();
+}
+
+TEST elimination_with_explicit_weights(void) {
+    CHECK_CALL(check_elimination(true));
+    PASS();
+}
+
+TEST elimination_keeps_best_pair(void) {
+    Instance instance = make_random_instance(false);
+    const int32_t n = instance.num_customers + 1;
+
+    for (int32_t i = 1; i < n; i++) {
+        instance.profits[i] = -100.0;
+    }
+
+    Bitset eliminated = bitset_create(n);
+    ASSERT_EQ(instance.num_customers - 2,
+              eliminate_customers(&instance, &eliminated));
+
+    bitset_destroy(&eliminated);
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST elimination_keeps_cheap_partner(void) {
+    // NOTE(dparo):
+    //     Customer 1 has no profitable insertion between any two other
+    //     nodes, but it is the only partner of customer 2 in a two
+    //     customers tour: 0 -> 1 -> 2 -> 0 costs 10 + 1 + 10 - 100.5
+    Instance instance = {0};
+    instance.num_customers = 3;
+    instance.num_vehicles = 1;
+    instance.vehicle_cap = 10.0;
+    instance.rounding_strat = CPTP_DIST_NO_ROUND;
+    ASSERT(instance_alloc(&instance, true));
+    const int32_t n = instance.num_customers + 1;
+
+    instance.profits[1] = 0.5;
+    instance.profits[2] = 100.0;
+    instance.profits[3] = 0.0;
+    for (int32_t i = 1; i < n; i++) {
+        instance.demands[i] = 1.0;
+    }
+    instance.edge_weight[sxpos(n, 0, 1)] = 10.0;
+    instance.edge_weight[sxpos(n, 0, 2)] = 10.0;
+    instance.edge_weight[sxpos(n, 1, 2)] = 1.0;
+    instance.edge_weight[sxpos(n, 0, 3)] = 50.0;
+    instance.edge_weight[sxpos(n, 1, 3)] = 50.0;
+    instance.edge_weight[sxpos(n, 2, 3)] = 50.0;
+
+    Bitset eliminated = bitset_create(n);
+    ASSERT_EQ(1, eliminate_customers(&instance, &eliminated));
+    ASSERT(!bitset_test(&eliminated, 1));
+    ASSERT(!bitset_test(&eliminated, 2));
+    ASSERT(bitset_test(&eliminated, 3));
+
+    ReducedInstance reduced = {0};
+    ASSERT(reduced_instance_create(&reduced, &instance, &eliminated));
+    BruteForceCtx full = brute_force(&instance);
+    BruteForceCtx sub = brute_force(&reduced.instance);
+    ASSERT_IN_RANGE(-79.5, full.best_cost, 1e-9);
+    ASSERT_IN_RANGE(full.best_cost, sub.best_cost, 1e-9);
+
+    reduced_instance_destroy(&reduced);
+    bitset_destroy(&eliminated);
+    instance_destroy(&instance);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    /* If tests are run outside of a suite, a default suite is used. */
+    RUN_TEST(elimination_preserves_negative_optimum);
+    RUN_TEST(elimination_with_explicit_weights);
+    RUN_TEST(elimination_keeps_best_pair);
+    RUN_TEST(elimination_keeps_cheap_partner);
+
+    GREATEST_MAIN_END(); /* display results */
+}
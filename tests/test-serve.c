@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <greatest.h>
+#include <cJSON.h>
+
+#include "serve.h"
+
+#define MAX_REPLIES 32
+
+typedef struct {
+    int32_t num_replies;
+    cJSON *replies[MAX_REPLIES];
+    bool keep_serving;
+} ServeResult;
+
+static void serve_result_destroy(ServeResult *result) {
+    for (int32_t i = 0; i < result->num_replies; i++) {
+        cJSON_Delete(result->replies[i]);
+    }
+    memset(result, 0, sizeof(*result));
+}
+
+/// Feeds the `requests` lines to `serve_stream` through a pipe, and collects
+/// the parsed reply lines from a second pipe. The requests and the replies
+/// are small enough to fit the pipe buffers, so a single thread suffices.
+static bool serve_requests(const char *requests, ServeResult *result) {
+    memset(result, 0, sizeof(*result));
+
+    SolverParams params = {0};
+    params.num_params = 1;
+    params.params[0].name = "ROUTE_LEN";
+    params.params[0].value = "2";
+
+    ServeConfig config = {
+        .solver_name = "stub",
+        .params = &params,
+        .timelimit = 1.0,
+        .randomseed = 1,
+        .num_columns = 4,
+    };
+    CancellationToken cancel = {0};
+
+    int in_fds[2], out_fds[2];
+    if (pipe(in_fds) != 0) {
+        return false;
+    }
+    if (pipe(out_fds) != 0) {
+        close(in_fds[0]);
+        close(in_fds[1]);
+        return false;
+    }
+
+    size_t len = strlen(requests);
+    bool ok = write(in_fds[1], requests, len) == (ssize_t)len;
+    close(in_fds[1]);
+
+    FILE *in = fdopen(in_fds[0], "r");
+    FILE *out = fdopen(out_fds[1], "w");
+    if (ok && in && out) {
+        result->keep_serving = serve_stream(&config, &cancel, in, out);
+    }
+    if (in) {
+        fclose(in);
+    } else {
+        close(in_fds[0]);
+    }
+    if (out) {
+        fclose(out);
+    } else {
+        close(out_fds[1]);
+    }
+
+    FILE *replies = fdopen(out_fds[0], "r");
+    if (!replies) {
+        close(out_fds[0]);
+        return false;
+    }
+
+    char line[4096];
+    while (fgets(line, sizeof(line), replies)) {
+        if (result->num_replies >= MAX_REPLIES) {
+            ok = false;
+            break;
+        }
+        cJSON *reply = cJSON_Parse(line);
+        if (!cJSON_IsObject(reply)) {
+            cJSON_Delete(reply);
+            ok = false;
+            break;
+        }
+        result->replies[result->num_replies++] = reply;
+    }
+    fclose(replies);
+    return ok;
+}
+
+static const char *reply_error(const cJSON *reply) {
+    const cJSON *error = cJSON_GetObjectItemCaseSensitive(reply, "error");
+    return cJSON_IsString(error) ? error->valuestring : NULL;
+}
+
+static bool reply_ok(const cJSON *reply) {
+    return cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(reply, "ok")) &&
+           !reply_error(reply);
+}
+
+static double reply_number(const cJSON *obj, const char *key) {
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return cJSON_IsNumber(item) ? item->valuedouble : NAN;
+}
+
+static const cJSON *reply_columns(const cJSON *reply) {
+    return cJSON_GetObjectItemCaseSensitive(reply, "columns");
+}
+
+static bool column_has_route(const cJSON *column, const int32_t *route,
+                             int32_t len) {
+    const cJSON *array = cJSON_GetObjectItemCaseSensitive(column, "route");
+    if (!cJSON_IsArray(array) || cJSON_GetArraySize(array) != len) {
+        return false;
+    }
+    for (int32_t i = 0; i < len; i++) {
+        if (cJSON_GetArrayItem(array, i)->valueint != route[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST request_errors(void) {
+    ServeResult result;
+    ASSERT(serve_requests(
+        "{\"id\":1,\"profits\":[0,1,2]}\n"
+        "this is not json\n"
+        "{\"id\":\"a\",\"foo\":1}\n"
+        "{\"id\":2,\"instance\":\"data/CVRP/missing.vrp\"}\n"
+        "{\"id\":3,\"instance\":{\"positions\":[[0,0]]}}\n"
+        "{\"id\":4,\"instance\":42}\n",
+        &result));
+
+    ASSERT(result.keep_serving);
+    ASSERT_EQ(6, result.num_replies);
+    cJSON **r = result.replies;
+
+    ASSERT_STR_EQ("no instance was loaded", reply_error(r[0]));
+    ASSERT_EQ(1, reply_number(r[0], "id"));
+    ASSERT_FALSE(cJSON_GetObjectItemCaseSensitive(r[0], "ok"));
+
+    ASSERT_STR_EQ("malformed request", reply_error(r[1]));
+    ASSERT_FALSE(cJSON_GetObjectItemCaseSensitive(r[1], "id"));
+
+    ASSERT_STR_EQ("unknown request", reply_error(r[2]));
+    ASSERT_STR_EQ("a",
+                  cJSON_GetObjectItemCaseSensitive(r[2], "id")->valuestring);
+
+    ASSERT_STR_EQ("failed to parse the instance file", reply_error(r[3]));
+    ASSERT_STR_EQ("inline instance requires `vehicleCap` and at least two "
+                  "`positions`",
+                  reply_error(r[4]));
+    ASSERT_STR_EQ("`instance` must be a file path or an object",
+                  reply_error(r[5]));
+
+    serve_result_destroy(&result);
+    PASS();
+}
+
+TEST instance_from_path(void) {
+    ServeResult result;
+    ASSERT(serve_requests(
+        "{\"id\":1,\"instance\":\"data/CVRP/toy.vrp\"}\n"
+        "{\"id\":2,\"profits\":[0,100]}\n"
+        "{\"id\":3,\"profits\":[0,100,0,100,0,0]}\n"
+        "{\"id\":4,\"profits\":[0,0,0,0,0,0]}\n",
+        &result));
+
+    ASSERT_EQ(4, result.num_replies);
+    cJSON **r = result.replies;
+
+    ASSERT(reply_ok(r[0]));
+    ASSERT_STR_EQ("toy",
+                  cJSON_GetObjectItemCaseSensitive(r[0], "name")->valuestring);
+    ASSERT_EQ(5, reply_number(r[0], "numCustomers"));
+
+    ASSERT_STR_EQ("`profits` must contain a number for each node",
+                  reply_error(r[1]));
+
+    // The stub visits the customers 1 and 3: 21 + 19 + 17 of travel cost
+    static const int32_t route[] = {0, 1, 3};
+    ASSERT(reply_ok(r[2]));
+    ASSERT_EQ(3, reply_number(r[2], "id"));
+    ASSERT_EQ(57.0 - 200.0, reply_number(r[2], "primalBound"));
+    ASSERT(cJSON_IsArray(reply_columns(r[2])));
+    ASSERT_EQ(1, cJSON_GetArraySize(reply_columns(r[2])));
+    const cJSON *column = cJSON_GetArrayItem(reply_columns(r[2]), 0);
+    ASSERT(column_has_route(column, route, 3));
+    ASSERT_EQ(57.0, reply_number(column, "cost"));
+    ASSERT_EQ(200.0, reply_number(column, "profit"));
+    ASSERT_EQ(17.0, reply_number(column, "demand"));
+    ASSERT_EQ(57.0 - 200.0, reply_number(column, "reducedCost"));
+
+    // The same session is reused with the new profits: the route is no
+    // longer improving, and does not make it to the columns
+    ASSERT(reply_ok(r[3]));
+    ASSERT_EQ(57.0, reply_number(r[3], "primalBound"));
+    ASSERT(cJSON_IsArray(reply_columns(r[3])));
+    ASSERT_EQ(0, cJSON_GetArraySize(reply_columns(r[3])));
+
+    serve_result_destroy(&result);
+    PASS();
+}
+
+TEST inline_instance(void) {
+    ServeResult result;
+    ASSERT(serve_requests(
+        "{\"id\":1,\"instance\":{\"vehicleCap\":10,"
+        "\"positions\":[[0,0],[3,4],[6,8]],\"demands\":[0,1,1]}}\n"
+        "{\"id\":2,\"profits\":[0,50,50]}\n"
+        "{\"id\":3,\"instance\":\"data/CVRP/toy.vrp\"}\n"
+        "{\"id\":4,\"profits\":[0,0,0,0,0,0]}\n",
+        &result));
+
+    ASSERT_EQ(4, result.num_replies);
+    cJSON **r = result.replies;
+
+    ASSERT(reply_ok(r[0]));
+    ASSERT_STR_EQ("inline",
+                  cJSON_GetObjectItemCaseSensitive(r[0], "name")->valuestring);
+    ASSERT_EQ(2, reply_number(r[0], "numCustomers"));
+
+    static const int32_t route[] = {0, 1, 2};
+    ASSERT(reply_ok(r[1]));
+    ASSERT_EQ(1, cJSON_GetArraySize(reply_columns(r[1])));
+    const cJSON *column = cJSON_GetArrayItem(reply_columns(r[1]), 0);
+    ASSERT(column_has_route(column, route, 3));
+    ASSERT_EQ(20.0 - 100.0, reply_number(column, "reducedCost"));
+
+    // A new instance replaces the session of the inline one
+    ASSERT(reply_ok(r[2]));
+    ASSERT_EQ(5, reply_number(r[2], "numCustomers"));
+    ASSERT(reply_ok(r[3]));
+    ASSERT_EQ(57.0, reply_number(r[3], "primalBound"));
+
+    serve_result_destroy(&result);
+    PASS();
+}
+
+TEST quit_request(void) {
+    ServeResult result;
+    ASSERT(serve_requests("{\"id\":1,\"quit\":true}\n"
+                          "{\"id\":2,\"instance\":\"data/CVRP/toy.vrp\"}\n",
+                          &result));
+
+    ASSERT_FALSE(result.keep_serving);
+    ASSERT_EQ(1, result.num_replies);
+    ASSERT(reply_ok(result.replies[0]));
+    ASSERT_EQ(1, reply_number(result.replies[0], "id"));
+
+    serve_result_destroy(&result);
+
+    // EOF ends the stream, but not the serving
+    ASSERT(serve_requests("", &result));
+    ASSERT(result.keep_serving);
+    ASSERT_EQ(0, result.num_replies);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    /* If tests are run outside of a suite, a default suite is used. */
+    RUN_TEST(request_errors);
+    RUN_TEST(instance_from_path);
+    RUN_TEST(inline_instance);
+    RUN_TEST(quit_request);
+
+    GREATEST_MAIN_END(); /* display results */
+}
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <greatest.h>
+
+#include "serve.h"
+#include "shm-channel.h"
+
+#define NUM_NODES 6
+#define MAX_COLUMNS 4
+#define NUM_SLOTS 2
+#define NUM_REQUESTS 16
+
+static void make_channel_name(char *name, size_t size, const char *suffix) {
+    snprintf(name, size, "/cptp-test-%d-%s", (int)getpid(), suffix);
+}
+
+static double request_profit(int32_t req, int32_t node) {
+    return req * 10.0 + node;
+}
+
+/// The fake pricer answers the `req`-th request with `1 + req % MAX_COLUMNS`
+/// columns, the k-th one visiting the nodes `0, 1, ..., k + 1`
+static void answer_request(const ShmChannel *channel, const ShmSlot *slot) {
+    int32_t req = (int32_t)(slot->profits[0] / 10.0);
+    slot->reply->status = req;
+    slot->reply->num_columns = 1 + req % MAX_COLUMNS;
+    slot->reply->primal_bound = -req;
+    slot->reply->dual_bound = -req - 1;
+
+    for (int32_t k = 0; k < slot->reply->num_columns; k++) {
+        int32_t *route = shm_slot_route(channel, slot, k);
+        ShmColumn *column = &slot->columns[k];
+        column->route_len = k + 2;
+        column->profit = 0.0;
+        for (int32_t i = 0; i < column->route_len; i++) {
+            route[i] = i;
+            column->profit += slot->profits[i];
+        }
+        column->cost = 1.0;
+        column->demand = column->route_len;
+        column->reduced_cost = column->cost - column->profit;
+    }
+}
+
+static bool check_reply(const ShmChannel *channel, const ShmSlot *slot,
+                        int32_t req) {
+    if (slot->reply->status != req ||
+        slot->reply->num_columns != 1 + req % MAX_COLUMNS ||
+        slot->reply->primal_bound != -req) {
+        return false;
+    }
+
+    for (int32_t k = 0; k < slot->reply->num_columns; k++) {
+        const int32_t *route = shm_slot_route(channel, slot, k);
+        const ShmColumn *column = &slot->columns[k];
+        double profit = 0.0;
+        if (column->route_len != k + 2) {
+            return false;
+        }
+        for (int32_t i = 0; i < column->route_len; i++) {
+            if (route[i] != i) {
+                return false;
+            }
+            profit += request_profit(req, i);
+        }
+        if (column->profit != profit ||
+            column->reduced_cost != column->cost - profit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Body of the fake master process: keeps the ring full, checks every
+/// reply, then asks the pricer to stop. Returns the exit code.
+static int run_fake_master(const char *name) {
+    ShmChannel channel = shm_channel_open(name);
+    if (!shm_channel_is_valid(&channel) || channel.num_nodes != NUM_NODES) {
+        return 1;
+    }
+
+    int exitcode = 0;
+    int32_t num_posted = 0;
+    double profits[NUM_NODES];
+
+    for (int32_t req = 0; req < NUM_REQUESTS; req++) {
+        while (num_posted < NUM_REQUESTS) {
+            for (int32_t i = 0; i < NUM_NODES; i++) {
+                profits[i] = request_profit(num_posted, i);
+            }
+            if (!shm_channel_post_request(&channel, profits)) {
+                break;
+            }
+            ++num_posted;
+        }
+
+        ShmSlot slot;
+        if (!shm_channel_wait_reply(&channel, 10 * 1000 * 1000, &slot) ||
+            !check_reply(&channel, &slot, req)) {
+            exitcode = 1;
+            break;
+        }
+        shm_channel_consume_reply(&channel);
+    }
+
+    shm_channel_shutdown(&channel);
+    shm_channel_destroy(&channel);
+    return exitcode;
+}
+
+TEST roundtrip_with_fake_master(void) {
+    char name[64];
+    make_channel_name(name, sizeof(name), "roundtrip");
+
+    ShmChannel channel =
+        shm_channel_create(name, NUM_NODES, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT(shm_channel_is_valid(&channel));
+
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(run_fake_master(name));
+    }
+    ASSERT(pid > 0);
+
+    int32_t num_answered = 0;
+    ShmSlot slot;
+    while (shm_channel_wait_request(&channel, NULL, &slot)) {
+        answer_request(&channel, &slot);
+        shm_channel_commit_reply(&channel);
+        ++num_answered;
+    }
+
+    int wstatus = 0;
+    ASSERT_EQ(pid, waitpid(pid, &wstatus, 0));
+    shm_channel_destroy(&channel);
+
+    ASSERT(WIFEXITED(wstatus));
+    ASSERT_EQ(0, WEXITSTATUS(wstatus));
+    ASSERT_EQ(NUM_REQUESTS, num_answered);
+    PASS();
+}
+
+TEST ring_full_and_timeouts(void) {
+    char name[64];
+    make_channel_name(name, sizeof(name), "full");
+
+    ShmChannel master =
+        shm_channel_create(name, NUM_NODES, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT(shm_channel_is_valid(&master));
+    ShmChannel pricer = shm_channel_open(name);
+    ASSERT(shm_channel_is_valid(&pricer));
+    ASSERT_EQ(NUM_SLOTS, pricer.num_slots);
+
+    ShmSlot slot;
+    double profits[NUM_NODES] = {0};
+
+    // Nothing was posted yet
+    ASSERT_FALSE(shm_channel_wait_reply(&master, 0, &slot));
+
+    for (int32_t i = 0; i < NUM_SLOTS; i++) {
+        ASSERT(shm_channel_post_request(&master, profits));
+    }
+    ASSERT_FALSE(shm_channel_post_request(&master, profits));
+    ASSERT_FALSE(shm_channel_wait_reply(&master, 1000, &slot));
+
+    // A single answer frees a single slot, once consumed
+    ASSERT(shm_channel_wait_request(&pricer, NULL, &slot));
+    shm_channel_commit_reply(&pricer);
+    ASSERT_FALSE(shm_channel_post_request(&master, profits));
+    ASSERT(shm_channel_wait_reply(&master, 0, &slot));
+    shm_channel_consume_reply(&master);
+    ASSERT(shm_channel_post_request(&master, profits));
+
+    // Pending requests are still answered after a shutdown
+    shm_channel_shutdown(&master);
+    ASSERT(shm_channel_wait_request(&pricer, NULL, &slot));
+    shm_channel_commit_reply(&pricer);
+    ASSERT(shm_channel_wait_request(&pricer, NULL, &slot));
+    shm_channel_commit_reply(&pricer);
+    ASSERT_FALSE(shm_channel_wait_request(&pricer, NULL, &slot));
+
+    shm_channel_destroy(&pricer);
+    shm_channel_destroy(&master);
+    PASS();
+}
+
+TEST cancelled_pricer(void) {
+    char name[64];
+    make_channel_name(name, sizeof(name), "cancel");
+
+    ShmChannel channel =
+        shm_channel_create(name, NUM_NODES, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT(shm_channel_is_valid(&channel));
+
+    CancellationToken cancel = {0};
+    cancellation_token_request(&cancel);
+    ShmSlot slot;
+    ASSERT_FALSE(shm_channel_wait_request(&channel, &cancel, &slot));
+
+    shm_channel_destroy(&channel);
+    PASS();
+}
+
+TEST create_and_open_failures(void) {
+    char name[64];
+    make_channel_name(name, sizeof(name), "failures");
+
+    ShmChannel missing = shm_channel_open(name);
+    ASSERT_FALSE(shm_channel_is_valid(&missing));
+
+    ShmChannel channel =
+        shm_channel_create(name, NUM_NODES, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT(shm_channel_is_valid(&channel));
+
+    // The name is already taken
+    ShmChannel duplicate =
+        shm_channel_create(name, NUM_NODES, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT_FALSE(shm_channel_is_valid(&duplicate));
+
+    // A header claiming more slots than mapped is rejected. NOTE(dparo):
+    // `num_slots` is the fifth 32 bit word of the header.
+    int32_t *num_slots = (int32_t *)channel.header + 4;
+    *num_slots = INT32_MAX;
+    ShmChannel corrupted = shm_channel_open(name);
+    ASSERT_FALSE(shm_channel_is_valid(&corrupted));
+    *num_slots = NUM_SLOTS;
+    ShmChannel restored = shm_channel_open(name);
+    ASSERT(shm_channel_is_valid(&restored));
+    shm_channel_destroy(&restored);
+
+    // The shared memory object is removed by its creator
+    shm_channel_destroy(&channel);
+    missing = shm_channel_open(name);
+    ASSERT_FALSE(shm_channel_is_valid(&missing));
+    PASS();
+}
+
+static ServeConfig stub_serve_config(const char *name,
+                                     const SolverParams *params) {
+    return (ServeConfig){
+        .solver_name = "stub",
+        .params = params,
+        .timelimit = 1.0,
+        .randomseed = 1,
+        .num_columns = MAX_COLUMNS,
+        .shm_name = name,
+        .instance_filepath = "data/CVRP/toy.vrp",
+    };
+}
+
+TEST serve_shm_pricer(void) {
+    char name[64];
+    make_channel_name(name, sizeof(name), "serve");
+
+    // NOTE(dparo): The toy instance has exactly NUM_NODES nodes
+    ShmChannel channel =
+        shm_channel_create(name, NUM_NODES, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT(shm_channel_is_valid(&channel));
+
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // The stub reports the route 0 -> 1 -> 3 -> 0, of cost 57
+        SolverParams params = {0};
+        params.num_params = 1;
+        params.params[0].name = "ROUTE_LEN";
+        params.params[0].value = "2";
+        ServeConfig config = stub_serve_config(name, &params);
+        _exit(serve_main(&config, NULL));
+    }
+    ASSERT(pid > 0);
+
+    const double improving[NUM_NODES] = {0, 100, 0, 100, 0, 0};
+    const double zeros[NUM_NODES] = {0};
+    ASSERT(shm_channel_post_request(&channel, improving));
+    ASSERT(shm_channel_post_request(&channel, zeros));
+
+    ShmSlot slot;
+    ASSERT(shm_channel_wait_reply(&channel, 10 * 1000 * 1000, &slot));
+    ASSERT(slot.reply->status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL);
+    ASSERT_EQ(57.0 - 200.0, slot.reply->primal_bound);
+    ASSERT_EQ(1, slot.reply->num_columns);
+    ASSERT_EQ(3, slot.columns[0].route_len);
+    const int32_t *route = shm_slot_route(&channel, &slot, 0);
+    ASSERT_EQ(0, route[0]);
+    ASSERT_EQ(1, route[1]);
+    ASSERT_EQ(3, route[2]);
+    ASSERT_EQ(57.0, slot.columns[0].cost);
+    ASSERT_EQ(200.0, slot.columns[0].profit);
+    ASSERT_EQ(17.0, slot.columns[0].demand);
+    ASSERT_EQ(57.0 - 200.0, slot.columns[0].reduced_cost);
+    shm_channel_consume_reply(&channel);
+
+    // Same route, no longer improving under the new profits
+    ASSERT(shm_channel_wait_reply(&channel, 10 * 1000 * 1000, &slot));
+    ASSERT(slot.reply->status & SOLVE_STATUS_PRIMAL_SOLUTION_AVAIL);
+    ASSERT_EQ(57.0, slot.reply->primal_bound);
+    ASSERT_EQ(0, slot.reply->num_columns);
+    shm_channel_consume_reply(&channel);
+
+    shm_channel_shutdown(&channel);
+    int wstatus = 0;
+    ASSERT_EQ(pid, waitpid(pid, &wstatus, 0));
+    shm_channel_destroy(&channel);
+
+    ASSERT(WIFEXITED(wstatus));
+    ASSERT_EQ(EXIT_SUCCESS, WEXITSTATUS(wstatus));
+    PASS();
+}
+
+TEST serve_shm_failures(void) {
+    char name[64];
+    make_channel_name(name, sizeof(name), "serve-failures");
+    SolverParams params = {0};
+    ServeConfig config = stub_serve_config(name, &params);
+
+    // No channel to attach to
+    ASSERT_EQ(EXIT_FAILURE, serve_main(&config, NULL));
+
+    // The channel does not match the number of nodes of the instance
+    ShmChannel channel =
+        shm_channel_create(name, NUM_NODES + 1, MAX_COLUMNS, NUM_SLOTS);
+    ASSERT(shm_channel_is_valid(&channel));
+    ASSERT_EQ(EXIT_FAILURE, serve_main(&config, NULL));
+    shm_channel_destroy(&channel);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    /* If tests are run outside of a suite, a default suite is used. */
+    RUN_TEST(roundtrip_with_fake_master);
+    RUN_TEST(ring_full_and_timeouts);
+    RUN_TEST(cancelled_pricer);
+    RUN_TEST(create_and_open_failures);
+    RUN_TEST(serve_shm_pricer);
+    RUN_TEST(serve_shm_failures);
+
+    GREATEST_MAIN_END(); /* display results */
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2022 Davide Paro
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <greatest.h>
+
+#include "parser.h"
+#include "core.h"
+#include "core-utils.h"
+#include "spatial-index.h"
+
+static int cmp_i32(const void *a, const void *b) {
+    int32_t ia = *(const int32_t *)a;
+    int32_t ib = *(const int32_t *)b;
+    return ia < ib ? -1 : (ia > ib ? 1 : 0);
+}
+
+static greatest_test_res check_queries(const Vec2d *points, int32_t n) {
+    SpatialIndex index = spatial_index_create(points, n);
+    ASSERT(index.points);
+
+    const int32_t ks[] = {1, 5, 16, n - 1, n + 3};
+    int32_t *found = malloc((n + 3) * sizeof(*found));
+    double *found_dists = malloc((n + 3) * sizeof(*found_dists));
+    int32_t *expected = malloc(n * sizeof(*expected));
+    double *dists = malloc(n * sizeof(*dists));
+
+    for (int32_t i = 0; i < n; i++) {
+        const Vec2d q = points[i];
+
+        for (int32_t kk = 0; kk < ARRAY_LEN_i32(ks); kk++) {
+            const int32_t k = ks[kk];
+            int32_t len =
+                spatial_index_knn(&index, q, k, i, found, found_dists);
+            ASSERT_EQ(MIN(k, n - 1), len);
+
+            // Results must be sorted by (distance, index) and no other point
+            // may be strictly closer than the last reported one
+            for (int32_t t = 0; t < len; t++) {
+                ASSERT(found[t] != i);
+                ASSERT_EQ(vec2d_dist(&q, &points[found[t]]), found_dists[t]);
+                if (t > 0) {
+                    ASSERT(found_dists[t - 1] < found_dists[t] ||
+                           (found_dists[t - 1] == found_dists[t] &&
+                            found[t - 1] < found[t]));
+                }
+            }
+            int32_t num_closer = 0;
+            for (int32_t j = 0; j < n; j++) {
+                if (j != i &&
+                    vec2d_dist(&q, &points[j]) < found_dists[len - 1]) {
+                    ++num_closer;
+                }
+            }
+            ASSERT(num_closer < len);
+        }
+
+        // Radius queries against a brute force scan
+        for (int32_t j = 0; j < n; j++) {
+            dists[j] = vec2d_dist(&q, &points[j]);
+        }
+        const double radii[] = {0.0, 5.0, 40.0, 1e9};
+        for (int32_t r = 0; r < ARRAY_LEN_i32(radii); r++) {
+            int32_t num_expected = 0;
+            for (int32_t j = 0; j < n; j++) {
+                if (dists[j] <= radii[r]) {
+                    expected[num_expected++] = j;
+                }
+            }
+            int32_t len = spatial_index_radius(&index, q, radii[r], found);
+            ASSERT_EQ(num_expected, len);
+            qsort(found, len, sizeof(*found), cmp_i32);
+            for (int32_t t = 0; t < len; t++) {
+                ASSERT_EQ(expected[t], found[t]);
+            }
+        }
+
+        // Rectangle queries centered around the point
+        {
+            const Vec2d lo = {q.x - 25.0, q.y - 10.0};
+            const Vec2d hi = {q.x + 10.0, q.y + 25.0};
+            int32_t num_expected = 0;
+            for (int32_t j = 0; j < n; j++) {
+                const Vec2d *p = &points[j];
+                if (p->x >= lo.x && p->x <= hi.x && p->y >= lo.y &&
+                    p->y <= hi.y) {
+                    expected[num_expected++] = j;
+                }
+            }
+            int32_t len = spatial_index_rect(&index, lo, hi, found);
+            ASSERT_EQ(num_expected, len);
+            qsort(found, len, sizeof(*found), cmp_i32);
+            for (int32_t t = 0; t < len; t++) {
+                ASSERT_EQ(expected[t], found[t]);
+            }
+        }
+    }
+
+    free(dists);
+    free(expected);
+    free(found_dists);
+    free(found);
+    spatial_index_destroy(&index);
+    PASS();
+}
+
+TEST spatial_index_queries_match_brute_force(void) {
+    Instance instance = parse("data/CVRP/X/X-n895-k37.vrp");
+    ASSERT(instance.positions);
+    CHECK_CALL(check_queries(instance.positions, instance.num_customers + 1));
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST spatial_index_degenerate_points(void) {
+    // Points on a small integral grid: lots of coincident points and ties
+    const int32_t n = 300;
+    Vec2d *points = malloc(n * sizeof(*points));
+    srand(0);
+    for (int32_t i = 0; i < n; i++) {
+        points[i].x = (double)(rand() % 6);
+        points[i].y = (double)(rand() % 6);
+    }
+    CHECK_CALL(check_queries(points, n));
+
+    // All the points collapsed on a single line
+    for (int32_t i = 0; i < n; i++) {
+        points[i].x = 3.0;
+        points[i].y = (double)(i % 17);
+    }
+    CHECK_CALL(check_queries(points, n));
+
+    free(points);
+    PASS();
+}
+
+/* Add all the definitions that need to be in the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN(); /* command-line arguments, initialization. */
+
+    RUN_TEST(spatial_index_queries_match_brute_force);
+    RUN_TEST(spatial_index_degenerate_points);
+
+    GREATEST_MAIN_END(); /* display results */
+}
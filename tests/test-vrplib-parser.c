@@ -26,10 +26,14 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <greatest.h>
 
 #include "parser.h"
 #include "core-utils.h"
+#include "render.h"
 #include "misc.h"
 #include "instances.h"
 
@@ -77,7 +81,502 @@ TEST parsing_single_instance(void) {
     PASS();
 }
 
+TEST parsing_truncated_instance(void) {
+    size_t size = 0;
+    char *content = fread_all_into_cstr("./data/CVRP/toy.vrp", &size);
+    ASSERT(content);
+
+    // The parser works on a mapping of the file (without NUL termination):
+    // every proper prefix of the instance must be rejected without reading
+    // past its end
+    const char *filepath = "test-vrplib-truncated.vrp";
+    for (size_t len = size / 2; len < size; len++) {
+        if (0 == strncmp(content + len, "EOF", 3)) {
+            break;
+        }
+        FILE *fh = fopen(filepath, "w");
+        ASSERT(fh);
+        fwrite(content, 1, len, fh);
+        fclose(fh);
+
+        Instance instance = parse(filepath);
+        ASSERT_FALSE(instance.positions);
+    }
+
+    remove(filepath);
+    free(content);
+    PASS();
+}
+
+typedef enum {
+    EXPLICIT_RECORDS_IN_ORDER,
+    EXPLICIT_RECORDS_REVERSED,
+    EXPLICIT_RECORDS_MISSING,
+    EXPLICIT_RECORDS_DUPLICATE,
+} ExplicitRecords;
+
+static double explicit_weight(int32_t i, int32_t j) {
+    return 1000.0 * MIN(i, j) + MAX(i, j) + 0.25;
+}
+
+/// Writes the header and node sections of an explicit instance of `n`
+/// nodes, up to its `EDGE_WEIGHT_SECTION` keyword
+static void write_explicit_header(FILE *fh, int32_t n, const char *format) {
+    fprintf(fh, "NAME : explicit-%d\nTYPE : CVRP\nDIMENSION : %d\n", n, n);
+    fprintf(fh, "VEHICLES : 2\nCAPACITY : 100\n");
+    fprintf(fh, "EDGE_WEIGHT_TYPE : EXPLICIT\n");
+    if (format) {
+        fprintf(fh, "EDGE_WEIGHT_FORMAT : %s\n", format);
+    }
+    fprintf(fh, "NODE_COORD_SECTION\n");
+    for (int32_t i = 0; i < n; i++) {
+        fprintf(fh, "%d 0 0\n", i + 1);
+    }
+    fprintf(fh, "DEMAND_SECTION\n");
+    for (int32_t i = 0; i < n; i++) {
+        fprintf(fh, "%d %d\n", i + 1, i == 0 ? 0 : 1);
+    }
+    fprintf(fh, "EDGE_WEIGHT_SECTION\n");
+}
+
+/// Writes an explicit instance of `n` nodes, whose `EDGE_WEIGHT_SECTION`
+/// records are laid out according to `records`
+static bool write_explicit_instance(const char *filepath, int32_t n,
+                                    ExplicitRecords records) {
+    FILE *fh = fopen(filepath, "w");
+    if (!fh) {
+        return false;
+    }
+
+    write_explicit_header(fh, n, NULL);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            int32_t a = i, b = j;
+            if (records == EXPLICIT_RECORDS_REVERSED) {
+                a = n - 1 - i;
+                b = n - 1 - j;
+            }
+            bool is_last = i == n - 2;
+            if (records == EXPLICIT_RECORDS_MISSING && is_last) {
+                continue;
+            }
+            fprintf(fh, "%d %d %.17g\n", a + 1, b + 1, explicit_weight(a, b));
+            if (records == EXPLICIT_RECORDS_DUPLICATE && i == n / 2 &&
+                j == i + 1) {
+                fprintf(fh, "%d %d %.17g\n", b + 1, a + 1,
+                        explicit_weight(a, b));
+            }
+        }
+    }
+
+    fprintf(fh, "DEPOT_SECTION\n1\n-1\nEOF\n");
+    fclose(fh);
+    return true;
+}
+
+static greatest_test_res check_explicit_instance(int32_t n,
+                                                 ExplicitRecords records) {
+    const char *filepath = "test-vrplib-explicit.vrp";
+    ASSERT(write_explicit_instance(filepath, n, records));
+
+    Instance instance = parse(filepath);
+    remove(filepath);
+
+    if (records == EXPLICIT_RECORDS_MISSING ||
+        records == EXPLICIT_RECORDS_DUPLICATE) {
+        ASSERT_FALSE(instance.edge_weight);
+        PASS();
+    }
+
+    ASSERT(is_valid_instance(&instance));
+    ASSERT(instance.edge_weight);
+    ASSERT_EQ(n - 1, instance.num_customers);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(explicit_weight(i, j), cptp_dist(&instance, i, j));
+        }
+    }
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST parsing_explicit_instances(void) {
+    // Small sections are parsed on a single thread, large ones are split
+    CHECK_CALL(check_explicit_instance(6, EXPLICIT_RECORDS_IN_ORDER));
+    CHECK_CALL(check_explicit_instance(6, EXPLICIT_RECORDS_REVERSED));
+    CHECK_CALL(check_explicit_instance(6, EXPLICIT_RECORDS_MISSING));
+    CHECK_CALL(check_explicit_instance(6, EXPLICIT_RECORDS_DUPLICATE));
+
+    CHECK_CALL(check_explicit_instance(1000, EXPLICIT_RECORDS_IN_ORDER));
+    CHECK_CALL(check_explicit_instance(1000, EXPLICIT_RECORDS_REVERSED));
+    CHECK_CALL(check_explicit_instance(1000, EXPLICIT_RECORDS_MISSING));
+    CHECK_CALL(check_explicit_instance(1000, EXPLICIT_RECORDS_DUPLICATE));
+    PASS();
+}
+
 #define EPS ((double)1e-2)
+/// Writes an explicit instance of `n` nodes in the TSPLIB matrix `format`,
+/// wrapping the lines every `wrap` weights. Weights are perturbed by
+/// `error` on the entries below the diagonal.
+static bool write_matrix_instance(const char *filepath, int32_t n,
+                                  const char *format, int32_t wrap,
+                                  double error) {
+    FILE *fh = fopen(filepath, "w");
+    if (!fh) {
+        return false;
+    }
+    write_explicit_header(fh, n, format);
+
+    bool is_full = 0 == strcmp(format, "FULL_MATRIX");
+    bool is_lower = 0 == strncmp(format, "LOWER", 5);
+    bool with_diag = is_full || strstr(format, "DIAG");
+
+    int32_t count = 0;
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = 0; j < n; j++) {
+            bool included = is_full || (is_lower ? j < i : j > i) ||
+                            (with_diag && i == j);
+            if (!included) {
+                continue;
+            }
+            double w = i == j ? 0.0 : explicit_weight(i, j);
+            w += j < i ? error : 0.0;
+            count++;
+            fprintf(fh, "%.17g%s", w, count % wrap == 0 ? "\n" : " ");
+        }
+    }
+    fprintf(fh, "\nDEPOT_SECTION\n1\n-1\nEOF\n");
+    fclose(fh);
+    return true;
+}
+
+/// Writes an explicit instance of `n` nodes as older versions did: declaring
+/// `UPPER_ROW`, while holding one `i j w` triplet per line
+static bool write_legacy_instance(const char *filepath, int32_t n) {
+    FILE *fh = fopen(filepath, "w");
+    if (!fh) {
+        return false;
+    }
+    write_explicit_header(fh, n, "UPPER_ROW");
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            fprintf(fh, "%d %d %.17g\n", i + 1, j + 1, explicit_weight(i, j));
+        }
+    }
+    fprintf(fh, "DEPOT_SECTION\n1\n-1\nEOF\n");
+    fclose(fh);
+    return true;
+}
+
+static greatest_test_res check_matrix_instance(int32_t n, const char *format,
+                                               int32_t wrap) {
+    const char *filepath = "test-vrplib-matrix.vrp";
+    ASSERT(write_matrix_instance(filepath, n, format, wrap, 0.0));
+    Instance instance = parse(filepath);
+    remove(filepath);
+
+    ASSERT(is_valid_instance(&instance));
+    ASSERT(instance.edge_weight);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(explicit_weight(i, j), cptp_dist(&instance, i, j));
+        }
+    }
+
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST parsing_edge_weight_formats(void) {
+    static const char *FORMATS[] = {"UPPER_ROW",      "LOWER_ROW",
+                                    "UPPER_DIAG_ROW", "LOWER_DIAG_ROW",
+                                    "FULL_MATRIX"};
+    const int32_t n = 23;
+
+    // All the formats must yield the same instance as the triplets
+    CHECK_CALL(check_explicit_instance(n, EXPLICIT_RECORDS_IN_ORDER));
+    for (int32_t i = 0; i < ARRAY_LEN_i32(FORMATS); i++) {
+        CHECK_CALL(check_matrix_instance(n, FORMATS[i], 1));
+        CHECK_CALL(check_matrix_instance(n, FORMATS[i], 7));
+        CHECK_CALL(check_matrix_instance(n, FORMATS[i], n * n));
+    }
+
+    // A non symmetric FULL_MATRIX is rejected
+    const char *filepath = "test-vrplib-matrix.vrp";
+    ASSERT(write_matrix_instance(filepath, n, "FULL_MATRIX", 10, 0.5));
+    Instance instance = parse(filepath);
+    ASSERT_FALSE(instance.edge_weight);
+    remove(filepath);
+
+    // Files declaring `UPPER_ROW` while holding triplets (as written by
+    // older versions) are still understood
+    ASSERT(write_legacy_instance(filepath, n));
+    instance = parse(filepath);
+    remove(filepath);
+    ASSERT(instance.edge_weight);
+    ASSERT_EQ(explicit_weight(3, 7), cptp_dist(&instance, 7, 3));
+    instance_destroy(&instance);
+
+    // A true `UPPER_ROW` starting with the same numbers as the triplets is
+    // read as rows: 1 2 5 | 1 3 | 6
+    FILE *fh = fopen(filepath, "w");
+    ASSERT(fh);
+    write_explicit_header(fh, 4, "UPPER_ROW");
+    fprintf(fh, "1 2 5\n1 3 6\nDEPOT_SECTION\n1\n-1\nEOF\n");
+    fclose(fh);
+    instance = parse(filepath);
+    remove(filepath);
+    ASSERT(instance.edge_weight);
+    ASSERT_EQ(1.0, cptp_dist(&instance, 0, 1));
+    ASSERT_EQ(2.0, cptp_dist(&instance, 0, 2));
+    ASSERT_EQ(5.0, cptp_dist(&instance, 0, 3));
+    ASSERT_EQ(1.0, cptp_dist(&instance, 1, 2));
+    ASSERT_EQ(3.0, cptp_dist(&instance, 1, 3));
+    ASSERT_EQ(6.0, cptp_dist(&instance, 2, 3));
+    instance_destroy(&instance);
+    PASS();
+}
+
+TEST rendered_instances_use_row_format(void) {
+    const int32_t n = 17;
+    const char *filepath = "test-vrplib-matrix.vrp";
+    ASSERT(write_matrix_instance(filepath, n, "LOWER_DIAG_ROW", 5, 0.0));
+    Instance instance = parse(filepath);
+    ASSERT(instance.edge_weight);
+
+    FILE *fh = fopen(filepath, "w");
+    ASSERT(fh);
+    render_instance_into_vrplib_file(fh, &instance, true);
+    fclose(fh);
+
+    size_t size = 0;
+    char *content = fread_all_into_cstr(filepath, &size);
+    ASSERT(content);
+    ASSERT(strstr(content, "EDGE_WEIGHT_FORMAT : UPPER_ROW\n"));
+
+    Instance parsed = parse(filepath);
+    remove(filepath);
+    ASSERT(parsed.edge_weight);
+    for (int32_t i = 0; i < n; i++) {
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(cptp_dist(&instance, i, j), cptp_dist(&parsed, i, j));
+        }
+    }
+
+    free(content);
+    instance_destroy(&parsed);
+    instance_destroy(&instance);
+    PASS();
+}
+
+typedef struct {
+    int fd;
+    const char *data;
+    size_t size;
+    /// Size of the single writes, splitting the lines among the reads
+    size_t piece;
+    bool close_fd;
+} PipeWriter;
+
+static void *pipe_writer_thread(void *arg) {
+    PipeWriter *w = arg;
+    for (size_t off = 0; off < w->size;) {
+        ssize_t amt = write(w->fd, w->data + off, MIN(w->piece, w->size - off));
+        if (amt <= 0) {
+            break;
+        }
+        off += (size_t)amt;
+    }
+    if (w->close_fd) {
+        close(w->fd);
+    }
+    return NULL;
+}
+
+/// Parses `size` bytes of `data` written into a pipe `piece` bytes at a
+/// time. Unless `close_fd`, the pipe is left open until the parse is over.
+static Instance parse_through_pipe(const char *data, size_t size,
+                                   size_t piece, bool close_fd) {
+    Instance instance = {0};
+    int fds[2];
+    if (0 != pipe(fds)) {
+        return instance;
+    }
+
+    PipeWriter writer = {fds[1], data, size, piece, close_fd};
+    pthread_t thread;
+    if (0 != pthread_create(&thread, NULL, pipe_writer_thread, &writer)) {
+        close(fds[0]);
+        close(fds[1]);
+        return instance;
+    }
+
+    instance = parse_fd(fds[0], "pipe");
+    // Unblocks the writer if the parse stopped early
+    close(fds[0]);
+    pthread_join(thread, NULL);
+    if (!close_fd) {
+        close(fds[1]);
+    }
+    return instance;
+}
+
+static greatest_test_res check_piped_instance(const char *filepath,
+                                              size_t piece, bool close_fd) {
+    size_t size = 0;
+    char *content = fread_all_into_cstr(filepath, &size);
+    ASSERT(content);
+
+    Instance expected = parse(filepath);
+    Instance instance = parse_through_pipe(content, size, piece, close_fd);
+    free(content);
+    ASSERT(is_valid_instance(&expected));
+    ASSERT(is_valid_instance(&instance));
+
+    const int32_t n = expected.num_customers + 1;
+    ASSERT_EQ(expected.num_customers, instance.num_customers);
+    ASSERT_EQ(expected.num_vehicles, instance.num_vehicles);
+    ASSERT_EQ(expected.vehicle_cap, instance.vehicle_cap);
+    ASSERT_STR_EQ(expected.name, instance.name);
+    ASSERT_EQ(!expected.profits, !instance.profits);
+    ASSERT_EQ(!expected.edge_weight, !instance.edge_weight);
+    for (int32_t i = 0; i < n; i++) {
+        ASSERT_EQ(expected.positions[i].x, instance.positions[i].x);
+        ASSERT_EQ(expected.positions[i].y, instance.positions[i].y);
+        ASSERT_EQ(expected.demands[i], instance.demands[i]);
+        if (expected.profits) {
+            ASSERT_EQ(expected.profits[i], instance.profits[i]);
+        }
+        for (int32_t j = i + 1; j < n; j++) {
+            ASSERT_EQ(cptp_dist(&expected, i, j), cptp_dist(&instance, i, j));
+        }
+    }
+
+    instance_destroy(&instance);
+    instance_destroy(&expected);
+    PASS();
+}
+
+TEST parsing_from_pipes(void) {
+    // The parser must not be killed when it stops reading early
+    signal(SIGPIPE, SIG_IGN);
+
+    const char *toy = "./data/CVRP/toy.vrp";
+    CHECK_CALL(check_piped_instance(toy, 1, true));
+    CHECK_CALL(check_piped_instance(toy, 7, true));
+    CHECK_CALL(check_piped_instance(toy, 4096, true));
+    // The input ends at the `EOF` keyword: the pipe need not be closed
+    CHECK_CALL(check_piped_instance(toy, 4096, false));
+
+    // The triplets span many refills, and the single line of the matrix
+    // outgrows the read buffer
+    const char *filepath = "test-vrplib-piped.vrp";
+    ASSERT(write_explicit_instance(filepath, 300, EXPLICIT_RECORDS_IN_ORDER));
+    CHECK_CALL(check_piped_instance(filepath, 4096, true));
+    ASSERT(write_matrix_instance(filepath, 300, "FULL_MATRIX", 300 * 300,
+                                 0.0));
+    CHECK_CALL(check_piped_instance(filepath, 65536, true));
+    ASSERT(write_matrix_instance(filepath, 40, "LOWER_DIAG_ROW", 7, 0.0));
+    CHECK_CALL(check_piped_instance(filepath, 1, false));
+    // The legacy triplets are buffered in full to be told apart
+    ASSERT(write_legacy_instance(filepath, 300));
+    CHECK_CALL(check_piped_instance(filepath, 4096, true));
+
+    // Binary instances are told apart by their magic number
+    Instance instance = parse(toy);
+    ASSERT(is_valid_instance(&instance));
+    FILE *fh = fopen(filepath, "wb");
+    ASSERT(fh);
+    ASSERT(render_instance_into_binary_file(fh, &instance));
+    fclose(fh);
+    instance_destroy(&instance);
+    CHECK_CALL(check_piped_instance(filepath, 100, true));
+    CHECK_CALL(check_piped_instance(filepath, 100, false));
+    remove(filepath);
+
+    // Truncated inputs are rejected once the pipe is closed
+    size_t size = 0;
+    char *content = fread_all_into_cstr(toy, &size);
+    ASSERT(content);
+    instance = parse_through_pipe(content, size / 2, 16, true);
+    ASSERT_FALSE(instance.positions);
+    instance = parse_through_pipe("CPTPINST", 8, 16, true);
+    ASSERT_FALSE(instance.positions);
+
+    // A binary header claiming a payload far larger than the input
+    CptpBinaryHeader hdr = {0};
+    memcpy(hdr.magic, CPTP_BINARY_MAGIC, sizeof(hdr.magic));
+    hdr.version = CPTP_BINARY_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.payload_size = (uint64_t)1 << 60;
+    hdr.num_customers = 5;
+    instance = parse_through_pipe((const char *)&hdr, sizeof(hdr), 16, true);
+    ASSERT_FALSE(instance.positions);
+    free(content);
+    PASS();
+}
+
+static greatest_test_res check_instance_header(const char *filepath) {
+    InstanceHeader header = {0};
+    ASSERT(parse_header(filepath, &header));
+    Instance instance = parse(filepath);
+    ASSERT(is_valid_instance(&instance));
+
+    ASSERT_STR_EQ(instance.name, header.name);
+    ASSERT_EQ(instance.num_customers, header.num_customers);
+    ASSERT_EQ(instance.num_vehicles, header.num_vehicles);
+    ASSERT_EQ(instance.vehicle_cap, header.vehicle_cap);
+    ASSERT_EQ(instance.edge_weight != NULL, header.has_edge_weight);
+
+    instance_destroy(&instance);
+    instance_header_destroy(&header);
+    PASS();
+}
+
+TEST parsing_headers(void) {
+    CHECK_CALL(check_instance_header("./data/CVRP/toy.vrp"));
+
+    const char *filepath = "test-vrplib-header.vrp";
+    ASSERT(write_explicit_instance(filepath, 30, EXPLICIT_RECORDS_IN_ORDER));
+    CHECK_CALL(check_instance_header(filepath));
+
+    Instance instance = parse(filepath);
+    ASSERT(is_valid_instance(&instance));
+    FILE *fh = fopen(filepath, "wb");
+    ASSERT(fh);
+    ASSERT(render_instance_into_binary_file(fh, &instance));
+    fclose(fh);
+    instance_destroy(&instance);
+    CHECK_CALL(check_instance_header(filepath));
+
+    // The sections are never looked at
+    fh = fopen(filepath, "w");
+    ASSERT(fh);
+    write_explicit_header(fh, 30, NULL);
+    fprintf(fh, "1 2 garbage\n");
+    fclose(fh);
+    InstanceHeader header = {0};
+    ASSERT(parse_header(filepath, &header));
+    ASSERT_STR_EQ("explicit-30", header.name);
+    ASSERT_EQ(29, header.num_customers);
+    ASSERT(header.has_edge_weight);
+    instance_header_destroy(&header);
+    instance = parse(filepath);
+    ASSERT_FALSE(instance.positions);
+
+    // While the header must be complete
+    fh = fopen(filepath, "w");
+    ASSERT(fh);
+    fprintf(fh, "NAME : no-capacity\nDIMENSION : 4\nNODE_COORD_SECTION\n");
+    fclose(fh);
+    ASSERT_FALSE(parse_header(filepath, &header));
+    ASSERT_FALSE(header.name);
+    remove(filepath);
+    ASSERT_FALSE(parse_header(filepath, &header));
+    PASS();
+}
+
 /* Add all the definitions that need to be in the test runner's main file. */
 GREATEST_MAIN_DEFS();
 
@@ -86,6 +585,12 @@ int main(int argc, char **argv) {
 
     /* If tests are run outside of a suite, a default suite is used. */
     RUN_TEST(parsing_single_instance);
+    RUN_TEST(parsing_truncated_instance);
+    RUN_TEST(parsing_explicit_instances);
+    RUN_TEST(parsing_edge_weight_formats);
+    RUN_TEST(rendered_instances_use_row_format);
+    RUN_TEST(parsing_from_pipes);
+    RUN_TEST(parsing_headers);
 
     GREATEST_MAIN_END(); /* display results */
 }